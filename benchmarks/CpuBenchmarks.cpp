@@ -0,0 +1,318 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include <VulkanLaunchpad.h>
+#include "AssetLoader.h"
+#include "DrawList.h"
+#include "FrameStatistics.h"
+#include "OcclusionCuller.h"
+#include "SceneGraph.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+/* --------------------------------------------- */
+// CPU Benchmarks
+//
+// Measures CPU-side hot paths in isolation, without a window and without
+// touching the GPU. Every benchmark runs a fixed number of iterations on
+// inputs which are either loaded from the bundled assets or generated with
+// fixed seeds. An untimed setup step prepares the input of every iteration.
+//
+// The results are written as JSON with one line per benchmark, in a fixed
+// order, so that the files of two commits can be diffed directly. Besides
+// the timings, every benchmark reports a checksum of its output, which only
+// changes if the benchmarked code's results change.
+//
+// Usage: VulkanLaunchpadStarterBenchmarks [--output <file>] [--filter <substring>]
+/* --------------------------------------------- */
+
+namespace
+{
+	/*!
+	 *	A benchmark: setup is called before every iteration and is not timed, run is timed.
+	 */
+	struct Benchmark {
+		std::string name;
+		uint32_t iterations;
+
+		//! Number of items (vertices, objects, nodes, packets) which one iteration processes
+		uint64_t itemsPerIteration;
+
+		std::function<void()> setup;
+
+		//! Returns a checksum of the iteration's results
+		std::function<uint64_t()> run;
+	};
+
+	struct BenchmarkResult {
+		std::string name;
+		uint32_t iterations;
+		uint64_t itemsPerIteration;
+		double minMilliseconds;
+		double medianMilliseconds;
+		double p95Milliseconds;
+		uint64_t checksum;
+
+		//! False if not all iterations have produced the same checksum
+		bool deterministic;
+	};
+
+	// FNV-1a, for checksums over result arrays:
+	uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i) {
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	BenchmarkResult runBenchmark(const Benchmark& benchmark)
+	{
+		using milliseconds = std::chrono::duration<double, std::milli>;
+
+		// One untimed iteration warms up caches and allocators:
+		benchmark.setup();
+		const uint64_t checksum = benchmark.run();
+
+		bool deterministic = true;
+		std::vector<double> iteration_milliseconds;
+		iteration_milliseconds.reserve(benchmark.iterations);
+		for (uint32_t i = 0; i < benchmark.iterations; ++i) {
+			benchmark.setup();
+			const auto start = std::chrono::steady_clock::now();
+			const uint64_t iteration_checksum = benchmark.run();
+			const auto end = std::chrono::steady_clock::now();
+			iteration_milliseconds.push_back(milliseconds(end - start).count());
+			deterministic = deterministic && iteration_checksum == checksum;
+		}
+
+		BenchmarkResult result;
+		result.name = benchmark.name;
+		result.iterations = benchmark.iterations;
+		result.itemsPerIteration = benchmark.itemsPerIteration;
+		result.minMilliseconds = *std::min_element(iteration_milliseconds.begin(), iteration_milliseconds.end());
+		result.medianMilliseconds = frameStatisticsPercentile(iteration_milliseconds, 50.0);
+		result.p95Milliseconds = frameStatisticsPercentile(iteration_milliseconds, 95.0);
+		result.checksum = checksum;
+		result.deterministic = deterministic;
+		return result;
+	}
+
+	bool writeJson(const std::vector<BenchmarkResult>& results, const char* path)
+	{
+		FILE* file = fopen(path, "w");
+		if (nullptr == file) {
+			return false;
+		}
+		fprintf(file, "{\n  \"benchmarks\": [\n");
+		for (size_t i = 0; i < results.size(); ++i) {
+			const BenchmarkResult& r = results[i];
+			const double items_per_second = r.medianMilliseconds > 0.0 ? static_cast<double>(r.itemsPerIteration) * 1000.0 / r.medianMilliseconds : 0.0;
+			fprintf(file, "    { \"name\": \"%s\", \"iterations\": %u, \"itemsPerIteration\": %llu, \"minMs\": %.4f, \"medianMs\": %.4f, \"p95Ms\": %.4f, "
+				"\"itemsPerSecond\": %.0f, \"checksum\": \"%016llx\", \"deterministic\": %s }%s\n",
+				r.name.c_str(), r.iterations, static_cast<unsigned long long>(r.itemsPerIteration), r.minMilliseconds, r.medianMilliseconds, r.p95Milliseconds,
+				items_per_second, static_cast<unsigned long long>(r.checksum), r.deterministic ? "true" : "false", i + 1 < results.size() ? "," : "");
+		}
+		fprintf(file, "  ]\n}\n");
+		return 0 == fclose(file);
+	}
+
+	/* --------------------------------------------- */
+	// Inputs, shared between benchmarks. They are created once, so that
+	// they are identical across benchmarks and iterations.
+	/* --------------------------------------------- */
+
+	struct MeshInput {
+		const char* name;
+		const char* path;
+		uint32_t parseIterations;
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> indices;
+	};
+
+	// Same shape as the former --scene-graph-benchmark: a random hierarchy in which every node's parent is picked
+	// uniformly among the nodes before it, which yields a bushy tree of logarithmic depth with subtrees of all sizes:
+	void buildRandomSceneGraph(SceneGraph& scene, uint32_t num_nodes, std::mt19937& random_engine)
+	{
+		std::uniform_real_distribution<float> random_angle(0.0f, glm::radians(360.0f));
+		for (uint32_t i = 0; i < num_nodes; ++i) {
+			const uint32_t parent = 0 == i ? kSceneGraphNoParent : std::uniform_int_distribution<uint32_t>(0, i - 1)(random_engine);
+			sceneGraphAddNode(scene, parent, glm::vec3(1.0f, 0.0f, 0.0f), glm::angleAxis(random_angle(random_engine), glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(0.9f));
+		}
+		sceneGraphUpdate(scene);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const char* output_path = "cpu_benchmarks.json";
+	const char* filter = nullptr;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+			output_path = argv[++i];
+		}
+		else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+			filter = argv[++i];
+		}
+		else {
+			VKL_LOG("Ignoring unknown command line argument \"" << argv[i] << "\"");
+		}
+	}
+
+	std::vector<Benchmark> benchmarks;
+
+	// OBJ parsing and vertex welding of the bundled assets:
+	std::vector<MeshInput> meshes = {
+		{ "cube", ASSET_DIR "/cube/cube.obj", 200 },
+		{ "sphere", ASSET_DIR "/sphere/sphere.obj", 50 },
+		{ "vespa", ASSET_DIR "/vespa/vespa.obj", 5 },
+	};
+	std::vector<glm::vec3> weld_positions;
+	std::vector<uint32_t> weld_indices;
+	for (MeshInput& mesh : meshes) {
+		VklGeometryData geometry = vklLoadModelGeometry(mesh.path);
+		mesh.positions.swap(geometry.positions);
+		mesh.indices.swap(geometry.indices);
+
+		const MeshInput* input = &mesh;
+		benchmarks.push_back({ std::string("obj_parse/") + mesh.name, mesh.parseIterations, mesh.positions.size(),
+			[] {},
+			[input] {
+				VklGeometryData parsed = vklLoadModelGeometry(input->path);
+				return hashBytes(parsed.indices.data(), parsed.indices.size() * sizeof(uint32_t), parsed.positions.size());
+			}
+		});
+		benchmarks.push_back({ std::string("weld_vertices/") + mesh.name, 10 * mesh.parseIterations, mesh.positions.size(),
+			[input, &weld_positions, &weld_indices] {
+				weld_positions = input->positions;
+				weld_indices = input->indices;
+			},
+			[&weld_positions, &weld_indices] {
+				assetLoaderWeldVertices(weld_positions, weld_indices);
+				return hashBytes(weld_indices.data(), weld_indices.size() * sizeof(uint32_t), weld_positions.size());
+			}
+		});
+	}
+
+	// Frustum culling of unit boxes which are scattered around the camera, about a sixth of which is visible:
+	const uint32_t num_cull_objects = 100000;
+	std::vector<OcclusionObject> cull_objects(num_cull_objects);
+	{
+		std::mt19937 random_engine(7);
+		std::uniform_real_distribution<float> random_position(-100.0f, 100.0f);
+		for (OcclusionObject& object : cull_objects) {
+			object = {};
+			object.worldMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(random_position(random_engine), random_position(random_engine), random_position(random_engine)));
+			object.boundsMin = glm::vec3(-0.5f);
+			object.boundsMax = glm::vec3(0.5f);
+		}
+	}
+	const glm::mat4 cull_view_projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 500.0f)
+		* glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	std::vector<uint8_t> cull_inside(num_cull_objects);
+	benchmarks.push_back({ "frustum_culling", 200, num_cull_objects,
+		[] {},
+		[&] {
+			const uint32_t num_inside = occlusionCullerCullFrustum(cull_objects.data(), num_cull_objects, cull_view_projection, cull_inside.data());
+			return hashBytes(cull_inside.data(), cull_inside.size(), num_inside);
+		}
+	});
+
+	// Transform propagation: 100k nodes, 1% of which get a new local rotation before every iteration. The world
+	// matrices are then written into one of three emulated instance buffers, one per frame in flight. The same
+	// nodes are changed in every iteration, so that every iteration recomputes and writes the same matrices:
+	const uint32_t num_nodes = 100000;
+	const uint32_t num_changes_per_iteration = num_nodes / 100;
+	const uint32_t num_instance_buffers = 3;
+	SceneGraph scene;
+	std::mt19937 scene_random_engine(42);
+	buildRandomSceneGraph(scene, num_nodes, scene_random_engine);
+	std::vector<std::vector<glm::mat4>> instance_buffers(num_instance_buffers, std::vector<glm::mat4>(num_nodes));
+	std::vector<uint64_t> instance_buffer_versions(num_instance_buffers, 0);
+	for (uint32_t b = 0; b < num_instance_buffers; ++b) {
+		sceneGraphWriteInstances(scene, instance_buffers[b].data(), instance_buffer_versions[b]);
+	}
+	uint32_t instance_buffer_index = 0;
+	const auto change_random_nodes = [&] {
+		scene_random_engine.seed(1);
+		std::uniform_real_distribution<float> random_angle(0.0f, glm::radians(360.0f));
+		std::uniform_int_distribution<uint32_t> random_node(0, num_nodes - 1);
+		for (uint32_t c = 0; c < num_changes_per_iteration; ++c) {
+			sceneGraphSetLocalRotation(scene, random_node(scene_random_engine), glm::angleAxis(random_angle(scene_random_engine), glm::vec3(0.0f, 1.0f, 0.0f)));
+		}
+	};
+	benchmarks.push_back({ "scene_graph/update", 1000, num_nodes,
+		change_random_nodes,
+		[&] {
+			return static_cast<uint64_t>(sceneGraphUpdate(scene));
+		}
+	});
+	benchmarks.push_back({ "scene_graph/write_instances", 1000, num_nodes,
+		[&] {
+			change_random_nodes();
+			sceneGraphUpdate(scene);
+			instance_buffer_index = (instance_buffer_index + 1) % num_instance_buffers;
+		},
+		[&] {
+			const uint32_t b = instance_buffer_index;
+			return static_cast<uint64_t>(sceneGraphWriteInstances(scene, instance_buffers[b].data(), instance_buffer_versions[b]));
+		}
+	});
+
+	// Draw list sorting: packets with random pipelines, materials, meshes, and depths in two passes:
+	const uint32_t num_packets = 50000;
+	std::vector<uint64_t> sort_keys(num_packets);
+	{
+		std::mt19937 random_engine(3);
+		std::uniform_int_distribution<uint32_t> random_pipeline(0, 15);
+		std::uniform_int_distribution<uint32_t> random_material(0, 255);
+		std::uniform_int_distribution<uint32_t> random_mesh(0, 1023);
+		std::uniform_real_distribution<float> random_depth(0.0f, 1.0f);
+		for (uint64_t& key : sort_keys) {
+			key = drawListMakeSortKey(random_engine() % 2, random_pipeline(random_engine), random_material(random_engine), random_mesh(random_engine), random_depth(random_engine));
+		}
+	}
+	DrawList draw_list;
+	benchmarks.push_back({ "draw_list/sort", 500, num_packets,
+		[&] {
+			drawListReset(draw_list);
+			DrawPacket packet = {};
+			for (uint32_t i = 0; i < num_packets; ++i) {
+				packet.sortKey = sort_keys[i];
+				packet.firstInstance = i;
+				drawListAdd(draw_list, packet);
+			}
+		},
+		[&] {
+			drawListSort(draw_list);
+			return hashBytes(draw_list.order.data(), draw_list.order.size() * sizeof(uint32_t));
+		}
+	});
+
+	std::vector<BenchmarkResult> results;
+	for (const Benchmark& benchmark : benchmarks) {
+		if (nullptr != filter && std::string::npos == benchmark.name.find(filter)) {
+			continue;
+		}
+		results.push_back(runBenchmark(benchmark));
+		const BenchmarkResult& r = results.back();
+		VKL_LOG(r.name << ": median " << r.medianMilliseconds << " ms, min " << r.minMilliseconds << " ms over " << r.iterations << " iterations"
+			<< (r.deterministic ? "" : " (NOT deterministic)"));
+	}
+
+	if (!writeJson(results, output_path)) {
+		VKL_LOG("Unable to write benchmark results to \"" << output_path << "\"");
+		return EXIT_FAILURE;
+	}
+	VKL_LOG("Benchmark results written to \"" << output_path << "\"");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,12 @@
+#version 450
+
+// Copies an image of the viewport's extent texel by texel, e.g., a captured frame into the swapchain image
+// (see src/FrameCapture.h). Draw it with shaders/fullscreen.shader.
+layout (location = 0) out vec4 out_color;
+
+layout (binding = 0) uniform sampler2D source_image;
+
+void main()
+{
+    out_color = texelFetch(source_image, ivec2(gl_FragCoord.xy), 0);
+}
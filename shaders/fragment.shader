@@ -1,4 +1,40 @@
 #version 450
+#ifdef MULTIVIEW
+#extension GL_EXT_multiview : require
+#endif
+
+// Features which do not change the shader interface are specialization constants (see src/ShaderPermutations.h).
+// Every pipeline is compiled with constant values, so these branches cost nothing at runtime:
+layout (constant_id = 0) const bool kLighting = false;
+layout (constant_id = 1) const bool kFog = false;
+
+#ifdef VERTEX_NORMALS
+layout (location = 0) in vec3 in_normal;
+#endif
+
+#ifdef CLUSTERED_LIGHTING
+layout (location = 1) in vec3 in_world_position;
+
+// Lights and per-cluster light lists, written by src/ClusteredLighting.cpp and shaders/light_culling.shader.
+// With multiview, the lists of every view follow each other. The constants must match src/ClusteredLighting.h:
+const uvec3 kClusterGrid = uvec3(16, 9, 24);
+const uint kClusterMaxLights = 255;
+const float kClusterNearDepth = 0.1;
+const float kClusterFarDepth = 100.0;
+
+struct Light {
+    vec4 position_radius;
+    vec4 color;
+};
+
+layout (std430, binding = 1) readonly buffer LightBuffer {
+    Light lights[];
+};
+
+layout (std430, binding = 2) readonly buffer ClusterBuffer {
+    uint cluster_data[];
+};
+#endif
 
 layout (location = 0) out vec4 out_color;
 
@@ -6,9 +42,68 @@ layout (binding = 0)
 uniform UniformBuffer {
     vec4 color;
     mat4 transformation;
+    vec4 camera_position;
+    vec4 viewport_size;
 } uniform_buffer;
 
 void main()
 {
-    out_color = uniform_buffer.color;
+    vec3 color = uniform_buffer.color.rgb;
+#ifdef VERTEX_NORMALS
+    if (kLighting) {
+        // Diffuse lighting from a fixed direction in world space, plus some ambient light:
+        const vec3 light_direction = normalize(vec3(-0.5, 1.0, 0.75));
+        const float diffuse = max(dot(normalize(in_normal), light_direction), 0.0);
+        color *= 0.2 + 0.8 * diffuse;
+    }
+#endif
+#ifdef CLUSTERED_LIGHTING
+    {
+        // Without vertex normals, the flat normal of the triangle is used. Either way, it faces the camera:
+        const vec3 to_camera = uniform_buffer.camera_position.xyz - in_world_position;
+#ifdef VERTEX_NORMALS
+        vec3 normal = normalize(in_normal);
+#else
+        vec3 normal = normalize(cross(dFdx(in_world_position), dFdy(in_world_position)));
+#endif
+        if (dot(normal, to_camera) < 0.0) {
+            normal = -normal;
+        }
+
+        // The cluster which the fragment lies in. For perspective projections, gl_FragCoord.w is the reciprocal of the view depth:
+        const uvec2 tile = min(uvec2(gl_FragCoord.xy / uniform_buffer.viewport_size.xy * vec2(kClusterGrid.xy)), kClusterGrid.xy - 1);
+        const float depth = 1.0 / gl_FragCoord.w;
+        uint slice = 0;
+        if (depth > kClusterNearDepth) {
+            slice = min(uint(log(depth / kClusterNearDepth) / log(kClusterFarDepth / kClusterNearDepth) * float(kClusterGrid.z)), kClusterGrid.z - 1);
+        }
+#ifdef MULTIVIEW
+        const uint view_cluster = gl_ViewIndex * kClusterGrid.x * kClusterGrid.y * kClusterGrid.z;
+#else
+        const uint view_cluster = 0;
+#endif
+        const uint base = (view_cluster + (slice * kClusterGrid.y + tile.y) * kClusterGrid.x + tile.x) * (1 + kClusterMaxLights);
+
+        // The scene is lit by the point lights only, plus some ambient light:
+        vec3 light_sum = vec3(0.2);
+        const uint count = cluster_data[base];
+        for (uint i = 0; i < count; ++i) {
+            const Light light = lights[cluster_data[base + 1 + i]];
+            const vec3 to_light = light.position_radius.xyz - in_world_position;
+            const float distance = length(to_light);
+            const float falloff = clamp(1.0 - (distance * distance) / (light.position_radius.w * light.position_radius.w), 0.0, 1.0);
+            light_sum += light.color.rgb * (falloff * falloff * max(dot(normal, to_light / max(distance, 1e-4)), 0.0));
+        }
+        color *= light_sum;
+    }
+#endif
+    if (kFog) {
+        // For perspective projections, gl_FragCoord.w is the reciprocal of the view-space depth.
+        // The fog color matches the clear color:
+        const vec3 fog_color = vec3(0.39, 0.58, 0.93);
+        const float fog_density = 0.05;
+        const float fog = 1.0 - exp(-fog_density / gl_FragCoord.w);
+        color = mix(color, fog_color, fog);
+    }
+    out_color = vec4(color, uniform_buffer.color.a);
 }
\ No newline at end of file
@@ -0,0 +1,11 @@
+#version 450
+
+// A triangle which covers the whole viewport, without any vertex input. Draw it with 3 vertices.
+layout (location = 0) out vec2 out_uv;
+
+void main()
+{
+    // (0, 0), (2, 0), (0, 2) in texture coordinates, i.e., the viewport is the triangle's lower-left half:
+    out_uv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(out_uv * 2.0 - 1.0, 0.0, 1.0);
+}
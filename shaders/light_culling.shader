@@ -0,0 +1,119 @@
+#version 450
+
+// Bins point lights into clusters (see src/ClusteredLighting.h). One invocation per cluster: it tests every
+// light's bounding sphere against the cluster's view space bounding box and writes the indices of the lights
+// which touch it. Lights are loaded into shared memory in batches, so that every workgroup reads each light once.
+layout (local_size_x = 64) in;
+
+struct Light {
+    vec4 position_radius;
+    vec4 color;
+};
+
+layout (std430, binding = 0) readonly buffer LightBuffer {
+    Light lights[];
+};
+
+// Per cluster: the number of lights, followed by kClusterMaxLights light indices. With multiview, the clusters of
+// every view follow each other, and each view is culled by a dispatch of its own:
+const uint kClusterMaxLights = 255;
+layout (std430, binding = 1) writeonly buffer ClusterBuffer {
+    uint cluster_data[];
+};
+
+// Clusters which more lights touch than fit into their list, and the most lights which touched a single cluster.
+// Reset to 0 by the host before every dispatch:
+layout (std430, binding = 2) buffer OverflowBuffer {
+    uint num_overflowed_clusters;
+    uint max_cluster_lights;
+};
+
+layout (push_constant) uniform PushConstants {
+    mat4 view_projection;
+    // xy: reciprocal of the projection's x and y scale, z: near depth of the slices, w: far depth of the slices
+    vec4 inverse_projection_scale_and_depth_range;
+    // xyz: grid size, w: number of lights
+    uvec4 grid_and_num_lights;
+    // x: index of the view's first cluster in the cluster buffer, yzw: unused
+    uvec4 first_cluster;
+} push_constants;
+
+// The current batch of lights in view space: x and y are clip space x and y divided by the projection's scale,
+// z is the view depth (i.e., clip space w), and w is the radius:
+shared vec4 shared_lights[64];
+
+// View depth of the boundary between slice - 1 and slice. Slice 0 starts at the camera, the last one has no end:
+float sliceDepth(uint slice)
+{
+    const uvec3 grid = push_constants.grid_and_num_lights.xyz;
+    const float near_depth = push_constants.inverse_projection_scale_and_depth_range.z;
+    const float far_depth = push_constants.inverse_projection_scale_and_depth_range.w;
+    if (0 == slice) {
+        return 0.0;
+    }
+    if (slice >= grid.z) {
+        return 3.0e38;
+    }
+    return near_depth * pow(far_depth / near_depth, float(slice) / float(grid.z));
+}
+
+void main()
+{
+    const uvec3 grid = push_constants.grid_and_num_lights.xyz;
+    const uint num_lights = push_constants.grid_and_num_lights.w;
+    const vec2 inverse_scale = push_constants.inverse_projection_scale_and_depth_range.xy;
+    const uint cluster = gl_GlobalInvocationID.x;
+    const bool valid_cluster = cluster < grid.x * grid.y * grid.z;
+
+    // The cluster's bounding box in view space. Tiles are given in normalized device coordinates,
+    // which are scaled with the depth of the box' near and far sides:
+    const uint tile_x = cluster % grid.x;
+    const uint tile_y = (cluster / grid.x) % grid.y;
+    const uint slice = cluster / (grid.x * grid.y);
+    const vec2 ndc_min = vec2(tile_x, tile_y) / vec2(grid.xy) * 2.0 - 1.0;
+    const vec2 ndc_max = vec2(tile_x + 1, tile_y + 1) / vec2(grid.xy) * 2.0 - 1.0;
+    const float depth_min = sliceDepth(slice);
+    const float depth_max = sliceDepth(slice + 1);
+    const vec2 xy_near_min = ndc_min * depth_min * inverse_scale;
+    const vec2 xy_near_max = ndc_max * depth_min * inverse_scale;
+    const vec2 xy_far_min = ndc_min * min(depth_max, 1.0e18) * inverse_scale;
+    const vec2 xy_far_max = ndc_max * min(depth_max, 1.0e18) * inverse_scale;
+    const vec3 box_min = vec3(min(min(xy_near_min, xy_near_max), min(xy_far_min, xy_far_max)), depth_min);
+    const vec3 box_max = vec3(max(max(xy_near_min, xy_near_max), max(xy_far_min, xy_far_max)), depth_max);
+
+    uint count = 0;
+    uint num_touching = 0;
+    const uint base = (push_constants.first_cluster.x + cluster) * (1 + kClusterMaxLights);
+    for (uint batch_start = 0; batch_start < num_lights; batch_start += gl_WorkGroupSize.x) {
+        const uint light_index = batch_start + gl_LocalInvocationIndex;
+        if (light_index < num_lights) {
+            const vec4 position_radius = lights[light_index].position_radius;
+            const vec4 clip = push_constants.view_projection * vec4(position_radius.xyz, 1.0);
+            shared_lights[gl_LocalInvocationIndex] = vec4(clip.xy * inverse_scale, clip.w, position_radius.w);
+        }
+        barrier();
+
+        const uint batch_size = min(gl_WorkGroupSize.x, num_lights - batch_start);
+        for (uint i = 0; valid_cluster && i < batch_size; ++i) {
+            const vec4 light = shared_lights[i];
+            // Sphere-box test: distance from the sphere's center to the nearest point of the box:
+            const vec3 nearest = clamp(light.xyz, box_min, box_max);
+            const vec3 offset = light.xyz - nearest;
+            if (dot(offset, offset) <= light.w * light.w) {
+                if (count < kClusterMaxLights) {
+                    cluster_data[base + 1 + count] = batch_start + i;
+                    ++count;
+                }
+                ++num_touching;
+            }
+        }
+        barrier();
+    }
+    if (valid_cluster) {
+        cluster_data[base] = count;
+    }
+    if (num_touching > kClusterMaxLights) {
+        atomicAdd(num_overflowed_clusters, 1);
+        atomicMax(max_cluster_lights, num_touching);
+    }
+}
@@ -0,0 +1,19 @@
+#version 450
+
+// Places the layers of a multiview target (see src/Multiview.h) side by side, from left to right.
+// Draw it with shaders/fullscreen.shader, into a viewport of the views' total width.
+layout (constant_id = 0) const uint kNumViews = 2;
+
+layout (location = 0) out vec4 out_color;
+
+layout (binding = 0) uniform sampler2DArray views;
+
+void main()
+{
+    // Every view has the same extent as a layer, hence texels are fetched without filtering:
+    const ivec2 view_size = textureSize(views, 0).xy;
+    const ivec2 pixel = ivec2(gl_FragCoord.xy);
+    const int view = min(pixel.x / view_size.x, int(kNumViews) - 1);
+    const ivec2 texel = min(ivec2(pixel.x - view * view_size.x, pixel.y), view_size - 1);
+    out_color = texelFetch(views, ivec3(texel, view), 0);
+}
@@ -0,0 +1,49 @@
+#version 450
+
+// Upscales the scene, which has been rendered into the top-left part of an offscreen image (see src/DynamicResolution.h),
+// to the whole viewport. Bilinear filtering blurs, hence the result is sharpened if the scene has been rendered at a
+// lower resolution.
+layout (location = 0) in vec2 in_uv;
+
+layout (location = 0) out vec4 out_color;
+
+layout (binding = 0) uniform sampler2D scene_image;
+
+// Must match UpscaleParameters in src/DynamicResolution.cpp:
+layout (binding = 1)
+uniform Parameters {
+    // Size of the rendered part and of one texel, in texture coordinates:
+    vec2 uv_scale;
+    vec2 texel_size;
+    // 0 for bilinear upscaling only, up to 1 for the strongest sharpening:
+    float sharpness;
+} parameters;
+
+// Texels outside of the rendered part hold stale data => bilinear filtering must stay half a texel within it:
+vec3 sampleScene(vec2 uv)
+{
+    return texture(scene_image, clamp(uv, 0.5 * parameters.texel_size, parameters.uv_scale - 0.5 * parameters.texel_size)).rgb;
+}
+
+void main()
+{
+    const vec2 uv = in_uv * parameters.uv_scale;
+    const vec3 center = sampleScene(uv);
+    if (parameters.sharpness <= 0.0) {
+        out_color = vec4(center, 1.0);
+        return;
+    }
+    const vec3 north = sampleScene(uv - vec2(0.0, parameters.texel_size.y));
+    const vec3 south = sampleScene(uv + vec2(0.0, parameters.texel_size.y));
+    const vec3 west = sampleScene(uv - vec2(parameters.texel_size.x, 0.0));
+    const vec3 east = sampleScene(uv + vec2(parameters.texel_size.x, 0.0));
+
+    // Contrast-adaptive sharpening: the center is pushed away from its neighbors, the less so the higher the local
+    // contrast already is, which avoids ringing at strong edges:
+    const vec3 minimum = min(center, min(min(north, south), min(west, east)));
+    const vec3 maximum = max(center, max(max(north, south), max(west, east)));
+    const vec3 amount = sqrt(clamp(min(minimum, 1.0 - maximum) / max(maximum, vec3(1.0e-4)), 0.0, 1.0));
+    const vec3 weight = -amount * mix(0.125, 0.2, parameters.sharpness);
+    const vec3 sharpened = (center + (north + south + west + east) * weight) / (1.0 + 4.0 * weight);
+    out_color = vec4(clamp(sharpened, 0.0, 1.0), 1.0);
+}
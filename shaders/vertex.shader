@@ -1,14 +1,54 @@
 #version 450
+#ifdef MULTIVIEW
+#extension GL_EXT_multiview : require
+#endif
 
 layout (location = 0) in vec3 in_position;
 
+// Per-instance world matrix from the scene graph's instance buffer (occupies locations 1 to 4):
+layout (location = 1) in mat4 in_world_matrix;
+
+#ifdef VERTEX_NORMALS
+// Per-vertex normal, e.g., the analytic normal of a tessellated Bezier patch:
+layout (location = 5) in vec3 in_normal;
+
+layout (location = 0) out vec3 out_normal;
+#endif
+
+#ifdef CLUSTERED_LIGHTING
+// Point lights are evaluated at the fragment's world space position:
+layout (location = 1) out vec3 out_world_position;
+#endif
+
 layout (binding = 0)
 uniform UniformBuffer {
     vec4 color;
     mat4 transformation;
+    vec4 camera_position;
+    vec4 viewport_size;
+#ifdef MULTIVIEW
+    // One view-projection matrix per view of a multiview render pass, see src/Multiview.h.
+    // The size must match kMultiviewMaxViews:
+    mat4 view_transformations[4];
+#endif
 } uniform_buffer;
 
+// A depth pre-pass and the main pass must produce bit-identical depth values for VK_COMPARE_OP_EQUAL:
+invariant gl_Position;
+
 void main()
 {
-    gl_Position = uniform_buffer.transformation * vec4(in_position, 1.0);
+#ifdef VERTEX_NORMALS
+    // World matrices only rotate and scale uniformly => their upper 3x3 part transforms normals, too:
+    out_normal = mat3(in_world_matrix) * in_normal;
+#endif
+    const vec4 world_position = in_world_matrix * vec4(in_position, 1.0);
+#ifdef CLUSTERED_LIGHTING
+    out_world_position = world_position.xyz;
+#endif
+#ifdef MULTIVIEW
+    gl_Position = uniform_buffer.view_transformations[gl_ViewIndex] * world_position;
+#else
+    gl_Position = uniform_buffer.transformation * world_position;
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,191 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "AssetLoader.h"
+#include "JobSystem.h"
+#include <VulkanLaunchpad.h>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+
+namespace
+{
+	//! A mesh's CPU geometry, which each load step passes on to the next one
+	struct AssetGeometry {
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t>  indices;
+		uint32_t               numVerticesBeforeWelding = 0;
+		glm::vec3              boundsMin = glm::vec3(0.0f);
+		glm::vec3              boundsMax = glm::vec3(0.0f);
+		OcclusionOccluder      occluder;
+	};
+
+	struct Asset {
+		const char* name;
+
+		//! The welded geometry, which is kept after staging
+		JobFuture<AssetGeometry> geometry;
+
+		//! The mesh in the geometry pool, published by the main-thread job
+		JobFuture<GeometryPoolMesh> stagedMesh;
+		bool             resident = false;
+		std::chrono::steady_clock::time_point startTime;
+	};
+
+	// A deque, so that the jobs' pointers to assets stay valid while new assets are added:
+	std::deque<Asset> mAssets;
+	uint32_t mNumPending = 0;
+	JobHandle mStagingDependency;
+
+	struct PositionHash {
+		size_t operator()(const glm::vec3& position) const
+		{
+			// Adding 0 turns -0 into +0, which compare equal and must hence hash equally:
+			const glm::vec3 normalized = position + glm::vec3(0.0f);
+			uint32_t bits[3];
+			memcpy(bits, &normalized, sizeof(bits));
+			return (static_cast<size_t>(bits[0]) * 73856093u) ^ (static_cast<size_t>(bits[1]) * 19349663u) ^ (static_cast<size_t>(bits[2]) * 83492791u);
+		}
+	};
+
+	AssetHandle startLoading(const char* name, AssetParseFunction parse)
+	{
+		const AssetHandle handle = static_cast<AssetHandle>(mAssets.size());
+		mAssets.emplace_back();
+		Asset* asset = &mAssets.back();
+		asset->name = name;
+		asset->startTime = std::chrono::steady_clock::now();
+		++mNumPending;
+
+		// Every step's future holds its result, which the next step takes over once the future's job has finished:
+		const JobFuture<AssetGeometry> parsed = jobSystemAsync<AssetGeometry>("Parse Mesh", [parse = std::move(parse)] {
+			AssetGeometry geometry;
+			parse(geometry.positions, geometry.indices);
+			geometry.numVerticesBeforeWelding = static_cast<uint32_t>(geometry.positions.size());
+			return geometry;
+		});
+		asset->geometry = jobSystemAsync<AssetGeometry>("Optimize Mesh", [parsed] {
+			AssetGeometry geometry = std::move(jobSystemGet(parsed));
+			assetLoaderWeldVertices(geometry.positions, geometry.indices);
+			if (!geometry.positions.empty()) {
+				geometry.boundsMin = geometry.positions[0];
+				geometry.boundsMax = geometry.positions[0];
+				for (const glm::vec3& position : geometry.positions) {
+					geometry.boundsMin = glm::min(geometry.boundsMin, position);
+					geometry.boundsMax = glm::max(geometry.boundsMax, position);
+				}
+			}
+			occlusionCullerBuildOccluder(geometry.positions.data(), geometry.indices.data(), static_cast<uint32_t>(geometry.indices.size()),
+				geometry.boundsMin, geometry.boundsMax, geometry.occluder);
+			return geometry;
+		}, &parsed.job, 1);
+		const JobHandle stage_dependencies[] = { asset->geometry.job, mStagingDependency };
+		asset->stagedMesh = jobSystemAsync<GeometryPoolMesh>("Stage Mesh", [name, geometry = asset->geometry] {
+			const AssetGeometry& optimized = jobSystemGet(geometry);
+			return geometryPoolAddMesh(name, optimized.positions.data(), static_cast<uint32_t>(optimized.positions.size()),
+				optimized.indices.data(), static_cast<uint32_t>(optimized.indices.size()));
+		}, stage_dependencies, 2);
+		// The geometry pool's memory is host-coherent, so the staged data is visible to the GPU as soon as
+		// the next command buffer is submitted. Publishing on the main thread keeps every frame consistent:
+		jobSystemSubmit("Publish Mesh", [asset] {
+			--mNumPending;
+			const GeometryPoolMesh mesh = jobSystemGet(asset->stagedMesh);
+			if (kGeometryPoolInvalidMesh == mesh) {
+				VKL_LOG("Unable to load mesh \"" << asset->name << "\" => keeping its placeholder.");
+				return;
+			}
+			asset->resident = true;
+			const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - asset->startTime).count();
+			VKL_LOG("Mesh \"" << asset->name << "\" is resident after " << milliseconds
+				<< " ms (" << jobSystemGet(asset->geometry).numVerticesBeforeWelding << " vertices welded to " << geometryPoolGetRange(mesh).vertexCount << ").");
+		}, &asset->stagedMesh.job, 1, JOB_AFFINITY_MAIN_THREAD);
+
+		return handle;
+	}
+}
+
+// Model files typically store one vertex per face corner. Since we only use positions, all vertices
+// with identical positions are merged, which shrinks the vertex buffer and improves post-transform cache hits:
+void assetLoaderWeldVertices(std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices)
+{
+	std::unordered_map<glm::vec3, uint32_t, PositionHash> unique_vertices;
+	unique_vertices.reserve(positions.size());
+	std::vector<uint32_t> remap(positions.size());
+	std::vector<glm::vec3> welded_positions;
+	welded_positions.reserve(positions.size());
+	for (size_t i = 0; i < positions.size(); ++i) {
+		auto inserted = unique_vertices.emplace(positions[i], static_cast<uint32_t>(welded_positions.size()));
+		if (inserted.second) {
+			welded_positions.push_back(positions[i]);
+		}
+		remap[i] = inserted.first->second;
+	}
+	for (uint32_t& index : indices) {
+		index = remap[index];
+	}
+	positions.swap(welded_positions);
+}
+
+AssetHandle assetLoaderLoadMesh(const char* name, const char* path)
+{
+	return startLoading(name, [path](std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices) {
+		VklGeometryData geometry = vklLoadModelGeometry(path);
+		positions.swap(geometry.positions);
+		indices.swap(geometry.indices);
+	});
+}
+
+AssetHandle assetLoaderLoadMesh(const char* name, AssetParseFunction parse)
+{
+	return startLoading(name, std::move(parse));
+}
+
+void assetLoaderSetStagingDependency(const JobHandle& job)
+{
+	mStagingDependency = job;
+}
+
+GeometryPoolMesh assetLoaderGetMesh(AssetHandle asset)
+{
+	if (kAssetInvalid == asset || !mAssets[asset].resident) {
+		return kGeometryPoolInvalidMesh;
+	}
+	return *mAssets[asset].stagedMesh.value;
+}
+
+bool assetLoaderGetMeshData(AssetHandle asset, AssetMeshData& data)
+{
+	if (kAssetInvalid == asset || !mAssets[asset].resident) {
+		return false;
+	}
+	const AssetGeometry& geometry = *mAssets[asset].geometry.value;
+	data.positions = geometry.positions.data();
+	data.numVertices = static_cast<uint32_t>(geometry.positions.size());
+	data.indices = geometry.indices.data();
+	data.numIndices = static_cast<uint32_t>(geometry.indices.size());
+	data.boundsMin = geometry.boundsMin;
+	data.boundsMax = geometry.boundsMax;
+	data.occluderPositions = geometry.occluder.positions.data();
+	data.occluderIndices = geometry.occluder.indices.data();
+	data.numOccluderIndices = static_cast<uint32_t>(geometry.occluder.indices.size());
+	data.numOccluderPieceIndices = geometry.occluder.numPieceIndices;
+	return true;
+}
+
+uint32_t assetLoaderGetNumPending()
+{
+	return mNumPending;
+}
+
+void assetLoaderDestroy()
+{
+	for (const Asset& asset : mAssets) {
+		if (kGeometryPoolInvalidMesh != *asset.stagedMesh.value) {
+			geometryPoolRemoveMesh(*asset.stagedMesh.value);
+		}
+	}
+	mAssets.clear();
+	mNumPending = 0;
+	mStagingDependency = nullptr;
+}
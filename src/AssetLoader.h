@@ -0,0 +1,115 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include "GeometryPool.h"
+#include "JobSystem.h"
+#include "OcclusionCuller.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/* --------------------------------------------- */
+// Asset Loader
+//
+// Loads meshes asynchronously on the job system. Every load is a chain of
+// jobs, each of which depends on the previous one and takes over its result
+// through a future (see jobSystemAsync):
+//  1. Parse:    read the file (or generate the geometry) on a worker thread
+//  2. Optimize: weld duplicate vertices and remap the indices, and build the
+//               mesh's occluder (see occlusionCullerBuildOccluder)
+//  3. Stage:    copy the geometry into the geometry pool's mapped memory
+//  4. Publish:  on the main thread, mark the mesh as resident
+// Until a mesh is resident, assetLoaderGetMesh returns kGeometryPoolInvalidMesh,
+// so the renderer can draw a placeholder in the meantime. Since residency only
+// changes on the main thread, the renderer never sees a mesh mid-frame.
+// A CPU copy of every resident mesh, its bounding box, and its occluder are
+// kept for occlusion culling.
+/* --------------------------------------------- */
+
+//! Handle to a mesh asset
+typedef uint32_t AssetHandle;
+
+//! An invalid asset handle, e.g., for scene graph nodes without a mesh
+constexpr AssetHandle kAssetInvalid = 0xFFFFFFFFu;
+
+//! Produces a mesh's vertex positions and triangle list indices. Invoked on a worker thread.
+typedef std::function<void(std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices)> AssetParseFunction;
+
+/*!
+ *	Starts loading a mesh from a model file (everything which vklLoadModelGeometry supports).
+ *	The job system and the geometry pool (or a fence for it, see assetLoaderSetStagingDependency) must have been created.
+ *	Must be called from the main thread.
+ *	@param	name	Name of the mesh, used for log messages and profiler zones. Must stay valid until the loader is destroyed.
+ *	@param	path	Path to the model file. Must stay valid until the mesh is resident.
+ *	@return	Handle to the asset, which becomes resident later.
+ */
+AssetHandle assetLoaderLoadMesh(const char* name, const char* path);
+
+/*!
+ *	Starts loading a mesh whose geometry is produced by the given function, e.g., procedural geometry.
+ *	@param	name	Name of the mesh. Must stay valid until the loader is destroyed.
+ *	@param	parse	Function which produces the geometry on a worker thread
+ *	@return	Handle to the asset, which becomes resident later.
+ */
+AssetHandle assetLoaderLoadMesh(const char* name, AssetParseFunction parse);
+
+/*!
+ *	Makes the stage jobs of all loads which start afterwards wait for the given job, too. With a fence (see
+ *	jobSystemCreateFence) which is signaled once the geometry pool exists, loads can start before it.
+ *	@param	job		The job to wait for, or nullptr to stage right after optimizing again
+ */
+void assetLoaderSetStagingDependency(const JobHandle& job);
+
+/*!
+ *	Returns the asset's mesh in the geometry pool if it is resident, kGeometryPoolInvalidMesh otherwise.
+ *	Must be called from the main thread.
+ */
+GeometryPoolMesh assetLoaderGetMesh(AssetHandle asset);
+
+/*!
+ *	The CPU copy of a resident mesh's geometry, after welding.
+ */
+struct AssetMeshData {
+	const glm::vec3* positions;
+	uint32_t         numVertices;
+	const uint32_t*  indices;
+	uint32_t         numIndices;
+
+	//! Axis-aligned bounding box of the positions
+	glm::vec3        boundsMin;
+	glm::vec3        boundsMax;
+
+	//! The simplified triangle list which occludes other meshes. numOccluderIndices is 0 if the mesh does not occlude anything.
+	const glm::vec3* occluderPositions;
+	const uint32_t*  occluderIndices;
+	uint32_t         numOccluderIndices;
+	uint32_t         numOccluderPieceIndices;
+};
+
+/*!
+ *	Returns the CPU copy of the asset's geometry if it is resident. The pointers stay valid until the loader is destroyed.
+ *	Must be called from the main thread.
+ *	@return	True if the asset is resident and data has been written, false otherwise.
+ */
+bool assetLoaderGetMeshData(AssetHandle asset, AssetMeshData& data);
+
+/*!
+ *	Returns the number of assets which are still loading. Must be called from the main thread.
+ */
+uint32_t assetLoaderGetNumPending();
+
+/*!
+ *	Merges all vertices with identical positions and remaps the indices. This is the loader's optimize step,
+ *	which runs on a worker thread for every mesh.
+ *	@param	positions	Vertex positions; receives the unique positions in order of their first occurrence
+ *	@param	indices		Triangle list indices into positions; remapped in place
+ */
+void assetLoaderWeldVertices(std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices);
+
+/*!
+ *	Removes all loaded meshes from the geometry pool and forgets all assets.
+ *	The job system must have finished all loads, i.e., call this after jobSystemDestroy.
+ */
+void assetLoaderDestroy();
@@ -0,0 +1,55 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "CameraPath.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <iomanip>
+
+bool cameraPathLoad(const char* path, std::vector<glm::mat4>& matrices)
+{
+	std::ifstream file(path);
+	if (!file) {
+		return false;
+	}
+
+	matrices.clear();
+	std::string line;
+	while (std::getline(file, line)) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		std::istringstream values(line);
+		glm::mat4 m;
+		for (int column = 0; column < 4; ++column) {
+			for (int row = 0; row < 4; ++row) {
+				values >> m[column][row];
+			}
+		}
+		if (values.fail()) {
+			return false;
+		}
+		matrices.push_back(m);
+	}
+	return !matrices.empty();
+}
+
+bool cameraPathSave(const char* path, const std::vector<glm::mat4>& matrices)
+{
+	std::ofstream file(path);
+	if (!file) {
+		return false;
+	}
+
+	file << "# Camera path: one view-projection matrix per frame, 16 floats in column-major order\n";
+	file << std::setprecision(9);
+	for (const glm::mat4& m : matrices) {
+		for (int column = 0; column < 4; ++column) {
+			for (int row = 0; row < 4; ++row) {
+				file << m[column][row] << ((column == 3 && row == 3) ? '\n' : ' ');
+			}
+		}
+	}
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+
+/* --------------------------------------------- */
+// Camera Paths
+//
+// A camera path is a sequence of view-projection matrices, one per frame.
+// Paths are recorded from interactive sessions and replayed frame-exact,
+// so that benchmark runs always see the same views.
+//
+// File format: plain text, one frame per line, each consisting of the 16
+// floats of the view-projection matrix in column-major order (i.e., in
+// glm's memory layout). Empty lines and lines starting with '#' are ignored.
+/* --------------------------------------------- */
+
+/*!
+ *	Loads a camera path from the given file.
+ *	@param	path		Path of the file to load
+ *	@param	matrices	Receives the view-projection matrices of all frames
+ *	@return	True if the file could be read and contains at least one frame, false otherwise.
+ */
+bool cameraPathLoad(const char* path, std::vector<glm::mat4>& matrices);
+
+/*!
+ *	Saves a camera path to the given file.
+ *	@param	path		Path of the file to write
+ *	@param	matrices	The view-projection matrices of all frames
+ *	@return	True on success, false if the file could not be written.
+ */
+bool cameraPathSave(const char* path, const std::vector<glm::mat4>& matrices);
@@ -0,0 +1,238 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "ClusteredLighting.h"
+#include "RenderGraph.h"
+#include "VulkanHelpers.h"
+#include <VulkanLaunchpad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	// One invocation per cluster. Must match local_size_x in shaders/light_culling.shader:
+	constexpr uint32_t kWorkgroupSize = 64;
+
+	// Must match the push constants in shaders/light_culling.shader:
+	struct PushConstants {
+		glm::mat4 viewProjection;
+		//! xy: reciprocal of the projection's x and y scale, z: near depth of the slices, w: far depth of the slices
+		glm::vec4 inverseProjectionScaleAndDepthRange;
+		//! xyz: grid size, w: number of lights
+		uint32_t gridAndNumLights[4];
+		//! x: index of the view's first cluster in the cluster buffer, yzw: unused
+		uint32_t firstCluster[4];
+	};
+
+	struct DeviceBuffer {
+		VkBuffer       buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+	};
+
+	VkDevice mDevice = VK_NULL_HANDLE;
+	VkPipeline mPipeline = VK_NULL_HANDLE;
+	VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
+	std::vector<HlpMappedBuffer> mLightBuffers;
+	std::vector<DeviceBuffer> mClusterBuffers;
+	std::vector<HlpMappedBuffer> mOverflowBuffers;
+	uint32_t mNumOverflowedClusters = 0;
+	std::vector<VkDescriptorSet> mDescriptorSets;
+	RenderGraphResource mClusterResource = 0;
+	uint32_t mCurrentFrame = 0;
+	std::vector<PushConstants> mPushConstants;
+
+	DeviceBuffer createDeviceLocalBuffer(VkPhysicalDevice physical_device, VkDeviceSize size, VkBufferUsageFlags usage, const char* name)
+	{
+		DeviceBuffer device_buffer;
+		VkBufferCreateInfo buffer_create_info = {};
+		buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer_create_info.size = size;
+		buffer_create_info.usage = usage;
+		buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		VkResult result = vkCreateBuffer(mDevice, &buffer_create_info, nullptr, &device_buffer.buffer);
+		VKL_CHECK_VULKAN_RESULT(result);
+
+		VkMemoryRequirements memory_requirements;
+		vkGetBufferMemoryRequirements(mDevice, device_buffer.buffer, &memory_requirements);
+		VkMemoryAllocateInfo memory_allocate_info = {};
+		memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		memory_allocate_info.allocationSize = memory_requirements.size;
+		memory_allocate_info.memoryTypeIndex = hlpFindMemoryTypeIndex(physical_device, memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		result = MEMORY_TRACKER_ALLOCATE(mDevice, &memory_allocate_info, &device_buffer.memory, MEMORY_CATEGORY_LIGHTING, name);
+		VKL_CHECK_VULKAN_RESULT(result);
+		result = vkBindBufferMemory(mDevice, device_buffer.buffer, device_buffer.memory, 0);
+		VKL_CHECK_VULKAN_RESULT(result);
+		hlpSetDebugUtilsObjectName(mDevice, VK_OBJECT_TYPE_BUFFER, (uint64_t)device_buffer.buffer, name);
+		return device_buffer;
+	}
+
+	void recordLightCulling(VkCommandBuffer command_buffer)
+	{
+		vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, mPipeline);
+		vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, hlpGetPipelineLayout(mPipeline), 0, 1,
+			&mDescriptorSets[mCurrentFrame], 0, nullptr);
+		// One dispatch per view. They write disjoint clusters and only read the lights, hence need no barriers in between:
+		for (const PushConstants& push_constants : mPushConstants) {
+			vkCmdPushConstants(command_buffer, hlpGetPipelineLayout(mPipeline), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &push_constants);
+			vkCmdDispatch(command_buffer, (kNumClusters + kWorkgroupSize - 1) / kWorkgroupSize, 1, 1);
+		}
+
+		// The overflow counts are read by the host after the frame's fence has been waited for:
+		VkMemoryBarrier memory_barrier = {};
+		memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		memory_barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &memory_barrier, 0, nullptr, 0, nullptr);
+	}
+}
+
+void clusteredLightingCreate(VkPhysicalDevice physical_device, VkDevice device, uint32_t num_frames, uint32_t num_views)
+{
+	mDevice = device;
+	mPushConstants.assign(std::max(num_views, 1u), PushConstants{});
+
+	VkDescriptorSetLayoutBinding light_binding = {};
+	light_binding.binding = 0;
+	light_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	light_binding.descriptorCount = 1;
+	light_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	VkDescriptorSetLayoutBinding cluster_binding = light_binding;
+	cluster_binding.binding = 1;
+	VkDescriptorSetLayoutBinding overflow_binding = light_binding;
+	overflow_binding.binding = 2;
+	mPipeline = hlpCreateComputePipeline(device, SHADER_BINARY_DIR "/light_culling.spv", { light_binding, cluster_binding, overflow_binding }, sizeof(PushConstants));
+	hlpSetDebugUtilsObjectName(device, VK_OBJECT_TYPE_PIPELINE, (uint64_t)mPipeline, "Light Culling Pipeline");
+
+	VkDescriptorPoolSize pool_size = {};
+	pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	pool_size.descriptorCount = 3 * num_frames;
+	VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
+	descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptor_pool_create_info.maxSets = num_frames;
+	descriptor_pool_create_info.poolSizeCount = 1;
+	descriptor_pool_create_info.pPoolSizes = &pool_size;
+	VkResult result = vkCreateDescriptorPool(device, &descriptor_pool_create_info, nullptr, &mDescriptorPool);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	const VkDescriptorSetLayout descriptor_set_layout = hlpGetDescriptorSetLayout(mPipeline);
+	const std::vector<VkDescriptorSetLayout> descriptor_set_layouts(num_frames, descriptor_set_layout);
+	VkDescriptorSetAllocateInfo descriptor_set_alloc_info = {};
+	descriptor_set_alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptor_set_alloc_info.descriptorPool = mDescriptorPool;
+	descriptor_set_alloc_info.descriptorSetCount = num_frames;
+	descriptor_set_alloc_info.pSetLayouts = descriptor_set_layouts.data();
+	mDescriptorSets.resize(num_frames);
+	result = vkAllocateDescriptorSets(device, &descriptor_set_alloc_info, mDescriptorSets.data());
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	// Lights are written by the host every frame, cluster lists only by the GPU:
+	const VkDeviceSize cluster_buffer_size = sizeof(uint32_t) * mPushConstants.size() * kNumClusters * (1 + kClusterMaxLights);
+	for (uint32_t i = 0; i < num_frames; ++i) {
+		mLightBuffers.push_back(hlpCreateMappedBuffer(physical_device, device, sizeof(ClusteredLight) * kClusteredLightingMaxLights,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, MEMORY_CATEGORY_LIGHTING, "Light Buffer"));
+		mClusterBuffers.push_back(createDeviceLocalBuffer(physical_device, cluster_buffer_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, "Cluster Light Lists"));
+		mOverflowBuffers.push_back(hlpCreateMappedBuffer(physical_device, device, 2 * sizeof(uint32_t),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, MEMORY_CATEGORY_READBACK, "Cluster Overflow Counts"));
+		memset(mOverflowBuffers[i].mappedData, 0, 2 * sizeof(uint32_t));
+
+		VkDescriptorBufferInfo buffer_infos[3] = {};
+		buffer_infos[0].buffer = mLightBuffers[i].buffer;
+		buffer_infos[0].range = VK_WHOLE_SIZE;
+		buffer_infos[1].buffer = mClusterBuffers[i].buffer;
+		buffer_infos[1].range = VK_WHOLE_SIZE;
+		buffer_infos[2].buffer = mOverflowBuffers[i].buffer;
+		buffer_infos[2].range = VK_WHOLE_SIZE;
+		VkWriteDescriptorSet write_descriptor_set = {};
+		write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write_descriptor_set.dstSet = mDescriptorSets[i];
+		write_descriptor_set.dstBinding = 0;
+		write_descriptor_set.descriptorCount = 3;
+		write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		write_descriptor_set.pBufferInfo = buffer_infos;
+		vkUpdateDescriptorSets(device, 1, &write_descriptor_set, 0, nullptr);
+	}
+
+	// The cluster lists are consumed by the fragment shaders of the framework's render pass:
+	mClusterResource = renderGraphImportBuffer("Cluster Light Lists", mClusterBuffers[0].buffer);
+	const RenderGraphPass pass = renderGraphAddPass("Light Culling", recordLightCulling);
+	renderGraphUseResource(pass, mClusterResource, RENDER_GRAPH_USAGE_STORAGE_WRITE_COMPUTE);
+	renderGraphMarkOutput(mClusterResource, RENDER_GRAPH_USAGE_STORAGE_READ_GRAPHICS);
+}
+
+void clusteredLightingDestroy()
+{
+	for (HlpMappedBuffer& light_buffer : mLightBuffers) {
+		hlpDestroyMappedBuffer(mDevice, light_buffer);
+	}
+	for (DeviceBuffer& cluster_buffer : mClusterBuffers) {
+		vkDestroyBuffer(mDevice, cluster_buffer.buffer, nullptr);
+		memoryTrackerFree(mDevice, cluster_buffer.memory);
+	}
+	for (HlpMappedBuffer& overflow_buffer : mOverflowBuffers) {
+		hlpDestroyMappedBuffer(mDevice, overflow_buffer);
+	}
+	mLightBuffers.clear();
+	mClusterBuffers.clear();
+	mOverflowBuffers.clear();
+	mNumOverflowedClusters = 0;
+	mDescriptorSets.clear();
+	mPushConstants.clear();
+	vkDestroyDescriptorPool(mDevice, mDescriptorPool, nullptr);
+	hlpDestroyGraphicsPipeline(mDevice, mPipeline);
+	mDescriptorPool = VK_NULL_HANDLE;
+	mPipeline = VK_NULL_HANDLE;
+	mDevice = VK_NULL_HANDLE;
+}
+
+void clusteredLightingUpdate(uint32_t frame_index, const ClusteredLight* lights, uint32_t num_lights, const glm::mat4* view_projections)
+{
+	num_lights = std::min(num_lights, kClusteredLightingMaxLights);
+	memcpy(mLightBuffers[frame_index].mappedData, lights, sizeof(ClusteredLight) * num_lights);
+
+	// The GPU has finished the frame which last used this slot, since its light buffer may be overwritten.
+	// Its overflow counts are read and reset for this frame:
+	uint32_t* overflow_counts = static_cast<uint32_t*>(mOverflowBuffers[frame_index].mappedData);
+	if (overflow_counts[0] != mNumOverflowedClusters) {
+		if (overflow_counts[0] > 0) {
+			VKL_LOG("Light culling: " << overflow_counts[0] << " clusters are touched by more than " << kClusterMaxLights
+				<< " lights (up to " << overflow_counts[1] << ") => the lights beyond that are dropped there.");
+		}
+		else {
+			VKL_LOG("Light culling: no cluster is touched by more than " << kClusterMaxLights << " lights anymore.");
+		}
+		mNumOverflowedClusters = overflow_counts[0];
+	}
+	overflow_counts[0] = 0;
+	overflow_counts[1] = 0;
+
+	// For a symmetric perspective projection, the first two rows of the view-projection matrix are the view matrix'
+	// rows scaled by the projection's x and y scale, respectively. The rows of a view matrix have unit length:
+	for (uint32_t view = 0; view < mPushConstants.size(); ++view) {
+		const glm::mat4& view_projection = view_projections[view];
+		const float scale_x = std::sqrt(view_projection[0][0] * view_projection[0][0] + view_projection[1][0] * view_projection[1][0] + view_projection[2][0] * view_projection[2][0]);
+		const float scale_y = std::sqrt(view_projection[0][1] * view_projection[0][1] + view_projection[1][1] * view_projection[1][1] + view_projection[2][1] * view_projection[2][1]);
+		PushConstants& push_constants = mPushConstants[view];
+		push_constants.viewProjection = view_projection;
+		push_constants.inverseProjectionScaleAndDepthRange = glm::vec4(1.0f / scale_x, 1.0f / scale_y, kClusterNearDepth, kClusterFarDepth);
+		push_constants.gridAndNumLights[0] = kClusterGridX;
+		push_constants.gridAndNumLights[1] = kClusterGridY;
+		push_constants.gridAndNumLights[2] = kClusterGridZ;
+		push_constants.gridAndNumLights[3] = num_lights;
+		push_constants.firstCluster[0] = view * kNumClusters;
+	}
+
+	mCurrentFrame = frame_index;
+	renderGraphSetImportedBuffer(mClusterResource, mClusterBuffers[frame_index].buffer);
+}
+
+VkBuffer clusteredLightingGetLightBuffer(uint32_t frame_index)
+{
+	return mLightBuffers[frame_index].buffer;
+}
+
+VkBuffer clusteredLightingGetClusterBuffer(uint32_t frame_index)
+{
+	return mClusterBuffers[frame_index].buffer;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+
+/* --------------------------------------------- */
+// Clustered Lighting
+//
+// Point lights are binned into a grid of froxels (clusters), i.e., screen
+// tiles which are subdivided into depth slices. Slices are spaced
+// exponentially in view depth, so that clusters are roughly cube-shaped.
+// A compute pass of the render graph tests every light's bounding sphere
+// against every cluster's view space bounding box and writes a list of light
+// indices per cluster. The fragment shader then only iterates over the lights
+// of the cluster which the fragment lies in (see shaders/fragment.shader with
+// CLUSTERED_LIGHTING defined).
+//
+// View space is derived from the view-projection matrix alone, which is
+// assumed to be a symmetric perspective projection. Hence, the same code
+// works for the interactive camera and for replayed camera paths.
+//
+// With multiview, every view has clusters of its own, which are culled with
+// the view's view-projection matrix and follow each other in the cluster
+// buffer. Fragments select them with gl_ViewIndex.
+//
+// Lights and cluster lists exist once per frame in flight. The compute pass
+// also counts the clusters which more than kClusterMaxLights lights touch.
+// The counts are read back once the frame's slot is reused, and logged
+// whenever they change.
+/* --------------------------------------------- */
+
+//! Number of screen tiles in x and y, and number of depth slices. Must match shaders/fragment.shader.
+constexpr uint32_t kClusterGridX = 16;
+constexpr uint32_t kClusterGridY = 9;
+constexpr uint32_t kClusterGridZ = 24;
+constexpr uint32_t kNumClusters = kClusterGridX * kClusterGridY * kClusterGridZ;
+
+//! Lights per cluster. Further lights which touch a cluster are dropped, which is logged. Must match shaders/fragment.shader.
+constexpr uint32_t kClusterMaxLights = 255;
+
+//! View depth range of the depth slices. The first slice extends to the camera, the last one to infinity.
+//! Must match shaders/fragment.shader.
+constexpr float kClusterNearDepth = 0.1f;
+constexpr float kClusterFarDepth = 100.0f;
+
+//! Maximum number of lights
+constexpr uint32_t kClusteredLightingMaxLights = 4096;
+
+/*!
+ *	A point light in world space. Layout matches the shaders' std430 Light struct.
+ */
+struct ClusteredLight {
+	//! xyz: position, w: radius beyond which the light has no effect
+	glm::vec4 positionRadius;
+
+	//! rgb: color multiplied by intensity, w: unused
+	glm::vec4 color;
+};
+
+/*!
+ *	Creates the light and cluster buffers and the light culling compute pipeline, and adds the
+ *	"Light Culling" pass to the render graph. Must be called after renderGraphCreate and before renderGraphCompile.
+ *	@param	physical_device		Physical device, used to select memory types
+ *	@param	device				Device handle
+ *	@param	num_frames			Number of frames which can be in flight at the same time
+ *	@param	num_views			Number of views of a multiview render pass, 1 otherwise
+ */
+void clusteredLightingCreate(VkPhysicalDevice physical_device, VkDevice device, uint32_t num_frames, uint32_t num_views);
+
+/*!
+ *	Destroys all buffers and the pipeline. The device must be idle.
+ */
+void clusteredLightingDestroy();
+
+/*!
+ *	Uploads the lights of a frame and prepares the light culling pass. Call this every frame before renderGraphExecute.
+ *	@param	frame_index			Index of the frame in flight, between 0 and num_frames - 1
+ *	@param	lights				The lights in world space
+ *	@param	num_lights			Number of lights, at most kClusteredLightingMaxLights
+ *	@param	view_projections	Every view's view-projection matrix, i.e., num_views matrices
+ */
+void clusteredLightingUpdate(uint32_t frame_index, const ClusteredLight* lights, uint32_t num_lights, const glm::mat4* view_projections);
+
+/*!
+ *	Returns the buffer which holds the lights of the given frame, i.e., an array of ClusteredLight.
+ */
+VkBuffer clusteredLightingGetLightBuffer(uint32_t frame_index);
+
+/*!
+ *	Returns the buffer which holds the light lists of the given frame: per cluster, the number of
+ *	lights, followed by kClusterMaxLights light indices. The kNumClusters clusters of every view follow each other.
+ */
+VkBuffer clusteredLightingGetClusterBuffer(uint32_t frame_index);
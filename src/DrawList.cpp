@@ -0,0 +1,176 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "DrawList.h"
+#include "VulkanHelpers.h"
+#include "GpuProfiler.h"
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	constexpr uint32_t kRadixBits = 8;
+	constexpr uint32_t kRadixSize = 1u << kRadixBits;
+	constexpr uint32_t kNumRadixPasses = 64 / kRadixBits;
+
+	inline uint32_t passOfKey(uint64_t key)
+	{
+		return static_cast<uint32_t>(key >> 60);
+	}
+}
+
+uint64_t drawListMakeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+{
+	assert(pass < kDrawListMaxPasses && pipeline < kDrawListMaxPipelines && material < kDrawListMaxMaterials && mesh < kDrawListMaxMeshes);
+	const float clamped_depth = std::min(std::max(depth, 0.0f), 1.0f);
+	const uint64_t quantized_depth = static_cast<uint64_t>(clamped_depth * 65535.0f + 0.5f);
+	return (static_cast<uint64_t>(pass) << 60)
+		| (static_cast<uint64_t>(pipeline) << 48)
+		| (static_cast<uint64_t>(material) << 32)
+		| (static_cast<uint64_t>(mesh) << 16)
+		| quantized_depth;
+}
+
+void drawListSetPassName(DrawList& draw_list, uint32_t pass, const char* name)
+{
+	assert(pass < kDrawListMaxPasses);
+	draw_list.passNames[pass] = name;
+}
+
+void drawListReset(DrawList& draw_list)
+{
+	draw_list.packets.clear();
+	draw_list.keys.clear();
+	draw_list.order.clear();
+}
+
+void drawListAdd(DrawList& draw_list, const DrawPacket& packet)
+{
+	draw_list.order.push_back(static_cast<uint32_t>(draw_list.packets.size()));
+	draw_list.keys.push_back(packet.sortKey);
+	draw_list.packets.push_back(packet);
+}
+
+void drawListSort(DrawList& draw_list)
+{
+	const size_t num_keys = draw_list.keys.size();
+	if (num_keys < 2) {
+		return;
+	}
+	draw_list.scratchKeys.resize(num_keys);
+	draw_list.scratchOrder.resize(num_keys);
+
+	// Histograms of all digits are gathered in one single pass over the keys:
+	uint32_t histograms[kNumRadixPasses][kRadixSize] = {};
+	for (uint64_t key : draw_list.keys) {
+		for (uint32_t p = 0; p < kNumRadixPasses; ++p) {
+			++histograms[p][(key >> (p * kRadixBits)) & (kRadixSize - 1)];
+		}
+	}
+
+	uint64_t* keys = draw_list.keys.data();
+	uint32_t* order = draw_list.order.data();
+	uint64_t* scratch_keys = draw_list.scratchKeys.data();
+	uint32_t* scratch_order = draw_list.scratchOrder.data();
+	for (uint32_t p = 0; p < kNumRadixPasses; ++p) {
+		// If all keys have the same digit (e.g., unused material bits), this pass would not change anything:
+		const uint32_t shift = p * kRadixBits;
+		if (histograms[p][(keys[0] >> shift) & (kRadixSize - 1)] == num_keys) {
+			continue;
+		}
+
+		uint32_t offsets[kRadixSize];
+		uint32_t sum = 0;
+		for (uint32_t d = 0; d < kRadixSize; ++d) {
+			offsets[d] = sum;
+			sum += histograms[p][d];
+		}
+		for (size_t i = 0; i < num_keys; ++i) {
+			const uint32_t destination = offsets[(keys[i] >> shift) & (kRadixSize - 1)]++;
+			scratch_keys[destination] = keys[i];
+			scratch_order[destination] = order[i];
+		}
+		std::swap(keys, scratch_keys);
+		std::swap(order, scratch_order);
+	}
+
+	// After an odd number of scatter passes, the sorted sequence resides in the scratch vectors:
+	if (keys != draw_list.keys.data()) {
+		draw_list.keys.swap(draw_list.scratchKeys);
+		draw_list.order.swap(draw_list.scratchOrder);
+	}
+}
+
+DrawListStatistics drawListSubmit(const DrawList& draw_list, VkCommandBuffer command_buffer, bool profile_passes)
+{
+	DrawListStatistics statistics = {};
+	VkPipeline bound_pipeline = VK_NULL_HANDLE;
+	VkDescriptorSet bound_descriptor_set = VK_NULL_HANDLE;
+	VkBuffer bound_vertex_buffer = VK_NULL_HANDLE;
+	VkBuffer bound_instance_buffer = VK_NULL_HANDLE;
+	VkBuffer bound_index_buffer = VK_NULL_HANDLE;
+	const char* open_pass_name = nullptr;
+	uint32_t current_pass = kDrawListMaxPasses;
+	const VkDeviceSize zero_offset = 0;
+
+	for (size_t i = 0; i < draw_list.order.size(); ++i) {
+		const DrawPacket& packet = draw_list.packets[draw_list.order[i]];
+
+		const uint32_t pass = passOfKey(draw_list.keys[i]);
+		if (pass != current_pass) {
+			if (nullptr != open_pass_name) {
+				if (profile_passes) {
+					gpuProfilerEndScope(command_buffer);
+				}
+				hlpEndDebugUtilsLabel(command_buffer);
+			}
+			current_pass = pass;
+			open_pass_name = draw_list.passNames[pass];
+			if (nullptr != open_pass_name) {
+				hlpBeginDebugUtilsLabel(command_buffer, open_pass_name);
+				if (profile_passes) {
+					gpuProfilerBeginScope(command_buffer, open_pass_name);
+				}
+			}
+		}
+
+		if (packet.pipeline != bound_pipeline) {
+			vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, packet.pipeline);
+			bound_pipeline = packet.pipeline;
+			++statistics.numPipelineBinds;
+		}
+		// Descriptor sets stay bound across pipeline changes as long as the pipeline layouts are compatible,
+		// i.e., have identically defined descriptor set layouts, which holds for all our pipelines:
+		if (VK_NULL_HANDLE != packet.descriptorSet && packet.descriptorSet != bound_descriptor_set) {
+			hlpBindDescriptorSetToPipeline(command_buffer, packet.descriptorSet, packet.pipeline);
+			bound_descriptor_set = packet.descriptorSet;
+			++statistics.numDescriptorSetBinds;
+		}
+		if (packet.vertexBuffer != bound_vertex_buffer) {
+			vkCmdBindVertexBuffers(command_buffer, 0, 1, &packet.vertexBuffer, &zero_offset);
+			bound_vertex_buffer = packet.vertexBuffer;
+			++statistics.numVertexBufferBinds;
+		}
+		if (VK_NULL_HANDLE != packet.instanceBuffer && packet.instanceBuffer != bound_instance_buffer) {
+			vkCmdBindVertexBuffers(command_buffer, 1, 1, &packet.instanceBuffer, &zero_offset);
+			bound_instance_buffer = packet.instanceBuffer;
+			++statistics.numVertexBufferBinds;
+		}
+		if (packet.indexBuffer != bound_index_buffer) {
+			vkCmdBindIndexBuffer(command_buffer, packet.indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+			bound_index_buffer = packet.indexBuffer;
+			++statistics.numIndexBufferBinds;
+		}
+
+		vkCmdDrawIndexed(command_buffer, packet.indexCount, packet.instanceCount, packet.firstIndex, packet.vertexOffset, packet.firstInstance);
+		++statistics.numDraws;
+	}
+
+	if (nullptr != open_pass_name) {
+		if (profile_passes) {
+			gpuProfilerEndScope(command_buffer);
+		}
+		hlpEndDebugUtilsLabel(command_buffer);
+	}
+	return statistics;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+
+/* --------------------------------------------- */
+// Draw List
+//
+// Draws are queued as packets, each of which carries a 64-bit sort key:
+//
+//   | pass (4) | pipeline (12) | material (16) | mesh (16) | depth (16) |
+//
+// Sorting by key groups draws by pass first, then by pipeline, material
+// (i.e., descriptor set), and mesh, and orders draws front-to-back within
+// such a group. Keys are sorted with an LSD radix sort, which is linear in
+// the number of draws. When the sorted list is submitted, every bind which
+// would not change the bound state is skipped.
+/* --------------------------------------------- */
+
+constexpr uint32_t kDrawListMaxPasses = 1u << 4;
+constexpr uint32_t kDrawListMaxPipelines = 1u << 12;
+constexpr uint32_t kDrawListMaxMaterials = 1u << 16;
+constexpr uint32_t kDrawListMaxMeshes = 1u << 16;
+
+/*!
+ *	Everything required to record one indexed draw call.
+ *	Pipelines must have been created with hlpCreateGraphicsPipeline.
+ */
+struct DrawPacket {
+	//! Sort key, as returned by drawListMakeSortKey
+	uint64_t sortKey;
+
+	//! The graphics pipeline to draw with
+	VkPipeline pipeline;
+
+	//! Descriptor set which is bound to set 0, or VK_NULL_HANDLE
+	VkDescriptorSet descriptorSet;
+
+	//! Vertex buffer which is bound to binding 0
+	VkBuffer vertexBuffer;
+
+	//! Per-instance vertex buffer which is bound to binding 1, or VK_NULL_HANDLE
+	VkBuffer instanceBuffer;
+
+	//! Index buffer with 32-bit indices
+	VkBuffer indexBuffer;
+
+	//! Parameters of vkCmdDrawIndexed
+	uint32_t indexCount;
+	uint32_t instanceCount;
+	uint32_t firstIndex;
+	int32_t  vertexOffset;
+	uint32_t firstInstance;
+};
+
+/*!
+ *	Number of draws and binds of the most recent drawListSubmit call.
+ */
+struct DrawListStatistics {
+	uint32_t numDraws;
+	uint32_t numPipelineBinds;
+	uint32_t numDescriptorSetBinds;
+	uint32_t numVertexBufferBinds;
+	uint32_t numIndexBufferBinds;
+};
+
+/*!
+ *	A queue of draw packets. Reset it, add packets, sort it, and submit it every frame.
+ *	The vectors keep their capacity across frames, so no allocations happen in steady state.
+ */
+struct DrawList {
+	//! All packets in the order in which they have been added
+	std::vector<DrawPacket> packets;
+
+	//! Sort keys and packet indices; sorted by key after drawListSort
+	std::vector<uint64_t> keys;
+	std::vector<uint32_t> order;
+
+	//! Scratch space for the radix sort's ping-pong passes
+	std::vector<uint64_t> scratchKeys;
+	std::vector<uint32_t> scratchOrder;
+
+	//! Names of passes, used for debug labels and GPU profiler scopes. nullptr for unnamed passes.
+	const char* passNames[kDrawListMaxPasses] = {};
+};
+
+/*!
+ *	Assembles a sort key. Every id must be smaller than the respective kDrawListMax* constant.
+ *	@param	pass		The pass which the draw belongs to. Passes are submitted in ascending order.
+ *	@param	pipeline	A small integer which identifies the draw's pipeline
+ *	@param	material	A small integer which identifies the draw's descriptor set
+ *	@param	mesh		A small integer which identifies the draw's vertex and index buffers
+ *	@param	depth		The draw's normalized depth in [0, 1]. Smaller depths are drawn first.
+ *	@return	The sort key
+ */
+uint64_t drawListMakeSortKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth);
+
+/*!
+ *	Assigns a name to a pass. Submitting a pass is then wrapped in a debug label and a GPU profiler scope.
+ *	@param	name	Name of the pass. Must stay valid for as long as the draw list is used.
+ */
+void drawListSetPassName(DrawList& draw_list, uint32_t pass, const char* name);
+
+/*!
+ *	Removes all packets.
+ */
+void drawListReset(DrawList& draw_list);
+
+/*!
+ *	Queues a draw packet.
+ */
+void drawListAdd(DrawList& draw_list, const DrawPacket& packet);
+
+/*!
+ *	Sorts all packets by their sort keys with an LSD radix sort. The sort is stable, i.e., packets with
+ *	equal keys are submitted in the order in which they have been added.
+ */
+void drawListSort(DrawList& draw_list);
+
+/*!
+ *	Records all packets in sorted order into the given command buffer. Pipelines, descriptor sets,
+ *	vertex buffers, and index buffers are only bound if they differ from the currently bound ones.
+ *	The command buffer's bound state is unknown at the beginning, so the first packet binds everything.
+ *	@param	draw_list		The draw list, sorted with drawListSort
+ *	@param	command_buffer	A command buffer inside a render pass
+ *	@param	profile_passes	Whether GPU profiler scopes are recorded per pass. Disable this when the same frame is recorded a second time.
+ *	@return	Number of draws and binds which have been recorded
+ */
+DrawListStatistics drawListSubmit(const DrawList& draw_list, VkCommandBuffer command_buffer, bool profile_passes = true);
@@ -0,0 +1,421 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "DynamicResolution.h"
+#include "GpuProfiler.h"
+#include "VulkanHelpers.h"
+#include <VulkanLaunchpad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace
+{
+	// The scale changes in steps of this size, so that small fluctuations cannot change it:
+	constexpr float kScaleStep = 0.05f;
+	// Frame times within this fraction of the target leave the scale as it is:
+	constexpr double kDeadBand = 0.1;
+	// Number of frames in a row which must be above or below the dead band before the scale is decreased or increased.
+	// Increasing is more cautious, since a frame which misses the target is worse than one which is rendered too small:
+	constexpr uint32_t kFramesToDecrease = 3;
+	constexpr uint32_t kFramesToIncrease = 30;
+	// After a change, this many frame times still belong to frames which have been recorded at the previous scale:
+	constexpr uint32_t kSettleFrames = 6;
+
+	// Must match the Parameters block in shaders/upscale.shader:
+	struct UpscaleParameters {
+		float uvScale[2];
+		float texelSize[2];
+		float sharpness;
+		float padding[3];
+	};
+
+	struct Frame {
+		VkCommandBuffer commandBuffer;
+		VkFence fence;
+		HlpMappedBuffer parameters;
+		VkDescriptorSet descriptorSet;
+	};
+
+	struct HistoryEntry {
+		double gpuMilliseconds;
+		float scale;
+	};
+
+	VkDevice mDevice = VK_NULL_HANDLE;
+	VkQueue mQueue = VK_NULL_HANDLE;
+	VkExtent2D mExtent = {};
+
+	HlpImage mColor = {};
+	HlpImage mDepth = {};
+	VkRenderPass mRenderPass = VK_NULL_HANDLE;
+	VkFramebuffer mFramebuffer = VK_NULL_HANDLE;
+	VkSampler mSampler = VK_NULL_HANDLE;
+	VkPipeline mUpscalePipeline = VK_NULL_HANDLE;
+	VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
+	VkCommandPool mCommandPool = VK_NULL_HANDLE;
+	std::vector<Frame> mFrames;
+	uint64_t mFrameNumber = 0;
+	uint32_t mRecordingFrame = 0;
+
+	// Controller state:
+	double mTargetMilliseconds = 16.0;
+	float mMinScale = 0.5f;
+	float mSharpness = 0.5f;
+	float mScale = 1.0f;
+	uint32_t mFramesAbove = 0;
+	uint32_t mFramesBelow = 0;
+	double mStreakMilliseconds = 0.0;
+	uint32_t mFramesToSettle = 0;
+	uint32_t mNumChanges = 0;
+	uint64_t mNumFrames = 0;
+	float mSmallestScale = 1.0f;
+	double mScaleSum = 0.0;
+	bool mRecordHistory = false;
+	std::vector<HistoryEntry> mHistory;
+
+	VkExtent2D scaledExtent(float scale)
+	{
+		return VkExtent2D{
+			std::max(1u, static_cast<uint32_t>(std::lround(scale * static_cast<float>(mExtent.width)))),
+			std::max(1u, static_cast<uint32_t>(std::lround(scale * static_cast<float>(mExtent.height)))),
+		};
+	}
+
+	void changeScale(float scale)
+	{
+		if (scale != mScale) {
+			const VkExtent2D extent = scaledExtent(scale);
+			VKL_LOG("Dynamic resolution: scale " << mScale << " -> " << scale << " (" << extent.width << "x" << extent.height << ")");
+			mScale = scale;
+			mFramesToSettle = kSettleFrames;
+			++mNumChanges;
+		}
+		mFramesAbove = 0;
+		mFramesBelow = 0;
+		mStreakMilliseconds = 0.0;
+	}
+}
+
+void dynamicResolutionCreate(VkPhysicalDevice physical_device, VkDevice device, VkQueue queue, uint32_t queue_family_index,
+	VkFormat color_format, VkFormat depth_format, VkExtent2D extent, VkRenderPass framework_render_pass, uint32_t num_frames,
+	double target_milliseconds, float min_scale, float sharpness, bool record_history)
+{
+	mDevice = device;
+	mQueue = queue;
+	mExtent = extent;
+	mTargetMilliseconds = target_milliseconds;
+	mMinScale = std::min(std::max(min_scale, kScaleStep), 1.0f);
+	mSharpness = std::min(std::max(sharpness, 0.0f), 1.0f);
+	mScale = 1.0f;
+	mFramesAbove = mFramesBelow = 0;
+	mStreakMilliseconds = 0.0;
+	mFramesToSettle = 0;
+	mNumChanges = 0;
+	mNumFrames = 0;
+	mSmallestScale = 1.0f;
+	mScaleSum = 0.0;
+	mRecordHistory = record_history;
+	mHistory.clear();
+	mFrameNumber = 0;
+
+	mColor = hlpCreateImage(physical_device, device, color_format, extent, 1, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_IMAGE_ASPECT_COLOR_BIT, MEMORY_CATEGORY_RENDER_TARGETS, "Dynamic Resolution Color");
+	mDepth = hlpCreateImage(physical_device, device, depth_format, extent, 1, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_IMAGE_ASPECT_DEPTH_BIT,
+		MEMORY_CATEGORY_RENDER_TARGETS, "Dynamic Resolution Depth");
+
+	// The color attachment ends up ready for the upscale to sample it:
+	mRenderPass = hlpCreateOffscreenRenderPass(device, color_format, depth_format, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	mFramebuffer = hlpCreateFramebuffer(device, mRenderPass, mColor.view, mDepth.view, extent);
+
+	// A fullscreen triangle which samples the scene (binding 0) with the parameters of binding 1:
+	mSampler = hlpCreateSampler(device, VK_FILTER_LINEAR, VK_FILTER_LINEAR);
+	VkDescriptorSetLayoutBinding bindings[2] = {};
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bindings[1].descriptorCount = 1;
+	bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	mUpscalePipeline = hlpCreateFullscreenPipeline(device, SHADER_BINARY_DIR "/upscale.spv", { bindings[0], bindings[1] }, framework_render_pass, extent);
+	hlpSetDebugUtilsObjectName(device, VK_OBJECT_TYPE_PIPELINE, (uint64_t)mUpscalePipeline, "Upscale Pipeline");
+
+	VkDescriptorPoolSize pool_sizes[2] = {};
+	pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	pool_sizes[0].descriptorCount = num_frames;
+	pool_sizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	pool_sizes[1].descriptorCount = num_frames;
+	VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
+	descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptor_pool_create_info.maxSets = num_frames;
+	descriptor_pool_create_info.poolSizeCount = 2;
+	descriptor_pool_create_info.pPoolSizes = pool_sizes;
+	VkResult result = vkCreateDescriptorPool(device, &descriptor_pool_create_info, nullptr, &mDescriptorPool);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	VkCommandPoolCreateInfo command_pool_create_info = {};
+	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	command_pool_create_info.queueFamilyIndex = queue_family_index;
+	result = vkCreateCommandPool(device, &command_pool_create_info, nullptr, &mCommandPool);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	// Every frame has its own parameters, since the scale of a frame can change while the previous one is in flight:
+	mFrames.resize(std::max(num_frames, 1u));
+	const VkDescriptorSetLayout descriptor_set_layout = hlpGetDescriptorSetLayout(mUpscalePipeline);
+	for (Frame& frame : mFrames) {
+		VkCommandBufferAllocateInfo command_buffer_alloc_info = {};
+		command_buffer_alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		command_buffer_alloc_info.commandPool = mCommandPool;
+		command_buffer_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		command_buffer_alloc_info.commandBufferCount = 1;
+		result = vkAllocateCommandBuffers(device, &command_buffer_alloc_info, &frame.commandBuffer);
+		VKL_CHECK_VULKAN_RESULT(result);
+
+		VkFenceCreateInfo fence_create_info = {};
+		fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+		result = vkCreateFence(device, &fence_create_info, nullptr, &frame.fence);
+		VKL_CHECK_VULKAN_RESULT(result);
+
+		frame.parameters = hlpCreateMappedBuffer(physical_device, device, sizeof(UpscaleParameters), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+			MEMORY_CATEGORY_UNIFORMS, "Upscale Parameters");
+
+		VkDescriptorSetAllocateInfo descriptor_set_alloc_info = {};
+		descriptor_set_alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		descriptor_set_alloc_info.descriptorPool = mDescriptorPool;
+		descriptor_set_alloc_info.descriptorSetCount = 1;
+		descriptor_set_alloc_info.pSetLayouts = &descriptor_set_layout;
+		result = vkAllocateDescriptorSets(device, &descriptor_set_alloc_info, &frame.descriptorSet);
+		VKL_CHECK_VULKAN_RESULT(result);
+
+		VkDescriptorImageInfo image_info = {};
+		image_info.sampler = mSampler;
+		image_info.imageView = mColor.view;
+		image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		VkDescriptorBufferInfo buffer_info = {};
+		buffer_info.buffer = frame.parameters.buffer;
+		buffer_info.range = VK_WHOLE_SIZE;
+		VkWriteDescriptorSet write_descriptor_sets[2] = {};
+		write_descriptor_sets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write_descriptor_sets[0].dstSet = frame.descriptorSet;
+		write_descriptor_sets[0].dstBinding = 0;
+		write_descriptor_sets[0].descriptorCount = 1;
+		write_descriptor_sets[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write_descriptor_sets[0].pImageInfo = &image_info;
+		write_descriptor_sets[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write_descriptor_sets[1].dstSet = frame.descriptorSet;
+		write_descriptor_sets[1].dstBinding = 1;
+		write_descriptor_sets[1].descriptorCount = 1;
+		write_descriptor_sets[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		write_descriptor_sets[1].pBufferInfo = &buffer_info;
+		vkUpdateDescriptorSets(device, 2, write_descriptor_sets, 0, nullptr);
+	}
+}
+
+void dynamicResolutionDestroy()
+{
+	if (VK_NULL_HANDLE == mDevice) {
+		return;
+	}
+	for (Frame& frame : mFrames) {
+		vkDestroyFence(mDevice, frame.fence, nullptr);
+		hlpDestroyMappedBuffer(mDevice, frame.parameters);
+	}
+	mFrames.clear();
+	vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
+	vkDestroyDescriptorPool(mDevice, mDescriptorPool, nullptr);
+	hlpDestroyGraphicsPipeline(mDevice, mUpscalePipeline);
+	hlpDestroySampler(mDevice, mSampler);
+	vkDestroyFramebuffer(mDevice, mFramebuffer, nullptr);
+	vkDestroyRenderPass(mDevice, mRenderPass, nullptr);
+	hlpDestroyImage(mDevice, mColor);
+	hlpDestroyImage(mDevice, mDepth);
+	mCommandPool = VK_NULL_HANDLE;
+	mDescriptorPool = VK_NULL_HANDLE;
+	mUpscalePipeline = VK_NULL_HANDLE;
+	mSampler = VK_NULL_HANDLE;
+	mFramebuffer = VK_NULL_HANDLE;
+	mRenderPass = VK_NULL_HANDLE;
+	mDevice = VK_NULL_HANDLE;
+}
+
+void dynamicResolutionUpdate(double gpu_milliseconds)
+{
+	++mNumFrames;
+	mSmallestScale = std::min(mSmallestScale, mScale);
+	mScaleSum += mScale;
+	if (mRecordHistory) {
+		mHistory.push_back(HistoryEntry{ gpu_milliseconds, mScale });
+	}
+	if (gpu_milliseconds < 0.0) {
+		return;
+	}
+	if (mFramesToSettle > 0) {
+		--mFramesToSettle;
+		return;
+	}
+
+	if (gpu_milliseconds > mTargetMilliseconds * (1.0 + kDeadBand)) {
+		mStreakMilliseconds = mFramesAbove > 0 ? mStreakMilliseconds + gpu_milliseconds : gpu_milliseconds;
+		++mFramesAbove;
+		mFramesBelow = 0;
+	}
+	else if (gpu_milliseconds < mTargetMilliseconds * (1.0 - kDeadBand)) {
+		mStreakMilliseconds = mFramesBelow > 0 ? mStreakMilliseconds + gpu_milliseconds : gpu_milliseconds;
+		++mFramesBelow;
+		mFramesAbove = 0;
+	}
+	else {
+		mFramesAbove = mFramesBelow = 0;
+		mStreakMilliseconds = 0.0;
+	}
+
+	const bool decrease = mFramesAbove >= kFramesToDecrease;
+	const bool increase = mFramesBelow >= kFramesToIncrease;
+	if (!decrease && !increase) {
+		return;
+	}
+	if ((decrease && mScale <= mMinScale) || (increase && mScale >= 1.0f)) {
+		// Already at the limit:
+		changeScale(mScale);
+		return;
+	}
+
+	// Increases are limited to one step at a time. Decreases jump to the scale which should meet the target, since GPU time
+	// is roughly proportional to the number of pixels, i.e., to the scale squared:
+	float scale = mScale + kScaleStep;
+	if (decrease) {
+		const double mean_milliseconds = mStreakMilliseconds / static_cast<double>(mFramesAbove);
+		const float ideal_scale = mScale * static_cast<float>(std::sqrt(mTargetMilliseconds / mean_milliseconds));
+		scale = std::min(ideal_scale, mScale - kScaleStep);
+	}
+	scale = std::round(scale / kScaleStep) * kScaleStep;
+	changeScale(std::min(std::max(scale, mMinScale), 1.0f));
+}
+
+VkExtent2D dynamicResolutionGetRenderExtent()
+{
+	return scaledExtent(mScale);
+}
+
+VkCommandBuffer dynamicResolutionBeginScene(VkSubpassContents contents)
+{
+	mRecordingFrame = static_cast<uint32_t>(mFrameNumber++ % mFrames.size());
+	Frame& frame = mFrames[mRecordingFrame];
+	VkResult result = vkWaitForFences(mDevice, 1, &frame.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+	VKL_CHECK_VULKAN_RESULT(result);
+	result = vkResetFences(mDevice, 1, &frame.fence);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	const VkExtent2D render_extent = scaledExtent(mScale);
+	UpscaleParameters parameters = {};
+	parameters.uvScale[0] = static_cast<float>(render_extent.width) / static_cast<float>(mExtent.width);
+	parameters.uvScale[1] = static_cast<float>(render_extent.height) / static_cast<float>(mExtent.height);
+	parameters.texelSize[0] = 1.0f / static_cast<float>(mExtent.width);
+	parameters.texelSize[1] = 1.0f / static_cast<float>(mExtent.height);
+	// At full resolution, the scene is copied as is:
+	parameters.sharpness = mScale < 1.0f ? mSharpness : 0.0f;
+	memcpy(frame.parameters.mappedData, &parameters, sizeof(parameters));
+
+	result = vkResetCommandBuffer(frame.commandBuffer, 0);
+	VKL_CHECK_VULKAN_RESULT(result);
+	VkCommandBufferBeginInfo begin_info = {};
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	result = vkBeginCommandBuffer(frame.commandBuffer, &begin_info);
+	VKL_CHECK_VULKAN_RESULT(result);
+	hlpBeginDebugUtilsLabel(frame.commandBuffer, "Scene (Dynamic Resolution)");
+
+	// Same clear values as the swapchain images. Only the render area is cleared and rendered:
+	VkClearValue clear_values[2] = {};
+	clear_values[0].color = VkClearColorValue{ 0.39f, 0.58f, 0.93f, 1.0f };
+	clear_values[1].depthStencil = VkClearDepthStencilValue{ 1.0f, 0 };
+	VkRenderPassBeginInfo render_pass_begin_info = {};
+	render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	render_pass_begin_info.renderPass = mRenderPass;
+	render_pass_begin_info.framebuffer = mFramebuffer;
+	render_pass_begin_info.renderArea = VkRect2D{ VkOffset2D{ 0, 0 }, render_extent };
+	render_pass_begin_info.clearValueCount = 2;
+	render_pass_begin_info.pClearValues = clear_values;
+	vkCmdBeginRenderPass(frame.commandBuffer, &render_pass_begin_info, contents);
+
+	// Secondary command buffers do not inherit dynamic state:
+	if (VK_SUBPASS_CONTENTS_INLINE == contents) {
+		const VkViewport viewport = { 0.0f, 0.0f, static_cast<float>(render_extent.width), static_cast<float>(render_extent.height), 0.0f, 1.0f };
+		vkCmdSetViewport(frame.commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(frame.commandBuffer, 0, 1, &render_pass_begin_info.renderArea);
+	}
+	return frame.commandBuffer;
+}
+
+VkCommandBufferInheritanceInfo dynamicResolutionGetInheritanceInfo()
+{
+	VkCommandBufferInheritanceInfo inheritance_info = {};
+	inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance_info.renderPass = mRenderPass;
+	inheritance_info.subpass = 0;
+	inheritance_info.framebuffer = mFramebuffer;
+	return inheritance_info;
+}
+
+void dynamicResolutionEndScene()
+{
+	Frame& frame = mFrames[mRecordingFrame];
+	vkCmdEndRenderPass(frame.commandBuffer);
+	hlpEndDebugUtilsLabel(frame.commandBuffer);
+	VkResult result = vkEndCommandBuffer(frame.commandBuffer);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	VkSubmitInfo submit_info = {};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &frame.commandBuffer;
+	result = vkQueueSubmit(mQueue, 1, &submit_info, frame.fence);
+	VKL_CHECK_VULKAN_RESULT(result);
+}
+
+void dynamicResolutionUpscale(VkCommandBuffer command_buffer)
+{
+	gpuProfilerBeginScope(command_buffer, "Upscale");
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mUpscalePipeline);
+	hlpBindDescriptorSetToPipeline(command_buffer, mFrames[mRecordingFrame].descriptorSet, mUpscalePipeline);
+	vkCmdDraw(command_buffer, 3, 1, 0, 0);
+	gpuProfilerEndScope(command_buffer);
+}
+
+bool dynamicResolutionWriteHistory(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if (nullptr == file) {
+		return false;
+	}
+	fprintf(file, "frame,gpu_ms,scale,width,height\n");
+	for (size_t i = 0; i < mHistory.size(); ++i) {
+		const HistoryEntry& entry = mHistory[i];
+		const VkExtent2D extent = scaledExtent(entry.scale);
+		if (entry.gpuMilliseconds >= 0.0) {
+			fprintf(file, "%zu,%.4f,%.2f,%u,%u\n", i, entry.gpuMilliseconds, entry.scale, extent.width, extent.height);
+		}
+		else {
+			fprintf(file, "%zu,,%.2f,%u,%u\n", i, entry.scale, extent.width, extent.height);
+		}
+	}
+	return 0 == fclose(file);
+}
+
+DynamicResolutionStatistics dynamicResolutionGetStatistics()
+{
+	DynamicResolutionStatistics statistics = {};
+	statistics.scale = mScale;
+	statistics.minScale = std::min(mSmallestScale, mScale);
+	statistics.numFrames = mNumFrames;
+	statistics.numChanges = mNumChanges;
+	statistics.meanScale = 0 == mNumFrames ? mScale : static_cast<float>(mScaleSum / static_cast<double>(mNumFrames));
+	return statistics;
+}
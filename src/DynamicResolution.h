@@ -0,0 +1,124 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+/* --------------------------------------------- */
+// Dynamic Resolution
+//
+// Keeps the GPU frame time near a target by changing the resolution which
+// the scene is rendered at:
+//  1. The scene is rendered into the top-left part of an offscreen image of
+//     the swapchain's extent, in a command buffer of its own which is
+//     submitted before the framework's one. Scene pipelines must have a
+//     dynamic viewport (see HlpPipelineState::dynamicViewport).
+//  2. Within the framework's render pass, a fullscreen triangle upscales
+//     that part to the swapchain image with bilinear filtering, followed by
+//     contrast-adaptive sharpening.
+//  3. Every frame, the controller compares the GPU profiler's latest frame
+//     time with the target. GPU time is roughly proportional to the number
+//     of pixels, i.e., to the scale squared, which determines the next scale.
+//     To avoid oscillation, the scale only changes if the frame time has
+//     left a dead band around the target for several frames in a row (more
+//     frames to increase than to decrease it), it is quantized to steps, and
+//     after a change, frame times are ignored until the GPU has finished the
+//     frames which were rendered at the new scale.
+// Optionally, every frame's GPU time and scale are recorded, and can be
+// written to a CSV file for tuning.
+/* --------------------------------------------- */
+
+/*!
+ *	Counters and current state, e.g., for logging.
+ */
+struct DynamicResolutionStatistics {
+	//! Current scale of the render resolution relative to the swapchain's, per axis
+	float scale;
+
+	//! Smallest and mean scale of all frames so far
+	float minScale;
+	float meanScale;
+
+	//! Number of frames so far, and how often the scale has changed
+	uint64_t numFrames;
+	uint32_t numChanges;
+};
+
+/*!
+ *	Creates the offscreen images, a render pass for the scene, and the upscale pipeline.
+ *	@param	physical_device			Physical device, used to select memory types
+ *	@param	device					Device handle
+ *	@param	queue					The queue which the scene's command buffers are submitted to
+ *	@param	queue_family_index		The queue's family
+ *	@param	color_format			Format of the swapchain images
+ *	@param	depth_format			Format of the depth attachments
+ *	@param	extent					Extent of the swapchain images, which is the maximum render resolution
+ *	@param	framework_render_pass	A render pass which is compatible with the framework's, for the upscale pipeline
+ *	@param	num_frames				Number of scene command buffers. Must be larger than the number of frames in flight.
+ *	@param	target_milliseconds		GPU frame time which the controller aims for
+ *	@param	min_scale				Lower bound of the scale, in (0, 1]
+ *	@param	sharpness				Strength of the sharpening after upscaling, from 0 (none) to 1
+ *	@param	record_history			Whether to record every frame's GPU time and scale for dynamicResolutionWriteHistory.
+ *									The history grows by one entry per frame.
+ */
+void dynamicResolutionCreate(VkPhysicalDevice physical_device, VkDevice device, VkQueue queue, uint32_t queue_family_index,
+	VkFormat color_format, VkFormat depth_format, VkExtent2D extent, VkRenderPass framework_render_pass, uint32_t num_frames,
+	double target_milliseconds, float min_scale, float sharpness, bool record_history);
+
+/*!
+ *	Destroys everything. The device must be idle.
+ */
+void dynamicResolutionDestroy();
+
+/*!
+ *	Records the latest GPU frame time and adapts the scale. Call this once per frame, before the scene is drawn.
+ *	@param	gpu_milliseconds	GPU time of the most recently finished frame, e.g., gpuProfilerGetLatestFrameMilliseconds.
+ *								Negative if unavailable, which keeps the scale.
+ */
+void dynamicResolutionUpdate(double gpu_milliseconds);
+
+/*!
+ *	Returns the extent which the scene is rendered at in the current frame.
+ */
+VkExtent2D dynamicResolutionGetRenderExtent();
+
+/*!
+ *	Begins a command buffer and a render pass which is compatible with the one returned by hlpCreateCompatibleRenderPass,
+ *	and, with inline contents, sets viewport and scissor to the render extent. Record the scene's draws into it, or execute
+ *	secondary command buffers, then call dynamicResolutionEndScene.
+ *	@param	contents	VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS if the scene is executed from secondary command buffers,
+ *						which have to set viewport and scissor themselves
+ *	@return	The command buffer
+ */
+VkCommandBuffer dynamicResolutionBeginScene(VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+
+/*!
+ *	Returns the render pass and framebuffer of the scene, for secondary command buffers which are executed in it.
+ */
+VkCommandBufferInheritanceInfo dynamicResolutionGetInheritanceInfo();
+
+/*!
+ *	Ends the render pass and submits the command buffer. Must be called before the framework's command buffer of the same
+ *	frame is submitted (i.e., before vklEndRecordingCommands) and before frameCaptureEndFrame, and between gpuProfilerBeginFrame
+ *	and gpuProfilerEndFrame.
+ */
+void dynamicResolutionEndScene();
+
+/*!
+ *	Records the upscale of the scene to the whole swapchain image.
+ *	@param	command_buffer	The framework's command buffer, within its render pass, or the one of frameCaptureBeginFrame
+ */
+void dynamicResolutionUpscale(VkCommandBuffer command_buffer);
+
+/*!
+ *	Writes every frame's GPU time and scale so far as CSV (frame, gpu_ms, scale, width, height).
+ *	Frames without a GPU time have an empty gpu_ms column. Writes only the header unless the history is recorded.
+ *	@return	True on success
+ */
+bool dynamicResolutionWriteHistory(const char* path);
+
+/*!
+ *	Returns counters and the current state.
+ */
+DynamicResolutionStatistics dynamicResolutionGetStatistics();
@@ -0,0 +1,636 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "FrameCapture.h"
+#include "GpuProfiler.h"
+#include "VulkanHelpers.h"
+#include <VulkanLaunchpad.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// A pixel differs from its golden reference if any channel differs by more than this:
+	constexpr int kChannelTolerance = 8;
+	// A frame mismatches if more than this fraction of its pixels differ:
+	constexpr double kMismatchFraction = 0.001;
+
+	enum class SlotState {
+		Free,    // Available for frameCaptureEndFrame
+		Pending, // Submitted, the GPU has not finished the readback yet
+		Writing, // Handed to the writer thread
+	};
+
+	struct ReadbackSlot {
+		HlpMappedBuffer buffer;
+		VkFence fence;
+		SlotState state;
+		uint64_t frameNumber;
+	};
+
+	struct Frame {
+		VkCommandBuffer commandBuffer;
+		VkFence fence;
+	};
+
+	VkDevice mDevice = VK_NULL_HANDLE;
+	VkQueue mQueue = VK_NULL_HANDLE;
+	VkExtent2D mExtent = {};
+	bool mSwizzleBgr = false;
+	FrameCaptureMode mMode = FRAME_CAPTURE_MODE_PNG;
+	std::string mOutputDirectory;
+	std::string mGoldenDirectory;
+
+	HlpImage mColor = {};
+	HlpImage mDepth = {};
+	VkRenderPass mRenderPass = VK_NULL_HANDLE;
+	VkFramebuffer mFramebuffer = VK_NULL_HANDLE;
+	VkSampler mSampler = VK_NULL_HANDLE;
+	VkPipeline mCopyPipeline = VK_NULL_HANDLE;
+	VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSet mDescriptorSet = VK_NULL_HANDLE;
+	VkCommandPool mCommandPool = VK_NULL_HANDLE;
+
+	// Main thread state:
+	std::vector<Frame> mFrames;
+	uint64_t mNumRecordedFrames = 0;
+	uint32_t mRecordingFrame = 0;
+	uint64_t mRecordingFrameNumber = 0;
+	std::vector<ReadbackSlot> mSlots;
+
+	// Shared with the writer thread, guarded by mMutex. Slots in state Writing belong to the writer thread:
+	std::thread mWriterThread;
+	std::mutex mMutex;
+	std::condition_variable mWorkAvailable;
+	std::condition_variable mWorkDone;
+	std::deque<uint32_t> mWriteQueue;
+	bool mWriterBusy = false;
+	bool mShutdown = false;
+	FrameCaptureStatistics mStatistics = {};
+
+	std::string framePath(const std::string& directory, const char* prefix, uint64_t frame_number, const char* extension)
+	{
+		char file_name[64];
+		std::snprintf(file_name, sizeof(file_name), "%s_%06llu.%s", prefix, static_cast<unsigned long long>(frame_number), extension);
+		return directory + "/" + file_name;
+	}
+
+	/* --------------------------------------------- */
+	// PNG encoding, without external dependencies: the image data is
+	// stored in uncompressed deflate blocks. Files are larger than those of
+	// a real encoder, but encoding costs hardly more than a copy.
+	/* --------------------------------------------- */
+
+	uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+	{
+		static uint32_t table[256];
+		static bool table_initialized = false;
+		if (!table_initialized) {
+			for (uint32_t n = 0; n < 256; ++n) {
+				uint32_t c = n;
+				for (int k = 0; k < 8; ++k) {
+					c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+				}
+				table[n] = c;
+			}
+			table_initialized = true;
+		}
+		crc = ~crc;
+		for (size_t i = 0; i < size; ++i) {
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+
+	void appendBigEndian(std::vector<uint8_t>& out, uint32_t value)
+	{
+		out.push_back(static_cast<uint8_t>(value >> 24));
+		out.push_back(static_cast<uint8_t>(value >> 16));
+		out.push_back(static_cast<uint8_t>(value >> 8));
+		out.push_back(static_cast<uint8_t>(value));
+	}
+
+	void appendChunk(std::vector<uint8_t>& out, const char type[4], const std::vector<uint8_t>& data)
+	{
+		appendBigEndian(out, static_cast<uint32_t>(data.size()));
+		const size_t type_offset = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+		appendBigEndian(out, crc32(out.data() + type_offset, 4 + data.size()));
+	}
+
+	bool writePng(const std::string& path, const std::vector<uint8_t>& rgb, uint32_t width, uint32_t height)
+	{
+		// Every row is prefixed with filter type 0 (none):
+		const size_t row_size = 3 * static_cast<size_t>(width);
+		std::vector<uint8_t> raw;
+		raw.reserve((row_size + 1) * height);
+		for (uint32_t y = 0; y < height; ++y) {
+			raw.push_back(0);
+			raw.insert(raw.end(), rgb.begin() + y * row_size, rgb.begin() + (y + 1) * row_size);
+		}
+
+		// zlib stream: header, stored blocks of at most 65535 bytes, Adler-32 checksum:
+		std::vector<uint8_t> zlib = { 0x78, 0x01 };
+		zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+		uint32_t adler_a = 1, adler_b = 0;
+		size_t offset = 0;
+		do {
+			const uint16_t block_size = static_cast<uint16_t>(std::min<size_t>(raw.size() - offset, 65535));
+			const bool final_block = offset + block_size == raw.size();
+			zlib.push_back(final_block ? 1 : 0);
+			zlib.push_back(static_cast<uint8_t>(block_size));
+			zlib.push_back(static_cast<uint8_t>(block_size >> 8));
+			zlib.push_back(static_cast<uint8_t>(~block_size));
+			zlib.push_back(static_cast<uint8_t>(~block_size >> 8));
+			for (size_t i = offset; i < offset + block_size; ++i) {
+				adler_a = (adler_a + raw[i]) % 65521;
+				adler_b = (adler_b + adler_a) % 65521;
+			}
+			zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + block_size);
+			offset += block_size;
+		} while (offset < raw.size());
+		appendBigEndian(zlib, (adler_b << 16) | adler_a);
+
+		std::vector<uint8_t> header;
+		appendBigEndian(header, width);
+		appendBigEndian(header, height);
+		header.insert(header.end(), { 8, 2, 0, 0, 0 }); // 8 bits per channel, RGB, deflate, adaptive filtering, no interlace
+
+		std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		appendChunk(png, "IHDR", header);
+		appendChunk(png, "IDAT", zlib);
+		appendChunk(png, "IEND", {});
+
+		std::ofstream file(path, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(png.data()), png.size());
+		return static_cast<bool>(file);
+	}
+
+	bool writePpm(const std::string& path, const std::vector<uint8_t>& rgb, uint32_t width, uint32_t height)
+	{
+		std::ofstream file(path, std::ios::binary);
+		file << "P6\n" << width << " " << height << "\n255\n";
+		file.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+		return static_cast<bool>(file);
+	}
+
+	bool readPpm(const std::string& path, std::vector<uint8_t>& rgb, uint32_t& width, uint32_t& height)
+	{
+		std::ifstream file(path, std::ios::binary);
+		std::string magic;
+		uint32_t max_value = 0;
+		file >> magic >> width >> height >> max_value;
+		file.get(); // Single whitespace character after the header
+		if (!file || "P6" != magic || 255 != max_value) {
+			return false;
+		}
+		rgb.resize(3 * static_cast<size_t>(width) * height);
+		file.read(reinterpret_cast<char*>(rgb.data()), rgb.size());
+		return static_cast<bool>(file);
+	}
+
+	// Returns true if the frame matches its golden reference. Writes a diff image otherwise:
+	bool compareWithGolden(uint64_t frame_number, const std::vector<uint8_t>& rgb)
+	{
+		const std::string golden_path = framePath(mGoldenDirectory, "frame", frame_number, "ppm");
+		std::vector<uint8_t> golden;
+		uint32_t golden_width = 0, golden_height = 0;
+		if (!readPpm(golden_path, golden, golden_width, golden_height)) {
+			VKL_LOG("Frame capture: no golden reference \"" << golden_path << "\" for frame " << frame_number << ".");
+			return false;
+		}
+		if (golden_width != mExtent.width || golden_height != mExtent.height) {
+			VKL_LOG("Frame capture: golden reference \"" << golden_path << "\" has a different size than frame " << frame_number << ".");
+			return false;
+		}
+
+		// Differing pixels are red, all others are a darkened copy of the frame:
+		std::vector<uint8_t> diff(rgb.size());
+		size_t num_differing = 0;
+		for (size_t i = 0; i < rgb.size(); i += 3) {
+			bool differs = false;
+			for (size_t c = 0; c < 3; ++c) {
+				differs = differs || std::abs(int(rgb[i + c]) - int(golden[i + c])) > kChannelTolerance;
+			}
+			num_differing += differs ? 1 : 0;
+			for (size_t c = 0; c < 3; ++c) {
+				diff[i + c] = differs ? (0 == c ? 255 : 0) : static_cast<uint8_t>(rgb[i + c] / 4);
+			}
+		}
+		const size_t num_pixels = rgb.size() / 3;
+		if (static_cast<double>(num_differing) <= kMismatchFraction * num_pixels) {
+			return true;
+		}
+		const std::string diff_path = framePath(mOutputDirectory, "diff", frame_number, "ppm");
+		VKL_LOG("Frame capture: frame " << frame_number << " differs from its golden reference in " << num_differing << " of " << num_pixels << " pixels, see \"" << diff_path << "\".");
+		writePpm(diff_path, diff, mExtent.width, mExtent.height);
+		return false;
+	}
+
+	void processSlot(const ReadbackSlot& slot)
+	{
+		// Drop the alpha channel and bring the channels into RGB order:
+		const uint8_t* pixels = static_cast<const uint8_t*>(slot.buffer.mappedData);
+		const size_t num_pixels = static_cast<size_t>(mExtent.width) * mExtent.height;
+		std::vector<uint8_t> rgb(3 * num_pixels);
+		const size_t r = mSwizzleBgr ? 2 : 0;
+		const size_t b = mSwizzleBgr ? 0 : 2;
+		for (size_t i = 0; i < num_pixels; ++i) {
+			rgb[3 * i + 0] = pixels[4 * i + r];
+			rgb[3 * i + 1] = pixels[4 * i + 1];
+			rgb[3 * i + 2] = pixels[4 * i + b];
+		}
+
+		bool mismatch = false;
+		switch (mMode) {
+		case FRAME_CAPTURE_MODE_PNG: {
+			const std::string path = framePath(mOutputDirectory, "frame", slot.frameNumber, "png");
+			if (!writePng(path, rgb, mExtent.width, mExtent.height)) {
+				VKL_LOG("Frame capture: unable to write \"" << path << "\".");
+			}
+			break;
+		}
+		case FRAME_CAPTURE_MODE_RAW: {
+			const std::string path = framePath(mOutputDirectory, "frame", slot.frameNumber, "ppm");
+			if (!writePpm(path, rgb, mExtent.width, mExtent.height)) {
+				VKL_LOG("Frame capture: unable to write \"" << path << "\".");
+			}
+			break;
+		}
+		case FRAME_CAPTURE_MODE_COMPARE:
+			mismatch = !compareWithGolden(slot.frameNumber, rgb);
+			break;
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		++mStatistics.numWritten;
+		mStatistics.numMismatches += mismatch ? 1 : 0;
+	}
+
+	void writeFrames()
+	{
+		for (;;) {
+			uint32_t slot_index;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mWriterBusy = false;
+				mWorkDone.notify_all();
+				mWorkAvailable.wait(lock, [] { return mShutdown || !mWriteQueue.empty(); });
+				if (mWriteQueue.empty()) {
+					return;
+				}
+				slot_index = mWriteQueue.front();
+				mWriteQueue.pop_front();
+				mWriterBusy = true;
+			}
+			processSlot(mSlots[slot_index]);
+			std::lock_guard<std::mutex> lock(mMutex);
+			mSlots[slot_index].state = SlotState::Free;
+		}
+	}
+
+	// Requires mMutex to be locked:
+	void handToWriter(uint32_t slot_index)
+	{
+		mSlots[slot_index].state = SlotState::Writing;
+		mWriteQueue.push_back(slot_index);
+		mWorkAvailable.notify_one();
+	}
+}
+
+void frameCaptureCreate(VkPhysicalDevice physical_device, VkDevice device, VkQueue queue, uint32_t queue_family_index,
+	VkFormat color_format, VkFormat depth_format, VkExtent2D extent, VkRenderPass framework_render_pass, uint32_t num_frames,
+	uint32_t num_readback_buffers, FrameCaptureMode mode, const char* output_directory, const char* golden_directory)
+{
+	switch (color_format) {
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+		mSwizzleBgr = false;
+		break;
+	case VK_FORMAT_B8G8R8A8_UNORM:
+	case VK_FORMAT_B8G8R8A8_SRGB:
+		mSwizzleBgr = true;
+		break;
+	default:
+		VKL_EXIT_WITH_ERROR("Frame capture does not support the swapchain's color format " << color_format << ".");
+	}
+
+	mDevice = device;
+	mQueue = queue;
+	mExtent = extent;
+	mMode = mode;
+	mOutputDirectory = nullptr != output_directory ? output_directory : ".";
+	mGoldenDirectory = nullptr != golden_directory ? golden_directory : ".";
+	mStatistics = {};
+	mNumRecordedFrames = 0;
+
+	mColor = hlpCreateImage(physical_device, device, color_format, extent, 1,
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT,
+		MEMORY_CATEGORY_RENDER_TARGETS, "Frame Capture Color");
+	mDepth = hlpCreateImage(physical_device, device, depth_format, extent, 1, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_IMAGE_ASPECT_DEPTH_BIT,
+		MEMORY_CATEGORY_RENDER_TARGETS, "Frame Capture Depth");
+
+	// The color attachment ends up ready for the readback:
+	mRenderPass = hlpCreateOffscreenRenderPass(device, color_format, depth_format, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+	mFramebuffer = hlpCreateFramebuffer(device, mRenderPass, mColor.view, mDepth.view, extent);
+
+	// A fullscreen triangle which fetches from the captured frame (binding 0):
+	mSampler = hlpCreateSampler(device, VK_FILTER_NEAREST, VK_FILTER_NEAREST);
+	VkDescriptorSetLayoutBinding binding = {};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	binding.descriptorCount = 1;
+	binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	mCopyPipeline = hlpCreateFullscreenPipeline(device, SHADER_BINARY_DIR "/copy.spv", { binding }, framework_render_pass, extent);
+	hlpSetDebugUtilsObjectName(device, VK_OBJECT_TYPE_PIPELINE, (uint64_t)mCopyPipeline, "Frame Capture Copy Pipeline");
+
+	// The image never changes => a single descriptor set serves all frames:
+	VkDescriptorPoolSize pool_size = {};
+	pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	pool_size.descriptorCount = 1;
+	VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
+	descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptor_pool_create_info.maxSets = 1;
+	descriptor_pool_create_info.poolSizeCount = 1;
+	descriptor_pool_create_info.pPoolSizes = &pool_size;
+	VkResult result = vkCreateDescriptorPool(device, &descriptor_pool_create_info, nullptr, &mDescriptorPool);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	const VkDescriptorSetLayout descriptor_set_layout = hlpGetDescriptorSetLayout(mCopyPipeline);
+	VkDescriptorSetAllocateInfo descriptor_set_alloc_info = {};
+	descriptor_set_alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptor_set_alloc_info.descriptorPool = mDescriptorPool;
+	descriptor_set_alloc_info.descriptorSetCount = 1;
+	descriptor_set_alloc_info.pSetLayouts = &descriptor_set_layout;
+	result = vkAllocateDescriptorSets(device, &descriptor_set_alloc_info, &mDescriptorSet);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	VkDescriptorImageInfo image_info = {};
+	image_info.sampler = mSampler;
+	image_info.imageView = mColor.view;
+	image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	VkWriteDescriptorSet write_descriptor_set = {};
+	write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write_descriptor_set.dstSet = mDescriptorSet;
+	write_descriptor_set.dstBinding = 0;
+	write_descriptor_set.descriptorCount = 1;
+	write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write_descriptor_set.pImageInfo = &image_info;
+	vkUpdateDescriptorSets(device, 1, &write_descriptor_set, 0, nullptr);
+
+	VkCommandPoolCreateInfo command_pool_create_info = {};
+	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	command_pool_create_info.queueFamilyIndex = queue_family_index;
+	result = vkCreateCommandPool(device, &command_pool_create_info, nullptr, &mCommandPool);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	mFrames.resize(std::max(num_frames, 1u));
+	for (Frame& frame : mFrames) {
+		VkCommandBufferAllocateInfo command_buffer_alloc_info = {};
+		command_buffer_alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		command_buffer_alloc_info.commandPool = mCommandPool;
+		command_buffer_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		command_buffer_alloc_info.commandBufferCount = 1;
+		result = vkAllocateCommandBuffers(device, &command_buffer_alloc_info, &frame.commandBuffer);
+		VKL_CHECK_VULKAN_RESULT(result);
+
+		VkFenceCreateInfo fence_create_info = {};
+		fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+		result = vkCreateFence(device, &fence_create_info, nullptr, &frame.fence);
+		VKL_CHECK_VULKAN_RESULT(result);
+	}
+
+	// Readbacks are signaled by fences of their own, since they outlive the frames' command buffers:
+	const VkDeviceSize readback_size = 4 * static_cast<VkDeviceSize>(extent.width) * extent.height;
+	mSlots.resize(std::max(num_readback_buffers, 1u));
+	for (ReadbackSlot& slot : mSlots) {
+		slot.buffer = hlpCreateMappedBuffer(physical_device, device, readback_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, MEMORY_CATEGORY_READBACK, "Frame Capture Readback");
+		slot.state = SlotState::Free;
+		slot.frameNumber = 0;
+
+		VkFenceCreateInfo fence_create_info = {};
+		fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		result = vkCreateFence(device, &fence_create_info, nullptr, &slot.fence);
+		VKL_CHECK_VULKAN_RESULT(result);
+	}
+
+	mShutdown = false;
+	mWriterBusy = false;
+	mWriterThread = std::thread(writeFrames);
+}
+
+void frameCaptureDestroy()
+{
+	if (VK_NULL_HANDLE == mDevice) {
+		return;
+	}
+	frameCaptureFlush();
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mShutdown = true;
+		mWorkAvailable.notify_one();
+	}
+	mWriterThread.join();
+
+	for (ReadbackSlot& slot : mSlots) {
+		vkDestroyFence(mDevice, slot.fence, nullptr);
+		hlpDestroyMappedBuffer(mDevice, slot.buffer);
+	}
+	mSlots.clear();
+	for (Frame& frame : mFrames) {
+		vkDestroyFence(mDevice, frame.fence, nullptr);
+	}
+	mFrames.clear();
+	vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
+	vkDestroyDescriptorPool(mDevice, mDescriptorPool, nullptr);
+	hlpDestroyGraphicsPipeline(mDevice, mCopyPipeline);
+	hlpDestroySampler(mDevice, mSampler);
+	vkDestroyFramebuffer(mDevice, mFramebuffer, nullptr);
+	vkDestroyRenderPass(mDevice, mRenderPass, nullptr);
+	hlpDestroyImage(mDevice, mColor);
+	hlpDestroyImage(mDevice, mDepth);
+	mCommandPool = VK_NULL_HANDLE;
+	mDescriptorPool = VK_NULL_HANDLE;
+	mDescriptorSet = VK_NULL_HANDLE;
+	mCopyPipeline = VK_NULL_HANDLE;
+	mSampler = VK_NULL_HANDLE;
+	mFramebuffer = VK_NULL_HANDLE;
+	mRenderPass = VK_NULL_HANDLE;
+	mDevice = VK_NULL_HANDLE;
+}
+
+VkCommandBuffer frameCaptureBeginFrame(uint64_t frame_number, VkSubpassContents contents)
+{
+	mRecordingFrame = static_cast<uint32_t>(mNumRecordedFrames++ % mFrames.size());
+	mRecordingFrameNumber = frame_number;
+	Frame& frame = mFrames[mRecordingFrame];
+	VkResult result = vkWaitForFences(mDevice, 1, &frame.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+	VKL_CHECK_VULKAN_RESULT(result);
+	result = vkResetFences(mDevice, 1, &frame.fence);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	result = vkResetCommandBuffer(frame.commandBuffer, 0);
+	VKL_CHECK_VULKAN_RESULT(result);
+	VkCommandBufferBeginInfo begin_info = {};
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	result = vkBeginCommandBuffer(frame.commandBuffer, &begin_info);
+	VKL_CHECK_VULKAN_RESULT(result);
+	hlpBeginDebugUtilsLabel(frame.commandBuffer, "Frame (Capture)");
+
+	// Same clear values as the swapchain images:
+	VkClearValue clear_values[2] = {};
+	clear_values[0].color = VkClearColorValue{ 0.39f, 0.58f, 0.93f, 1.0f };
+	clear_values[1].depthStencil = VkClearDepthStencilValue{ 1.0f, 0 };
+	VkRenderPassBeginInfo render_pass_begin_info = {};
+	render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	render_pass_begin_info.renderPass = mRenderPass;
+	render_pass_begin_info.framebuffer = mFramebuffer;
+	render_pass_begin_info.renderArea = VkRect2D{ VkOffset2D{ 0, 0 }, mExtent };
+	render_pass_begin_info.clearValueCount = 2;
+	render_pass_begin_info.pClearValues = clear_values;
+	vkCmdBeginRenderPass(frame.commandBuffer, &render_pass_begin_info, contents);
+	return frame.commandBuffer;
+}
+
+VkCommandBufferInheritanceInfo frameCaptureGetInheritanceInfo()
+{
+	VkCommandBufferInheritanceInfo inheritance_info = {};
+	inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance_info.renderPass = mRenderPass;
+	inheritance_info.subpass = 0;
+	inheritance_info.framebuffer = mFramebuffer;
+	return inheritance_info;
+}
+
+void frameCaptureEndFrame()
+{
+	Frame& frame = mFrames[mRecordingFrame];
+	vkCmdEndRenderPass(frame.commandBuffer);
+
+	uint32_t free_slot = std::numeric_limits<uint32_t>::max();
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (uint32_t i = 0; i < static_cast<uint32_t>(mSlots.size()) && free_slot == std::numeric_limits<uint32_t>::max(); ++i) {
+			if (SlotState::Free == mSlots[i].state) {
+				free_slot = i;
+			}
+		}
+		if (free_slot == std::numeric_limits<uint32_t>::max()) {
+			++mStatistics.numDropped;
+		}
+	}
+
+	// The render pass has transitioned the color attachment to TRANSFER_SRC_OPTIMAL:
+	if (free_slot != std::numeric_limits<uint32_t>::max()) {
+		ReadbackSlot& slot = mSlots[free_slot];
+		slot.frameNumber = mRecordingFrameNumber;
+		VkBufferImageCopy region = {};
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageExtent = VkExtent3D{ mExtent.width, mExtent.height, 1 };
+		vkCmdCopyImageToBuffer(frame.commandBuffer, mColor.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer.buffer, 1, &region);
+
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = slot.buffer.buffer;
+		barrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(frame.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	// After the readback, the frame is copied into the swapchain image. The render pass has made the color attachment's
+	// writes available to the transfer stage, which this barrier makes visible to fragment shaders:
+	VkImageMemoryBarrier image_barrier = {};
+	image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	image_barrier.srcAccessMask = 0;
+	image_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	image_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	image_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	image_barrier.image = mColor.image;
+	image_barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	vkCmdPipelineBarrier(frame.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &image_barrier);
+
+	hlpEndDebugUtilsLabel(frame.commandBuffer);
+	VkResult result = vkEndCommandBuffer(frame.commandBuffer);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	VkSubmitInfo submit_info = {};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &frame.commandBuffer;
+	result = vkQueueSubmit(mQueue, 1, &submit_info, frame.fence);
+	VKL_CHECK_VULKAN_RESULT(result);
+	if (free_slot == std::numeric_limits<uint32_t>::max()) {
+		return;
+	}
+
+	// A submission without command buffers signals its fence once all previously submitted work has finished:
+	ReadbackSlot& slot = mSlots[free_slot];
+	result = vkResetFences(mDevice, 1, &slot.fence);
+	VKL_CHECK_VULKAN_RESULT(result);
+	result = vkQueueSubmit(mQueue, 0, nullptr, slot.fence);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	slot.state = SlotState::Pending;
+	++mStatistics.numCaptured;
+}
+
+void frameCapturePresent(VkCommandBuffer command_buffer)
+{
+	gpuProfilerBeginScope(command_buffer, "Present Captured Frame");
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mCopyPipeline);
+	hlpBindDescriptorSetToPipeline(command_buffer, mDescriptorSet, mCopyPipeline);
+	vkCmdDraw(command_buffer, 3, 1, 0, 0);
+	gpuProfilerEndScope(command_buffer);
+}
+
+void frameCapturePoll()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (uint32_t i = 0; i < static_cast<uint32_t>(mSlots.size()); ++i) {
+		if (SlotState::Pending == mSlots[i].state && VK_SUCCESS == vkGetFenceStatus(mDevice, mSlots[i].fence)) {
+			handToWriter(i);
+		}
+	}
+}
+
+void frameCaptureFlush()
+{
+	for (uint32_t i = 0; i < static_cast<uint32_t>(mSlots.size()); ++i) {
+		if (SlotState::Pending == mSlots[i].state) {
+			VkResult result = vkWaitForFences(mDevice, 1, &mSlots[i].fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+			VKL_CHECK_VULKAN_RESULT(result);
+		}
+	}
+	std::unique_lock<std::mutex> lock(mMutex);
+	for (uint32_t i = 0; i < static_cast<uint32_t>(mSlots.size()); ++i) {
+		if (SlotState::Pending == mSlots[i].state) {
+			handToWriter(i);
+		}
+	}
+	mWorkDone.wait(lock, [] { return mWriteQueue.empty() && !mWriterBusy; });
+}
+
+FrameCaptureStatistics frameCaptureGetStatistics()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStatistics;
+}
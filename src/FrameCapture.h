@@ -0,0 +1,129 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+/* --------------------------------------------- */
+// Frame Capture
+//
+// Brings presented frames to the CPU without stalling the render loop:
+//  1. Every frame is composed in an offscreen image of the swapchain's format
+//     and extent instead of the swapchain image, in a render pass which is
+//     compatible with the framework's: the scene's draws, or the upscale or
+//     multiview composite of an offscreen scene (see DynamicResolution.h and
+//     Multiview.h). The image is copied with vkCmdCopyImageToBuffer into one
+//     of a ring of host-visible readback buffers, and within the framework's
+//     render pass, a fullscreen triangle copies it into the swapchain image.
+//     Hence, captured frames are exactly the presented ones, for the cost of
+//     one copy per pixel. The swapchain images cannot be copied themselves,
+//     since the framework owns their synchronization with the presentation
+//     engine.
+//  2. Every frame, the fences of all pending readbacks are polled. Finished
+//     readbacks are handed to a writer thread, typically a few frames later.
+//  3. The writer thread encodes frames as PNG or PPM files, or compares them
+//     against golden PPM files and writes a diff image for every mismatch.
+// If no readback buffer is free, the frame is presented, but dropped from the
+// capture rather than waited for.
+/* --------------------------------------------- */
+
+/*!
+ *	What the writer thread does with captured frames.
+ */
+enum FrameCaptureMode {
+	//! Write frame_NNNNNN.png (uncompressed deflate, RGB)
+	FRAME_CAPTURE_MODE_PNG,
+
+	//! Write frame_NNNNNN.ppm (binary PPM, RGB), which can serve as golden references
+	FRAME_CAPTURE_MODE_RAW,
+
+	//! Compare with frame_NNNNNN.ppm in the golden directory and write diff_NNNNNN.ppm for every mismatch
+	FRAME_CAPTURE_MODE_COMPARE,
+};
+
+/*!
+ *	Counters since frameCaptureCreate. Up to date after frameCaptureFlush.
+ */
+struct FrameCaptureStatistics {
+	//! Frames which have been read back
+	uint32_t numCaptured;
+
+	//! Frames which have been skipped, because all readback buffers were in use
+	uint32_t numDropped;
+
+	//! Frames which the writer thread has finished
+	uint32_t numWritten;
+
+	//! In compare mode: frames which differ from their golden reference, or which have no golden reference
+	uint32_t numMismatches;
+};
+
+/*!
+ *	Creates the offscreen images, the copy pipeline, the readback ring, and the writer thread.
+ *	Exits with an error if the color format is not an 8-bit RGBA or BGRA format.
+ *	@param	physical_device			Physical device, used to select memory types
+ *	@param	device					Device handle
+ *	@param	queue					The queue which the frames' command buffers are submitted to
+ *	@param	queue_family_index		The queue's family
+ *	@param	color_format			Format of the swapchain images
+ *	@param	depth_format			Format of the depth attachments
+ *	@param	extent					Extent of the swapchain images
+ *	@param	framework_render_pass	A render pass which is compatible with the framework's, for the copy pipeline
+ *	@param	num_frames				Number of frame command buffers. Must be larger than the number of frames in flight.
+ *	@param	num_readback_buffers	Number of frames which can be in readback or in the writer's queue at the same time
+ *	@param	mode					What to do with the captured frames
+ *	@param	output_directory		Directory which files are written into; must exist
+ *	@param	golden_directory		Directory of the golden references in compare mode, nullptr otherwise
+ */
+void frameCaptureCreate(VkPhysicalDevice physical_device, VkDevice device, VkQueue queue, uint32_t queue_family_index,
+	VkFormat color_format, VkFormat depth_format, VkExtent2D extent, VkRenderPass framework_render_pass, uint32_t num_frames,
+	uint32_t num_readback_buffers, FrameCaptureMode mode, const char* output_directory, const char* golden_directory);
+
+/*!
+ *	Flushes and destroys everything. The device must be idle.
+ */
+void frameCaptureDestroy();
+
+/*!
+ *	Begins a command buffer and a render pass which is compatible with the framework's and with the one returned by
+ *	hlpCreateCompatibleRenderPass. Record everything into it which would otherwise be recorded into the framework's
+ *	render pass, or execute secondary command buffers, then call frameCaptureEndFrame.
+ *	@param	frame_number	Number of the frame, used for file names
+ *	@param	contents		VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS if the frame is executed from secondary command buffers
+ *	@return	The command buffer
+ */
+VkCommandBuffer frameCaptureBeginFrame(uint64_t frame_number, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+
+/*!
+ *	Returns the render pass and framebuffer of the offscreen image, for secondary command buffers which are executed in it.
+ */
+VkCommandBufferInheritanceInfo frameCaptureGetInheritanceInfo();
+
+/*!
+ *	Ends the render pass, records the readback if a readback buffer is free, and submits the command buffer. Must be
+ *	called before the framework's command buffer of the same frame is submitted (i.e., before vklEndRecordingCommands),
+ *	and between gpuProfilerBeginFrame and gpuProfilerEndFrame.
+ */
+void frameCaptureEndFrame();
+
+/*!
+ *	Records copying the frame into the swapchain image.
+ *	@param	command_buffer	The framework's command buffer, within its render pass
+ */
+void frameCapturePresent(VkCommandBuffer command_buffer);
+
+/*!
+ *	Hands all finished readbacks to the writer thread. Never blocks. Call this once per frame.
+ */
+void frameCapturePoll();
+
+/*!
+ *	Blocks until all pending readbacks have finished and the writer thread has processed them.
+ */
+void frameCaptureFlush();
+
+/*!
+ *	Returns the counters since frameCaptureCreate.
+ */
+FrameCaptureStatistics frameCaptureGetStatistics();
@@ -0,0 +1,340 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "FrameScheduler.h"
+#include "Profiler.h"
+#include <VulkanLaunchpad.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace
+{
+	constexpr uint32_t kHistoryLength = 64;
+
+	using Clock = std::chrono::steady_clock;
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+
+	struct PendingDeletion {
+		uint64_t              frameNumber;
+		std::function<void()> deletion;
+	};
+
+	struct History {
+		double   milliseconds[kHistoryLength];
+		uint32_t count;
+	};
+
+	VkDevice mDevice = VK_NULL_HANDLE;
+	VkQueue mQueue = VK_NULL_HANDLE;
+	uint32_t mFramesInFlight = 1;
+	bool mTimelineEnabled = false;
+	VkSemaphore mTimelineSemaphore = VK_NULL_HANDLE;
+#if defined(VK_KHR_timeline_semaphore)
+	PFN_vkWaitSemaphoresKHR mVkWaitSemaphoresKHR = nullptr;
+	PFN_vkGetSemaphoreCounterValueKHR mVkGetSemaphoreCounterValueKHR = nullptr;
+#endif
+
+	// Without timeline semaphores: frame N signals mFences[N % mFramesInFlight]:
+	std::vector<VkFence> mFences;
+
+	// Main thread state:
+	uint64_t mFrameNumber = 1;
+	uint64_t mCompletedFrame = 0;
+	std::deque<PendingDeletion> mDeletions;
+	History mCpuWaitHistory = {};
+	History mGpuIdleHistory = {};
+	std::vector<double>* mCpuWaitDestination = nullptr;
+	std::vector<double>* mGpuIdleDestination = nullptr;
+
+	// Shared with the completion thread, guarded by mMutex:
+	std::thread mCompletionThread;
+	std::mutex mMutex;
+	std::condition_variable mFrameSubmitted;
+	bool mShutdown = false;
+	std::deque<Clock::time_point> mSubmitTimes;
+	std::vector<double> mGpuIdleResults;
+
+	void addToHistory(History& history, double milliseconds)
+	{
+		history.milliseconds[history.count++ % kHistoryLength] = milliseconds;
+	}
+
+	double averageOf(const History& history)
+	{
+		const uint32_t n = std::min(history.count, kHistoryLength);
+		if (0 == n) {
+			return 0.0;
+		}
+		double sum = 0.0;
+		for (uint32_t i = 0; i < n; ++i) {
+			sum += history.milliseconds[i];
+		}
+		return sum / n;
+	}
+
+	void waitForTimelineValue(uint64_t value)
+	{
+#if defined(VK_KHR_timeline_semaphore)
+		VkSemaphoreWaitInfoKHR wait_info = {};
+		wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+		wait_info.semaphoreCount = 1;
+		wait_info.pSemaphores = &mTimelineSemaphore;
+		wait_info.pValues = &value;
+		VkResult result = mVkWaitSemaphoresKHR(mDevice, &wait_info, std::numeric_limits<uint64_t>::max());
+		VKL_CHECK_VULKAN_RESULT(result);
+#endif
+	}
+
+	// Timestamps the completion of every frame, in order. A frame's GPU idle time is the time between the completion
+	// of the previous frame and its own submission. It is only known once the frame itself has completed, since only
+	// then the previous frame's completion is guaranteed to have been observed:
+	void watchCompletions()
+	{
+		uint64_t frame_number = 1;
+		Clock::time_point previous_completion;
+		for (;;) {
+			Clock::time_point submit_time;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mFrameSubmitted.wait(lock, [] { return mShutdown || !mSubmitTimes.empty(); });
+				if (mSubmitTimes.empty()) {
+					return;
+				}
+				submit_time = mSubmitTimes.front();
+				mSubmitTimes.pop_front();
+			}
+			waitForTimelineValue(frame_number);
+			const Clock::time_point completion = Clock::now();
+			if (frame_number > 1) {
+				const double idle_milliseconds = std::max(0.0, Milliseconds(submit_time - previous_completion).count());
+				std::lock_guard<std::mutex> lock(mMutex);
+				mGpuIdleResults.push_back(idle_milliseconds);
+			}
+			previous_completion = completion;
+			++frame_number;
+		}
+	}
+
+	// Updates mCompletedFrame without blocking:
+	void pollCompletedFrame()
+	{
+		if (mTimelineEnabled) {
+#if defined(VK_KHR_timeline_semaphore)
+			uint64_t value = 0;
+			VkResult result = mVkGetSemaphoreCounterValueKHR(mDevice, mTimelineSemaphore, &value);
+			VKL_CHECK_VULKAN_RESULT(result);
+			mCompletedFrame = std::max(mCompletedFrame, value);
+#endif
+			return;
+		}
+		// Frames complete in submission order, and the fences of all frames after mCompletedFrame are still in use:
+		while (mCompletedFrame + 1 < mFrameNumber && VK_SUCCESS == vkGetFenceStatus(mDevice, mFences[(mCompletedFrame + 1) % mFramesInFlight])) {
+			++mCompletedFrame;
+		}
+	}
+
+	void runDeletions(uint64_t completed_frame)
+	{
+		while (!mDeletions.empty() && mDeletions.front().frameNumber <= completed_frame) {
+			mDeletions.front().deletion();
+			mDeletions.pop_front();
+		}
+	}
+}
+
+void frameSchedulerCreate(VkDevice device, VkQueue queue, uint32_t frames_in_flight, bool timeline_semaphores_enabled)
+{
+	mDevice = device;
+	mQueue = queue;
+	mFramesInFlight = std::max(frames_in_flight, 1u);
+	mFrameNumber = 1;
+	mCompletedFrame = 0;
+	mTimelineEnabled = false;
+
+#if defined(VK_KHR_timeline_semaphore)
+	if (timeline_semaphores_enabled) {
+		mVkWaitSemaphoresKHR = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR"));
+		mVkGetSemaphoreCounterValueKHR = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR"));
+		mTimelineEnabled = nullptr != mVkWaitSemaphoresKHR && nullptr != mVkGetSemaphoreCounterValueKHR;
+	}
+	if (mTimelineEnabled) {
+		VkSemaphoreTypeCreateInfoKHR type_create_info = {};
+		type_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+		type_create_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+		type_create_info.initialValue = 0;
+		VkSemaphoreCreateInfo semaphore_create_info = {};
+		semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphore_create_info.pNext = &type_create_info;
+		VkResult result = vkCreateSemaphore(device, &semaphore_create_info, nullptr, &mTimelineSemaphore);
+		VKL_CHECK_VULKAN_RESULT(result);
+
+		mShutdown = false;
+		mCompletionThread = std::thread(watchCompletions);
+	}
+#endif
+	if (!mTimelineEnabled) {
+		VKL_LOG("Timeline semaphores are not available => frame scheduler falls back to fences, GPU idle times are not measured.");
+		VkFenceCreateInfo fence_create_info = {};
+		fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		mFences.resize(mFramesInFlight);
+		for (VkFence& fence : mFences) {
+			VkResult result = vkCreateFence(device, &fence_create_info, nullptr, &fence);
+			VKL_CHECK_VULKAN_RESULT(result);
+		}
+	}
+	VKL_LOG("Frame scheduler: " << mFramesInFlight << " frame(s) in flight.");
+}
+
+void frameSchedulerDestroy()
+{
+	// Work of the current frame might have been submitted without ending the frame => wait for the whole queue:
+	VkResult result = vkQueueWaitIdle(mQueue);
+	VKL_CHECK_VULKAN_RESULT(result);
+	runDeletions(std::numeric_limits<uint64_t>::max());
+
+	if (mCompletionThread.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mShutdown = true;
+		}
+		mFrameSubmitted.notify_one();
+		mCompletionThread.join();
+	}
+	mSubmitTimes.clear();
+	mGpuIdleResults.clear();
+	if (VK_NULL_HANDLE != mTimelineSemaphore) {
+		vkDestroySemaphore(mDevice, mTimelineSemaphore, nullptr);
+		mTimelineSemaphore = VK_NULL_HANDLE;
+	}
+	for (VkFence fence : mFences) {
+		vkDestroyFence(mDevice, fence, nullptr);
+	}
+	mFences.clear();
+	mCpuWaitDestination = nullptr;
+	mGpuIdleDestination = nullptr;
+	mCpuWaitHistory = {};
+	mGpuIdleHistory = {};
+	mDevice = VK_NULL_HANDLE;
+}
+
+void frameSchedulerBeginFrame()
+{
+	pollCompletedFrame();
+	double wait_milliseconds = 0.0;
+	if (mFrameNumber > mFramesInFlight && mCompletedFrame < mFrameNumber - mFramesInFlight) {
+		PROFILER_ZONE("Wait For GPU");
+		const Clock::time_point wait_start = Clock::now();
+		frameSchedulerWaitForFrame(mFrameNumber - mFramesInFlight);
+		wait_milliseconds = Milliseconds(Clock::now() - wait_start).count();
+	}
+	addToHistory(mCpuWaitHistory, wait_milliseconds);
+	if (nullptr != mCpuWaitDestination) {
+		mCpuWaitDestination->push_back(wait_milliseconds);
+	}
+
+	std::vector<double> gpu_idle_results;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		gpu_idle_results.swap(mGpuIdleResults);
+	}
+	for (double idle_milliseconds : gpu_idle_results) {
+		addToHistory(mGpuIdleHistory, idle_milliseconds);
+		if (nullptr != mGpuIdleDestination) {
+			mGpuIdleDestination->push_back(idle_milliseconds);
+		}
+	}
+
+	runDeletions(mCompletedFrame);
+}
+
+void frameSchedulerEndFrame()
+{
+	// An empty submission signals once all previously submitted work has completed:
+	if (mTimelineEnabled) {
+#if defined(VK_KHR_timeline_semaphore)
+		VkTimelineSemaphoreSubmitInfoKHR timeline_submit_info = {};
+		timeline_submit_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+		timeline_submit_info.signalSemaphoreValueCount = 1;
+		timeline_submit_info.pSignalSemaphoreValues = &mFrameNumber;
+		VkSubmitInfo submit_info = {};
+		submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submit_info.pNext = &timeline_submit_info;
+		submit_info.signalSemaphoreCount = 1;
+		submit_info.pSignalSemaphores = &mTimelineSemaphore;
+		VkResult result = vkQueueSubmit(mQueue, 1, &submit_info, VK_NULL_HANDLE);
+		VKL_CHECK_VULKAN_RESULT(result);
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mSubmitTimes.push_back(Clock::now());
+		}
+		mFrameSubmitted.notify_one();
+#endif
+	}
+	else {
+		// frameSchedulerBeginFrame has waited for the frame which used this fence before:
+		VkFence fence = mFences[mFrameNumber % mFramesInFlight];
+		VkResult result = vkResetFences(mDevice, 1, &fence);
+		VKL_CHECK_VULKAN_RESULT(result);
+		result = vkQueueSubmit(mQueue, 0, nullptr, fence);
+		VKL_CHECK_VULKAN_RESULT(result);
+	}
+	++mFrameNumber;
+}
+
+void frameSchedulerDeferDeletion(std::function<void()> deletion)
+{
+	mDeletions.push_back(PendingDeletion{ mFrameNumber, std::move(deletion) });
+}
+
+uint64_t frameSchedulerGetFrameNumber()
+{
+	return mFrameNumber;
+}
+
+uint64_t frameSchedulerGetCompletedFrameNumber()
+{
+	pollCompletedFrame();
+	return mCompletedFrame;
+}
+
+void frameSchedulerWaitForFrame(uint64_t frame_number)
+{
+	if (frame_number <= mCompletedFrame) {
+		return;
+	}
+	if (mTimelineEnabled) {
+		waitForTimelineValue(frame_number);
+	}
+	else {
+		// Only the latest mFramesInFlight frames can be incomplete, and their fences have not been reused yet:
+		VkResult result = vkWaitForFences(mDevice, 1, &mFences[frame_number % mFramesInFlight], VK_TRUE, std::numeric_limits<uint64_t>::max());
+		VKL_CHECK_VULKAN_RESULT(result);
+	}
+	// All earlier frames have been submitted before => they have completed, too:
+	mCompletedFrame = frame_number;
+}
+
+uint32_t frameSchedulerGetFramesInFlight()
+{
+	return mFramesInFlight;
+}
+
+FrameSchedulerStatistics frameSchedulerGetStatistics()
+{
+	FrameSchedulerStatistics statistics;
+	statistics.cpuWaitMilliseconds = averageOf(mCpuWaitHistory);
+	statistics.gpuIdleMilliseconds = mTimelineEnabled ? averageOf(mGpuIdleHistory) : -1.0;
+	return statistics;
+}
+
+void frameSchedulerCollectFrameTimes(std::vector<double>* cpu_wait_destination, std::vector<double>* gpu_idle_destination)
+{
+	mCpuWaitDestination = cpu_wait_destination;
+	mGpuIdleDestination = gpu_idle_destination;
+}
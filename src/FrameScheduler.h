@@ -0,0 +1,107 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/* --------------------------------------------- */
+// Frame Scheduler
+//
+// Controls how far the CPU runs ahead of the GPU. Frames are numbered from
+// 1. At the end of frame N, an empty submission signals N on a timeline
+// semaphore (VK_KHR_timeline_semaphore), which happens once the GPU has
+// finished all work submitted so far. At the beginning of frame N, the CPU
+// waits until frame N - framesInFlight has finished. Hence, one frame in
+// flight means lowest latency (the CPU never records while the GPU renders),
+// more frames in flight mean more overlap and throughput.
+//
+// Objects which the GPU might still use are retired with
+// frameSchedulerDeferDeletion: they are destroyed once the current frame
+// has finished on the GPU.
+//
+// A background thread timestamps the completion of every frame, so that the
+// time in which the GPU idled between frames can be measured. Without timeline
+// semaphores, one fence per frame in flight is used instead, and GPU idle
+// times are not available.
+/* --------------------------------------------- */
+
+/*!
+ *	Averages over the recent frames, in milliseconds.
+ */
+struct FrameSchedulerStatistics {
+	//! Time the CPU has been blocked in frameSchedulerBeginFrame, waiting for the GPU
+	double cpuWaitMilliseconds;
+
+	//! Time between the GPU finishing a frame and the CPU submitting the next one, or a negative value if unavailable
+	double gpuIdleMilliseconds;
+};
+
+/*!
+ *	Creates the timeline semaphore (or fences) and starts the completion thread.
+ *	@param	device							Device handle
+ *	@param	queue							The queue which all frames are submitted to
+ *	@param	frames_in_flight				Number of frames which the CPU may submit before the first of them has finished, at least 1
+ *	@param	timeline_semaphores_enabled		Whether VK_KHR_timeline_semaphore has been enabled on the device
+ */
+void frameSchedulerCreate(VkDevice device, VkQueue queue, uint32_t frames_in_flight, bool timeline_semaphores_enabled);
+
+/*!
+ *	Waits for all frames to finish, runs all deferred deletions, and destroys the scheduler.
+ */
+void frameSchedulerDestroy();
+
+/*!
+ *	Begins a frame: waits until no more than frames_in_flight - 1 frames are pending on the GPU, and
+ *	runs the deferred deletions of all finished frames. Call this at the start of every frame.
+ */
+void frameSchedulerBeginFrame();
+
+/*!
+ *	Ends a frame: signals its completion after all work which has been submitted so far.
+ *	Call this after the frame's last submission, i.e., after presenting.
+ */
+void frameSchedulerEndFrame();
+
+/*!
+ *	Retires an object: the given function is called once the GPU has finished the current frame,
+ *	i.e., all work which has been or will be submitted before the next frameSchedulerEndFrame.
+ *	@param	deletion	Destroys the object
+ */
+void frameSchedulerDeferDeletion(std::function<void()> deletion);
+
+/*!
+ *	Returns the number of the current frame, starting at 1.
+ */
+uint64_t frameSchedulerGetFrameNumber();
+
+/*!
+ *	Returns the number of the latest frame which the GPU has finished, or 0 if none.
+ */
+uint64_t frameSchedulerGetCompletedFrameNumber();
+
+/*!
+ *	Blocks until the GPU has finished the given frame.
+ *	@param	frame_number	A frame number which has ended already
+ */
+void frameSchedulerWaitForFrame(uint64_t frame_number);
+
+/*!
+ *	Returns the number of frames which may be in flight.
+ */
+uint32_t frameSchedulerGetFramesInFlight();
+
+/*!
+ *	Returns averages over the most recent frames.
+ */
+FrameSchedulerStatistics frameSchedulerGetStatistics();
+
+/*!
+ *	Appends the CPU wait time and the GPU idle time of every frame to the given vectors, for benchmark statistics.
+ *	GPU idle times are appended once the next frame has been submitted. Pass nullptr to stop collecting.
+ *	@param	cpu_wait_destination	Receives CPU wait times in milliseconds
+ *	@param	gpu_idle_destination	Receives GPU idle times in milliseconds; nothing is appended if unavailable.
+ */
+void frameSchedulerCollectFrameTimes(std::vector<double>* cpu_wait_destination, std::vector<double>* gpu_idle_destination);
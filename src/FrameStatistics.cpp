@@ -0,0 +1,61 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "FrameStatistics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+namespace
+{
+	void writeSummary(FILE* file, const char* key, const std::vector<double>& values, bool last)
+	{
+		if (values.empty()) {
+			fprintf(file, "  \"%s\": null%s\n", key, last ? "" : ",");
+			return;
+		}
+		const double sum = std::accumulate(values.begin(), values.end(), 0.0);
+		const auto minmax = std::minmax_element(values.begin(), values.end());
+		fprintf(file, "  \"%s\": { \"samples\": %zu, \"mean\": %.4f, \"min\": %.4f, \"max\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f }%s\n",
+			key, values.size(), sum / static_cast<double>(values.size()), *minmax.first, *minmax.second,
+			frameStatisticsPercentile(values, 50.0), frameStatisticsPercentile(values, 95.0), frameStatisticsPercentile(values, 99.0),
+			last ? "" : ",");
+	}
+}
+
+double frameStatisticsPercentile(std::vector<double> values, double percentile)
+{
+	if (values.empty()) {
+		return 0.0;
+	}
+	const double rank = std::ceil(percentile / 100.0 * static_cast<double>(values.size()));
+	const size_t index = static_cast<size_t>(std::min(std::max(rank, 1.0), static_cast<double>(values.size()))) - 1;
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+	return values[index];
+}
+
+bool frameStatisticsWriteJson(const FrameStatistics& statistics, const char* path, const char* run_name)
+{
+	FILE* file = fopen(path, "w");
+	if (nullptr == file) {
+		return false;
+	}
+
+	fprintf(file, "{\n  \"run\": \"");
+	for (const char* c = run_name; *c != '\0'; ++c) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', file);
+		}
+		fputc(*c, file);
+	}
+	fprintf(file, "\",\n  \"frames\": %zu,\n", statistics.frameMilliseconds.size());
+	writeSummary(file, "frameTimeMs", statistics.frameMilliseconds, false);
+	writeSummary(file, "cpuTimeMs", statistics.cpuMilliseconds, false);
+	writeSummary(file, "gpuTimeMs", statistics.gpuMilliseconds, false);
+	writeSummary(file, "cpuWaitTimeMs", statistics.cpuWaitMilliseconds, false);
+	writeSummary(file, "gpuIdleTimeMs", statistics.gpuIdleMilliseconds, true);
+	fprintf(file, "}\n");
+
+	return 0 == fclose(file);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <vector>
+
+/* --------------------------------------------- */
+// Frame Statistics
+//
+// Collects per-frame timings of a benchmark run and summarizes them as
+// mean, min, max, and percentiles in a JSON file.
+/* --------------------------------------------- */
+
+/*!
+ *	Per-frame timings of a benchmark run in milliseconds.
+ */
+struct FrameStatistics {
+	//! Wall-clock time from the start of one frame to the start of the next one.
+	std::vector<double> frameMilliseconds;
+
+	//! CPU time spent on a frame, excluding the time spent blocking in swapchain acquire and present, and waiting for the GPU.
+	std::vector<double> cpuMilliseconds;
+
+	//! GPU time of a frame as measured by the GPU profiler. Might contain fewer entries than the
+	//! other vectors (e.g., if the GPU profiler is not available).
+	std::vector<double> gpuMilliseconds;
+
+	//! Time the CPU waited for the GPU at the start of a frame, to limit the number of frames in flight.
+	std::vector<double> cpuWaitMilliseconds;
+
+	//! Time the GPU idled before a frame was submitted, as measured by the frame scheduler. Might contain
+	//! fewer entries than the other vectors (e.g., if timeline semaphores are not available).
+	std::vector<double> gpuIdleMilliseconds;
+};
+
+/*!
+ *	Computes the given percentile of the given values using the nearest-rank method.
+ *	@param	values		The values; need not be sorted.
+ *	@param	percentile	The percentile in the range [0, 100]
+ *	@return	The percentile, or 0 if values is empty.
+ */
+double frameStatisticsPercentile(std::vector<double> values, double percentile);
+
+/*!
+ *	Writes a summary (mean, min, max, p50, p95, p99) of the given statistics into a JSON file.
+ *	@param	statistics		The collected timings
+ *	@param	path			Path of the JSON file to write
+ *	@param	run_name		A name describing the run, e.g., the camera path's file name
+ *	@return	True on success, false if the file could not be written.
+ */
+bool frameStatisticsWriteJson(const FrameStatistics& statistics, const char* path, const char* run_name);
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "GeometryPool.h"
+#include "VulkanHelpers.h"
+#include <VulkanLaunchpad.h>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	struct FreeRange {
+		uint32_t offset;
+		uint32_t count;
+	};
+
+	// Free ranges, sorted by offset. Adjacent free ranges are always merged.
+	class FreeList
+	{
+	public:
+		void reset(uint32_t capacity)
+		{
+			mRanges.clear();
+			if (capacity > 0) {
+				mRanges.push_back(FreeRange{ 0, capacity });
+			}
+		}
+
+		// Returns the offset of the allocated range, or kNoSpace
+		uint32_t allocate(uint32_t count)
+		{
+			for (size_t i = 0; i < mRanges.size(); ++i) {
+				if (mRanges[i].count >= count) {
+					const uint32_t offset = mRanges[i].offset;
+					mRanges[i].offset += count;
+					mRanges[i].count -= count;
+					if (0 == mRanges[i].count) {
+						mRanges.erase(mRanges.begin() + i);
+					}
+					return offset;
+				}
+			}
+			return kNoSpace;
+		}
+
+		void free(uint32_t offset, uint32_t count)
+		{
+			if (0 == count) {
+				return;
+			}
+			size_t i = 0;
+			while (i < mRanges.size() && mRanges[i].offset < offset) {
+				++i;
+			}
+			const bool merge_with_previous = i > 0 && mRanges[i - 1].offset + mRanges[i - 1].count == offset;
+			const bool merge_with_next = i < mRanges.size() && offset + count == mRanges[i].offset;
+			if (merge_with_previous && merge_with_next) {
+				mRanges[i - 1].count += count + mRanges[i].count;
+				mRanges.erase(mRanges.begin() + i);
+			}
+			else if (merge_with_previous) {
+				mRanges[i - 1].count += count;
+			}
+			else if (merge_with_next) {
+				mRanges[i].offset = offset;
+				mRanges[i].count += count;
+			}
+			else {
+				mRanges.insert(mRanges.begin() + i, FreeRange{ offset, count });
+			}
+		}
+
+		static constexpr uint32_t kNoSpace = 0xFFFFFFFFu;
+
+	private:
+		std::vector<FreeRange> mRanges;
+	};
+
+	struct PoolMesh {
+		const char*       name;
+		GeometryPoolRange range;
+		bool              alive;
+	};
+
+	VkDevice mDevice = VK_NULL_HANDLE;
+	HlpMappedBuffer mVertexBuffer = {};
+	HlpMappedBuffer mIndexBuffer = {};
+	FreeList mFreeVertices;
+	FreeList mFreeIndices;
+	std::vector<PoolMesh> mMeshes;
+	std::vector<GeometryPoolMesh> mFreeMeshHandles;
+	// Guards the free-lists and mMeshes, since meshes are added from job system workers:
+	std::mutex mMutex;
+}
+
+void geometryPoolCreate(VkPhysicalDevice physical_device, VkDevice device, uint32_t max_vertices, uint32_t max_indices)
+{
+	mDevice = device;
+	mVertexBuffer = hlpCreateMappedBuffer(physical_device, device, sizeof(glm::vec3) * static_cast<VkDeviceSize>(max_vertices),
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, MEMORY_CATEGORY_GEOMETRY, "Geometry Pool Vertices");
+	mIndexBuffer = hlpCreateMappedBuffer(physical_device, device, sizeof(uint32_t) * static_cast<VkDeviceSize>(max_indices),
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT, MEMORY_CATEGORY_GEOMETRY, "Geometry Pool Indices");
+	mFreeVertices.reset(max_vertices);
+	mFreeIndices.reset(max_indices);
+	mMeshes.clear();
+	mFreeMeshHandles.clear();
+}
+
+void geometryPoolDestroy()
+{
+	hlpDestroyMappedBuffer(mDevice, mVertexBuffer);
+	hlpDestroyMappedBuffer(mDevice, mIndexBuffer);
+	mMeshes.clear();
+	mFreeMeshHandles.clear();
+	mDevice = VK_NULL_HANDLE;
+}
+
+GeometryPoolMesh geometryPoolAddMesh(const char* name, const glm::vec3* positions, uint32_t num_vertices, const uint32_t* indices, uint32_t num_indices)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	const uint32_t first_vertex = mFreeVertices.allocate(num_vertices);
+	if (FreeList::kNoSpace == first_vertex) {
+		VKL_LOG("Geometry pool: not enough space for the " << num_vertices << " vertices of \"" << name << "\"");
+		return kGeometryPoolInvalidMesh;
+	}
+	const uint32_t first_index = mFreeIndices.allocate(num_indices);
+	if (FreeList::kNoSpace == first_index) {
+		mFreeVertices.free(first_vertex, num_vertices);
+		VKL_LOG("Geometry pool: not enough space for the " << num_indices << " indices of \"" << name << "\"");
+		return kGeometryPoolInvalidMesh;
+	}
+
+	// The ranges belong to this mesh now, so the (potentially large) copies can run concurrently to other calls.
+	// Indices stay relative to the mesh's first vertex; vertexOffset is added when drawing:
+	lock.unlock();
+	memcpy(static_cast<glm::vec3*>(mVertexBuffer.mappedData) + first_vertex, positions, sizeof(glm::vec3) * num_vertices);
+	memcpy(static_cast<uint32_t*>(mIndexBuffer.mappedData) + first_index, indices, sizeof(uint32_t) * num_indices);
+	lock.lock();
+
+	PoolMesh pool_mesh;
+	pool_mesh.name = name;
+	pool_mesh.range.firstIndex = first_index;
+	pool_mesh.range.indexCount = num_indices;
+	pool_mesh.range.vertexOffset = static_cast<int32_t>(first_vertex);
+	pool_mesh.range.vertexCount = num_vertices;
+	pool_mesh.alive = true;
+
+	GeometryPoolMesh mesh;
+	if (!mFreeMeshHandles.empty()) {
+		mesh = mFreeMeshHandles.back();
+		mFreeMeshHandles.pop_back();
+		mMeshes[mesh] = pool_mesh;
+	}
+	else {
+		mesh = static_cast<GeometryPoolMesh>(mMeshes.size());
+		mMeshes.push_back(pool_mesh);
+	}
+	return mesh;
+}
+
+void geometryPoolRemoveMesh(GeometryPoolMesh mesh)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	PoolMesh& pool_mesh = mMeshes[mesh];
+	if (!pool_mesh.alive) {
+		VKL_LOG("Geometry pool: mesh " << mesh << " has already been removed");
+		return;
+	}
+	mFreeVertices.free(static_cast<uint32_t>(pool_mesh.range.vertexOffset), pool_mesh.range.vertexCount);
+	mFreeIndices.free(pool_mesh.range.firstIndex, pool_mesh.range.indexCount);
+	pool_mesh.alive = false;
+	mFreeMeshHandles.push_back(mesh);
+}
+
+GeometryPoolRange geometryPoolGetRange(GeometryPoolMesh mesh)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mMeshes[mesh].range;
+}
+
+VkBuffer geometryPoolGetVertexBuffer()
+{
+	return mVertexBuffer.buffer;
+}
+
+VkBuffer geometryPoolGetIndexBuffer()
+{
+	return mIndexBuffer.buffer;
+}
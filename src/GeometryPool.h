@@ -0,0 +1,88 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+
+/* --------------------------------------------- */
+// Geometry Pool
+//
+// All static meshes share one vertex buffer and one index buffer. Every mesh
+// occupies a range of vertices and a range of indices, which are drawn with
+// vertexOffset and firstIndex. Hence, the buffers are bound once per frame,
+// no matter how many different meshes are drawn.
+//
+// Vertex and index ranges are managed with free-lists (first fit, adjacent
+// free ranges are merged), so meshes can be removed and their space reused.
+// Adding, removing and querying meshes is thread-safe.
+/* --------------------------------------------- */
+
+//! Handle to a mesh in the geometry pool
+typedef uint32_t GeometryPoolMesh;
+
+//! Returned by geometryPoolAddMesh if the pool is out of space
+constexpr GeometryPoolMesh kGeometryPoolInvalidMesh = 0xFFFFFFFFu;
+
+/*!
+ *	The ranges which a mesh occupies in the geometry pool's buffers, i.e., the parameters for vkCmdDrawIndexed.
+ */
+struct GeometryPoolRange {
+	//! First index of the mesh in the index buffer
+	uint32_t firstIndex;
+
+	//! Number of indices of the mesh
+	uint32_t indexCount;
+
+	//! Value added to every index, i.e., the mesh's first vertex in the vertex buffer
+	int32_t vertexOffset;
+
+	//! Number of vertices of the mesh
+	uint32_t vertexCount;
+};
+
+/*!
+ *	Creates the geometry pool's vertex and index buffers.
+ *	@param	physical_device		Physical device, used to select a memory type
+ *	@param	device				Device handle
+ *	@param	max_vertices		Capacity of the vertex buffer (vertices are 3 floats)
+ *	@param	max_indices			Capacity of the index buffer (indices are 32 bits)
+ */
+void geometryPoolCreate(VkPhysicalDevice physical_device, VkDevice device, uint32_t max_vertices, uint32_t max_indices);
+
+/*!
+ *	Destroys the geometry pool's buffers. The device must be idle.
+ */
+void geometryPoolDestroy();
+
+/*!
+ *	Copies a mesh into the geometry pool.
+ *	@param	name			Name of the mesh, used in log messages. Must stay valid until the mesh is removed.
+ *	@param	positions		Vertex positions
+ *	@param	num_vertices	Number of vertex positions
+ *	@param	indices			Triangle list indices, relative to the mesh's first vertex
+ *	@param	num_indices		Number of indices
+ *	@return	Handle to the new mesh, or kGeometryPoolInvalidMesh if there is not enough contiguous space left.
+ */
+GeometryPoolMesh geometryPoolAddMesh(const char* name, const glm::vec3* positions, uint32_t num_vertices, const uint32_t* indices, uint32_t num_indices);
+
+/*!
+ *	Removes a mesh and returns its ranges to the free-lists. The GPU must not use the mesh anymore.
+ */
+void geometryPoolRemoveMesh(GeometryPoolMesh mesh);
+
+/*!
+ *	Returns the ranges which the given mesh occupies.
+ */
+GeometryPoolRange geometryPoolGetRange(GeometryPoolMesh mesh);
+
+/*!
+ *	Returns the vertex buffer which all meshes share.
+ */
+VkBuffer geometryPoolGetVertexBuffer();
+
+/*!
+ *	Returns the index buffer which all meshes share. Its index type is VK_INDEX_TYPE_UINT32.
+ */
+VkBuffer geometryPoolGetIndexBuffer();
@@ -0,0 +1,416 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "GpuProfiler.h"
+
+#if PROFILER_ENABLED
+
+#include <VulkanLaunchpad.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace
+{
+	constexpr uint32_t kMaxScopesPerFrame = 64;
+	constexpr uint32_t kHistoryLength = 64;
+	constexpr uint32_t kNumStatistics = 3;
+	constexpr uint32_t kNoQuery = std::numeric_limits<uint32_t>::max();
+
+	// The results of a pipeline statistics query are ordered by bit position:
+	// [0] vertex shader invocations, [1] clipping primitives, [2] fragment shader invocations
+	constexpr VkQueryPipelineStatisticFlags kStatisticsFlags =
+		VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+		VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+	struct GpuScope {
+		const char* name;
+		uint32_t    depth;
+		uint32_t    statisticsQuery;
+	};
+
+	struct GpuFrame {
+		VkQueryPool         timestampPool = VK_NULL_HANDLE;
+		VkQueryPool         statisticsPool = VK_NULL_HANDLE;
+		VkCommandBuffer     resetCommandBuffer = VK_NULL_HANDLE;
+		VkFence             fence = VK_NULL_HANDLE;
+		std::vector<GpuScope> scopes;
+		uint32_t            numStatisticsQueries = 0;
+		double              submitMicroseconds = 0.0;
+		bool                pending = false;
+	};
+
+	struct GpuScopeHistory {
+		const char* name;
+		double      milliseconds[kHistoryLength];
+		uint64_t    statistics[kHistoryLength][kNumStatistics];
+		bool        hasStatistics;
+		uint32_t    count;
+	};
+
+	bool mAvailable = false;
+	VkDevice mDevice = VK_NULL_HANDLE;
+	VkQueue mQueue = VK_NULL_HANDLE;
+	VkCommandPool mCommandPool = VK_NULL_HANDLE;
+	bool mStatisticsEnabled = false;
+	double mTimestampPeriod = 1.0;
+	uint64_t mTimestampMask = ~0ull;
+	uint32_t mLogInterval = 0;
+	uint32_t mTrack = 0;
+
+	std::vector<GpuFrame> mFrames;
+	uint64_t mFrameNumber = 0;
+	uint64_t mResolvedFrames = 0;
+	std::vector<uint32_t> mOpenScopes;
+	std::vector<GpuScopeHistory> mHistories;
+	std::vector<uint64_t> mTimestampResults;
+	std::vector<uint64_t> mStatisticsResults;
+	double mLatestFrameMilliseconds = -1.0;
+	std::vector<double>* mFrameTimesDestination = nullptr;
+	double mGpuToCpuOffsetMicroseconds = std::numeric_limits<double>::lowest();
+
+	GpuScopeHistory& getHistory(const char* name)
+	{
+		for (auto& history : mHistories) {
+			if (history.name == name || strcmp(history.name, name) == 0) {
+				return history;
+			}
+		}
+		mHistories.push_back(GpuScopeHistory{});
+		mHistories.back().name = name;
+		return mHistories.back();
+	}
+
+	double timestampToMicroseconds(uint64_t timestamp)
+	{
+		return static_cast<double>(timestamp & mTimestampMask) * mTimestampPeriod / 1000.0;
+	}
+
+	void logAverages()
+	{
+		for (const auto& history : mHistories) {
+			const uint32_t n = std::min(history.count, kHistoryLength);
+			if (0 == n) {
+				continue;
+			}
+			double sum_ms = 0.0;
+			uint64_t sum_statistics[kNumStatistics] = {};
+			for (uint32_t i = 0; i < n; ++i) {
+				sum_ms += history.milliseconds[i];
+				for (uint32_t s = 0; s < kNumStatistics; ++s) {
+					sum_statistics[s] += history.statistics[i][s];
+				}
+			}
+			if (history.hasStatistics) {
+				VKL_LOG("GPU \"" << history.name << "\": " << (sum_ms / n) << " ms (avg. of " << n << " frames)"
+					<< ", VS invocations: " << (sum_statistics[0] / n)
+					<< ", clipping primitives: " << (sum_statistics[1] / n)
+					<< ", FS invocations: " << (sum_statistics[2] / n));
+			}
+			else {
+				VKL_LOG("GPU \"" << history.name << "\": " << (sum_ms / n) << " ms (avg. of " << n << " frames)");
+			}
+		}
+	}
+
+	void resolveFrame(GpuFrame& frame)
+	{
+		frame.pending = false;
+		const uint32_t num_scopes = static_cast<uint32_t>(frame.scopes.size());
+		if (0 == num_scopes) {
+			return;
+		}
+
+		// The frame's fence has been signaled => all results are available, no need to wait:
+		mTimestampResults.resize(2 * num_scopes);
+		VkResult result = vkGetQueryPoolResults(mDevice, frame.timestampPool, 0, 2 * num_scopes,
+			mTimestampResults.size() * sizeof(uint64_t), mTimestampResults.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (VK_SUCCESS != result) {
+			return;
+		}
+		if (frame.numStatisticsQueries > 0) {
+			mStatisticsResults.resize(kNumStatistics * frame.numStatisticsQueries);
+			result = vkGetQueryPoolResults(mDevice, frame.statisticsPool, 0, frame.numStatisticsQueries,
+				mStatisticsResults.size() * sizeof(uint64_t), mStatisticsResults.data(), kNumStatistics * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+			if (VK_SUCCESS != result) {
+				mStatisticsResults.assign(mStatisticsResults.size(), 0);
+			}
+		}
+
+		double frame_begin_us = std::numeric_limits<double>::max();
+		double frame_end_us = std::numeric_limits<double>::lowest();
+		for (uint32_t i = 0; i < num_scopes; ++i) {
+			frame_begin_us = std::min(frame_begin_us, timestampToMicroseconds(mTimestampResults[2 * i]));
+			frame_end_us = std::max(frame_end_us, timestampToMicroseconds(mTimestampResults[2 * i + 1]));
+		}
+		mLatestFrameMilliseconds = (frame_end_us - frame_begin_us) / 1000.0;
+		if (nullptr != mFrameTimesDestination) {
+			mFrameTimesDestination->push_back(mLatestFrameMilliseconds);
+		}
+
+		// GPU timestamps live in a different time domain than the CPU profiler's timestamps. The GPU cannot
+		// have started a frame before it was submitted, so the submission time is a lower bound which we
+		// use to place GPU zones on the CPU timeline (approximately):
+		mGpuToCpuOffsetMicroseconds = std::max(mGpuToCpuOffsetMicroseconds, frame.submitMicroseconds - frame_begin_us);
+
+		for (uint32_t i = 0; i < num_scopes; ++i) {
+			const GpuScope& scope = frame.scopes[i];
+			const double begin_us = timestampToMicroseconds(mTimestampResults[2 * i]);
+			const double duration_us = static_cast<double>((mTimestampResults[2 * i + 1] - mTimestampResults[2 * i]) & mTimestampMask) * mTimestampPeriod / 1000.0;
+
+			GpuScopeHistory& history = getHistory(scope.name);
+			const uint32_t slot = history.count % kHistoryLength;
+			history.milliseconds[slot] = duration_us / 1000.0;
+			for (uint32_t s = 0; s < kNumStatistics; ++s) {
+				history.statistics[slot][s] = kNoQuery != scope.statisticsQuery ? mStatisticsResults[kNumStatistics * scope.statisticsQuery + s] : 0;
+			}
+			history.hasStatistics = history.hasStatistics || kNoQuery != scope.statisticsQuery;
+			++history.count;
+
+			profilerRecordTrackZone(mTrack, scope.name, begin_us + mGpuToCpuOffsetMicroseconds, duration_us);
+		}
+
+		++mResolvedFrames;
+		if (mLogInterval > 0 && 0 == mResolvedFrames % mLogInterval) {
+			logAverages();
+		}
+	}
+
+	void resolveFinishedFrames()
+	{
+		// Frames finish in submission order. Start with the oldest one, which uses the same slot as the new frame:
+		const uint64_t num_frames = mFrames.size();
+		for (uint64_t i = 0; i < num_frames; ++i) {
+			GpuFrame& frame = mFrames[(mFrameNumber + i) % num_frames];
+			if (!frame.pending) {
+				continue;
+			}
+			if (VK_SUCCESS != vkGetFenceStatus(mDevice, frame.fence)) {
+				break;
+			}
+			resolveFrame(frame);
+		}
+	}
+}
+
+bool gpuProfilerCreate(VkPhysicalDevice physical_device, VkDevice device, VkQueue queue, uint32_t queue_family_index,
+	uint32_t num_frames, bool enable_pipeline_statistics, uint32_t log_interval)
+{
+	uint32_t queue_family_count = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+	std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
+	const uint32_t valid_bits = queue_family_index < queue_family_count ? queue_families[queue_family_index].timestampValidBits : 0;
+	if (0 == valid_bits) {
+		VKL_LOG("The selected queue family does not support timestamps => GPU profiler disabled.");
+		return false;
+	}
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+	mDevice = device;
+	mQueue = queue;
+	mStatisticsEnabled = enable_pipeline_statistics;
+	mTimestampPeriod = static_cast<double>(properties.limits.timestampPeriod);
+	mTimestampMask = valid_bits >= 64 ? ~0ull : ((1ull << valid_bits) - 1ull);
+	mLogInterval = log_interval;
+	mTrack = profilerCreateTrack("GPU");
+
+	VkCommandPoolCreateInfo command_pool_create_info = {};
+	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_create_info.queueFamilyIndex = queue_family_index;
+	VkResult result = vkCreateCommandPool(device, &command_pool_create_info, nullptr, &mCommandPool);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	mFrames.resize(std::max(num_frames, 2u));
+	for (GpuFrame& frame : mFrames) {
+		VkQueryPoolCreateInfo timestamp_pool_create_info = {};
+		timestamp_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		timestamp_pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		timestamp_pool_create_info.queryCount = 2 * kMaxScopesPerFrame;
+		result = vkCreateQueryPool(device, &timestamp_pool_create_info, nullptr, &frame.timestampPool);
+		VKL_CHECK_VULKAN_RESULT(result);
+
+		if (mStatisticsEnabled) {
+			VkQueryPoolCreateInfo statistics_pool_create_info = {};
+			statistics_pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			statistics_pool_create_info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+			statistics_pool_create_info.queryCount = kMaxScopesPerFrame;
+			statistics_pool_create_info.pipelineStatistics = kStatisticsFlags;
+			result = vkCreateQueryPool(device, &statistics_pool_create_info, nullptr, &frame.statisticsPool);
+			VKL_CHECK_VULKAN_RESULT(result);
+		}
+
+		VkFenceCreateInfo fence_create_info = {};
+		fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		result = vkCreateFence(device, &fence_create_info, nullptr, &frame.fence);
+		VKL_CHECK_VULKAN_RESULT(result);
+
+		// Queries must be reset outside of a render pass, but Vulkan Launchpad's command buffers begin
+		// their render pass right away. Hence, resets are recorded once into separate command buffers
+		// which are submitted at the beginning of every frame:
+		VkCommandBufferAllocateInfo command_buffer_alloc_info = {};
+		command_buffer_alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		command_buffer_alloc_info.commandPool = mCommandPool;
+		command_buffer_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		command_buffer_alloc_info.commandBufferCount = 1;
+		result = vkAllocateCommandBuffers(device, &command_buffer_alloc_info, &frame.resetCommandBuffer);
+		VKL_CHECK_VULKAN_RESULT(result);
+
+		VkCommandBufferBeginInfo begin_info = {};
+		begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		vkBeginCommandBuffer(frame.resetCommandBuffer, &begin_info);
+		vkCmdResetQueryPool(frame.resetCommandBuffer, frame.timestampPool, 0, 2 * kMaxScopesPerFrame);
+		if (VK_NULL_HANDLE != frame.statisticsPool) {
+			vkCmdResetQueryPool(frame.resetCommandBuffer, frame.statisticsPool, 0, kMaxScopesPerFrame);
+		}
+		result = vkEndCommandBuffer(frame.resetCommandBuffer);
+		VKL_CHECK_VULKAN_RESULT(result);
+
+		frame.scopes.reserve(kMaxScopesPerFrame);
+	}
+
+	mAvailable = true;
+	return true;
+}
+
+void gpuProfilerDestroy()
+{
+	if (!mAvailable) {
+		return;
+	}
+	resolveFinishedFrames();
+	mFrameTimesDestination = nullptr;
+
+	for (GpuFrame& frame : mFrames) {
+		vkDestroyFence(mDevice, frame.fence, nullptr);
+		vkDestroyQueryPool(mDevice, frame.timestampPool, nullptr);
+		if (VK_NULL_HANDLE != frame.statisticsPool) {
+			vkDestroyQueryPool(mDevice, frame.statisticsPool, nullptr);
+		}
+	}
+	vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
+	mFrames.clear();
+	mHistories.clear();
+	mAvailable = false;
+}
+
+void gpuProfilerBeginFrame()
+{
+	if (!mAvailable) {
+		return;
+	}
+	resolveFinishedFrames();
+
+	GpuFrame& frame = mFrames[mFrameNumber % mFrames.size()];
+	if (frame.pending) {
+		// Only happens if more frames are in flight than the profiler has been configured for:
+		PROFILER_ZONE("GPU Profiler Stall");
+		vkWaitForFences(mDevice, 1, &frame.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		resolveFrame(frame);
+	}
+	vkResetFences(mDevice, 1, &frame.fence);
+
+	VkSubmitInfo submit_info = {};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &frame.resetCommandBuffer;
+	VkResult result = vkQueueSubmit(mQueue, 1, &submit_info, VK_NULL_HANDLE);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	frame.scopes.clear();
+	frame.numStatisticsQueries = 0;
+	mOpenScopes.clear();
+}
+
+void gpuProfilerEndFrame()
+{
+	if (!mAvailable) {
+		return;
+	}
+	if (!mOpenScopes.empty()) {
+		VKL_LOG("GPU profiler: " << mOpenScopes.size() << " scope(s) have not been ended in frame " << mFrameNumber);
+	}
+
+	// An empty submission signals its fence once all previously submitted work has completed:
+	GpuFrame& frame = mFrames[mFrameNumber % mFrames.size()];
+	VkResult result = vkQueueSubmit(mQueue, 0, nullptr, frame.fence);
+	VKL_CHECK_VULKAN_RESULT(result);
+	frame.submitMicroseconds = profilerTimestampToMicroseconds(profilerNow());
+	frame.pending = true;
+	++mFrameNumber;
+}
+
+void gpuProfilerBeginScope(VkCommandBuffer command_buffer, const char* name)
+{
+	if (!mAvailable) {
+		return;
+	}
+	GpuFrame& frame = mFrames[mFrameNumber % mFrames.size()];
+	if (frame.scopes.size() >= kMaxScopesPerFrame) {
+		mOpenScopes.push_back(kNoQuery);
+		return;
+	}
+
+	const uint32_t index = static_cast<uint32_t>(frame.scopes.size());
+	GpuScope scope = { name, static_cast<uint32_t>(mOpenScopes.size()), kNoQuery };
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.timestampPool, 2 * index);
+
+	// Only one pipeline statistics query can be active at a time => outermost scopes only:
+	if (mStatisticsEnabled && mOpenScopes.empty()) {
+		scope.statisticsQuery = frame.numStatisticsQueries++;
+		vkCmdBeginQuery(command_buffer, frame.statisticsPool, scope.statisticsQuery, 0);
+	}
+
+	frame.scopes.push_back(scope);
+	mOpenScopes.push_back(index);
+}
+
+void gpuProfilerEndScope(VkCommandBuffer command_buffer)
+{
+	if (!mAvailable || mOpenScopes.empty()) {
+		return;
+	}
+	const uint32_t index = mOpenScopes.back();
+	mOpenScopes.pop_back();
+	if (kNoQuery == index) {
+		return;
+	}
+
+	GpuFrame& frame = mFrames[mFrameNumber % mFrames.size()];
+	const GpuScope& scope = frame.scopes[index];
+	if (kNoQuery != scope.statisticsQuery) {
+		vkCmdEndQuery(command_buffer, frame.statisticsPool, scope.statisticsQuery);
+	}
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, 2 * index + 1);
+}
+
+void gpuProfilerCollectFrameTimes(std::vector<double>* destination)
+{
+	mFrameTimesDestination = destination;
+}
+
+double gpuProfilerGetLatestFrameMilliseconds()
+{
+	return mLatestFrameMilliseconds;
+}
+
+double gpuProfilerGetAverageMilliseconds(const char* name)
+{
+	for (const auto& history : mHistories) {
+		if (history.name == name || strcmp(history.name, name) == 0) {
+			const uint32_t n = std::min(history.count, kHistoryLength);
+			double sum_ms = 0.0;
+			for (uint32_t i = 0; i < n; ++i) {
+				sum_ms += history.milliseconds[i];
+			}
+			return n > 0 ? sum_ms / n : -1.0;
+		}
+	}
+	return -1.0;
+}
+
+#endif
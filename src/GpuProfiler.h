@@ -0,0 +1,107 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <vulkan/vulkan.h>
+#include <vector>
+#include "Profiler.h"
+
+/* --------------------------------------------- */
+// GPU Profiler
+//
+// Measures named scopes in command buffers with timestamp queries and,
+// optionally, pipeline statistics queries. Every frame gets its own set of
+// query pools. A frame's results are read back only once the GPU has
+// finished it (typically two frames later), so reading back never stalls.
+// Per-scope rolling averages are logged periodically and added to the CPU
+// profiler's trace on a separate "GPU" track.
+//
+// Like the CPU profiler, it is compiled out if PROFILER_ENABLED is 0.
+/* --------------------------------------------- */
+
+#if PROFILER_ENABLED
+
+/*!
+ *	Creates the query pools and helper objects of the GPU profiler.
+ *	@param	physical_device				Physical device, used to query timestamp support and the timestamp period
+ *	@param	device						Device handle
+ *	@param	queue						The queue which all profiled command buffers are submitted to
+ *	@param	queue_family_index			The queue's family index
+ *	@param	num_frames					Number of frames whose results can be pending at the same time.
+ *										Should be larger than the number of frames in flight, so that reading
+ *										back results never waits for the GPU.
+ *	@param	enable_pipeline_statistics	Whether or not to collect vertex/fragment shader invocations and clipping
+ *										primitives. Requires the pipelineStatisticsQuery device feature to be enabled.
+ *	@param	log_interval				Every this many frames, the rolling per-scope averages are logged. 0 to disable.
+ *	@return	True if GPU profiling is available, false if the queue does not support timestamps. In the latter case,
+ *			all other gpuProfiler* functions do nothing.
+ */
+bool gpuProfilerCreate(VkPhysicalDevice physical_device, VkDevice device, VkQueue queue, uint32_t queue_family_index,
+	uint32_t num_frames = 4, bool enable_pipeline_statistics = false, uint32_t log_interval = 300);
+
+/*!
+ *	Destroys all resources of the GPU profiler. The device must be idle.
+ *	The results of all frames which have not been read back yet are read back before.
+ */
+void gpuProfilerDestroy();
+
+/*!
+ *	Starts a new profiled frame. Reads back the results of all previous frames which the GPU
+ *	has finished in the meantime, and prepares the queries of the new frame.
+ *	Must be called before any command buffer of the new frame is submitted.
+ */
+void gpuProfilerBeginFrame();
+
+/*!
+ *	Ends the current profiled frame. Must be called after all of the frame's command buffers have been submitted.
+ */
+void gpuProfilerEndFrame();
+
+/*!
+ *	Begins a named scope in the given command buffer. Scopes can be nested; pipeline statistics
+ *	are only collected for outermost scopes (i.e., for passes).
+ *	@param	command_buffer	Command buffer to record the queries into
+ *	@param	name			Name of the scope. Must stay valid for the lifetime of the profiler.
+ */
+void gpuProfilerBeginScope(VkCommandBuffer command_buffer, const char* name);
+
+/*!
+ *	Ends the scope which has most recently been begun with gpuProfilerBeginScope.
+ *	@param	command_buffer	Command buffer to record the queries into
+ */
+void gpuProfilerEndScope(VkCommandBuffer command_buffer);
+
+/*!
+ *	Returns the GPU time of the most recently read back frame in milliseconds, measured from the
+ *	start of its first scope until the end of its last scope. Returns a negative value if no
+ *	frame has been read back yet.
+ */
+double gpuProfilerGetLatestFrameMilliseconds();
+
+/*!
+ *	Returns the rolling average GPU time of the scope with the given name in milliseconds,
+ *	or a negative value if there is no scope with that name.
+ */
+double gpuProfilerGetAverageMilliseconds(const char* name);
+
+/*!
+ *	Starts or stops collecting the GPU time of every frame which is read back.
+ *	@param	destination		Vector which each frame's GPU time in milliseconds is appended to, or
+ *							nullptr to stop collecting. Must stay valid until collecting is stopped
+ *							or the profiler has been destroyed.
+ */
+void gpuProfilerCollectFrameTimes(std::vector<double>* destination);
+
+#else
+
+inline bool gpuProfilerCreate(VkPhysicalDevice, VkDevice, VkQueue, uint32_t, uint32_t = 4, bool = false, uint32_t = 300) { return false; }
+inline void gpuProfilerDestroy() {}
+inline void gpuProfilerBeginFrame() {}
+inline void gpuProfilerEndFrame() {}
+inline void gpuProfilerBeginScope(VkCommandBuffer, const char*) {}
+inline void gpuProfilerEndScope(VkCommandBuffer) {}
+inline double gpuProfilerGetLatestFrameMilliseconds() { return -1.0; }
+inline double gpuProfilerGetAverageMilliseconds(const char*) { return -1.0; }
+inline void gpuProfilerCollectFrameTimes(std::vector<double>*) {}
+
+#endif
@@ -0,0 +1,298 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <VulkanLaunchpad.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Job {
+	const char*           name;
+	std::function<void()> work;
+	JobAffinity           affinity;
+
+	//! Number of unfinished dependencies, plus one while the job is being submitted
+	std::atomic<uint32_t> numPendingDependencies{ 1 };
+
+	//! Guards done and continuations
+	std::mutex            mutex;
+	bool                  done = false;
+
+	//! Notified once done has been set
+	std::condition_variable finished;
+
+	//! Jobs which depend on this one
+	std::vector<JobHandle> continuations;
+};
+
+namespace
+{
+	struct WorkerQueue {
+		std::mutex            mutex;
+		std::deque<JobHandle> jobs;
+	};
+
+	std::vector<std::thread> mWorkers;
+	std::vector<std::unique_ptr<WorkerQueue>> mWorkerQueues;
+	// Thread names must stay valid until the profiler trace has been written => never cleared
+	std::vector<std::string> mWorkerNames;
+	std::thread::id mMainThreadId;
+
+	std::mutex mMainThreadMutex;
+	std::vector<JobHandle> mMainThreadJobs;
+
+	std::mutex mSleepMutex;
+	std::condition_variable mWakeUp;
+	std::atomic<uint32_t> mNumQueuedJobs{ 0 };
+	std::atomic<uint32_t> mNumUnfinishedJobs{ 0 };
+	std::atomic<uint32_t> mNextQueue{ 0 };
+	bool mStopping = false;
+
+	// Index of the worker which the calling thread is, or -1 for non-worker threads
+	thread_local int tWorkerIndex = -1;
+
+	// How long jobSystemWait sleeps when there is nothing to help with, before it looks for new jobs again:
+	constexpr std::chrono::milliseconds kHelpInterval(1);
+
+	void schedule(const JobHandle& job)
+	{
+		if (JOB_AFFINITY_MAIN_THREAD == job->affinity) {
+			std::lock_guard<std::mutex> lock(mMainThreadMutex);
+			mMainThreadJobs.push_back(job);
+			return;
+		}
+
+		// Workers push onto their own deque; other threads distribute jobs round-robin:
+		const uint32_t queue_index = tWorkerIndex >= 0
+			? static_cast<uint32_t>(tWorkerIndex)
+			: mNextQueue.fetch_add(1, std::memory_order_relaxed) % static_cast<uint32_t>(mWorkerQueues.size());
+		// Counted before it is pushed, so that a worker which pops it right away cannot decrement the count below zero.
+		// A worker which wakes up in between finds no job and checks the count again:
+		{
+			std::lock_guard<std::mutex> lock(mSleepMutex);
+			mNumQueuedJobs.fetch_add(1);
+		}
+		{
+			std::lock_guard<std::mutex> lock(mWorkerQueues[queue_index]->mutex);
+			mWorkerQueues[queue_index]->jobs.push_back(job);
+		}
+		mWakeUp.notify_one();
+	}
+
+	void releaseDependency(const JobHandle& job)
+	{
+		if (1 == job->numPendingDependencies.fetch_sub(1)) {
+			schedule(job);
+		}
+	}
+
+	void execute(const JobHandle& job)
+	{
+		{
+			PROFILER_ZONE(job->name);
+			job->work();
+			job->work = nullptr;
+		}
+
+		std::vector<JobHandle> continuations;
+		{
+			std::lock_guard<std::mutex> lock(job->mutex);
+			job->done = true;
+			continuations.swap(job->continuations);
+		}
+		job->finished.notify_all();
+		for (const JobHandle& continuation : continuations) {
+			releaseDependency(continuation);
+		}
+		mNumUnfinishedJobs.fetch_sub(1);
+	}
+
+	// Pops a job from the back of the own deque, or steals one from the front of another worker's deque.
+	JobHandle findJob(int own_index)
+	{
+		const uint32_t num_queues = static_cast<uint32_t>(mWorkerQueues.size());
+		if (own_index >= 0) {
+			WorkerQueue& own_queue = *mWorkerQueues[own_index];
+			std::lock_guard<std::mutex> lock(own_queue.mutex);
+			if (!own_queue.jobs.empty()) {
+				JobHandle job = std::move(own_queue.jobs.back());
+				own_queue.jobs.pop_back();
+				mNumQueuedJobs.fetch_sub(1);
+				return job;
+			}
+		}
+		const uint32_t first_victim = own_index >= 0 ? static_cast<uint32_t>(own_index) + 1 : 0;
+		for (uint32_t i = 0; i < num_queues; ++i) {
+			WorkerQueue& victim = *mWorkerQueues[(first_victim + i) % num_queues];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.jobs.empty()) {
+				JobHandle job = std::move(victim.jobs.front());
+				victim.jobs.pop_front();
+				mNumQueuedJobs.fetch_sub(1);
+				return job;
+			}
+		}
+		return nullptr;
+	}
+
+	void workerMain(int worker_index)
+	{
+		tWorkerIndex = worker_index;
+		profilerSetThreadName(mWorkerNames[worker_index].c_str());
+		while (true) {
+			JobHandle job = findJob(worker_index);
+			if (nullptr != job) {
+				execute(job);
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(mSleepMutex);
+			mWakeUp.wait(lock, [] { return mStopping || mNumQueuedJobs.load() > 0; });
+			if (mStopping && 0 == mNumQueuedJobs.load()) {
+				return;
+			}
+		}
+	}
+}
+
+void jobSystemCreate(uint32_t num_workers)
+{
+	if (0 == num_workers) {
+		num_workers = std::max(1u, std::thread::hardware_concurrency()) - 1;
+		num_workers = std::max(1u, num_workers);
+	}
+	mMainThreadId = std::this_thread::get_id();
+	mStopping = false;
+	mWorkerQueues.clear();
+	for (uint32_t i = 0; i < num_workers; ++i) {
+		mWorkerQueues.push_back(std::make_unique<WorkerQueue>());
+		if (mWorkerNames.size() <= i) {
+			mWorkerNames.push_back("Job Worker " + std::to_string(i));
+		}
+	}
+	for (uint32_t i = 0; i < num_workers; ++i) {
+		mWorkers.emplace_back(workerMain, static_cast<int>(i));
+	}
+	VKL_LOG("Job system started with " << num_workers << " worker threads.");
+}
+
+void jobSystemDestroy()
+{
+	while (mNumUnfinishedJobs.load() > 0) {
+		JobHandle job = findJob(-1);
+		if (nullptr != job) {
+			execute(job);
+		}
+		else if (0 == jobSystemRunMainThreadJobs()) {
+			std::this_thread::yield();
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mStopping = true;
+	}
+	mWakeUp.notify_all();
+	for (std::thread& worker : mWorkers) {
+		worker.join();
+	}
+	mWorkers.clear();
+	mWorkerQueues.clear();
+}
+
+JobHandle jobSystemSubmit(const char* name, std::function<void()> work, const JobHandle* dependencies, uint32_t num_dependencies, JobAffinity affinity)
+{
+	JobHandle job = std::make_shared<Job>();
+	job->name = name;
+	job->work = std::move(work);
+	job->affinity = affinity;
+	mNumUnfinishedJobs.fetch_add(1);
+
+	// Register with every unfinished dependency. The extra initial count keeps the job from being
+	// scheduled before all dependencies have been registered:
+	for (uint32_t i = 0; i < num_dependencies; ++i) {
+		const JobHandle& dependency = dependencies[i];
+		if (nullptr == dependency) {
+			continue;
+		}
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+		if (!dependency->done) {
+			job->numPendingDependencies.fetch_add(1);
+			dependency->continuations.push_back(job);
+		}
+	}
+	releaseDependency(job);
+	return job;
+}
+
+JobHandle jobSystemCreateFence(const char* name)
+{
+	// The initial dependency count of one is only released by jobSystemSignalFence:
+	JobHandle fence = std::make_shared<Job>();
+	fence->name = name;
+	fence->work = [] {};
+	fence->affinity = JOB_AFFINITY_WORKER;
+	mNumUnfinishedJobs.fetch_add(1);
+	return fence;
+}
+
+void jobSystemSignalFence(const JobHandle& fence)
+{
+	execute(fence);
+}
+
+bool jobSystemIsDone(const JobHandle& job)
+{
+	std::lock_guard<std::mutex> lock(job->mutex);
+	return job->done;
+}
+
+void jobSystemWait(const JobHandle& job)
+{
+	const bool is_main_thread = std::this_thread::get_id() == mMainThreadId;
+	while (!jobSystemIsDone(job)) {
+		JobHandle other_job = findJob(tWorkerIndex);
+		if (nullptr != other_job) {
+			execute(other_job);
+		}
+		else if (!is_main_thread || 0 == jobSystemRunMainThreadJobs()) {
+			std::unique_lock<std::mutex> lock(job->mutex);
+			job->finished.wait_for(lock, kHelpInterval, [&job] { return job->done; });
+		}
+	}
+}
+
+void jobSystemSleepUntilDone(const JobHandle& job)
+{
+	std::unique_lock<std::mutex> lock(job->mutex);
+	job->finished.wait(lock, [&job] { return job->done; });
+}
+
+uint32_t jobSystemRunMainThreadJobs()
+{
+	std::vector<JobHandle> jobs;
+	{
+		std::lock_guard<std::mutex> lock(mMainThreadMutex);
+		jobs.swap(mMainThreadJobs);
+	}
+	for (const JobHandle& job : jobs) {
+		execute(job);
+	}
+	return static_cast<uint32_t>(jobs.size());
+}
+
+uint32_t jobSystemGetNumWorkers()
+{
+	return static_cast<uint32_t>(mWorkers.size());
+}
+
+uint32_t jobSystemGetNumUnfinishedJobs()
+{
+	return mNumUnfinishedJobs.load();
+}
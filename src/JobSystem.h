@@ -0,0 +1,152 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+/* --------------------------------------------- */
+// Job System
+//
+// A work-stealing task scheduler. Every worker thread owns a deque of jobs:
+// it pushes and pops jobs at the back (LIFO, which keeps the data of related
+// jobs in the cache), while idle workers steal jobs from the front of other
+// workers' deques (FIFO, i.e., the oldest and typically largest jobs).
+//
+// A job can depend on other jobs; it is only scheduled once all of them have
+// finished. Jobs can also be marked to run on the main thread, e.g., to make
+// results visible to the renderer. Those run in jobSystemRunMainThreadJobs,
+// which the main thread calls once per frame.
+/* --------------------------------------------- */
+
+struct Job;
+
+//! Handle to a submitted job. Stays valid for as long as it is referenced.
+typedef std::shared_ptr<Job> JobHandle;
+
+/*!
+ *	Where a job is executed
+ */
+enum JobAffinity {
+	//! On any of the worker threads
+	JOB_AFFINITY_WORKER,
+	//! On the main thread, during jobSystemRunMainThreadJobs
+	JOB_AFFINITY_MAIN_THREAD,
+};
+
+/*!
+ *	The result of a job, which becomes available once the job has finished.
+ */
+template <typename T>
+struct JobFuture {
+	//! The job which computes the value
+	JobHandle job;
+
+	//! The value. Only valid after the job has finished.
+	std::shared_ptr<T> value;
+};
+
+/*!
+ *	Starts the worker threads. Must be called from the main thread.
+ *	@param	num_workers		Number of worker threads. 0 means: one less than the number of hardware threads (at least 1).
+ */
+void jobSystemCreate(uint32_t num_workers = 0);
+
+/*!
+ *	Runs all remaining jobs (including main-thread jobs) to completion and stops the worker threads.
+ *	Must be called from the main thread.
+ */
+void jobSystemDestroy();
+
+/*!
+ *	Submits a job.
+ *	@param	name				Name of the job, used as profiler zone name. Must stay valid until the profiler trace has been written.
+ *	@param	work				The work to do
+ *	@param	dependencies		Jobs which must have finished before this job may start. Can be nullptr.
+ *	@param	num_dependencies	Number of elements in dependencies
+ *	@param	affinity			Whether the job runs on a worker thread or on the main thread
+ *	@return	Handle to the job, e.g., for use as dependency of other jobs
+ */
+JobHandle jobSystemSubmit(const char* name, std::function<void()> work, const JobHandle* dependencies = nullptr, uint32_t num_dependencies = 0,
+	JobAffinity affinity = JOB_AFFINITY_WORKER);
+
+/*!
+ *	Creates a fence: a job without work, which finishes when jobSystemSignalFence is called. Other jobs can depend
+ *	on it, e.g., on a resource which the main thread creates later, so that work which does not need the resource
+ *	can start earlier. Must be signaled before jobSystemDestroy.
+ *	@param	name	Name of the fence. Must stay valid until the profiler trace has been written.
+ *	@return	Handle to the fence, for use as dependency of other jobs
+ */
+JobHandle jobSystemCreateFence(const char* name);
+
+/*!
+ *	Finishes a fence which has been created with jobSystemCreateFence, which releases the jobs that depend on it.
+ *	Must be called exactly once per fence.
+ */
+void jobSystemSignalFence(const JobHandle& fence);
+
+/*!
+ *	Returns true if the given job has finished.
+ */
+bool jobSystemIsDone(const JobHandle& job);
+
+/*!
+ *	Blocks until the given job has finished. The calling thread executes other jobs in the meantime
+ *	(including main-thread jobs if it is the main thread), so waiting never deadlocks. While there is
+ *	nothing to execute, it sleeps.
+ */
+void jobSystemWait(const JobHandle& job);
+
+/*!
+ *	Blocks until the given job has finished, without executing other jobs in the meantime, so that no other
+ *	job can delay the calling thread once the job has finished. The calling thread sleeps while it waits.
+ *	If called from the main thread, the job must not depend on main-thread jobs.
+ */
+void jobSystemSleepUntilDone(const JobHandle& job);
+
+/*!
+ *	Runs all main-thread jobs whose dependencies have finished. Must be called from the main thread, once per frame.
+ *	@return	Number of jobs which have been run
+ */
+uint32_t jobSystemRunMainThreadJobs();
+
+/*!
+ *	Returns the number of worker threads.
+ */
+uint32_t jobSystemGetNumWorkers();
+
+/*!
+ *	Returns the number of jobs which have been submitted but have not finished yet, including main-thread jobs
+ *	and jobs which wait for their dependencies.
+ */
+uint32_t jobSystemGetNumUnfinishedJobs();
+
+/*!
+ *	Submits a job which computes a value.
+ *	@param	name	Name of the job
+ *	@param	work	A callable without parameters which returns a T
+ *	@param	dependencies, num_dependencies, affinity	See jobSystemSubmit
+ *	@return	A future which holds the value once the job has finished
+ */
+template <typename T, typename F>
+JobFuture<T> jobSystemAsync(const char* name, F work, const JobHandle* dependencies = nullptr, uint32_t num_dependencies = 0,
+	JobAffinity affinity = JOB_AFFINITY_WORKER)
+{
+	JobFuture<T> future;
+	future.value = std::make_shared<T>();
+	std::shared_ptr<T> value = future.value;
+	future.job = jobSystemSubmit(name, [value, work]() mutable { *value = work(); }, dependencies, num_dependencies, affinity);
+	return future;
+}
+
+/*!
+ *	Waits for a future's job to finish and returns its value. Returns right away in jobs which depend on the future's job.
+ */
+template <typename T>
+T& jobSystemGet(const JobFuture<T>& future)
+{
+	jobSystemWait(future.job);
+	return *future.value;
+}
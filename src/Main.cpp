@@ -10,11 +10,41 @@
 #include "VulkanHelpers.h"
 #include "Teapot.h"
 #include "Camera.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "CameraPath.h"
+#include "FrameStatistics.h"
+#include "RenderGraph.h"
+#include "SceneGraph.h"
+#include "DrawList.h"
+#include "GeometryPool.h"
+#include "JobSystem.h"
+#include "AssetLoader.h"
+#include "PatchTessellator.h"
+#include "PipelineCache.h"
+#include "ShaderPermutations.h"
+#include "OcclusionCuller.h"
+#include "ClusteredLighting.h"
+#include "FrameScheduler.h"
+#include "FrameCapture.h"
+#include "MemoryTracker.h"
+#include "RenderOnDemand.h"
+#include "TileStreamer.h"
+#include "StartupGraph.h"
+#include "DynamicResolution.h"
+#include "Multiview.h"
 
 // Include functionality from the standard library:
 #include <vector>
 #include <unordered_map>
 #include <limits>
+#include <algorithm>
+#include <cstring>
+#include <cstddef>
+#include <cstdlib>
+#include <chrono>
+#include <random>
+#include <cmath>
 
 /* ------------------------------------------------ */
 // Some more little helpers directly declared here:
@@ -26,6 +56,127 @@
  */
 void errorCallbackFromGlfw(int error, const char* description);
 
+/*!
+ *	Options which can be passed to the application via the command line.
+ */
+struct CommandLineOptions {
+	//! Whether or not VK_LAYER_KHRONOS_validation shall be enabled. Defaults to true in debug builds
+	//! and to false in release builds (i.e., whenever NDEBUG is defined).
+	//! Can be overridden at runtime with --validation or --no-validation.
+	bool enableValidation;
+
+	//! True if the validation layer has been requested explicitly via --validation.
+	//! In this case, a missing validation layer is treated as an error rather than a warning.
+	bool validationRequested;
+
+	//! If set via --trace <file>, all recorded profiler zones are written to this file in the
+	//! Chrome trace event format when the application exits. nullptr otherwise.
+	const char* tracePath;
+
+	//! Whether or not the GPU profiler shall collect pipeline statistics (shader invocations, clipping
+	//! primitives) in addition to timestamps. Enabled with --pipeline-statistics.
+	bool pipelineStatistics;
+
+	//! If set via --record-camera <file>, the camera's view-projection matrix of every frame is saved to this file on exit.
+	const char* recordCameraPath;
+
+	//! If set via --replay-camera <file>, the camera is driven by the given camera path instead of user input.
+	//! The application then runs in benchmark mode: it renders a fixed number of frames, writes frame time
+	//! statistics, and exits.
+	const char* replayCameraPath;
+
+	//! Number of frames to render in benchmark mode (--benchmark-frames <n>). The camera path is looped if
+	//! it is shorter. 0 means: as many frames as the camera path has.
+	uint32_t benchmarkFrames;
+
+	//! The JSON file which benchmark mode writes its statistics into (--benchmark-output <file>).
+	const char* benchmarkOutputPath;
+
+	//! If enabled via --depth-prepass, the scene is first rendered into the depth buffer only. The main pass
+	//! then tests with VK_COMPARE_OP_EQUAL, so that every pixel is shaded at most once.
+	bool depthPrepass;
+
+	//! The scene to render (--scene <name>): "teapot" (the default) for a single teapot, or "meshes" for
+	//! the teapot, the cube, the sphere, and the vespa side by side.
+	const char* scene;
+
+	//! If enabled via --tessellation, the teapot is drawn from its Bezier patches, tessellated on the CPU at a level
+	//! which follows its size on screen, and shaded with analytic normals.
+	bool tessellation;
+
+	//! If enabled via --fog, all shader permutations are selected with distance fog.
+	bool fog;
+
+	//! If enabled via --occlusion-culling, nodes which are hidden behind other nodes are not drawn, see OcclusionCuller.h.
+	bool occlusionCulling;
+
+	//! Number of animated point lights (--lights <n>), which are shaded with clustered lighting, see ClusteredLighting.h.
+	//! 0 disables point lights. At most kClusteredLightingMaxLights.
+	uint32_t numLights;
+
+	//! Number of frames which the CPU may submit before the GPU has finished the first of them (--frames-in-flight <n>),
+	//! see FrameScheduler.h. 1 minimizes latency, more frames maximize throughput. At most the number of swapchain images.
+	uint32_t framesInFlight;
+
+	//! If set via --capture <directory>, every frame is read back and written into this directory, see FrameCapture.h.
+	//! The directory must exist. nullptr otherwise.
+	const char* captureDirectory;
+
+	//! File format of captured frames (--capture-format png|raw). Raw frames are binary PPM files, which can serve as golden references.
+	FrameCaptureMode captureMode;
+
+	//! If set via --golden <directory>, captured frames are compared against the PPM files in this directory instead of
+	//! being written, and the application exits with EXIT_FAILURE if any frame mismatches. Requires --capture.
+	const char* goldenDirectory;
+
+	//! If enabled via --on-demand, frames are only rendered when something visibly changed, and the render loop
+	//! waits for events otherwise, see RenderOnDemand.h. Ignored in benchmark mode.
+	bool onDemand;
+
+	//! With --on-demand: a frame is rendered at least every this many seconds (--max-idle <seconds>). 0 means never.
+	double maxIdleSeconds;
+
+	//! If enabled via --reuse-draw-lists, every swapchain image's draw list is built once and submitted again in
+	//! later frames, until the scene, the pipelines, or the loaded assets change. If the scene is drawn in a render
+	//! pass of our own, the draw list's secondary command buffer is executed again, too.
+	bool reuseDrawLists;
+
+	//! If set via --tiles <file>, the tiles of this tile file (written by the OBJ tiler) are streamed around the camera
+	//! and drawn in addition to the scene, see TileStreamer.h. nullptr otherwise.
+	const char* tilesPath;
+
+	//! With --tiles: megabytes of tile geometry which may be resident or loading at the same time (--tile-budget <MiB>).
+	//! The geometry pool's vertex and index buffers share it, see TileStreamer.h.
+	uint32_t tileBudgetMiB;
+
+	//! With --tiles: tiles further away from the camera are not loaded (--tile-distance <distance>). 0 means no limit.
+	float tileLoadDistance;
+
+	//! If set via --dynamic-resolution <milliseconds>, the scene's render resolution adapts to keep the GPU frame time
+	//! near this target, see DynamicResolution.h. 0 otherwise. Ignored with more than one view.
+	double dynamicResolutionTarget;
+
+	//! With --dynamic-resolution: every frame's GPU time and render scale are written to this CSV file on exit
+	//! (--resolution-history <file>). nullptr otherwise.
+	const char* resolutionHistoryPath;
+
+	//! Number of views which are rendered side by side in a single pass (--views <n>), see Multiview.h. 2 for stereo.
+	//! At most kMultiviewMaxViews.
+	uint32_t numViews;
+
+	//! With --views: distance between neighboring views in world space (--view-separation <distance>)
+	float viewSeparation;
+};
+
+/*!
+ *	Parses the given command line arguments into a CommandLineOptions instance.
+ *	Unknown arguments are reported and ignored.
+ *	@param		argc	Number of arguments, as passed to main
+ *	@param		argv	Argument strings, as passed to main
+ *	@return		The parsed options, with defaults applied for every option which has not been specified.
+ */
+CommandLineOptions parseCommandLineOptions(int argc, char** argv);
+
 /*!
  *	Function that is invoked by GLFW to handle key events like key presses or key releases.
  *	If the ESC key has been pressed, the window will be marked that it should close.
@@ -67,8 +218,13 @@ uint32_t selectQueueFamilyIndex(VkPhysicalDevice physical_device, VkSurfaceKHR s
 
 int main(int argc, char** argv)
 {
+	profilerInit();
+	PROFILER_BEGIN(startup_zone, "Startup");
+
 	VKL_LOG(":::::: WELCOME TO VULKAN LAUNCHPAD ::::::");
 
+	CommandLineOptions options = parseCommandLineOptions(argc, argv);
+
 	// Install a callback function, which gets invoked whenever a GLFW error occurred:
 	glfwSetErrorCallback(errorCallbackFromGlfw);
 
@@ -77,9 +233,102 @@ int main(int argc, char** argv)
 		VKL_EXIT_WITH_ERROR("Failed to init GLFW");
 	}
 
+	// Startup is measured as a graph of phases on the main thread and tasks on the job system, see StartupGraph.h.
+	// Everything which only needs some of the Vulkan objects (the instance, asset parsing, pipeline compiles) runs
+	// in the background, as soon as its inputs exist. The critical path is logged once the first frame is presented:
+	startupGraphCreate();
+	const StartupTask job_system_phase = startupGraphBegin("Start Job System");
+	jobSystemCreate();
+	startupGraphEnd(job_system_phase);
+
+	// All meshes share the geometry pool's vertex and index buffers. They are loaded asynchronously on the job
+	// system, so that loading overlaps with the Vulkan setup, pipeline creation, and the first frames. Parsing starts
+	// right away; staging waits until the geometry pool has been created after Task 1.6. Until a mesh is resident,
+	// its nodes are drawn as a placeholder box:
+	const JobHandle geometry_pool_created = jobSystemCreateFence("Geometry Pool Created");
+	assetLoaderSetStagingDependency(geometry_pool_created);
+	const bool meshes_scene = strcmp(options.scene, "meshes") == 0;
+	const AssetHandle teapot_asset = assetLoaderLoadMesh("Teapot", teapotGetGeometry);
+	const AssetHandle cube_asset = meshes_scene ? assetLoaderLoadMesh("Cube", ASSET_DIR "/cube/cube.obj") : kAssetInvalid;
+	const AssetHandle sphere_asset = meshes_scene ? assetLoaderLoadMesh("Sphere", ASSET_DIR "/sphere/sphere.obj") : kAssetInvalid;
+	const AssetHandle vespa_asset = meshes_scene ? assetLoaderLoadMesh("Vespa", ASSET_DIR "/vespa/vespa.obj") : kAssetInvalid;
+
+	/* --------------------------------------------- */
+	// Task 1.2: Create a Vulkan Instance
+	/* --------------------------------------------- */
+	// The instance does not depend on the window => it is created on a worker thread while the window is being created:
+	VkInstance vk_instance = VK_NULL_HANDLE;
+	const StartupTask task_1_2 = startupGraphSubmit("Task 1.2: Create Instance", [&options, &vk_instance] {
+		// Describe some meta data about this application, and define which Vulkan API version is required:
+		VkApplicationInfo application_info = {};                     // Zero-initialize every member
+		application_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO; // Set this struct instance's type
+		application_info.pEngineName = "Vulkan Launchpad";           // Set some properties...
+		application_info.engineVersion = VK_MAKE_API_VERSION(0, 2023, 1, 0);
+		application_info.pApplicationName = "An Introduction to Vulkan";
+		application_info.applicationVersion = VK_MAKE_API_VERSION(0, 2023, 1, 1);
+		application_info.apiVersion = VK_API_VERSION_1_1;            // Your system needs to support this Vulkan API version.
+
+		// We'll require some extensions (e.g., for presenting something on a window surface, and more):
+		std::vector<const char*> required_extensions = getRequiredInstanceExtensions();
+
+		// VK_EXT_debug_utils is optional. If it is available, we use it to name objects and to label command buffer
+		// regions, which graphics debuggers and external profilers pick up without any validation overhead:
+		const bool debug_utils_enabled = hlpIsInstanceExtensionSupported(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+		if (debug_utils_enabled && std::none_of(required_extensions.begin(), required_extensions.end(),
+				[](const char* ext) { return strcmp(ext, VK_EXT_DEBUG_UTILS_EXTENSION_NAME) == 0; })) {
+			required_extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+		}
+
+		// Layers enable additional functionality. The standard validation layer gives us meaningful and descriptive
+		// error messages whenever we messed up something, but it adds CPU overhead to every Vulkan call and requires
+		// the Vulkan SDK to be installed. Hence, it is only enabled by default in debug builds:
+		std::vector<const char*> enabled_layers;
+		if (options.enableValidation) {
+			if (hlpIsInstanceLayerSupported("VK_LAYER_KHRONOS_validation")) {
+				VKL_LOG("Validation layer \"VK_LAYER_KHRONOS_validation\" is supported.");
+				enabled_layers.push_back("VK_LAYER_KHRONOS_validation");
+			}
+			else if (options.validationRequested) {
+				VKL_EXIT_WITH_ERROR("Validation layer \"VK_LAYER_KHRONOS_validation\" is not supported.");
+			}
+			else {
+				VKL_LOG("Validation layer \"VK_LAYER_KHRONOS_validation\" is not supported => running without validation.");
+			}
+		}
+		else {
+			VKL_LOG("Validation layer disabled.");
+		}
+
+		// Tie everything from above together in an instance of VkInstanceCreateInfo:
+		VkInstanceCreateInfo instance_create_info = {}; // Zero-initialize every member
+		instance_create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO; // Set this struct instance's type
+		instance_create_info.pApplicationInfo = &application_info;
+
+		instance_create_info.enabledLayerCount = static_cast<uint32_t>(enabled_layers.size());
+		instance_create_info.ppEnabledLayerNames = enabled_layers.data();
+		instance_create_info.enabledExtensionCount = static_cast<uint32_t>(required_extensions.size());
+		instance_create_info.ppEnabledExtensionNames = &required_extensions[0];
+		// TODO: Hook in required_extensions using VkInstanceCreateInfo::enabledExtensionCount and VkInstanceCreateInfo::ppEnabledExtensionNames!
+		// TODO: Hook in enabled_layers using VkInstanceCreateInfo::enabledLayerCount and VkInstanceCreateInfo::ppEnabledLayerNames!
+
+		// TODO: Use vkCreateInstance to create a vulkan instance handle! Assign it to vk_instance!
+		VkResult result = VK_ERROR_INITIALIZATION_FAILED;
+		result = vkCreateInstance(&instance_create_info, nullptr, &vk_instance);
+		VKL_CHECK_VULKAN_RESULT(result);
+
+		if (!vk_instance) {
+			VKL_EXIT_WITH_ERROR("No VkInstance created or handle not assigned.");
+		}
+		if (debug_utils_enabled && !hlpLoadDebugUtilsFunctions(vk_instance)) {
+			VKL_LOG("Unable to load VK_EXT_debug_utils functions => no object names and labels.");
+		}
+		VKL_LOG("Task 1.2 done.");
+	});
+
 	/* --------------------------------------------- */
 	// Task 1.1: Create a Window with GLFW
 	/* --------------------------------------------- */
+	const StartupTask task_1_1 = startupGraphBegin("Task 1.1: Create Window");
 	constexpr int window_width  = 800;
 	constexpr int window_height = 800;
 	constexpr bool fullscreen = false;
@@ -104,76 +353,34 @@ int main(int argc, char** argv)
 		VKL_LOG("2) You haven't implemented the first task, which is creating a window with GLFW.");
 		VKL_EXIT_WITH_ERROR("No GLFW window created.");
 	}
+	startupGraphEnd(task_1_1);
 	VKL_LOG("Task 1.1 done.");
 
 	// Set up a key callback via GLFW here to handle keyboard user input:
 	glfwSetKeyCallback(window, handleGlfwKeyCallback);
 
-	/* --------------------------------------------- */
-	// Task 1.2: Create a Vulkan Instance
-	/* --------------------------------------------- */
-	VkInstance vk_instance = VK_NULL_HANDLE;
-
-	// Describe some meta data about this application, and define which Vulkan API version is required:
-	VkApplicationInfo application_info = {};                     // Zero-initialize every member
-	application_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO; // Set this struct instance's type
-	application_info.pEngineName = "Vulkan Launchpad";           // Set some properties...
-	application_info.engineVersion = VK_MAKE_API_VERSION(0, 2023, 1, 0);
-	application_info.pApplicationName = "An Introduction to Vulkan";
-	application_info.applicationVersion = VK_MAKE_API_VERSION(0, 2023, 1, 1);
-	application_info.apiVersion = VK_API_VERSION_1_1;            // Your system needs to support this Vulkan API version.
-
-	// We'll require some extensions (e.g., for presenting something on a window surface, and more):
-	std::vector<const char*> required_extensions = getRequiredInstanceExtensions();
-
-	// Layers enable additional functionality. We'd like to enable the standard validation layer,
-	// so that we get meaningful and descriptive error messages whenever we messed up something:
-	if (!hlpIsInstanceLayerSupported("VK_LAYER_KHRONOS_validation")) {
-		VKL_EXIT_WITH_ERROR("Validation layer \"VK_LAYER_KHRONOS_validation\" is not supported.");
-	}
-	VKL_LOG("Validation layer \"VK_LAYER_KHRONOS_validation\" is supported.");
-	std::vector<const char*> enabled_layers{ "VK_LAYER_KHRONOS_validation" };
-
-	// Tie everything from above together in an instance of VkInstanceCreateInfo:
-	VkInstanceCreateInfo instance_create_info = {}; // Zero-initialize every member
-	instance_create_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO; // Set this struct instance's type
-	instance_create_info.pApplicationInfo = &application_info;
-
-	instance_create_info.enabledLayerCount = static_cast<uint32_t>(enabled_layers.size());
-	instance_create_info.ppEnabledLayerNames = &enabled_layers[0];
-	instance_create_info.enabledExtensionCount = static_cast<uint32_t>(required_extensions.size());
-	instance_create_info.ppEnabledExtensionNames = &required_extensions[0];
-	// TODO: Hook in required_extensions using VkInstanceCreateInfo::enabledExtensionCount and VkInstanceCreateInfo::ppEnabledExtensionNames!
-	// TODO: Hook in enabled_layers using VkInstanceCreateInfo::enabledLayerCount and VkInstanceCreateInfo::ppEnabledLayerNames!
-
-	// TODO: Use vkCreateInstance to create a vulkan instance handle! Assign it to vk_instance!
-	VkResult result = VK_ERROR_INITIALIZATION_FAILED;
-	result = vkCreateInstance(&instance_create_info, nullptr, &vk_instance);
-	VKL_CHECK_VULKAN_RESULT(result);
-
-	if (!vk_instance) {
-		VKL_EXIT_WITH_ERROR("No VkInstance created or handle not assigned.");
-	}
-	VKL_LOG("Task 1.2 done.");
-
 	/* --------------------------------------------- */
 	// Task 1.3: Create a Vulkan Window Surface
 	/* --------------------------------------------- */
+	const StartupTask task_1_3 = startupGraphBegin("Task 1.3: Create Surface");
+	startupGraphWait(task_1_2);
 	VkSurfaceKHR vk_surface = VK_NULL_HANDLE;
 
 	// TODO: Use glfwCreateWindowSurface to create a window surface! Assign its handle to vk_surface!
-	result = VK_ERROR_INITIALIZATION_FAILED;
+	VkResult result = VK_ERROR_INITIALIZATION_FAILED;
 	result = glfwCreateWindowSurface(vk_instance, window, NULL, &vk_surface);
 	VKL_CHECK_VULKAN_RESULT(result);
 
 	if (!vk_surface) {
 		VKL_EXIT_WITH_ERROR("No VkSurfaceKHR created or handle not assigned.");
 	}
+	startupGraphEnd(task_1_3);
 	VKL_LOG("Task 1.3 done.");
 
 	/* --------------------------------------------- */
 	// Task 1.4 Pick a Physical Device
 	/* --------------------------------------------- */
+	const StartupTask task_1_4 = startupGraphBegin("Task 1.4: Pick Physical Device");
 	VkPhysicalDevice vk_physical_device = VK_NULL_HANDLE;
 
 	// TODO: Use vkEnumeratePhysicalDevices get all the available physical device handles!
@@ -198,11 +405,17 @@ int main(int argc, char** argv)
 	if (!vk_physical_device) {
 		VKL_EXIT_WITH_ERROR("No VkPhysicalDevice selected or handle not assigned.");
 	}
+
+	// The swapchain, the framework's render pass, the pipelines, and frame capture all use the same formats => query them once:
+	const VkSurfaceFormatKHR surface_format = hlpGetSurfaceImageFormat(vk_physical_device, vk_surface);
+	const VkFormat depth_format = hlpSelectDepthFormat(vk_physical_device);
+	startupGraphEnd(task_1_4);
 	VKL_LOG("Task 1.4 done.");
 
 	/* --------------------------------------------- */
 	// Task 1.5: Select a Queue Family
 	/* --------------------------------------------- */
+	const StartupTask task_1_5 = startupGraphBegin("Task 1.5: Select Queue Family");
 
 	// TODO: Find a suitable queue family and assign its index to the following variable:
 	//       Hint: Use selectQueueFamilyIndex, but complete its implementation before!
@@ -214,11 +427,13 @@ int main(int argc, char** argv)
 	if (selected_queue_family_index >= queue_family_count) {
 		VKL_EXIT_WITH_ERROR("Invalid queue family index selected.");
 	}
+	startupGraphEnd(task_1_5);
 	VKL_LOG("Task 1.5 done.");
 
 	/* --------------------------------------------- */
 	// Task 1.6: Create a Logical Device and Get Queue
 	/* --------------------------------------------- */
+	const StartupTask task_1_6 = startupGraphBegin("Task 1.6: Create Device");
 	VkDevice vk_device = VK_NULL_HANDLE;
 	VkQueue  vk_queue  = VK_NULL_HANDLE;
 
@@ -235,8 +450,107 @@ int main(int argc, char** argv)
 	device_create_info.queueCreateInfoCount = 1;
 	device_create_info.pQueueCreateInfos = &queue_create_info;
 
+	// Pipeline statistics queries are an optional feature, which the GPU profiler uses if requested.
+	// Wireframe rendering (VK_POLYGON_MODE_LINE) is enabled whenever it is supported:
+	VkPhysicalDeviceFeatures supported_features = {};
+	vkGetPhysicalDeviceFeatures(vk_physical_device, &supported_features);
+	VkPhysicalDeviceFeatures enabled_features = {};
+	enabled_features.fillModeNonSolid = supported_features.fillModeNonSolid;
+	if (options.pipelineStatistics) {
+		if (VK_TRUE == supported_features.pipelineStatisticsQuery) {
+			enabled_features.pipelineStatisticsQuery = VK_TRUE;
+		}
+		else {
+			VKL_LOG("Pipeline statistics queries are not supported by the device => collecting timestamps only.");
+		}
+	}
+	device_create_info.pEnabledFeatures = &enabled_features;
+
 
 	std::vector<const char*> enabled_extensions_for_device = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+
+	// VK_KHR_synchronization2 is optional. The render graph uses it to record barriers with individual
+	// stage masks per barrier:
+	bool synchronization2_enabled = false;
+#if defined(VK_KHR_synchronization2)
+	VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2_features = {};
+	synchronization2_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+	if (hlpIsDeviceExtensionSupported(vk_physical_device, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+		VkPhysicalDeviceFeatures2 supported_features2 = {};
+		supported_features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supported_features2.pNext = &synchronization2_features;
+		vkGetPhysicalDeviceFeatures2(vk_physical_device, &supported_features2);
+		if (VK_TRUE == synchronization2_features.synchronization2) {
+			enabled_extensions_for_device.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+			synchronization2_features.pNext = const_cast<void*>(device_create_info.pNext);
+			device_create_info.pNext = &synchronization2_features;
+			synchronization2_enabled = true;
+		}
+	}
+#endif
+
+	// VK_KHR_timeline_semaphore is optional, too. The frame scheduler uses it to wait for specific frames:
+	bool timeline_semaphores_enabled = false;
+#if defined(VK_KHR_timeline_semaphore)
+	VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timeline_semaphore_features = {};
+	timeline_semaphore_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+	if (hlpIsDeviceExtensionSupported(vk_physical_device, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)) {
+		VkPhysicalDeviceFeatures2 supported_features2 = {};
+		supported_features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supported_features2.pNext = &timeline_semaphore_features;
+		vkGetPhysicalDeviceFeatures2(vk_physical_device, &supported_features2);
+		if (VK_TRUE == timeline_semaphore_features.timelineSemaphore) {
+			enabled_extensions_for_device.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+			timeline_semaphore_features.pNext = const_cast<void*>(device_create_info.pNext);
+			device_create_info.pNext = &timeline_semaphore_features;
+			timeline_semaphores_enabled = true;
+		}
+	}
+#endif
+
+	// VK_EXT_memory_budget is optional. With it, the memory tracker reports usage against the heaps' actual budgets:
+	bool memory_budget_enabled = false;
+#if defined(VK_EXT_memory_budget)
+	if (hlpIsDeviceExtensionSupported(vk_physical_device, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+		enabled_extensions_for_device.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		memory_budget_enabled = true;
+	}
+#endif
+
+	// Multiview (VK_KHR_multiview, core since Vulkan 1.1) is only needed for more than one view:
+	uint32_t num_views = 1;
+	VkPhysicalDeviceMultiviewFeatures multiview_features = {};
+	multiview_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES;
+	if (options.numViews > 1) {
+		VkPhysicalDeviceFeatures2 supported_features2 = {};
+		supported_features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supported_features2.pNext = &multiview_features;
+		vkGetPhysicalDeviceFeatures2(vk_physical_device, &supported_features2);
+		VkPhysicalDeviceMultiviewProperties multiview_properties = {};
+		multiview_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_PROPERTIES;
+		VkPhysicalDeviceProperties2 properties2 = {};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &multiview_properties;
+		vkGetPhysicalDeviceProperties2(vk_physical_device, &properties2);
+		if (VK_TRUE == multiview_features.multiview) {
+#if defined(VK_KHR_multiview)
+			if (hlpIsDeviceExtensionSupported(vk_physical_device, VK_KHR_MULTIVIEW_EXTENSION_NAME)) {
+				enabled_extensions_for_device.push_back(VK_KHR_MULTIVIEW_EXTENSION_NAME);
+			}
+#endif
+			multiview_features.multiviewGeometryShader = VK_FALSE;
+			multiview_features.multiviewTessellationShader = VK_FALSE;
+			multiview_features.pNext = const_cast<void*>(device_create_info.pNext);
+			device_create_info.pNext = &multiview_features;
+			num_views = std::min({ options.numViews, kMultiviewMaxViews, multiview_properties.maxMultiviewViewCount });
+			if (num_views < options.numViews) {
+				VKL_LOG("At most " << num_views << " views are supported => --views is clamped.");
+			}
+		}
+		else {
+			VKL_LOG("Multiview is not supported => --views is ignored.");
+		}
+	}
 	device_create_info.ppEnabledExtensionNames = &enabled_extensions_for_device[0];
 	device_create_info.enabledExtensionCount = static_cast<uint32_t>(enabled_extensions_for_device.size());
 
@@ -255,6 +569,8 @@ int main(int argc, char** argv)
 	}
 
 	vkGetDeviceQueue(vk_device, selected_queue_family_index, 0, &vk_queue);
+	memoryTrackerCreate(vk_physical_device, memory_budget_enabled);
+	hlpSetDebugUtilsObjectName(vk_device, VK_OBJECT_TYPE_QUEUE, (uint64_t)vk_queue, "Graphics+Present Queue");
 
 	// TODO: After device creation, use vkGetDeviceQueue to get the one and only created queue!
 	//       Assign its handle to vk_queue!
@@ -262,11 +578,217 @@ int main(int argc, char** argv)
 	if (!vk_queue) {
 		VKL_EXIT_WITH_ERROR("No VkQueue selected or handle not assigned.");
 	}
+	startupGraphEnd(task_1_6);
 	VKL_LOG("Task 1.6 done.");
 
+	// The geometry pool only needs the device. Once it exists, the meshes which have been parsed in the meantime are staged:
+	const StartupTask geometry_phase = startupGraphBegin("Create Geometry Pool");
+	// Streamed tiles share their budget between both buffers, in the proportions which the tile file's table requires:
+	const bool tiles_enabled = nullptr != options.tilesPath;
+	const uint64_t tile_budget_bytes = static_cast<uint64_t>(options.tileBudgetMiB) * 1024 * 1024;
+	if (tiles_enabled && !tileStreamerCreate(options.tilesPath, tile_budget_bytes, options.tileLoadDistance)) {
+		VKL_EXIT_WITH_ERROR("Unable to read tile file \"" << options.tilesPath << "\"");
+	}
+	uint32_t max_tile_vertices = 0;
+	uint32_t max_tile_indices = 0;
+	if (tiles_enabled) {
+		tileStreamerGetGeometryCapacity(max_tile_vertices, max_tile_indices);
+	}
+	geometryPoolCreate(vk_physical_device, vk_device, (1u << 19) + max_tile_vertices, (1u << 20) + max_tile_indices);
+	const glm::vec3 placeholder_positions[] = {
+		glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3( 0.5f, -0.5f, -0.5f), glm::vec3(-0.5f,  0.5f, -0.5f), glm::vec3( 0.5f,  0.5f, -0.5f),
+		glm::vec3(-0.5f, -0.5f,  0.5f), glm::vec3( 0.5f, -0.5f,  0.5f), glm::vec3(-0.5f,  0.5f,  0.5f), glm::vec3( 0.5f,  0.5f,  0.5f),
+	};
+	const uint32_t placeholder_indices[] = {
+		0, 4, 6, 0, 6, 2,   1, 3, 7, 1, 7, 5,   0, 1, 5, 0, 5, 4,
+		2, 6, 7, 2, 7, 3,   0, 2, 3, 0, 3, 1,   4, 5, 7, 4, 7, 6,
+	};
+	const GeometryPoolMesh placeholder_mesh = geometryPoolAddMesh("Placeholder", placeholder_positions, 8, placeholder_indices, 36);
+	jobSystemSignalFence(geometry_pool_created);
+
+	// The teapot's positions are the control points of its Bezier patches, 16 per patch:
+	std::vector<glm::vec3> teapot_control_points;
+	std::vector<uint32_t> teapot_control_point_indices;
+	teapotGetGeometry(teapot_control_points, teapot_control_point_indices);
+	const uint32_t num_teapot_patches = static_cast<uint32_t>(teapot_control_points.size() / 16);
+	startupGraphEnd(geometry_phase);
+
+	// Pipelines only need the device and the formats. They are compiled in the background while the swapchain, the framework,
+	// the descriptors, and the scene are created, and fetched at the end of startup. The swapchain has the window's size:
+	const StartupTask pipeline_phase = startupGraphBegin("Create Pipelines");
+	const VkExtent2D swapchain_extent = { static_cast<uint32_t>(window_width), static_cast<uint32_t>(window_height) };
+	std::vector<StartupTask> pipeline_tasks;
+
+	// Our pipelines are used within the framework's render pass, hence they are created for a compatible one:
+	VkRenderPass vk_compatible_render_pass = hlpCreateCompatibleRenderPass(vk_device, surface_format.format, depth_format);
+
+	// With multiple views, the scene is rendered into the layers of the multiview target instead, hence the scene's
+	// pipelines are created for a compatible multiview render pass and the extent of a single view:
+	const ShaderFeatures multiview_feature = num_views > 1 ? SHADER_FEATURE_MULTIVIEW : 0;
+	const VkExtent2D scene_extent = num_views > 1 ? multiviewGetViewExtent(swapchain_extent, num_views) : swapchain_extent;
+	VkRenderPass vk_scene_render_pass = num_views > 1
+		? hlpCreateCompatibleRenderPass(vk_device, surface_format.format, depth_format, multiviewGetViewMask(num_views))
+		: vk_compatible_render_pass;
+
+	// The shaders are selected by shaderPermutationApply below:
+	VklGraphicsPipelineConfig pipeline_config;
+
+	VkVertexInputBindingDescription vertex_input = {};
+	vertex_input.binding = 0;
+	vertex_input.stride = sizeof(float) * 3;
+	vertex_input.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+	pipeline_config.vertexInputBuffers.push_back(vertex_input);
+
+	VkVertexInputAttributeDescription vertex_attribute = {};
+	vertex_attribute.binding = 0;
+	vertex_attribute.location = 0;
+	vertex_attribute.format = VK_FORMAT_R32G32B32_SFLOAT;
+
+	pipeline_config.inputAttributeDescriptions.push_back(vertex_attribute);
+
+	// World matrices are read per instance from the scene graph's instance buffer, one column per location:
+	VkVertexInputBindingDescription instance_input = {};
+	instance_input.binding = 1;
+	instance_input.stride = sizeof(glm::mat4);
+	instance_input.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+	pipeline_config.vertexInputBuffers.push_back(instance_input);
+	for (uint32_t column = 0; column < 4; ++column) {
+		VkVertexInputAttributeDescription instance_attribute = {};
+		instance_attribute.binding = 1;
+		instance_attribute.location = 1 + column;
+		instance_attribute.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+		instance_attribute.offset = column * sizeof(glm::vec4);
+		pipeline_config.inputAttributeDescriptions.push_back(instance_attribute);
+	}
+	pipeline_config.polygonDrawMode = VK_POLYGON_MODE_FILL;
+	pipeline_config.triangleCullingMode = VK_CULL_MODE_BACK_BIT;
+
+	struct UniformBufferData {
+    	glm::vec4 color = glm::vec4{1.0f, 0.25f, 0.0f, 1.0f};
+		glm::mat4 transformation = glm::mat4{ 1,  0,  0,  0,
+           0, -1,  0,  0,
+           0,  0, -1,  0,
+           0,  0,  0,  1};
+		glm::vec4 camera_position = glm::vec4{0.0f, 0.0f, 0.0f, 1.0f};
+		glm::vec4 viewport_size = glm::vec4{1.0f, 1.0f, 0.0f, 0.0f};
+		glm::mat4 view_transformations[kMultiviewMaxViews] = {};
+	} uniform_buffer_data;
+	uniform_buffer_data.viewport_size = glm::vec4(static_cast<float>(scene_extent.width), static_cast<float>(scene_extent.height), 0.0f, 0.0f);
+
+	VkDescriptorSetLayoutBinding descriptor_binding;
+	descriptor_binding.binding = 0;
+	descriptor_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	descriptor_binding.descriptorCount = 1;
+	descriptor_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+	descriptor_binding.pImmutableSamplers = nullptr;
+
+	pipeline_config.descriptorLayout.push_back(descriptor_binding);
+
+	// With point lights, the fragment shaders additionally read the lights (binding 1) and the cluster light lists (binding 2):
+	const uint32_t num_lights = std::min(options.numLights, kClusteredLightingMaxLights);
+	const ShaderFeatures clustered_lighting_feature = num_lights > 0 ? SHADER_FEATURE_CLUSTERED_LIGHTING : 0;
+	if (num_lights > 0) {
+		VkDescriptorSetLayoutBinding storage_buffer_binding = {};
+		storage_buffer_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		storage_buffer_binding.descriptorCount = 1;
+		storage_buffer_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		storage_buffer_binding.binding = 1;
+		pipeline_config.descriptorLayout.push_back(storage_buffer_binding);
+		storage_buffer_binding.binding = 2;
+		pipeline_config.descriptorLayout.push_back(storage_buffer_binding);
+	}
+
+	// The teapot's triangles are wound counter-clockwise when seen from outside => cull back faces.
+	// With a depth pre-pass, the main pass only shades fragments whose depth equals the nearest one:
+	HlpPipelineState main_pass_state;
+	main_pass_state.cullMode = pipeline_config.triangleCullingMode;
+	main_pass_state.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	// With dynamic resolution, the scene is rendered into a part of an offscreen image, whose size changes every frame.
+	// Multiview renders into an offscreen target of its own:
+	const bool dynamic_resolution = options.dynamicResolutionTarget > 0.0 && 1 == num_views;
+	if (options.dynamicResolutionTarget > 0.0 && !dynamic_resolution) {
+		VKL_LOG("Multiple views are rendered => --dynamic-resolution is ignored.");
+	}
+	main_pass_state.dynamicViewport = dynamic_resolution;
+	if (options.depthPrepass) {
+		main_pass_state.depthWriteEnable = VK_FALSE;
+		main_pass_state.depthCompareOp = VK_COMPARE_OP_EQUAL;
+	}
+	// Every draw gets the smallest shader permutation that it needs: meshes only have positions and are drawn unlit:
+	const ShaderFeatures fog_feature = options.fog ? SHADER_FEATURE_FOG : 0;
+	const ShaderFeatures mesh_features = clustered_lighting_feature | fog_feature;
+	shaderPermutationApply(mesh_features | multiview_feature, pipeline_config, main_pass_state);
+	VKL_LOG("Mesh shader permutation: " << shaderPermutationFind(mesh_features)->name);
+
+	// All pipelines are created through the pipeline cache, which deduplicates identical requests:
+	pipelineCacheCreate(vk_device, vk_scene_render_pass, scene_extent);
+	pipeline_tasks.push_back(startupGraphTrack("Compile Main Pipeline", pipelineCachePrepare(pipeline_config, main_pass_state)));
+
+	// The depth pre-pass variants only write depth:
+	HlpPipelineState depth_prepass_state = main_pass_state;
+	depth_prepass_state.depthWriteEnable = VK_TRUE;
+	depth_prepass_state.depthCompareOp = VK_COMPARE_OP_LESS;
+	depth_prepass_state.colorWriteMask = 0;
+	depth_prepass_state.useFragmentShader = false;
+	if (options.depthPrepass) {
+		pipeline_tasks.push_back(startupGraphTrack("Compile Depth Pre-Pass Pipeline", pipelineCachePrepare(pipeline_config, depth_prepass_state)));
+	}
+
+	// The tessellated teapot has interleaved positions and normals in vertex input binding 0:
+	VklGraphicsPipelineConfig tessellated_pipeline_config = pipeline_config;
+	HlpPipelineState tessellated_state = main_pass_state;
+	if (options.tessellation) {
+		// Point lights replace the directional light:
+		const ShaderFeatures lighting_feature = num_lights > 0 ? SHADER_FEATURE_CLUSTERED_LIGHTING : SHADER_FEATURE_LIGHTING;
+		const ShaderFeatures tessellated_features = SHADER_FEATURE_VERTEX_NORMALS | lighting_feature | fog_feature;
+		shaderPermutationApply(tessellated_features | multiview_feature, tessellated_pipeline_config, tessellated_state);
+		VKL_LOG("Tessellated teapot shader permutation: " << shaderPermutationFind(tessellated_features)->name);
+		tessellated_pipeline_config.vertexInputBuffers[0].stride = sizeof(PatchTessellatorVertex);
+		VkVertexInputAttributeDescription normal_attribute = {};
+		normal_attribute.binding = 0;
+		normal_attribute.location = 5;
+		normal_attribute.format = VK_FORMAT_R32G32B32_SFLOAT;
+		normal_attribute.offset = offsetof(PatchTessellatorVertex, normal);
+		tessellated_pipeline_config.inputAttributeDescriptions.push_back(normal_attribute);
+
+		pipeline_tasks.push_back(startupGraphTrack("Compile Tessellated Pipeline", pipelineCachePrepare(tessellated_pipeline_config, tessellated_state)));
+	}
+	HlpPipelineState tessellated_depth_prepass_state = tessellated_state;
+	tessellated_depth_prepass_state.depthWriteEnable = VK_TRUE;
+	tessellated_depth_prepass_state.depthCompareOp = VK_COMPARE_OP_LESS;
+	tessellated_depth_prepass_state.colorWriteMask = 0;
+	tessellated_depth_prepass_state.useFragmentShader = false;
+	if (options.tessellation && options.depthPrepass) {
+		pipeline_tasks.push_back(startupGraphTrack("Compile Tessellated Depth Pre-Pass Pipeline",
+			pipelineCachePrepare(tessellated_pipeline_config, tessellated_depth_prepass_state)));
+	}
+
+	// Wireframe variants are only compiled when wireframe mode is switched on for the first time. They have
+	// to pass the depth test against the solid depth pre-pass, which rasterizes at slightly different depths:
+	const bool wireframe_supported = VK_TRUE == enabled_features.fillModeNonSolid;
+	if (!wireframe_supported) {
+		VKL_LOG("Non-solid fill modes are not supported by the device => wireframe mode is unavailable.");
+	}
+	VklGraphicsPipelineConfig wireframe_pipeline_config = pipeline_config;
+	wireframe_pipeline_config.polygonDrawMode = VK_POLYGON_MODE_LINE;
+	VklGraphicsPipelineConfig tessellated_wireframe_pipeline_config = tessellated_pipeline_config;
+	tessellated_wireframe_pipeline_config.polygonDrawMode = VK_POLYGON_MODE_LINE;
+	HlpPipelineState wireframe_state = main_pass_state;
+	HlpPipelineState tessellated_wireframe_state = tessellated_state;
+	if (options.depthPrepass) {
+		wireframe_state.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+		tessellated_wireframe_state.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	}
+	bool wireframe = false;
+	bool wireframe_key_was_down = false;
+
+	startupGraphEnd(pipeline_phase);
+
 	/* --------------------------------------------- */
 	// Task 1.7: Create Swap Chain
 	/* --------------------------------------------- */
+	const StartupTask task_1_7 = startupGraphBegin("Task 1.7: Create Swapchain");
 	VkSwapchainKHR vk_swapchain = VK_NULL_HANDLE;
 
 	VkSurfaceCapabilitiesKHR surface_capabilities = hlpGetPhysicalDeviceSurfaceCapabilities(vk_physical_device, vk_surface);
@@ -287,11 +809,20 @@ int main(int argc, char** argv)
 	swapchain_create_info.queueFamilyIndexCount = static_cast<uint32_t>(vec_queue_family_indices.size());
 	swapchain_create_info.pQueueFamilyIndices = &vec_queue_family_indices[0];
 
-	swapchain_create_info.imageFormat = hlpGetSurfaceImageFormat(vk_physical_device, vk_surface).format;
-	swapchain_create_info.imageColorSpace = hlpGetSurfaceImageFormat(vk_physical_device, vk_surface).colorSpace;
+	swapchain_create_info.imageFormat = surface_format.format;
+	swapchain_create_info.imageColorSpace = surface_format.colorSpace;
 	swapchain_create_info.imageExtent.height = window_height;
 	swapchain_create_info.imageExtent.width = window_width;
 	swapchain_create_info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+	if (nullptr != options.replayCameraPath) {
+		// Benchmarks shall not be limited by the display's refresh rate:
+		if (hlpIsPresentModeSupported(vk_physical_device, vk_surface, VK_PRESENT_MODE_IMMEDIATE_KHR)) {
+			swapchain_create_info.presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+		}
+		else if (hlpIsPresentModeSupported(vk_physical_device, vk_surface, VK_PRESENT_MODE_MAILBOX_KHR)) {
+			swapchain_create_info.presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+		}
+	}
 	// TODO: Provide values for:
 	//        - VkSwapchainCreateInfoKHR::queueFamilyIndexCount
 	//        - VkSwapchainCreateInfoKHR::pQueueFamilyIndices
@@ -326,34 +857,73 @@ int main(int argc, char** argv)
 	{
 		VKL_EXIT_WITH_ERROR("image count mismatch");
 	}
+	startupGraphEnd(task_1_7);
 	VKL_LOG("Task 1.7 done.");
 
 	/* --------------------------------------------- */
 	// Task 1.8: Initialize Vulkan Launchpad
 	/* --------------------------------------------- */
+	const StartupTask task_1_8 = startupGraphBegin("Task 1.8: Init Framework");
+
+	// Create one depth buffer per swapchain image in the most precise supported format (see Task 1.4). Frames in flight
+	// thus never share a depth buffer, and the framework's render pass clears it at the beginning of each frame:
+	std::vector<VkImage> depth_images(swap_chain_images.size());
+	std::vector<VkDeviceMemory> depth_images_memory(swap_chain_images.size());
+	for (size_t i = 0; i < swap_chain_images.size(); ++i) {
+		VkImageCreateInfo depth_image_create_info = {};
+		depth_image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		depth_image_create_info.imageType = VK_IMAGE_TYPE_2D;
+		depth_image_create_info.format = depth_format;
+		depth_image_create_info.extent = VkExtent3D{ swapchain_create_info.imageExtent.width, swapchain_create_info.imageExtent.height, 1 };
+		depth_image_create_info.mipLevels = 1;
+		depth_image_create_info.arrayLayers = 1;
+		depth_image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+		depth_image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+		depth_image_create_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		depth_image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		depth_image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		result = vkCreateImage(vk_device, &depth_image_create_info, nullptr, &depth_images[i]);
+		VKL_CHECK_VULKAN_RESULT(result);
+
+		VkMemoryRequirements memory_requirements;
+		vkGetImageMemoryRequirements(vk_device, depth_images[i], &memory_requirements);
+		VkMemoryAllocateInfo memory_allocate_info = {};
+		memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		memory_allocate_info.allocationSize = memory_requirements.size;
+		memory_allocate_info.memoryTypeIndex = hlpFindMemoryTypeIndex(vk_physical_device, memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		result = MEMORY_TRACKER_ALLOCATE(vk_device, &memory_allocate_info, &depth_images_memory[i], MEMORY_CATEGORY_RENDER_TARGETS, "Depth Buffer");
+		VKL_CHECK_VULKAN_RESULT(result);
+		result = vkBindImageMemory(vk_device, depth_images[i], depth_images_memory[i], 0);
+		VKL_CHECK_VULKAN_RESULT(result);
+		hlpSetDebugUtilsObjectName(vk_device, VK_OBJECT_TYPE_IMAGE, (uint64_t)depth_images[i], "Depth Buffer");
+	}
 
 	// Gather swapchain config as required by the framework:
 	VklSwapchainConfig swapchain_config = {};
 	swapchain_config.imageExtent = swapchain_create_info.imageExtent;
 	swapchain_config.swapchainHandle = vk_swapchain;
-	for (VkImage vk_image : swap_chain_images) {
+	for (size_t i = 0; i < swap_chain_images.size(); ++i) {
+		VkImage vk_image = swap_chain_images[i];
 		VklSwapchainFramebufferComposition framebufferData;
 		// TODO: Fill the data for the color attachment:
 		//  - VklSwapchainImageDetails::imageHandle
 		//  - VklSwapchainImageDetails::imageFormat
 		//  - VklSwapchainImageDetails::imageUsage
 		//  - VklSwapchainImageDetails::clearValue
-		framebufferData.colorAttachmentImageDetails.imageFormat = hlpGetSurfaceImageFormat(vk_physical_device, vk_surface).format;
+		framebufferData.colorAttachmentImageDetails.imageFormat = surface_format.format;
 		framebufferData.colorAttachmentImageDetails.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 		framebufferData.colorAttachmentImageDetails.imageHandle = vk_image;
 		framebufferData.colorAttachmentImageDetails.clearValue = VkClearValue {
 			VkClearColorValue{ 0.39f, 0.58f, 0.93f, 1.0f }
 		};
 
-		// We don't need the depth attachment now, but keep it in mind for later!
-		framebufferData.depthAttachmentImageDetails.imageHandle = VK_NULL_HANDLE;
+		framebufferData.depthAttachmentImageDetails.imageHandle = depth_images[i];
+		framebufferData.depthAttachmentImageDetails.imageFormat = depth_format;
+		framebufferData.depthAttachmentImageDetails.imageUsage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		framebufferData.depthAttachmentImageDetails.clearValue.depthStencil = VkClearDepthStencilValue{ 1.0f, 0 };
 
 		// Add it to the vector:
+		hlpSetDebugUtilsObjectName(vk_device, VK_OBJECT_TYPE_IMAGE, (uint64_t)vk_image, "Swapchain Image");
 		swapchain_config.swapchainImages.push_back(framebufferData);
 	}
 
@@ -361,118 +931,798 @@ int main(int argc, char** argv)
 	if (!vklInitFramework(vk_instance, vk_surface, vk_physical_device, vk_device, vk_queue, swapchain_config)) {
 		VKL_EXIT_WITH_ERROR("Failed to init Vulkan Launchpad");
 	}
+	startupGraphEnd(task_1_8);
 	VKL_LOG("Task 1.8 done.");
 
-	VklGraphicsPipelineConfig pipeline_config;
-	pipeline_config.vertexShaderPath = "../../shaders/vertex.shader";
-	pipeline_config.fragmentShaderPath = "../../shaders/fragment.shader";
-
-	VkVertexInputBindingDescription vertex_input = {};
-	vertex_input.binding = 0;
-	vertex_input.stride = sizeof(float) * 3;
-	vertex_input.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-	pipeline_config.vertexInputBuffers.push_back(vertex_input);
-
-	VkVertexInputAttributeDescription vertex_attribute = {};
-	vertex_attribute.binding = 0;
-	vertex_attribute.location = 0;
-	vertex_attribute.format = VK_FORMAT_R32G32B32_SFLOAT;
-
-	pipeline_config.inputAttributeDescriptions.push_back(vertex_attribute);
-	pipeline_config.polygonDrawMode = VK_POLYGON_MODE_FILL;
-	pipeline_config.triangleCullingMode = VK_CULL_MODE_NONE;
-
-	struct UniformBufferData {
-    	glm::vec4 color = glm::vec4{1.0f, 0.25f, 0.0f, 1.0f};
-		glm::mat4 transformation = glm::mat4{ 1,  0,  0,  0,
-           0, -1,  0,  0,
-           0,  0, -1,  0,
-           0,  0,  0,  1};
-	} uniform_buffer_data;
+	// All per-frame resources (uniform, instance, and light buffers, descriptor sets, draw lists) exist once per swapchain
+	// image and are only written after vklWaitForNextSwapchainImage => there cannot be more frames in flight than images:
+	uint32_t frames_in_flight = std::max(options.framesInFlight, 1u);
+	if (frames_in_flight > swap_chain_images.size()) {
+		frames_in_flight = static_cast<uint32_t>(swap_chain_images.size());
+		VKL_LOG("Only " << frames_in_flight << " swapchain images => --frames-in-flight is clamped.");
+	}
+	frameSchedulerCreate(vk_device, vk_queue, frames_in_flight, timeline_semaphores_enabled);
+
+	// Readbacks finish a few frames after they have been submitted => more readback buffers than frames in flight,
+	// so that frames are only dropped if the writer thread cannot keep up:
+	const bool frame_capture_enabled = nullptr != options.captureDirectory;
+	if (frame_capture_enabled) {
+		const bool compare = nullptr != options.goldenDirectory;
+		frameCaptureCreate(vk_physical_device, vk_device, vk_queue, selected_queue_family_index,
+			swapchain_create_info.imageFormat, depth_format, swapchain_create_info.imageExtent, vk_compatible_render_pass,
+			frames_in_flight + 1u, frames_in_flight + 2u,
+			compare ? FRAME_CAPTURE_MODE_COMPARE : options.captureMode, options.captureDirectory, options.goldenDirectory);
+	}
+	else if (nullptr != options.goldenDirectory) {
+		VKL_LOG("--golden requires --capture <directory> for diff images => no frames are compared.");
+	}
 
-	VkDescriptorSetLayoutBinding descriptor_binding;
-	descriptor_binding.binding = 0;
-	descriptor_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	descriptor_binding.descriptorCount = 1;
-	descriptor_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_VERTEX_BIT;
-	descriptor_binding.pImmutableSamplers = nullptr;
+	// The GPU profiler keeps more frames' queries than there are swapchain images, so that reading back results never stalls:
+	gpuProfilerCreate(vk_physical_device, vk_device, vk_queue, selected_queue_family_index,
+		static_cast<uint32_t>(swap_chain_images.size()) + 1u, VK_TRUE == enabled_features.pipelineStatisticsQuery);
 
-	pipeline_config.descriptorLayout.push_back(descriptor_binding);
+	// Dynamic resolution is driven by the GPU profiler's frame times. At most half the resolution per axis, since
+	// the upscaled image gets too blurry below that:
+	if (dynamic_resolution) {
+		dynamicResolutionCreate(vk_physical_device, vk_device, vk_queue, selected_queue_family_index,
+			swapchain_create_info.imageFormat, depth_format, swapchain_create_info.imageExtent, vk_compatible_render_pass,
+			frames_in_flight + 1u, options.dynamicResolutionTarget, 0.5f, 0.5f, nullptr != options.resolutionHistoryPath);
+	}
 
-	auto vk_pipeline = vklCreateGraphicsPipeline(pipeline_config);
+	// The views share the swapchain image side by side:
+	if (num_views > 1) {
+		multiviewCreate(vk_physical_device, vk_device, vk_queue, selected_queue_family_index,
+			swapchain_create_info.imageFormat, depth_format, swapchain_create_info.imageExtent, vk_compatible_render_pass,
+			num_views, frames_in_flight + 1u);
+		VKL_LOG(num_views << " views of " << scene_extent.width << "x" << scene_extent.height << " pixels are rendered in a single pass.");
+	}
 
-	auto vk_uniform_buffer = vklCreateHostCoherentBufferWithBackingMemory(sizeof(uniform_buffer_data),
-		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+	// The render graph records all passes which run before the framework's render pass. Passes and
+	// resources are declared below, before renderGraphCompile is called:
+	renderGraphCreate(vk_physical_device, vk_device, vk_queue, selected_queue_family_index,
+		static_cast<uint32_t>(swap_chain_images.size()), synchronization2_enabled);
+
+	const StartupTask descriptors_phase = startupGraphBegin("Create Uniform Buffers and Descriptors");
+	// One uniform buffer per swapchain image, since the camera changes every frame while earlier frames may still read it:
+	std::vector<HlpMappedBuffer> uniform_buffers(swap_chain_images.size());
+	for (auto& uniform_buffer : uniform_buffers) {
+		uniform_buffer = hlpCreateMappedBuffer(vk_physical_device, vk_device, sizeof(uniform_buffer_data),
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, MEMORY_CATEGORY_UNIFORMS, "Uniform Buffer");
+		memcpy(uniform_buffer.mappedData, &uniform_buffer_data, sizeof(uniform_buffer_data));
+	}
 
-	vklCopyDataIntoHostCoherentBuffer(vk_uniform_buffer, &uniform_buffer_data, sizeof(uniform_buffer_data));
+	// Lights and cluster light lists exist once per swapchain image. Their "Light Culling" pass is added to the render graph:
+	if (num_lights > 0) {
+		clusteredLightingCreate(vk_physical_device, vk_device, static_cast<uint32_t>(swap_chain_images.size()), num_views);
+	}
 
-	VkDescriptorPoolSize uniform_buffer_pool_size = {};
-	uniform_buffer_pool_size.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	uniform_buffer_pool_size.descriptorCount = 16;
+	// One descriptor set per swapchain image, since the light buffers differ per image:
+	const uint32_t num_descriptor_sets = static_cast<uint32_t>(swap_chain_images.size());
+	VkDescriptorPoolSize descriptor_pool_sizes[2] = {};
+	descriptor_pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	descriptor_pool_sizes[0].descriptorCount = num_descriptor_sets;
+	descriptor_pool_sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	descriptor_pool_sizes[1].descriptorCount = 2 * num_descriptor_sets;
 
 	VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
 	descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	descriptor_pool_create_info.maxSets = 8;
-	descriptor_pool_create_info.poolSizeCount = 1;
-	descriptor_pool_create_info.pPoolSizes = &uniform_buffer_pool_size;
+	descriptor_pool_create_info.maxSets = num_descriptor_sets;
+	descriptor_pool_create_info.poolSizeCount = num_lights > 0 ? 2 : 1;
+	descriptor_pool_create_info.pPoolSizes = descriptor_pool_sizes;
 
 	VkDescriptorPool vk_descriptor_pool = nullptr;
 	result = vkCreateDescriptorPool(vk_device, &descriptor_pool_create_info, nullptr, &vk_descriptor_pool);
 	VKL_CHECK_VULKAN_RESULT(result);
 
 	VkDescriptorSetLayoutCreateInfo descript_set_create_info = {};
-	descript_set_create_info.bindingCount = 1;
-	descript_set_create_info.pBindings = &descriptor_binding;
+	descript_set_create_info.bindingCount = static_cast<uint32_t>(pipeline_config.descriptorLayout.size());
+	descript_set_create_info.pBindings = pipeline_config.descriptorLayout.data();
 	descript_set_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 
 	VkDescriptorSetLayout vk_descriptor_set_layout = {};
 	result = vkCreateDescriptorSetLayout(vk_device, &descript_set_create_info, nullptr, &vk_descriptor_set_layout);
 	VKL_CHECK_VULKAN_RESULT(result);
 
+	const std::vector<VkDescriptorSetLayout> descriptor_set_layouts(num_descriptor_sets, vk_descriptor_set_layout);
 	VkDescriptorSetAllocateInfo descriptor_set_alloc_info = {};
 	descriptor_set_alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
 	descriptor_set_alloc_info.descriptorPool = vk_descriptor_pool;
-	descriptor_set_alloc_info.descriptorSetCount = 1;
-	descriptor_set_alloc_info.pSetLayouts = &vk_descriptor_set_layout;
+	descriptor_set_alloc_info.descriptorSetCount = num_descriptor_sets;
+	descriptor_set_alloc_info.pSetLayouts = descriptor_set_layouts.data();
 
-	VkDescriptorSet vk_descriptor_set = nullptr;
-	result = vkAllocateDescriptorSets(vk_device, &descriptor_set_alloc_info, &vk_descriptor_set);
+	std::vector<VkDescriptorSet> vk_descriptor_sets(num_descriptor_sets);
+	result = vkAllocateDescriptorSets(vk_device, &descriptor_set_alloc_info, vk_descriptor_sets.data());
+	VKL_CHECK_VULKAN_RESULT(result);
 
-	VkDescriptorBufferInfo descriptor_buffer_info = {};
-	descriptor_buffer_info.buffer = vk_uniform_buffer;
-	descriptor_buffer_info.offset = 0;
-	descriptor_buffer_info.range = VK_WHOLE_SIZE;
+	for (uint32_t i = 0; i < num_descriptor_sets; ++i) {
+		hlpSetDebugUtilsObjectName(vk_device, VK_OBJECT_TYPE_DESCRIPTOR_SET, (uint64_t)vk_descriptor_sets[i], "Teapot Descriptor Set");
+
+		VkDescriptorBufferInfo descriptor_buffer_infos[3] = {};
+		descriptor_buffer_infos[0].buffer = uniform_buffers[i].buffer;
+		descriptor_buffer_infos[0].offset = 0;
+		descriptor_buffer_infos[0].range = VK_WHOLE_SIZE;
+
+		VkWriteDescriptorSet write_descriptor_sets[2] = {};
+		write_descriptor_sets[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write_descriptor_sets[0].dstSet = vk_descriptor_sets[i];
+		write_descriptor_sets[0].dstBinding = 0;
+		write_descriptor_sets[0].descriptorCount = 1;
+		write_descriptor_sets[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+		write_descriptor_sets[0].pBufferInfo = &descriptor_buffer_infos[0];
+
+		if (num_lights > 0) {
+			descriptor_buffer_infos[1].buffer = clusteredLightingGetLightBuffer(i);
+			descriptor_buffer_infos[1].range = VK_WHOLE_SIZE;
+			descriptor_buffer_infos[2].buffer = clusteredLightingGetClusterBuffer(i);
+			descriptor_buffer_infos[2].range = VK_WHOLE_SIZE;
+			write_descriptor_sets[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write_descriptor_sets[1].dstSet = vk_descriptor_sets[i];
+			write_descriptor_sets[1].dstBinding = 1;
+			write_descriptor_sets[1].descriptorCount = 2;
+			write_descriptor_sets[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			write_descriptor_sets[1].pBufferInfo = &descriptor_buffer_infos[1];
+		}
 
-	VkWriteDescriptorSet write_descriptor_set = {};
-	write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	write_descriptor_set.dstSet = vk_descriptor_set;
-	write_descriptor_set.dstBinding = 0;
-	write_descriptor_set.descriptorCount = 1;
-	write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	write_descriptor_set.pBufferInfo = &descriptor_buffer_info;
+		vkUpdateDescriptorSets(vk_device, num_lights > 0 ? 2 : 1, write_descriptor_sets, 0, nullptr);
+	}
 
-	vkUpdateDescriptorSets(vk_device, 1, &write_descriptor_set, 0, nullptr);
+	startupGraphEnd(descriptors_phase);
 
 	VklCameraHandle camera = vklCreateCamera(window);
 
-	teapotCreateGeometryAndBuffers();
+	// The scene: every scene graph node with a mesh is drawn as one instance of that mesh. The teapot
+	// is turned around so that its spout points to the left:
+	const StartupTask scene_phase = startupGraphBegin("Create Scene");
+	SceneGraph scene;
+	std::vector<AssetHandle> node_assets; // The mesh asset of each node, or kAssetInvalid
+	const glm::quat turn_around = glm::angleAxis(glm::radians(180.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	if (meshes_scene) {
+		const uint32_t root = sceneGraphAddNode(scene, kSceneGraphNoParent);
+		node_assets.push_back(kAssetInvalid);
+		sceneGraphAddNode(scene, root, glm::vec3(-0.6f, 0.5f, 0.0f), turn_around, glm::vec3(0.5f));
+		node_assets.push_back(teapot_asset);
+		sceneGraphAddNode(scene, root, glm::vec3(0.6f, 0.5f, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.25f));
+		node_assets.push_back(cube_asset);
+		sceneGraphAddNode(scene, root, glm::vec3(-0.6f, -0.5f, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.3f));
+		node_assets.push_back(sphere_asset);
+		sceneGraphAddNode(scene, root, glm::vec3(0.6f, -0.5f, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.25f));
+		node_assets.push_back(vespa_asset);
+	}
+	else {
+		if (strcmp(options.scene, "teapot") != 0) {
+			VKL_LOG("Unknown scene \"" << options.scene << "\" => rendering the teapot instead.");
+		}
+		sceneGraphAddNode(scene, kSceneGraphNoParent, glm::vec3(0.0f), turn_around);
+		node_assets.push_back(teapot_asset);
+	}
+	// Streamed tiles are drawn as instances of their own root node, which is not transformed:
+	uint32_t tiles_node = kSceneGraphNoParent;
+	if (tiles_enabled) {
+		tiles_node = sceneGraphAddNode(scene, kSceneGraphNoParent);
+		node_assets.push_back(kAssetInvalid);
+	}
+	sceneGraphUpdate(scene);
+
+	// One instance buffer per swapchain image, each of which remembers the scene graph version it holds,
+	// so that only changed world matrices need to be written when it is used next:
+	std::vector<HlpMappedBuffer> instance_buffers(swap_chain_images.size());
+	std::vector<uint64_t> instance_buffer_versions(swap_chain_images.size(), 0);
+	for (auto& instance_buffer : instance_buffers) {
+		instance_buffer = hlpCreateMappedBuffer(vk_physical_device, vk_device, sizeof(glm::mat4) * sceneGraphGetNumNodes(scene),
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, MEMORY_CATEGORY_INSTANCES, "Instance Buffer");
+	}
+
+	// Likewise, one tessellation of the teapot per swapchain image, which is only rewritten when its level changes:
+	std::vector<PatchTessellationBuffer> tessellation_buffers;
+	if (options.tessellation) {
+		for (size_t i = 0; i < swap_chain_images.size(); ++i) {
+			tessellation_buffers.push_back(patchTessellatorCreateBuffer(vk_physical_device, vk_device, num_teapot_patches));
+		}
+	}
+	startupGraphEnd(scene_phase);
+
+	const StartupTask render_graph_phase = startupGraphBegin("Compile Render Graph");
+	renderGraphCompile();
+	startupGraphEnd(render_graph_phase);
+
+	// The pipelines have been compiling since the device was created. Wait for those which are still compiling:
+	const StartupTask wait_for_pipelines_phase = startupGraphBegin("Wait For Pipelines");
+	for (StartupTask task : pipeline_tasks) {
+		startupGraphWait(task);
+	}
+	VkPipeline vk_pipeline = pipelineCacheGet(pipeline_config, main_pass_state);
+	hlpSetDebugUtilsObjectName(vk_device, VK_OBJECT_TYPE_PIPELINE, (uint64_t)vk_pipeline, "Main Pipeline");
+	VkPipeline vk_depth_prepass_pipeline = VK_NULL_HANDLE;
+	if (options.depthPrepass) {
+		vk_depth_prepass_pipeline = pipelineCacheGet(pipeline_config, depth_prepass_state);
+		hlpSetDebugUtilsObjectName(vk_device, VK_OBJECT_TYPE_PIPELINE, (uint64_t)vk_depth_prepass_pipeline, "Depth Pre-Pass Pipeline");
+	}
+	VkPipeline vk_tessellated_pipeline = VK_NULL_HANDLE;
+	VkPipeline vk_tessellated_depth_prepass_pipeline = VK_NULL_HANDLE;
+	if (options.tessellation) {
+		vk_tessellated_pipeline = pipelineCacheGet(tessellated_pipeline_config, tessellated_state);
+		hlpSetDebugUtilsObjectName(vk_device, VK_OBJECT_TYPE_PIPELINE, (uint64_t)vk_tessellated_pipeline, "Tessellated Pipeline");
+		if (options.depthPrepass) {
+			vk_tessellated_depth_prepass_pipeline = pipelineCacheGet(tessellated_pipeline_config, tessellated_depth_prepass_state);
+			hlpSetDebugUtilsObjectName(vk_device, VK_OBJECT_TYPE_PIPELINE, (uint64_t)vk_tessellated_depth_prepass_pipeline, "Tessellated Depth Pre-Pass Pipeline");
+		}
+	}
+	startupGraphEnd(wait_for_pipelines_phase);
+
+	PROFILER_END(startup_zone);
+
+	// Camera paths are either replayed (benchmark mode) or recorded:
+	std::vector<glm::mat4> camera_path;
+	const bool benchmark_mode = nullptr != options.replayCameraPath;
+	if (benchmark_mode) {
+		if (!cameraPathLoad(options.replayCameraPath, camera_path)) {
+			VKL_EXIT_WITH_ERROR("Unable to load camera path from \"" << options.replayCameraPath << "\"");
+		}
+		VKL_LOG("Replaying camera path \"" << options.replayCameraPath << "\" with " << camera_path.size() << " frames.");
+	}
+	const uint64_t num_benchmark_frames = options.benchmarkFrames > 0 ? options.benchmarkFrames : camera_path.size();
+
+	// Benchmarks measure continuous rendering, and their camera moves every frame anyway:
+	const bool on_demand = options.onDemand && !benchmark_mode;
+	if (options.onDemand && benchmark_mode) {
+		VKL_LOG("--on-demand is ignored in benchmark mode.");
+	}
+	if (on_demand) {
+		renderOnDemandCreate(window, options.maxIdleSeconds);
+	}
+
+	// All draws are queued into a draw list, which is sorted and submitted with as few binds as possible.
+	// Passes, pipelines, materials, and meshes are identified by small integers in the sort keys:
+	const uint32_t depth_prepass_pass_id = 0;
+	const uint32_t main_pass_id = 1;
+	const uint32_t depth_prepass_pipeline_id = 0;
+	const uint32_t main_pipeline_id = 1;
+	const uint32_t material_id = 0;
+	// With --reuse-draw-lists, every swapchain image keeps its own draw list, see DrawListState below:
+	std::vector<DrawList> draw_lists(options.reuseDrawLists ? swap_chain_images.size() : 1);
+	for (DrawList& draw_list : draw_lists) {
+		drawListSetPassName(draw_list, depth_prepass_pass_id, "Depth Pre-Pass");
+		drawListSetPassName(draw_list, main_pass_id, "Main Pass");
+	}
+	DrawListStatistics previous_draw_list_statistics = {};
+
+	// With --reuse-draw-lists and a scene render pass of our own, i.e., with dynamic resolution, multiview, or frame capture,
+	// every swapchain image's draw list is also recorded once into a secondary command buffer, which is executed again in
+	// later frames. It is only recorded anew if the draw list has been rebuilt or the render extent has changed. The
+	// framework's render pass begins with inline contents, so without a pass of our own, draw lists are recorded every frame:
+	struct SceneCommands {
+		VkCommandBuffer    commandBuffer;
+		bool               valid;
+		VkExtent2D         renderExtent;
+		DrawListStatistics statistics;
+	};
+	const bool reuse_scene_commands = options.reuseDrawLists && (dynamic_resolution || num_views > 1 || frame_capture_enabled);
+	VkCommandPool vk_scene_command_pool = VK_NULL_HANDLE;
+	std::vector<SceneCommands> scene_commands;
+	uint64_t num_reused_scene_commands = 0;
+	if (reuse_scene_commands) {
+		VkCommandPoolCreateInfo command_pool_create_info = {};
+		command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		command_pool_create_info.queueFamilyIndex = selected_queue_family_index;
+		VkResult result = vkCreateCommandPool(vk_device, &command_pool_create_info, nullptr, &vk_scene_command_pool);
+		VKL_CHECK_VULKAN_RESULT(result);
+		scene_commands.resize(swap_chain_images.size());
+		for (SceneCommands& commands : scene_commands) {
+			VkCommandBufferAllocateInfo command_buffer_alloc_info = {};
+			command_buffer_alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			command_buffer_alloc_info.commandPool = vk_scene_command_pool;
+			command_buffer_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			command_buffer_alloc_info.commandBufferCount = 1;
+			result = vkAllocateCommandBuffers(vk_device, &command_buffer_alloc_info, &commands.commandBuffer);
+			VKL_CHECK_VULKAN_RESULT(result);
+			hlpSetDebugUtilsObjectName(vk_device, VK_OBJECT_TYPE_COMMAND_BUFFER, (uint64_t)commands.commandBuffer, "Scene Command Buffer");
+			commands.valid = false;
+			commands.renderExtent = VkExtent2D{ 0, 0 };
+			commands.statistics = {};
+		}
+	}
+
+	// Everything which a swapchain image's draw list depends on, besides the per-image buffers and descriptor sets.
+	// Dynamic data (camera, lights, world matrices) flows through buffers, so the draw list of a static scene can be
+	// submitted again as is. Only if nodes are culled or tessellated per view, the draw list depends on the camera:
+	struct DrawListState {
+		uint64_t   sceneVersion;
+		VkPipeline mainPipeline;
+		VkPipeline tessellatedPipeline;
+		uint64_t   numPendingAssets;
+		uint64_t   tileResidencyVersion;
+		glm::mat4  viewProjection;
+		glm::vec4  viewportSize;
+	};
+	std::vector<DrawListState> draw_list_states(draw_lists.size());
+	std::vector<bool> draw_list_valid(draw_lists.size(), false);
+	const bool view_dependent_draw_lists = options.occlusionCulling || options.tessellation || tiles_enabled;
+	uint64_t num_reused_draw_lists = 0;
+
+	// Resident tiles are culled against the view frustum before they are drawn:
+	std::vector<OcclusionObject> tile_objects;
+	std::vector<uint8_t> tile_visible;
+
+	// The tessellated teapot is drawn with its own pipelines and buffers. Its segments should be about 8 pixels long:
+	const uint32_t tessellated_depth_prepass_pipeline_id = 2;
+	const uint32_t tessellated_pipeline_id = 3;
+	const uint32_t tessellated_teapot_mesh_id = kDrawListMaxMeshes - 1;
+	const float tessellation_pixels_per_segment = 8.0f;
+	uint32_t previous_tessellation_level = 0;
+
+	// Occlusion culling rasterizes the occluders at a quarter of the viewport's resolution:
+	OcclusionCuller occlusion_culler;
+	std::vector<OcclusionObject> occlusion_objects(sceneGraphGetNumNodes(scene));
+	std::vector<uint8_t> node_visible(sceneGraphGetNumNodes(scene), 1);
+	OcclusionCullerStatistics previous_occlusion_statistics = {};
+	if (options.occlusionCulling) {
+		occlusionCullerCreate(occlusion_culler, swapchain_create_info.imageExtent.width / 4, swapchain_create_info.imageExtent.height / 4);
+		if (num_views > 1) {
+			VKL_LOG("With " << num_views << " views, occlusion culling only culls nodes which are outside of every view's frustum.");
+		}
+	}
+
+	// Point lights orbit around the vertical axis at random distances, heights, and speeds. The more lights there
+	// are, the smaller their radius, so that every surface is reached by a similar number of them:
+	std::vector<ClusteredLight> lights(num_lights);
+	std::vector<glm::vec4> light_orbits(num_lights); // x: distance, y: height, z: initial angle, w: angular velocity
+	{
+		std::mt19937 random_engine(7);
+		std::uniform_real_distribution<float> random_unit(0.0f, 1.0f);
+		const float light_radius = std::max(0.25f, 2.0f / std::cbrt(static_cast<float>(std::max(num_lights, 1u))));
+		for (uint32_t i = 0; i < num_lights; ++i) {
+			light_orbits[i] = glm::vec4(0.2f + 1.6f * random_unit(random_engine), -1.0f + 2.0f * random_unit(random_engine),
+				glm::radians(360.0f) * random_unit(random_engine), 0.25f + random_unit(random_engine));
+			lights[i].positionRadius.w = light_radius;
+			lights[i].color = glm::vec4(random_unit(random_engine), random_unit(random_engine), random_unit(random_engine), 0.0f);
+		}
+	}
+
+	FrameStatistics frame_statistics;
+	if (benchmark_mode) {
+		gpuProfilerCollectFrameTimes(&frame_statistics.gpuMilliseconds);
+		frameSchedulerCollectFrameTimes(&frame_statistics.cpuWaitMilliseconds, &frame_statistics.gpuIdleMilliseconds);
+	}
+	uint64_t frame_index = 0;
+	bool frame_begun = false;
+	// Startup ends when the first frame has been presented:
+	constexpr double startup_target_milliseconds = 100.0;
+	const StartupTask first_frame_phase = startupGraphBegin("First Frame");
+	auto previous_frame_start = std::chrono::steady_clock::now();
 
 	/* --------------------------------------------- */
 	// Task 1.9:  Implement the Render Loop
 	/* --------------------------------------------- */
 	while (!glfwWindowShouldClose(window)) {
-		glfwPollEvents(); // Handle user input
-		vklUpdateCamera(camera);
-		glm::mat4 matrix = vklGetCameraViewProjectionMatrix(camera);
-		uniform_buffer_data.transformation = matrix;
-		vklCopyDataIntoHostCoherentBuffer(vk_uniform_buffer, &uniform_buffer_data, sizeof(uniform_buffer_data));
+		if (benchmark_mode && frame_index >= num_benchmark_frames) {
+			break;
+		}
+		PROFILER_ZONE("Frame");
+		const auto frame_start = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::duration blocking_duration{ 0 };
+
+		// Wait for the GPU before handling input, so that the input is as recent as possible when the frame is recorded.
+		// If on-demand rendering has skipped the previous iteration, its frame has begun already:
+		if (!frame_begun) {
+			frameSchedulerBeginFrame();
+			frame_begun = true;
+		}
+		blocking_duration += std::chrono::steady_clock::now() - frame_start;
 
-		vklWaitForNextSwapchainImage();
-		vklStartRecordingCommands();
-		teapotDraw(vk_pipeline, vk_descriptor_set);
-		vklEndRecordingCommands();
-		vklPresentCurrentSwapchainImage();
+		{
+			PROFILER_ZONE("Poll Events");
+			if (on_demand) {
+				renderOnDemandHandleEvents(jobSystemGetNumUnfinishedJobs() > 0);
+			}
+			else {
+				glfwPollEvents(); // Handle user input
+			}
+		}
+		if (frame_capture_enabled) {
+			frameCapturePoll();
+		}
+		{
+			// Finished asset loads and pipeline compiles become visible here, i.e., never in the middle of a frame:
+			PROFILER_ZONE("Run Main Thread Jobs");
+			jobSystemRunMainThreadJobs();
+		}
+		const bool wireframe_key_down = isKeyDown(GLFW_KEY_F);
+		if (wireframe_supported && wireframe_key_down && !wireframe_key_was_down) {
+			wireframe = !wireframe;
+			VKL_LOG("Wireframe mode " << (wireframe ? "on" : "off") << ".");
+		}
+		wireframe_key_was_down = wireframe_key_down;
+		// Until a wireframe variant has been compiled in the background, the solid pipeline keeps being used:
+		VkPipeline main_pipeline = vk_pipeline;
+		VkPipeline tessellated_pipeline = vk_tessellated_pipeline;
+		if (wireframe) {
+			main_pipeline = pipelineCacheRequest(wireframe_pipeline_config, wireframe_state, vk_pipeline);
+			if (options.tessellation) {
+				tessellated_pipeline = pipelineCacheRequest(tessellated_wireframe_pipeline_config, tessellated_wireframe_state, vk_tessellated_pipeline);
+			}
+		}
+		glm::mat4 view_projection_matrix;
+		{
+			PROFILER_ZONE("Update Camera");
+			if (benchmark_mode) {
+				view_projection_matrix = camera_path[frame_index % camera_path.size()];
+			}
+			else {
+				vklUpdateCamera(camera);
+				view_projection_matrix = vklGetCameraViewProjectionMatrix(camera);
+				if (nullptr != options.recordCameraPath) {
+					camera_path.push_back(view_projection_matrix);
+				}
+			}
+		}
+		{
+			PROFILER_ZONE("Update Scene Graph");
+			sceneGraphUpdate(scene);
+		}
+		if (tiles_enabled) {
+			// The tiles node is not transformed, so the camera position is in the tiles' model space:
+			const glm::vec4 camera_position = glm::inverse(view_projection_matrix)[2];
+			tileStreamerUpdate(glm::vec3(camera_position) / camera_position.w);
+		}
+		if (on_demand) {
+			// Everything which the image depends on. Lights are animated per rendered frame, so they keep changing it:
+			uint64_t state_hash = kRenderOnDemandInitialHash;
+			state_hash = renderOnDemandHash(state_hash, &view_projection_matrix, sizeof(view_projection_matrix));
+			state_hash = renderOnDemandHash(state_hash, &scene.version, sizeof(scene.version));
+			state_hash = renderOnDemandHash(state_hash, &main_pipeline, sizeof(main_pipeline));
+			state_hash = renderOnDemandHash(state_hash, &tessellated_pipeline, sizeof(tessellated_pipeline));
+			const uint32_t num_pending_assets = assetLoaderGetNumPending();
+			state_hash = renderOnDemandHash(state_hash, &num_pending_assets, sizeof(num_pending_assets));
+			if (tiles_enabled) {
+				const uint64_t tile_residency_version = tileStreamerGetResidencyVersion();
+				state_hash = renderOnDemandHash(state_hash, &tile_residency_version, sizeof(tile_residency_version));
+			}
+			if (num_lights > 0) {
+				state_hash = renderOnDemandHash(state_hash, &frame_index, sizeof(frame_index));
+			}
+			if (!renderOnDemandShouldRender(state_hash)) {
+				continue;
+			}
+		}
+		if (dynamic_resolution) {
+			// Clustered lighting maps fragment coordinates to clusters relative to the rendered part of the image:
+			dynamicResolutionUpdate(gpuProfilerGetLatestFrameMilliseconds());
+			const VkExtent2D render_extent = dynamicResolutionGetRenderExtent();
+			uniform_buffer_data.viewport_size = glm::vec4(static_cast<float>(render_extent.width), static_cast<float>(render_extent.height), 0.0f, 0.0f);
+		}
+		{
+			PROFILER_ZONE("Wait For Swapchain Image");
+			const auto wait_start = std::chrono::steady_clock::now();
+			vklWaitForNextSwapchainImage();
+			blocking_duration += std::chrono::steady_clock::now() - wait_start;
+		}
+		const uint32_t instance_buffer_index = vklGetCurrentSwapChainImageIndex();
+		{
+			// Only the current image's uniform buffer is written, since earlier frames may still read the others:
+			PROFILER_ZONE("Upload Uniforms");
+			uniform_buffer_data.transformation = view_projection_matrix;
+			if (num_views > 1) {
+				multiviewGetViewProjectionMatrices(view_projection_matrix, num_views, options.viewSeparation, uniform_buffer_data.view_transformations);
+			}
+			// The camera is the point which the view-projection matrix maps to clip space (0, 0, c, 0):
+			const glm::vec4 camera_position = glm::inverse(view_projection_matrix)[2];
+			uniform_buffer_data.camera_position = glm::vec4(glm::vec3(camera_position) / camera_position.w, 1.0f);
+			memcpy(uniform_buffers[instance_buffer_index].mappedData, &uniform_buffer_data, sizeof(uniform_buffer_data));
+		}
+		{
+			PROFILER_ZONE("Upload Instances");
+			sceneGraphWriteInstances(scene, static_cast<glm::mat4*>(instance_buffers[instance_buffer_index].mappedData),
+				instance_buffer_versions[instance_buffer_index]);
+		}
+		if (num_lights > 0) {
+			PROFILER_ZONE("Update Lights");
+			// Lights are animated per frame rather than per second, so that benchmark runs are reproducible:
+			const float time = static_cast<float>(frame_index) / 60.0f;
+			for (uint32_t i = 0; i < num_lights; ++i) {
+				const glm::vec4& orbit = light_orbits[i];
+				const float angle = orbit.z + orbit.w * time;
+				lights[i].positionRadius = glm::vec4(orbit.x * std::cos(angle), orbit.y, orbit.x * std::sin(angle), lights[i].positionRadius.w);
+			}
+			// With multiview, every view is culled with its own matrix, since fragments find their cluster in their view:
+			clusteredLightingUpdate(instance_buffer_index, lights.data(), num_lights,
+				num_views > 1 ? uniform_buffer_data.view_transformations : &view_projection_matrix);
+		}
+		DrawList& draw_list = draw_lists[options.reuseDrawLists ? instance_buffer_index : 0];
+		bool rebuild_draw_list = true;
+		if (options.reuseDrawLists) {
+			DrawListState state = {};
+			state.sceneVersion = scene.version;
+			state.mainPipeline = main_pipeline;
+			state.tessellatedPipeline = tessellated_pipeline;
+			state.numPendingAssets = assetLoaderGetNumPending();
+			state.tileResidencyVersion = tiles_enabled ? tileStreamerGetResidencyVersion() : 0;
+			if (view_dependent_draw_lists) {
+				state.viewProjection = view_projection_matrix;
+				state.viewportSize = uniform_buffer_data.viewport_size;
+			}
+			rebuild_draw_list = !draw_list_valid[instance_buffer_index]
+				|| 0 != memcmp(&state, &draw_list_states[instance_buffer_index], sizeof(DrawListState));
+			draw_list_states[instance_buffer_index] = state;
+			draw_list_valid[instance_buffer_index] = true;
+			if (!rebuild_draw_list) {
+				++num_reused_draw_lists;
+			}
+		}
+		// Culling and level of detail consider every view, since each of them sees a different part of the scene:
+		const glm::mat4* view_projections = num_views > 1 ? uniform_buffer_data.view_transformations : &view_projection_matrix;
+		uint32_t tessellation_level = 0;
+		if (options.tessellation && rebuild_draw_list) {
+			PROFILER_ZONE("Tessellate Teapot");
+			// All teapots share one tessellation, at the finest level which any of them needs in any view. Segment lengths are
+			// measured in the pixels which the scene is rendered at, i.e., per view and at the current dynamic resolution:
+			const glm::vec2 viewport_size(uniform_buffer_data.viewport_size);
+			for (uint32_t node = 0; node < sceneGraphGetNumNodes(scene); ++node) {
+				if (teapot_asset != node_assets[node]) {
+					continue;
+				}
+				for (uint32_t view = 0; view < num_views; ++view) {
+					tessellation_level = std::max(tessellation_level, patchTessellatorSelectLevel(teapot_control_points.data(), num_teapot_patches,
+						view_projections[view] * scene.worldMatrices[node], viewport_size, tessellation_pixels_per_segment));
+				}
+			}
+			if (tessellation_level > 0) {
+				patchTessellatorUpdate(tessellation_buffers[instance_buffer_index], teapot_control_points.data(), num_teapot_patches, tessellation_level);
+			}
+			if (tessellation_level != previous_tessellation_level) {
+				VKL_LOG("Teapot tessellation level " << tessellation_level << " => " << num_teapot_patches * tessellation_level * tessellation_level * 2 << " triangles");
+				previous_tessellation_level = tessellation_level;
+			}
+		}
+		gpuProfilerBeginFrame();
+		{
+			PROFILER_ZONE("Execute Render Graph");
+			renderGraphExecute();
+		}
+		if (options.occlusionCulling && rebuild_draw_list) {
+			PROFILER_ZONE("Occlusion Culling");
+			for (uint32_t node = 0; node < sceneGraphGetNumNodes(scene); ++node) {
+				OcclusionObject& object = occlusion_objects[node];
+				object.worldMatrix = scene.worldMatrices[node];
+				object.boundsMin = glm::vec3(0.0f);
+				object.boundsMax = glm::vec3(0.0f);
+				object.positions = nullptr;
+				object.indices = nullptr;
+				object.numIndices = 0;
+				object.numPieceIndices = 0;
+				if (kAssetInvalid == node_assets[node]) {
+					continue;
+				}
+				AssetMeshData mesh_data;
+				if (assetLoaderGetMeshData(node_assets[node], mesh_data)) {
+					object.boundsMin = mesh_data.boundsMin;
+					object.boundsMax = mesh_data.boundsMax;
+					// A tessellated surface can lie in front of its control points => it only occludes if drawn from them.
+					// Its bounds still hold, since a Bezier patch lies within the convex hull of its control points:
+					if ((!options.tessellation || teapot_asset != node_assets[node]) && mesh_data.numOccluderIndices > 0) {
+						object.positions = mesh_data.occluderPositions;
+						object.indices = mesh_data.occluderIndices;
+						object.numIndices = mesh_data.numOccluderIndices;
+						object.numPieceIndices = mesh_data.numOccluderPieceIndices;
+					}
+				}
+				else {
+					object.boundsMin = glm::vec3(-0.5f);
+					object.boundsMax = glm::vec3(0.5f);
+					object.positions = placeholder_positions;
+					object.indices = placeholder_indices;
+					object.numIndices = 36;
+					object.numPieceIndices = 36;
+				}
+			}
+			occlusionCullerCull(occlusion_culler, occlusion_objects.data(), static_cast<uint32_t>(occlusion_objects.size()), view_projections, num_views,
+				node_visible.data());
+			const OcclusionCullerStatistics& statistics = occlusion_culler.statistics;
+			if (statistics.numFrustumCulledObjects != previous_occlusion_statistics.numFrustumCulledObjects
+				|| statistics.numOccludedObjects != previous_occlusion_statistics.numOccludedObjects) {
+				VKL_LOG("Occlusion culling: " << statistics.numFrustumCulledObjects << " of " << statistics.numObjects << " nodes outside of the frustum, "
+					<< statistics.numOccludedObjects << " occluded, " << statistics.numRasterizedTriangles << " occluder triangles");
+				previous_occlusion_statistics = statistics;
+			}
+		}
+		if (rebuild_draw_list) {
+			PROFILER_ZONE("Build Draw List");
+			drawListReset(draw_list);
+			DrawPacket packet = {};
+			packet.descriptorSet = vk_descriptor_sets[instance_buffer_index];
+			packet.vertexBuffer = geometryPoolGetVertexBuffer();
+			packet.instanceBuffer = instance_buffers[instance_buffer_index].buffer;
+			packet.indexBuffer = geometryPoolGetIndexBuffer();
+			packet.instanceCount = 1;
+			for (uint32_t node = 0; node < sceneGraphGetNumNodes(scene); ++node) {
+				if (kAssetInvalid == node_assets[node] || 0 == node_visible[node]) {
+					continue;
+				}
+				packet.firstInstance = node;
+
+				// Sort front-to-back by the depth of the node's origin:
+				const glm::vec4 origin = view_projection_matrix * scene.worldMatrices[node][3];
+				const float depth = origin.w > 0.0f ? origin.z / origin.w : 0.0f;
+
+				if (options.tessellation && teapot_asset == node_assets[node]) {
+					// Level 0 means that the teapot is outside of every view's frustum:
+					if (0 == tessellation_level) {
+						continue;
+					}
+					DrawPacket tessellated_packet = packet;
+					tessellated_packet.vertexBuffer = tessellation_buffers[instance_buffer_index].vertexBuffer.buffer;
+					tessellated_packet.indexBuffer = tessellation_buffers[instance_buffer_index].indexBuffer.buffer;
+					tessellated_packet.indexCount = tessellation_buffers[instance_buffer_index].indexCount;
+					tessellated_packet.firstIndex = 0;
+					tessellated_packet.vertexOffset = 0;
+					if (VK_NULL_HANDLE != vk_tessellated_depth_prepass_pipeline) {
+						tessellated_packet.pipeline = vk_tessellated_depth_prepass_pipeline;
+						tessellated_packet.sortKey = drawListMakeSortKey(depth_prepass_pass_id, tessellated_depth_prepass_pipeline_id, material_id, tessellated_teapot_mesh_id, depth);
+						drawListAdd(draw_list, tessellated_packet);
+					}
+					tessellated_packet.pipeline = tessellated_pipeline;
+					tessellated_packet.sortKey = drawListMakeSortKey(main_pass_id, tessellated_pipeline_id, material_id, tessellated_teapot_mesh_id, depth);
+					drawListAdd(draw_list, tessellated_packet);
+					continue;
+				}
+
+				GeometryPoolMesh mesh = assetLoaderGetMesh(node_assets[node]);
+				if (kGeometryPoolInvalidMesh == mesh) {
+					mesh = placeholder_mesh;
+				}
+				const GeometryPoolRange range = geometryPoolGetRange(mesh);
+				packet.indexCount = range.indexCount;
+				packet.firstIndex = range.firstIndex;
+				packet.vertexOffset = range.vertexOffset;
+				if (VK_NULL_HANDLE != vk_depth_prepass_pipeline) {
+					packet.pipeline = vk_depth_prepass_pipeline;
+					packet.sortKey = drawListMakeSortKey(depth_prepass_pass_id, depth_prepass_pipeline_id, material_id, mesh, depth);
+					drawListAdd(draw_list, packet);
+				}
+				packet.pipeline = main_pipeline;
+				packet.sortKey = drawListMakeSortKey(main_pass_id, main_pipeline_id, material_id, mesh, depth);
+				drawListAdd(draw_list, packet);
+			}
+			if (tiles_enabled) {
+				const std::vector<StreamedTile>& tiles = tileStreamerGetResidentTiles();
+				const uint32_t num_tiles = static_cast<uint32_t>(tiles.size());
+				const glm::mat4& tiles_world_matrix = scene.worldMatrices[tiles_node];
+				tile_objects.resize(num_tiles);
+				tile_visible.resize(num_tiles);
+				for (uint32_t t = 0; t < num_tiles; ++t) {
+					tile_objects[t] = OcclusionObject{ tiles_world_matrix, tiles[t].boundsMin, tiles[t].boundsMax, nullptr, nullptr, 0, 0 };
+				}
+				occlusionCullerCullFrustum(tile_objects.data(), num_tiles, view_projections, num_views, tile_visible.data());
+				packet.firstInstance = tiles_node;
+				for (uint32_t t = 0; t < num_tiles; ++t) {
+					if (0 == tile_visible[t]) {
+						continue;
+					}
+					const glm::vec4 center = view_projection_matrix * tiles_world_matrix * glm::vec4(0.5f * (tiles[t].boundsMin + tiles[t].boundsMax), 1.0f);
+					const float depth = center.w > 0.0f ? center.z / center.w : 0.0f;
+					const GeometryPoolRange range = geometryPoolGetRange(tiles[t].mesh);
+					packet.indexCount = range.indexCount;
+					packet.firstIndex = range.firstIndex;
+					packet.vertexOffset = range.vertexOffset;
+					if (VK_NULL_HANDLE != vk_depth_prepass_pipeline) {
+						packet.pipeline = vk_depth_prepass_pipeline;
+						packet.sortKey = drawListMakeSortKey(depth_prepass_pass_id, depth_prepass_pipeline_id, material_id, tiles[t].mesh, depth);
+						drawListAdd(draw_list, packet);
+					}
+					packet.pipeline = main_pipeline;
+					packet.sortKey = drawListMakeSortKey(main_pass_id, main_pipeline_id, material_id, tiles[t].mesh, depth);
+					drawListAdd(draw_list, packet);
+				}
+			}
+			drawListSort(draw_list);
+		}
+		{
+			PROFILER_ZONE("Record Commands");
+			vklStartRecordingCommands();
+			// With frame capture, the frame is composed in the frame capture's offscreen image, which is read back and
+			// copied into the swapchain image within the framework's render pass:
+			// The render pass which holds the scene only executes its secondary command buffer if it is reused:
+			const VkSubpassContents scene_contents = reuse_scene_commands ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+			const bool scene_in_frame_pass = !dynamic_resolution && 1 == num_views;
+			const VkCommandBuffer frame_command_buffer = frame_capture_enabled
+				? frameCaptureBeginFrame(frame_index, scene_in_frame_pass ? scene_contents : VK_SUBPASS_CONTENTS_INLINE) : vklGetCurrentCommandBuffer();
+			// With dynamic resolution or multiple views, the scene is rendered offscreen first, and upscaled or composited
+			// into the frame:
+			VkCommandBuffer scene_command_buffer = frame_command_buffer;
+			if (dynamic_resolution) {
+				scene_command_buffer = dynamicResolutionBeginScene(scene_contents);
+			}
+			else if (num_views > 1) {
+				scene_command_buffer = multiviewBeginScene(scene_contents);
+			}
+			DrawListStatistics draw_list_statistics;
+			if (reuse_scene_commands) {
+				SceneCommands& commands = scene_commands[instance_buffer_index];
+				const VkExtent2D render_extent = dynamic_resolution ? dynamicResolutionGetRenderExtent() : scene_extent;
+				if (rebuild_draw_list || !commands.valid || render_extent.width != commands.renderExtent.width
+					|| render_extent.height != commands.renderExtent.height) {
+					const VkCommandBufferInheritanceInfo inheritance_info = dynamic_resolution ? dynamicResolutionGetInheritanceInfo()
+						: (num_views > 1 ? multiviewGetInheritanceInfo() : frameCaptureGetInheritanceInfo());
+					VkCommandBufferBeginInfo begin_info = {};
+					begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+					begin_info.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+					begin_info.pInheritanceInfo = &inheritance_info;
+					// This image's previous frame has finished => its command buffer is not in use anymore:
+					VkResult result = vkBeginCommandBuffer(commands.commandBuffer, &begin_info);
+					VKL_CHECK_VULKAN_RESULT(result);
+					// Dynamic state is not inherited from the primary command buffer:
+					if (dynamic_resolution) {
+						const VkViewport viewport = { 0.0f, 0.0f, static_cast<float>(render_extent.width), static_cast<float>(render_extent.height), 0.0f, 1.0f };
+						const VkRect2D scissor = { VkOffset2D{ 0, 0 }, render_extent };
+						vkCmdSetViewport(commands.commandBuffer, 0, 1, &viewport);
+						vkCmdSetScissor(commands.commandBuffer, 0, 1, &scissor);
+					}
+					// GPU profiler queries are written once per frame => no per-pass scopes in command buffers which are executed again:
+					commands.statistics = drawListSubmit(draw_list, commands.commandBuffer, false);
+					result = vkEndCommandBuffer(commands.commandBuffer);
+					VKL_CHECK_VULKAN_RESULT(result);
+					commands.valid = true;
+					commands.renderExtent = render_extent;
+				}
+				else {
+					++num_reused_scene_commands;
+				}
+				vkCmdExecuteCommands(scene_command_buffer, 1, &commands.commandBuffer);
+				draw_list_statistics = commands.statistics;
+			}
+			else {
+				// Within a multiview render pass, every query takes one slot per view => no per-pass GPU profiler scopes there:
+				draw_list_statistics = drawListSubmit(draw_list, scene_command_buffer, 1 == num_views);
+			}
+			if (dynamic_resolution) {
+				dynamicResolutionEndScene();
+				dynamicResolutionUpscale(frame_command_buffer);
+			}
+			else if (num_views > 1) {
+				multiviewEndScene();
+				multiviewComposite(frame_command_buffer);
+			}
+			if (frame_capture_enabled) {
+				frameCaptureEndFrame();
+				frameCapturePresent(vklGetCurrentCommandBuffer());
+			}
+			vklEndRecordingCommands();
+
+			// Report the number of draws and binds whenever it changes:
+			if (0 != memcmp(&draw_list_statistics, &previous_draw_list_statistics, sizeof(DrawListStatistics))) {
+				VKL_LOG("Draw list: " << draw_list_statistics.numDraws << " draws, " << draw_list_statistics.numPipelineBinds << " pipeline binds, "
+					<< draw_list_statistics.numDescriptorSetBinds << " descriptor set binds, " << draw_list_statistics.numVertexBufferBinds
+					<< " vertex buffer binds, " << draw_list_statistics.numIndexBufferBinds << " index buffer binds per frame");
+				previous_draw_list_statistics = draw_list_statistics;
+			}
+		}
+		gpuProfilerEndFrame();
+		{
+			PROFILER_ZONE("Present");
+			const auto present_start = std::chrono::steady_clock::now();
+			vklPresentCurrentSwapchainImage();
+			blocking_duration += std::chrono::steady_clock::now() - present_start;
+		}
+		frameSchedulerEndFrame();
+		frame_begun = false;
+		if (on_demand) {
+			renderOnDemandFramePresented();
+		}
+		if (0 == frame_index) {
+			startupGraphEnd(first_frame_phase);
+			startupGraphLogReport(first_frame_phase, startup_target_milliseconds);
+		}
+
+		if (benchmark_mode) {
+			using milliseconds = std::chrono::duration<double, std::milli>;
+			const auto frame_end = std::chrono::steady_clock::now();
+			if (frame_index > 0) {
+				frame_statistics.frameMilliseconds.push_back(milliseconds(frame_start - previous_frame_start).count());
+			}
+			frame_statistics.cpuMilliseconds.push_back(milliseconds(frame_end - frame_start - blocking_duration).count());
+		}
+		previous_frame_start = frame_start;
+		++frame_index;
 	}
 
 	// Wait for all GPU work to finish before cleaning up:
@@ -482,21 +1732,269 @@ int main(int argc, char** argv)
 	// Task 1.10: Cleanup
 	/* --------------------------------------------- */
 
+	const FrameSchedulerStatistics frame_scheduler_statistics = frameSchedulerGetStatistics();
+	VKL_LOG("Frame pacing with " << frameSchedulerGetFramesInFlight() << " frame(s) in flight: " << frame_scheduler_statistics.cpuWaitMilliseconds
+		<< " ms CPU wait, " << frame_scheduler_statistics.gpuIdleMilliseconds << " ms GPU idle per frame (avg. of recent frames, negative if unavailable)");
+	frameSchedulerDestroy();
+	if (tiles_enabled) {
+		const TileStreamerStatistics tile_statistics = tileStreamerGetStatistics();
+		VKL_LOG("Tile streaming: " << tile_statistics.numLoads << " loads, " << tile_statistics.numEvictions << " evictions, peak of "
+			<< static_cast<double>(tile_statistics.peakResidentBytes) / (1024.0 * 1024.0) << " MiB resident (budget: " << options.tileBudgetMiB << " MiB)");
+	}
+	if (options.reuseDrawLists) {
+		VKL_LOG("Draw list reuse: " << num_reused_draw_lists << " of " << frame_index << " frames have submitted the draw list of a previous frame.");
+		if (reuse_scene_commands) {
+			VKL_LOG("Command buffer reuse: " << num_reused_scene_commands << " of " << frame_index << " frames have executed the scene's secondary "
+				"command buffer of a previous frame.");
+		}
+		else {
+			VKL_LOG("The scene is drawn within the framework's render pass => draw lists have been recorded every frame.");
+		}
+	}
+	if (on_demand) {
+		const RenderOnDemandStatistics on_demand_statistics = renderOnDemandGetStatistics();
+		const uint64_t num_iterations = std::max(on_demand_statistics.numRendered + on_demand_statistics.numSkipped, uint64_t(1));
+		VKL_LOG("On-demand rendering: " << on_demand_statistics.numRendered << " frames rendered, " << on_demand_statistics.numSkipped << " skipped ("
+			<< 100.0 * on_demand_statistics.numSkipped / num_iterations << "%), " << on_demand_statistics.idleSeconds << " s idle, wake latency "
+			<< on_demand_statistics.meanWakeLatencyMilliseconds << " ms avg., " << on_demand_statistics.maxWakeLatencyMilliseconds << " ms max.");
+		renderOnDemandDestroy();
+	}
+	bool frame_capture_mismatch = false;
+	if (frame_capture_enabled) {
+		frameCaptureFlush();
+		const FrameCaptureStatistics frame_capture_statistics = frameCaptureGetStatistics();
+		VKL_LOG("Frame capture: " << frame_capture_statistics.numCaptured << " frames captured, " << frame_capture_statistics.numDropped
+			<< " dropped, " << frame_capture_statistics.numWritten << " written or compared, " << frame_capture_statistics.numMismatches << " mismatches");
+		frame_capture_mismatch = frame_capture_statistics.numMismatches > 0;
+		frameCaptureDestroy();
+	}
+	if (dynamic_resolution) {
+		const DynamicResolutionStatistics resolution_statistics = dynamicResolutionGetStatistics();
+		VKL_LOG("Dynamic resolution: " << resolution_statistics.numChanges << " scale changes in " << resolution_statistics.numFrames
+			<< " frames, mean scale " << resolution_statistics.meanScale << ", min. " << resolution_statistics.minScale
+			<< ", final " << resolution_statistics.scale << " (target: " << options.dynamicResolutionTarget << " ms GPU time)");
+		if (nullptr != options.resolutionHistoryPath) {
+			if (dynamicResolutionWriteHistory(options.resolutionHistoryPath)) {
+				VKL_LOG("Resolution history written to \"" << options.resolutionHistoryPath << "\"");
+			}
+			else {
+				VKL_LOG("Unable to write resolution history to \"" << options.resolutionHistoryPath << "\"");
+			}
+		}
+		dynamicResolutionDestroy();
+	}
+	if (num_views > 1) {
+		multiviewDestroy();
+	}
+	if (num_lights > 0) {
+		clusteredLightingDestroy();
+	}
+	renderGraphDestroy();
+	gpuProfilerDestroy();
 	vklDestroyCamera(camera);
-	vklDestroyHostCoherentBufferAndItsBackingMemory(vk_uniform_buffer);
-	vklDestroyGraphicsPipeline(vk_pipeline);
 
-	teapotDestroyBuffers();
+	if (benchmark_mode) {
+		if (frame_statistics.gpuMilliseconds.empty()) {
+			VKL_LOG("No GPU timings available (GPU profiler compiled out or not supported).");
+		}
+		if (frameStatisticsWriteJson(frame_statistics, options.benchmarkOutputPath, options.replayCameraPath)) {
+			VKL_LOG("Benchmark results written to \"" << options.benchmarkOutputPath << "\"");
+		}
+		else {
+			VKL_LOG("Unable to write benchmark results to \"" << options.benchmarkOutputPath << "\"");
+		}
+	}
+	else if (nullptr != options.recordCameraPath) {
+		if (cameraPathSave(options.recordCameraPath, camera_path)) {
+			VKL_LOG("Camera path with " << camera_path.size() << " frames written to \"" << options.recordCameraPath << "\"");
+		}
+		else {
+			VKL_LOG("Unable to write camera path to \"" << options.recordCameraPath << "\"");
+		}
+	}
+	// Loads and pipeline compiles which are still in flight are finished first, since they write into the
+	// geometry pool and use the render pass:
+	jobSystemDestroy();
+
+	if (VK_NULL_HANDLE != vk_scene_command_pool) {
+		vkDestroyCommandPool(vk_device, vk_scene_command_pool, nullptr);
+	}
+	for (auto& uniform_buffer : uniform_buffers) {
+		hlpDestroyMappedBuffer(vk_device, uniform_buffer);
+	}
+	for (auto& instance_buffer : instance_buffers) {
+		hlpDestroyMappedBuffer(vk_device, instance_buffer);
+	}
+	for (auto& tessellation_buffer : tessellation_buffers) {
+		patchTessellatorDestroyBuffer(vk_device, tessellation_buffer);
+	}
+	pipelineCacheDestroy();
+	if (vk_scene_render_pass != vk_compatible_render_pass) {
+		vkDestroyRenderPass(vk_device, vk_scene_render_pass, nullptr);
+	}
+	vkDestroyRenderPass(vk_device, vk_compatible_render_pass, nullptr);
+
+	if (tiles_enabled) {
+		tileStreamerDestroy();
+	}
+	assetLoaderDestroy();
+	geometryPoolDestroy();
 	vklDestroyFramework();
+
+	// The framework's framebuffers reference the depth buffers => destroy them after the framework:
+	for (size_t i = 0; i < depth_images.size(); ++i) {
+		vkDestroyImage(vk_device, depth_images[i], nullptr);
+		memoryTrackerFree(vk_device, depth_images_memory[i]);
+	}
+
+	// Everything has been destroyed by now => every allocation which is still tracked has leaked:
+	memoryTrackerDestroy();
 	glfwTerminate();
 
-	return EXIT_SUCCESS;
+	if (nullptr != options.tracePath) {
+		if (profilerWriteChromeTrace(options.tracePath)) {
+			VKL_LOG("Profiler trace written to \"" << options.tracePath << "\"");
+		}
+		else {
+			VKL_LOG("Unable to write profiler trace to \"" << options.tracePath << "\"");
+		}
+	}
+	profilerShutdown();
+
+	return frame_capture_mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 /* ------------------------------------------------ */
 // Definitions of little helpers defined above main:
 /* ------------------------------------------------ */
 
+CommandLineOptions parseCommandLineOptions(int argc, char** argv)
+{
+	CommandLineOptions options = {};
+	options.benchmarkOutputPath = "benchmark.json";
+	options.scene = "teapot";
+	options.framesInFlight = 2;
+	options.captureMode = FRAME_CAPTURE_MODE_PNG;
+	options.maxIdleSeconds = 1.0;
+	options.tileBudgetMiB = 256;
+	options.numViews = 1;
+	options.viewSeparation = 0.1f;
+#ifdef NDEBUG
+	options.enableValidation = false;
+#else
+	options.enableValidation = true;
+#endif
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--validation") == 0) {
+			options.enableValidation = true;
+			options.validationRequested = true;
+		}
+		else if (strcmp(argv[i], "--no-validation") == 0) {
+			options.enableValidation = false;
+			options.validationRequested = false;
+		}
+		else if (strcmp(argv[i], "--pipeline-statistics") == 0) {
+			options.pipelineStatistics = true;
+		}
+		else if (strcmp(argv[i], "--depth-prepass") == 0) {
+			options.depthPrepass = true;
+		}
+		else if (strcmp(argv[i], "--tessellation") == 0) {
+			options.tessellation = true;
+		}
+		else if (strcmp(argv[i], "--fog") == 0) {
+			options.fog = true;
+		}
+		else if (strcmp(argv[i], "--occlusion-culling") == 0) {
+			options.occlusionCulling = true;
+		}
+		else if (strcmp(argv[i], "--lights") == 0 && i + 1 < argc) {
+			options.numLights = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+			if (options.numLights > kClusteredLightingMaxLights) {
+				VKL_LOG("At most " << kClusteredLightingMaxLights << " lights are supported => --lights is clamped.");
+			}
+		}
+		else if (strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc) {
+			options.framesInFlight = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+			options.captureDirectory = argv[++i];
+		}
+		else if (strcmp(argv[i], "--capture-format") == 0 && i + 1 < argc) {
+			++i;
+			if (strcmp(argv[i], "raw") == 0) {
+				options.captureMode = FRAME_CAPTURE_MODE_RAW;
+			}
+			else if (strcmp(argv[i], "png") != 0) {
+				VKL_LOG("Unknown capture format \"" << argv[i] << "\" => frames are captured as PNG.");
+			}
+		}
+		else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+			options.goldenDirectory = argv[++i];
+		}
+		else if (strcmp(argv[i], "--on-demand") == 0) {
+			options.onDemand = true;
+		}
+		else if (strcmp(argv[i], "--max-idle") == 0 && i + 1 < argc) {
+			options.maxIdleSeconds = strtod(argv[++i], nullptr);
+		}
+		else if (strcmp(argv[i], "--reuse-draw-lists") == 0) {
+			options.reuseDrawLists = true;
+		}
+		else if (strcmp(argv[i], "--tiles") == 0 && i + 1 < argc) {
+			options.tilesPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--tile-budget") == 0 && i + 1 < argc) {
+			options.tileBudgetMiB = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--tile-distance") == 0 && i + 1 < argc) {
+			options.tileLoadDistance = strtof(argv[++i], nullptr);
+		}
+		else if (strcmp(argv[i], "--dynamic-resolution") == 0 && i + 1 < argc) {
+			options.dynamicResolutionTarget = strtod(argv[++i], nullptr);
+#if !PROFILER_ENABLED
+			VKL_LOG("The GPU profiler has been compiled out (ENABLE_PROFILER=OFF) => --dynamic-resolution has no effect.");
+			options.dynamicResolutionTarget = 0.0;
+#endif
+		}
+		else if (strcmp(argv[i], "--resolution-history") == 0 && i + 1 < argc) {
+			options.resolutionHistoryPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--views") == 0 && i + 1 < argc) {
+			options.numViews = std::max(static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)), 1u);
+		}
+		else if (strcmp(argv[i], "--view-separation") == 0 && i + 1 < argc) {
+			options.viewSeparation = strtof(argv[++i], nullptr);
+		}
+		else if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc) {
+			options.scene = argv[++i];
+		}
+		else if (strcmp(argv[i], "--record-camera") == 0 && i + 1 < argc) {
+			options.recordCameraPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--replay-camera") == 0 && i + 1 < argc) {
+			options.replayCameraPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--benchmark-frames") == 0 && i + 1 < argc) {
+			options.benchmarkFrames = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+		}
+		else if (strcmp(argv[i], "--benchmark-output") == 0 && i + 1 < argc) {
+			options.benchmarkOutputPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+			options.tracePath = argv[++i];
+#if !PROFILER_ENABLED
+			VKL_LOG("The profiler has been compiled out (ENABLE_PROFILER=OFF) => --trace has no effect.");
+#endif
+		}
+		else {
+			VKL_LOG("Ignoring unknown command line argument \"" << argv[i] << "\"");
+		}
+	}
+	return options;
+}
+
 void errorCallbackFromGlfw(int error, const char* description) {
 	std::cout << "GLFW error " << error << ": " << description << std::endl;
 }
@@ -0,0 +1,217 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "MemoryTracker.h"
+#include "VulkanHelpers.h"
+#include <VulkanLaunchpad.h>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+	constexpr uint32_t kUnknownMemoryType = ~0u;
+
+	const char* const kCategoryNames[MEMORY_CATEGORY_COUNT] = {
+		"Geometry", "Instances", "Uniforms", "Lighting", "Render Targets", "Readback"
+	};
+
+	struct Allocation {
+		VkDeviceSize   size;
+		uint32_t       memoryTypeIndex;
+		MemoryCategory category;
+		std::string    name;
+		const char*    file;
+		int            line;
+	};
+
+	struct Usage {
+		VkDeviceSize liveBytes;
+		VkDeviceSize peakBytes;
+		uint32_t     numAllocations;
+	};
+
+	VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
+	bool mMemoryBudgetEnabled = false;
+	VkPhysicalDeviceMemoryProperties mMemoryProperties = {};
+
+	// Allocations may happen on any thread, e.g., in jobs. Everything below is guarded by mMutex:
+	std::mutex mMutex;
+	std::unordered_map<uint64_t, Allocation> mAllocations;
+	Usage mHeapUsage[VK_MAX_MEMORY_HEAPS] = {};
+	Usage mCategoryUsage[MEMORY_CATEGORY_COUNT] = {};
+
+	// File name without its directories, for readable reports:
+	const char* baseName(const char* path)
+	{
+		const char* slash = std::max(std::strrchr(path, '/'), std::strrchr(path, '\\'));
+		return nullptr != slash ? slash + 1 : path;
+	}
+
+	void addUsage(Usage& usage, VkDeviceSize size)
+	{
+		usage.liveBytes += size;
+		usage.peakBytes = std::max(usage.peakBytes, usage.liveBytes);
+		++usage.numAllocations;
+	}
+
+	void removeUsage(Usage& usage, VkDeviceSize size)
+	{
+		usage.liveBytes -= size;
+		--usage.numAllocations;
+	}
+
+	uint32_t heapOf(uint32_t memory_type_index)
+	{
+		return memory_type_index < mMemoryProperties.memoryTypeCount ? mMemoryProperties.memoryTypes[memory_type_index].heapIndex : kUnknownMemoryType;
+	}
+
+	void record(uint64_t handle, Allocation allocation)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		const uint32_t heap = heapOf(allocation.memoryTypeIndex);
+		if (kUnknownMemoryType != heap) {
+			addUsage(mHeapUsage[heap], allocation.size);
+		}
+		addUsage(mCategoryUsage[allocation.category], allocation.size);
+		mAllocations[handle] = std::move(allocation);
+	}
+
+	void forget(uint64_t handle)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto it = mAllocations.find(handle);
+		if (mAllocations.end() == it) {
+			VKL_LOG("Memory tracker: freeing untracked memory " << handle << ".");
+			return;
+		}
+		const uint32_t heap = heapOf(it->second.memoryTypeIndex);
+		if (kUnknownMemoryType != heap) {
+			removeUsage(mHeapUsage[heap], it->second.size);
+		}
+		removeUsage(mCategoryUsage[it->second.category], it->second.size);
+		mAllocations.erase(it);
+	}
+
+	// Budgets per heap: what VK_EXT_memory_budget reports (including other processes' usage), or the heap sizes:
+	void queryBudgets(VkDeviceSize budgets[VK_MAX_MEMORY_HEAPS])
+	{
+		for (uint32_t h = 0; h < mMemoryProperties.memoryHeapCount; ++h) {
+			budgets[h] = mMemoryProperties.memoryHeaps[h].size;
+		}
+#if defined(VK_EXT_memory_budget)
+		if (mMemoryBudgetEnabled) {
+			VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties = {};
+			budget_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+			VkPhysicalDeviceMemoryProperties2 memory_properties2 = {};
+			memory_properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+			memory_properties2.pNext = &budget_properties;
+			vkGetPhysicalDeviceMemoryProperties2(mPhysicalDevice, &memory_properties2);
+			for (uint32_t h = 0; h < mMemoryProperties.memoryHeapCount; ++h) {
+				budgets[h] = budget_properties.heapBudget[h];
+			}
+		}
+#endif
+	}
+
+	double toMiB(VkDeviceSize bytes)
+	{
+		return static_cast<double>(bytes) / (1024.0 * 1024.0);
+	}
+}
+
+void memoryTrackerCreate(VkPhysicalDevice physical_device, bool memory_budget_enabled)
+{
+	mPhysicalDevice = physical_device;
+	mMemoryBudgetEnabled = memory_budget_enabled;
+	vkGetPhysicalDeviceMemoryProperties(physical_device, &mMemoryProperties);
+}
+
+uint32_t memoryTrackerDestroy()
+{
+	memoryTrackerLogReport();
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	const uint32_t num_leaks = static_cast<uint32_t>(mAllocations.size());
+	if (num_leaks > 0) {
+		VKL_LOG("Memory tracker: " << num_leaks << " allocation(s) have not been freed:");
+		for (const auto& entry : mAllocations) {
+			const Allocation& allocation = entry.second;
+			VKL_LOG("  " << allocation.size << " bytes, " << kCategoryNames[allocation.category] << ", \"" << allocation.name << "\", allocated at "
+				<< baseName(allocation.file) << ":" << allocation.line);
+		}
+	}
+	else {
+		VKL_LOG("Memory tracker: all device memory has been freed.");
+	}
+
+	mAllocations.clear();
+	std::fill(std::begin(mHeapUsage), std::end(mHeapUsage), Usage{});
+	std::fill(std::begin(mCategoryUsage), std::end(mCategoryUsage), Usage{});
+	mPhysicalDevice = VK_NULL_HANDLE;
+	return num_leaks;
+}
+
+VkResult memoryTrackerAllocate(VkDevice device, const VkMemoryAllocateInfo* allocate_info, VkDeviceMemory* memory,
+	MemoryCategory category, const char* name, const char* file, int line)
+{
+	VkResult result = vkAllocateMemory(device, allocate_info, nullptr, memory);
+	if (VK_SUCCESS != result) {
+		return result;
+	}
+	hlpSetDebugUtilsObjectName(device, VK_OBJECT_TYPE_DEVICE_MEMORY, (uint64_t)*memory, name);
+	record((uint64_t)*memory, Allocation{ allocate_info->allocationSize, allocate_info->memoryTypeIndex, category, name, file, line });
+	return result;
+}
+
+void memoryTrackerFree(VkDevice device, VkDeviceMemory memory)
+{
+	if (VK_NULL_HANDLE == memory) {
+		return;
+	}
+	forget((uint64_t)memory);
+	vkFreeMemory(device, memory, nullptr);
+}
+
+MemoryTrackerHeapUsage memoryTrackerGetHeapUsage(uint32_t heap_index)
+{
+	if (heap_index >= mMemoryProperties.memoryHeapCount) {
+		return MemoryTrackerHeapUsage{};
+	}
+	VkDeviceSize budgets[VK_MAX_MEMORY_HEAPS];
+	queryBudgets(budgets);
+	std::lock_guard<std::mutex> lock(mMutex);
+	const Usage& usage = mHeapUsage[heap_index];
+	return MemoryTrackerHeapUsage{ usage.liveBytes, usage.peakBytes, budgets[heap_index], usage.numAllocations };
+}
+
+VkDeviceSize memoryTrackerGetCategoryBytes(MemoryCategory category)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mCategoryUsage[category].liveBytes;
+}
+
+void memoryTrackerLogReport()
+{
+	VkDeviceSize budgets[VK_MAX_MEMORY_HEAPS];
+	queryBudgets(budgets);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	VKL_LOG("Memory tracker: device memory per category (live / peak MiB):");
+	for (uint32_t c = 0; c < MEMORY_CATEGORY_COUNT; ++c) {
+		const Usage& usage = mCategoryUsage[c];
+		VKL_LOG("  " << kCategoryNames[c] << ": " << toMiB(usage.liveBytes) << " / " << toMiB(usage.peakBytes) << " in " << usage.numAllocations << " allocation(s)");
+	}
+	VKL_LOG("Memory tracker: device memory per heap (live / peak / " << (mMemoryBudgetEnabled ? "budget" : "heap size") << " MiB):");
+	for (uint32_t h = 0; h < mMemoryProperties.memoryHeapCount; ++h) {
+		const Usage& usage = mHeapUsage[h];
+		const bool device_local = (mMemoryProperties.memoryHeaps[h].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+		const double peak_percent = budgets[h] > 0 ? 100.0 * static_cast<double>(usage.peakBytes) / static_cast<double>(budgets[h]) : 0.0;
+		VKL_LOG("  Heap " << h << (device_local ? " (device local): " : ": ") << toMiB(usage.liveBytes) << " / " << toMiB(usage.peakBytes) << " / "
+			<< toMiB(budgets[h]) << ", peak at " << peak_percent << "% of the budget");
+	}
+}
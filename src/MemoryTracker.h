@@ -0,0 +1,117 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+/* --------------------------------------------- */
+// Memory Tracker
+//
+// Accounts for every device memory allocation: each one is tagged with a
+// category, a debug name, and the source location which allocated it.
+// Live and peak totals are kept per category and per memory heap, and are
+// reported against the heaps' budgets (VK_EXT_memory_budget if enabled, the
+// heap sizes otherwise). Allocations which are still live at shutdown are
+// reported as leaks.
+//
+// Allocate with MEMORY_TRACKER_ALLOCATE and free with memoryTrackerFree.
+// The application allocates no buffers through the framework, so all of its
+// memory is tracked. All geometry, the teapot's included, lives in the
+// geometry pool's buffers.
+/* --------------------------------------------- */
+
+/*!
+ *	What an allocation is used for.
+ */
+enum MemoryCategory {
+	//! Vertex and index buffers
+	MEMORY_CATEGORY_GEOMETRY,
+
+	//! Per-instance data, e.g., world matrices
+	MEMORY_CATEGORY_INSTANCES,
+
+	//! Uniform buffers
+	MEMORY_CATEGORY_UNIFORMS,
+
+	//! Light buffers and per-cluster light lists
+	MEMORY_CATEGORY_LIGHTING,
+
+	//! Depth buffers, offscreen images, and render graph transients
+	MEMORY_CATEGORY_RENDER_TARGETS,
+
+	//! Host-visible buffers which the GPU writes for the CPU to read
+	MEMORY_CATEGORY_READBACK,
+
+	MEMORY_CATEGORY_COUNT
+};
+
+/*!
+ *	Live and peak bytes of one memory heap.
+ */
+struct MemoryTrackerHeapUsage {
+	//! Bytes which are currently allocated by the application
+	VkDeviceSize liveBytes;
+
+	//! Highest value of liveBytes so far
+	VkDeviceSize peakBytes;
+
+	//! Bytes which the application may allocate from this heap: VK_EXT_memory_budget's budget if available, the heap size otherwise
+	VkDeviceSize budgetBytes;
+
+	//! Number of live allocations
+	uint32_t numAllocations;
+};
+
+/*!
+ *	Reads the physical device's memory heaps and types. Call this right after device creation, before any allocation.
+ *	@param	physical_device				Physical device, used to query memory properties and budgets
+ *	@param	memory_budget_enabled		Whether VK_EXT_memory_budget has been enabled on the device
+ */
+void memoryTrackerCreate(VkPhysicalDevice physical_device, bool memory_budget_enabled);
+
+/*!
+ *	Logs the usage report and every allocation which is still live, then forgets all allocations.
+ *	@return	Number of allocations which were still live, i.e., leaked
+ */
+uint32_t memoryTrackerDestroy();
+
+/*!
+ *	Allocates device memory with vkAllocateMemory and records the allocation. Use MEMORY_TRACKER_ALLOCATE instead,
+ *	which passes the caller's source location.
+ *	@param	device			Device handle
+ *	@param	allocate_info	As for vkAllocateMemory
+ *	@param	memory			Receives the memory handle
+ *	@param	category		What the memory is used for
+ *	@param	name			A debug name for the memory, which is also assigned with hlpSetDebugUtilsObjectName
+ *	@param	file			Source file of the allocation
+ *	@param	line			Source line of the allocation
+ *	@return	The result of vkAllocateMemory. Failed allocations are not recorded.
+ */
+VkResult memoryTrackerAllocate(VkDevice device, const VkMemoryAllocateInfo* allocate_info, VkDeviceMemory* memory,
+	MemoryCategory category, const char* name, const char* file, int line);
+
+/*!
+ *	Frees device memory with vkFreeMemory and removes its record. VK_NULL_HANDLE is ignored.
+ *	@param	device			Device handle
+ *	@param	memory			Memory which has been allocated with MEMORY_TRACKER_ALLOCATE
+ */
+void memoryTrackerFree(VkDevice device, VkDeviceMemory memory);
+
+/*!
+ *	Returns the usage of the given memory heap, or all zeros if there is no such heap.
+ */
+MemoryTrackerHeapUsage memoryTrackerGetHeapUsage(uint32_t heap_index);
+
+/*!
+ *	Returns the number of bytes which are currently allocated for the given category.
+ */
+VkDeviceSize memoryTrackerGetCategoryBytes(MemoryCategory category);
+
+/*!
+ *	Logs live and peak bytes per category and per heap, and the peaks against the heaps' budgets.
+ */
+void memoryTrackerLogReport();
+
+#define MEMORY_TRACKER_ALLOCATE(device, allocate_info, memory, category, name) \
+	memoryTrackerAllocate(device, allocate_info, memory, category, name, __FILE__, __LINE__)
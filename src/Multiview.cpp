@@ -0,0 +1,246 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "Multiview.h"
+#include "GpuProfiler.h"
+#include "VulkanHelpers.h"
+#include <VulkanLaunchpad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace
+{
+	struct Frame {
+		VkCommandBuffer commandBuffer;
+		VkFence fence;
+	};
+
+	VkDevice mDevice = VK_NULL_HANDLE;
+	VkQueue mQueue = VK_NULL_HANDLE;
+	VkExtent2D mViewExtent = {};
+	uint32_t mNumViews = 0;
+
+	HlpImage mColor = {};
+	HlpImage mDepth = {};
+	VkRenderPass mRenderPass = VK_NULL_HANDLE;
+	VkFramebuffer mFramebuffer = VK_NULL_HANDLE;
+	VkSampler mSampler = VK_NULL_HANDLE;
+	VkPipeline mCompositePipeline = VK_NULL_HANDLE;
+	VkDescriptorPool mDescriptorPool = VK_NULL_HANDLE;
+	VkDescriptorSet mDescriptorSet = VK_NULL_HANDLE;
+	VkCommandPool mCommandPool = VK_NULL_HANDLE;
+	std::vector<Frame> mFrames;
+	uint64_t mFrameNumber = 0;
+	uint32_t mRecordingFrame = 0;
+}
+
+VkExtent2D multiviewGetViewExtent(VkExtent2D extent, uint32_t num_views)
+{
+	return VkExtent2D{ std::max(extent.width / std::max(num_views, 1u), 1u), extent.height };
+}
+
+void multiviewGetViewProjectionMatrices(const glm::mat4& view_projection, uint32_t num_views, float view_separation,
+	glm::mat4* view_projection_matrices)
+{
+	// With a symmetric projection, the first row of the view-projection matrix is the view matrix's first row (the
+	// camera's right axis in world space), scaled:
+	const glm::vec3 right = glm::normalize(glm::vec3(view_projection[0][0], view_projection[1][0], view_projection[2][0]));
+
+	// Every view gets 1 / num_views of the width => scaling x in clip space by num_views keeps the aspect ratio:
+	const glm::mat4 narrow = glm::scale(glm::mat4(1.0f), glm::vec3(static_cast<float>(num_views), 1.0f, 1.0f));
+	for (uint32_t i = 0; i < num_views; ++i) {
+		// Moving the camera to the right is moving the world to the left:
+		const float offset = (static_cast<float>(i) - 0.5f * static_cast<float>(num_views - 1)) * view_separation;
+		view_projection_matrices[i] = narrow * view_projection * glm::translate(glm::mat4(1.0f), -offset * right);
+	}
+}
+
+void multiviewCreate(VkPhysicalDevice physical_device, VkDevice device, VkQueue queue, uint32_t queue_family_index,
+	VkFormat color_format, VkFormat depth_format, VkExtent2D extent, VkRenderPass framework_render_pass,
+	uint32_t num_views, uint32_t num_frames)
+{
+	mDevice = device;
+	mQueue = queue;
+	mNumViews = std::min(std::max(num_views, 1u), kMultiviewMaxViews);
+	mViewExtent = multiviewGetViewExtent(extent, mNumViews);
+	mFrameNumber = 0;
+
+	// One layer per view:
+	mColor = hlpCreateImage(physical_device, device, color_format, mViewExtent, mNumViews, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_IMAGE_ASPECT_COLOR_BIT, MEMORY_CATEGORY_RENDER_TARGETS, "Multiview Color");
+	mDepth = hlpCreateImage(physical_device, device, depth_format, mViewExtent, mNumViews, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+		VK_IMAGE_ASPECT_DEPTH_BIT, MEMORY_CATEGORY_RENDER_TARGETS, "Multiview Depth");
+
+	// All layers are rendered at once and end up ready for the composite to sample them:
+	mRenderPass = hlpCreateOffscreenRenderPass(device, color_format, depth_format, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		multiviewGetViewMask(mNumViews));
+	mFramebuffer = hlpCreateFramebuffer(device, mRenderPass, mColor.view, mDepth.view, mViewExtent);
+
+	// A fullscreen triangle which fetches from the layers (binding 0). The number of views is specialization constant 0:
+	mSampler = hlpCreateSampler(device, VK_FILTER_NEAREST, VK_FILTER_NEAREST);
+	VkDescriptorSetLayoutBinding binding = {};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	binding.descriptorCount = 1;
+	binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	HlpPipelineState state;
+	state.specializationConstants[0] = mNumViews;
+	state.numSpecializationConstants = 1;
+	mCompositePipeline = hlpCreateFullscreenPipeline(device, SHADER_BINARY_DIR "/multiview_composite.spv", { binding }, framework_render_pass, extent, state);
+	hlpSetDebugUtilsObjectName(device, VK_OBJECT_TYPE_PIPELINE, (uint64_t)mCompositePipeline, "Multiview Composite Pipeline");
+
+	// The layers never change => a single descriptor set serves all frames:
+	VkDescriptorPoolSize pool_size = {};
+	pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	pool_size.descriptorCount = 1;
+	VkDescriptorPoolCreateInfo descriptor_pool_create_info = {};
+	descriptor_pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptor_pool_create_info.maxSets = 1;
+	descriptor_pool_create_info.poolSizeCount = 1;
+	descriptor_pool_create_info.pPoolSizes = &pool_size;
+	VkResult result = vkCreateDescriptorPool(device, &descriptor_pool_create_info, nullptr, &mDescriptorPool);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	const VkDescriptorSetLayout descriptor_set_layout = hlpGetDescriptorSetLayout(mCompositePipeline);
+	VkDescriptorSetAllocateInfo descriptor_set_alloc_info = {};
+	descriptor_set_alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptor_set_alloc_info.descriptorPool = mDescriptorPool;
+	descriptor_set_alloc_info.descriptorSetCount = 1;
+	descriptor_set_alloc_info.pSetLayouts = &descriptor_set_layout;
+	result = vkAllocateDescriptorSets(device, &descriptor_set_alloc_info, &mDescriptorSet);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	VkDescriptorImageInfo image_info = {};
+	image_info.sampler = mSampler;
+	image_info.imageView = mColor.view;
+	image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	VkWriteDescriptorSet write_descriptor_set = {};
+	write_descriptor_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write_descriptor_set.dstSet = mDescriptorSet;
+	write_descriptor_set.dstBinding = 0;
+	write_descriptor_set.descriptorCount = 1;
+	write_descriptor_set.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write_descriptor_set.pImageInfo = &image_info;
+	vkUpdateDescriptorSets(device, 1, &write_descriptor_set, 0, nullptr);
+
+	VkCommandPoolCreateInfo command_pool_create_info = {};
+	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	command_pool_create_info.queueFamilyIndex = queue_family_index;
+	result = vkCreateCommandPool(device, &command_pool_create_info, nullptr, &mCommandPool);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	mFrames.resize(std::max(num_frames, 1u));
+	for (Frame& frame : mFrames) {
+		VkCommandBufferAllocateInfo command_buffer_alloc_info = {};
+		command_buffer_alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		command_buffer_alloc_info.commandPool = mCommandPool;
+		command_buffer_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		command_buffer_alloc_info.commandBufferCount = 1;
+		result = vkAllocateCommandBuffers(device, &command_buffer_alloc_info, &frame.commandBuffer);
+		VKL_CHECK_VULKAN_RESULT(result);
+
+		VkFenceCreateInfo fence_create_info = {};
+		fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+		result = vkCreateFence(device, &fence_create_info, nullptr, &frame.fence);
+		VKL_CHECK_VULKAN_RESULT(result);
+	}
+}
+
+void multiviewDestroy()
+{
+	if (VK_NULL_HANDLE == mDevice) {
+		return;
+	}
+	for (Frame& frame : mFrames) {
+		vkDestroyFence(mDevice, frame.fence, nullptr);
+	}
+	mFrames.clear();
+	vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
+	vkDestroyDescriptorPool(mDevice, mDescriptorPool, nullptr);
+	hlpDestroyGraphicsPipeline(mDevice, mCompositePipeline);
+	hlpDestroySampler(mDevice, mSampler);
+	vkDestroyFramebuffer(mDevice, mFramebuffer, nullptr);
+	vkDestroyRenderPass(mDevice, mRenderPass, nullptr);
+	hlpDestroyImage(mDevice, mColor);
+	hlpDestroyImage(mDevice, mDepth);
+	mCommandPool = VK_NULL_HANDLE;
+	mDescriptorPool = VK_NULL_HANDLE;
+	mDescriptorSet = VK_NULL_HANDLE;
+	mCompositePipeline = VK_NULL_HANDLE;
+	mSampler = VK_NULL_HANDLE;
+	mFramebuffer = VK_NULL_HANDLE;
+	mRenderPass = VK_NULL_HANDLE;
+	mDevice = VK_NULL_HANDLE;
+}
+
+VkCommandBuffer multiviewBeginScene(VkSubpassContents contents)
+{
+	mRecordingFrame = static_cast<uint32_t>(mFrameNumber++ % mFrames.size());
+	Frame& frame = mFrames[mRecordingFrame];
+	VkResult result = vkWaitForFences(mDevice, 1, &frame.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+	VKL_CHECK_VULKAN_RESULT(result);
+	result = vkResetFences(mDevice, 1, &frame.fence);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	result = vkResetCommandBuffer(frame.commandBuffer, 0);
+	VKL_CHECK_VULKAN_RESULT(result);
+	VkCommandBufferBeginInfo begin_info = {};
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	result = vkBeginCommandBuffer(frame.commandBuffer, &begin_info);
+	VKL_CHECK_VULKAN_RESULT(result);
+	hlpBeginDebugUtilsLabel(frame.commandBuffer, "Scene (Multiview)");
+
+	// Same clear values as the swapchain images. Clears apply to all views:
+	VkClearValue clear_values[2] = {};
+	clear_values[0].color = VkClearColorValue{ 0.39f, 0.58f, 0.93f, 1.0f };
+	clear_values[1].depthStencil = VkClearDepthStencilValue{ 1.0f, 0 };
+	VkRenderPassBeginInfo render_pass_begin_info = {};
+	render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	render_pass_begin_info.renderPass = mRenderPass;
+	render_pass_begin_info.framebuffer = mFramebuffer;
+	render_pass_begin_info.renderArea = VkRect2D{ VkOffset2D{ 0, 0 }, mViewExtent };
+	render_pass_begin_info.clearValueCount = 2;
+	render_pass_begin_info.pClearValues = clear_values;
+	vkCmdBeginRenderPass(frame.commandBuffer, &render_pass_begin_info, contents);
+	return frame.commandBuffer;
+}
+
+VkCommandBufferInheritanceInfo multiviewGetInheritanceInfo()
+{
+	VkCommandBufferInheritanceInfo inheritance_info = {};
+	inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritance_info.renderPass = mRenderPass;
+	inheritance_info.subpass = 0;
+	inheritance_info.framebuffer = mFramebuffer;
+	return inheritance_info;
+}
+
+void multiviewEndScene()
+{
+	Frame& frame = mFrames[mRecordingFrame];
+	vkCmdEndRenderPass(frame.commandBuffer);
+	hlpEndDebugUtilsLabel(frame.commandBuffer);
+	VkResult result = vkEndCommandBuffer(frame.commandBuffer);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	VkSubmitInfo submit_info = {};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &frame.commandBuffer;
+	result = vkQueueSubmit(mQueue, 1, &submit_info, frame.fence);
+	VKL_CHECK_VULKAN_RESULT(result);
+}
+
+void multiviewComposite(VkCommandBuffer command_buffer)
+{
+	gpuProfilerBeginScope(command_buffer, "Composite Views");
+	vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mCompositePipeline);
+	hlpBindDescriptorSetToPipeline(command_buffer, mDescriptorSet, mCompositePipeline);
+	vkCmdDraw(command_buffer, 3, 1, 0, 0);
+	gpuProfilerEndScope(command_buffer);
+}
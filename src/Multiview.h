@@ -0,0 +1,103 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+
+/* --------------------------------------------- */
+// Multiview
+//
+// Renders several views of the scene in a single pass (VK_KHR_multiview),
+// e.g., for stereo or for a row of side-by-side screens:
+//  1. The scene is drawn once, into a render pass whose subpass has a view
+//     mask with one bit per view. The driver broadcasts every draw to all
+//     layers of a layered offscreen target, and the vertex shader selects the
+//     view-projection matrix with gl_ViewIndex (MULTIVIEW shader permutation).
+//     Additional views cost GPU work, but no additional CPU submissions.
+//  2. Within the framework's render pass, a fullscreen triangle places the
+//     layers side by side in the swapchain image.
+// The views form a row of parallel cameras along the camera's right axis,
+// which is derived from a single view-projection matrix, so that recorded
+// camera paths work as well. Scene pipelines must be created for a render
+// pass returned by hlpCreateCompatibleRenderPass with multiviewGetViewMask.
+/* --------------------------------------------- */
+
+//! Maximum number of views. Must match the size of view_transformations in shaders/vertex.shader.
+constexpr uint32_t kMultiviewMaxViews = 4;
+
+/*!
+ *	Returns the view mask of a render pass which renders the given number of views.
+ */
+constexpr uint32_t multiviewGetViewMask(uint32_t num_views)
+{
+	return (1u << num_views) - 1u;
+}
+
+/*!
+ *	Returns the extent of every view, if the given number of views shares the given extent side by side.
+ */
+VkExtent2D multiviewGetViewExtent(VkExtent2D extent, uint32_t num_views);
+
+/*!
+ *	Computes the view-projection matrix of every view from the view-projection matrix of a camera, e.g., from
+ *	vklGetCameraViewProjectionMatrix. The views are moved along the camera's right axis, centered around the camera,
+ *	and their horizontal field of view is narrowed so that their aspect ratio fits the side-by-side layout.
+ *	Assumes a symmetric perspective projection.
+ *	@param	view_projection				The camera's view-projection matrix
+ *	@param	num_views					Number of views, at most kMultiviewMaxViews
+ *	@param	view_separation				Distance between neighboring views in world space, e.g., the eye distance for stereo
+ *	@param	view_projection_matrices	Receives num_views matrices, from left to right
+ */
+void multiviewGetViewProjectionMatrices(const glm::mat4& view_projection, uint32_t num_views, float view_separation,
+	glm::mat4* view_projection_matrices);
+
+/*!
+ *	Creates the layered offscreen images, the multiview render pass, and the composite pipeline.
+ *	The multiview device feature must have been enabled.
+ *	@param	physical_device			Physical device, used to select memory types
+ *	@param	device					Device handle
+ *	@param	queue					The queue which the scene's command buffers are submitted to
+ *	@param	queue_family_index		The queue's family
+ *	@param	color_format			Format of the swapchain images
+ *	@param	depth_format			Format of the depth attachments
+ *	@param	extent					Extent of the swapchain images, which the views share side by side
+ *	@param	framework_render_pass	A render pass which is compatible with the framework's, for the composite pipeline
+ *	@param	num_views				Number of views, from 2 to kMultiviewMaxViews
+ *	@param	num_frames				Number of scene command buffers. Must be larger than the number of frames in flight.
+ */
+void multiviewCreate(VkPhysicalDevice physical_device, VkDevice device, VkQueue queue, uint32_t queue_family_index,
+	VkFormat color_format, VkFormat depth_format, VkExtent2D extent, VkRenderPass framework_render_pass,
+	uint32_t num_views, uint32_t num_frames);
+
+/*!
+ *	Destroys everything. The device must be idle.
+ */
+void multiviewDestroy();
+
+/*!
+ *	Begins a command buffer and the multiview render pass. Record the scene's draws into it once, or execute secondary
+ *	command buffers, then call multiviewEndScene.
+ *	@param	contents	VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS if the scene is executed from secondary command buffers
+ *	@return	The command buffer
+ */
+VkCommandBuffer multiviewBeginScene(VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+
+/*!
+ *	Returns the multiview render pass and its framebuffer, for secondary command buffers which are executed in it.
+ */
+VkCommandBufferInheritanceInfo multiviewGetInheritanceInfo();
+
+/*!
+ *	Ends the render pass and submits the command buffer. Must be called before the framework's command buffer of the same
+ *	frame is submitted (i.e., before vklEndRecordingCommands) and before frameCaptureEndFrame, and between gpuProfilerBeginFrame
+ *	and gpuProfilerEndFrame.
+ */
+void multiviewEndScene();
+
+/*!
+ *	Records placing the views side by side in the swapchain image.
+ *	@param	command_buffer	The framework's command buffer, within its render pass, or the one of frameCaptureBeginFrame
+ */
+void multiviewComposite(VkCommandBuffer command_buffer);
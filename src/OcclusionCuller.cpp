@@ -0,0 +1,632 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "OcclusionCuller.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+
+namespace
+{
+	// Vertices with a smaller w are (almost) in the camera's plane and cannot be projected:
+	constexpr float kMinW = 1e-5f;
+
+	// Occluders: cells of the voxel grid along every axis of the bounding box, the number of boxes, and the
+	// smallest box worth its 12 triangles (in cells). Meshes which are not closed keep this many triangles:
+	constexpr int      kOccluderGridResolution = 16;
+	constexpr uint32_t kOccluderMaxBoxes = 4;
+	constexpr int      kOccluderMinBoxCells = 8;
+	constexpr uint32_t kOccluderMaxTriangles = 128;
+
+	// Every box occluder is a convex piece of its own, with two triangles per face:
+	constexpr uint32_t kOccluderBoxIndices = 36;
+
+	// Rasterization is split into bands of at least this many rows, if there are at least this many triangles:
+	constexpr uint32_t kMinBandRows = 16;
+	constexpr uint32_t kMinBandedTriangles = 64;
+
+	// Voxel grid over a mesh's bounding box, with two cells of padding on every side, so that the outermost
+	// layer is never touched by the surface:
+	struct VoxelGrid {
+		enum : uint8_t { UNKNOWN, SURFACE, OUTSIDE };
+
+		glm::vec3 origin;
+		glm::vec3 cellSize;
+		int size;
+		std::vector<uint8_t> cells;
+
+		size_t index(int x, int y, int z) const
+		{
+			return (static_cast<size_t>(z) * size + y) * size + x;
+		}
+	};
+
+	// Marks every cell which the triangle might touch as surface. Large triangles are split until their bounding
+	// boxes span at most two cells per axis, since the union of the parts' bounding boxes still covers the triangle:
+	void markTriangle(VoxelGrid& grid, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, uint32_t depth)
+	{
+		const glm::vec3 low = (glm::min(glm::min(a, b), c) - grid.origin) / grid.cellSize;
+		const glm::vec3 high = (glm::max(glm::max(a, b), c) - grid.origin) / grid.cellSize;
+		const glm::ivec3 first = glm::clamp(glm::ivec3(glm::floor(low - 1e-3f)), glm::ivec3(0), glm::ivec3(grid.size - 1));
+		const glm::ivec3 last = glm::clamp(glm::ivec3(glm::floor(high + 1e-3f)), glm::ivec3(0), glm::ivec3(grid.size - 1));
+		if (depth < 8 && glm::any(glm::greaterThan(last - first, glm::ivec3(1)))) {
+			const glm::vec3 ab = 0.5f * (a + b), bc = 0.5f * (b + c), ca = 0.5f * (c + a);
+			markTriangle(grid, a, ab, ca, depth + 1);
+			markTriangle(grid, ab, b, bc, depth + 1);
+			markTriangle(grid, ca, bc, c, depth + 1);
+			markTriangle(grid, ab, bc, ca, depth + 1);
+			return;
+		}
+		for (int z = first.z; z <= last.z; ++z) {
+			for (int y = first.y; y <= last.y; ++y) {
+				for (int x = first.x; x <= last.x; ++x) {
+					grid.cells[grid.index(x, y, z)] = VoxelGrid::SURFACE;
+				}
+			}
+		}
+	}
+
+	// Everything which can be reached from the grid's corner without crossing the surface is outside:
+	void floodOutside(VoxelGrid& grid)
+	{
+		std::vector<glm::ivec3> stack = { glm::ivec3(0) };
+		grid.cells[0] = VoxelGrid::OUTSIDE;
+		const glm::ivec3 neighbors[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+		while (!stack.empty()) {
+			const glm::ivec3 cell = stack.back();
+			stack.pop_back();
+			for (const glm::ivec3& offset : neighbors) {
+				const glm::ivec3 neighbor = cell + offset;
+				if (glm::any(glm::lessThan(neighbor, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(neighbor, glm::ivec3(grid.size)))) {
+					continue;
+				}
+				uint8_t& state = grid.cells[grid.index(neighbor.x, neighbor.y, neighbor.z)];
+				if (VoxelGrid::UNKNOWN == state) {
+					state = VoxelGrid::OUTSIDE;
+					stack.push_back(neighbor);
+				}
+			}
+		}
+	}
+
+	bool isBoxInside(const VoxelGrid& grid, const glm::ivec3& first, const glm::ivec3& last)
+	{
+		for (int z = first.z; z <= last.z; ++z) {
+			for (int y = first.y; y <= last.y; ++y) {
+				for (int x = first.x; x <= last.x; ++x) {
+					if (VoxelGrid::UNKNOWN != grid.cells[grid.index(x, y, z)]) {
+						return false;
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	// Finds up to kOccluderMaxBoxes boxes of inside cells. Each one grows from the inside cell which is deepest
+	// inside and not covered by a previous box, one layer per direction in turn, as long as it stays inside:
+	void findInsideBoxes(const VoxelGrid& grid, OcclusionOccluder& occluder)
+	{
+		// Depth of every inside cell: 1 + the smallest depth of its neighbors, 0 for all other cells:
+		std::vector<int> depths(grid.cells.size(), 0);
+		for (size_t i = 0; i < grid.cells.size(); ++i) {
+			depths[i] = VoxelGrid::UNKNOWN == grid.cells[i] ? 1 : 0;
+		}
+		for (bool changed = true; changed; ) {
+			changed = false;
+			for (int z = 1; z + 1 < grid.size; ++z) {
+				for (int y = 1; y + 1 < grid.size; ++y) {
+					for (int x = 1; x + 1 < grid.size; ++x) {
+						int& depth = depths[grid.index(x, y, z)];
+						if (0 == depth) {
+							continue;
+						}
+						const int neighbor_depth = std::min({ depths[grid.index(x - 1, y, z)], depths[grid.index(x + 1, y, z)],
+							depths[grid.index(x, y - 1, z)], depths[grid.index(x, y + 1, z)], depths[grid.index(x, y, z - 1)], depths[grid.index(x, y, z + 1)] });
+						if (depth != neighbor_depth + 1) {
+							depth = neighbor_depth + 1;
+							changed = true;
+						}
+					}
+				}
+			}
+		}
+
+		std::vector<uint8_t> covered(grid.cells.size(), 0);
+		for (uint32_t box = 0; box < kOccluderMaxBoxes; ++box) {
+			size_t seed = grid.cells.size();
+			for (size_t i = 0; i < depths.size(); ++i) {
+				if (0 != depths[i] && 0 == covered[i] && (grid.cells.size() == seed || depths[i] > depths[seed])) {
+					seed = i;
+				}
+			}
+			if (grid.cells.size() == seed) {
+				return;
+			}
+			const int seed_x = static_cast<int>(seed % grid.size);
+			const int seed_y = static_cast<int>(seed / grid.size % grid.size);
+			const int seed_z = static_cast<int>(seed / grid.size / grid.size);
+			glm::ivec3 first(seed_x, seed_y, seed_z);
+			glm::ivec3 last = first;
+			for (bool grown = true; grown; ) {
+				grown = false;
+				for (int axis = 0; axis < 3; ++axis) {
+					glm::ivec3 slab_first = first, slab_last = last;
+					slab_first[axis] = slab_last[axis] = last[axis] + 1;
+					if (isBoxInside(grid, slab_first, slab_last)) {
+						last[axis] += 1;
+						grown = true;
+					}
+					slab_first = first;
+					slab_last = last;
+					slab_first[axis] = slab_last[axis] = first[axis] - 1;
+					if (isBoxInside(grid, slab_first, slab_last)) {
+						first[axis] -= 1;
+						grown = true;
+					}
+				}
+			}
+			const glm::ivec3 extent = last - first + 1;
+			for (int z = first.z; z <= last.z; ++z) {
+				for (int y = first.y; y <= last.y; ++y) {
+					for (int x = first.x; x <= last.x; ++x) {
+						covered[grid.index(x, y, z)] = 1;
+					}
+				}
+			}
+			if (extent.x * extent.y * extent.z < kOccluderMinBoxCells) {
+				// The deepest remaining cell is in a small pocket => the remaining boxes would be even smaller:
+				return;
+			}
+
+			const glm::vec3 box_min = grid.origin + glm::vec3(first) * grid.cellSize;
+			const glm::vec3 box_max = grid.origin + glm::vec3(last + 1) * grid.cellSize;
+			const uint32_t base = static_cast<uint32_t>(occluder.positions.size());
+			for (uint32_t corner = 0; corner < 8; ++corner) {
+				occluder.positions.emplace_back((corner & 1) ? box_max.x : box_min.x, (corner & 2) ? box_max.y : box_min.y, (corner & 4) ? box_max.z : box_min.z);
+			}
+			// Two triangles per face. Occluders are rasterized regardless of their winding:
+			const uint32_t faces[6][4] = { { 0, 2, 6, 4 }, { 1, 3, 7, 5 }, { 0, 1, 5, 4 }, { 2, 3, 7, 6 }, { 0, 1, 3, 2 }, { 4, 5, 7, 6 } };
+			for (const auto& face : faces) {
+				occluder.indices.insert(occluder.indices.end(), { base + face[0], base + face[1], base + face[2], base + face[0], base + face[2], base + face[3] });
+			}
+		}
+	}
+
+	// Projects a clip space position onto the depth buffer, as (x, y, depth). Fails for positions in front of the near plane.
+	// z < 0 is in front of the near plane for [0, 1] depth ranges, and conservatively rejected for [-1, 1] ones:
+	bool project(const glm::vec4& clip, float width, float height, glm::vec3& vertex)
+	{
+		if (clip.w < kMinW || clip.z < 0.0f) {
+			return false;
+		}
+		const float inverse_w = 1.0f / clip.w;
+		vertex.x = (clip.x * inverse_w * 0.5f + 0.5f) * width;
+		vertex.y = (clip.y * inverse_w * 0.5f + 0.5f) * height;
+		vertex.z = clip.z * inverse_w;
+		return true;
+	}
+
+	// Rasterizes one convex piece of an occluder (a box or a single triangle), given by the projected triangles
+	// [first_triangle, end_triangle), with a depth test into the rows [row_begin, row_end) of level 0.
+	// Occluders must never hide what lies beside or behind them, hence a pixel is only covered if the piece covers
+	// all of it, and then receives the farthest depth of the piece's front surface within it. A convex piece stays
+	// convex when projected, so both hold if they hold at the pixel's four corners: the piece covers the pixel if it
+	// covers its corners, and the depth of its front surface is a convex function, whose maximum over the pixel
+	// lies at one of them. The corners are therefore rasterized first, and the pixels are derived from them:
+	void rasterizePiece(OcclusionCuller& culler, uint32_t first_triangle, uint32_t end_triangle, int row_begin, int row_end,
+		std::vector<float>& corner_depths)
+	{
+		const glm::vec3* vertices = culler.occluderTriangles.data() + 3 * static_cast<size_t>(first_triangle);
+		const uint32_t num_vertices = 3 * (end_triangle - first_triangle);
+		float min_x = vertices[0].x, max_x = vertices[0].x, min_y = vertices[0].y, max_y = vertices[0].y;
+		for (uint32_t i = 1; i < num_vertices; ++i) {
+			min_x = std::min(min_x, vertices[i].x);
+			max_x = std::max(max_x, vertices[i].x);
+			min_y = std::min(min_y, vertices[i].y);
+			max_y = std::max(max_y, vertices[i].y);
+		}
+
+		// The pixels which lie completely within the piece's bounding rectangle:
+		const int width = static_cast<int>(culler.levelWidths[0]);
+		const int height = static_cast<int>(culler.levelHeights[0]);
+		const int x_begin = std::max(static_cast<int>(std::ceil(min_x)), 0);
+		const int x_end = std::min(static_cast<int>(std::floor(max_x)), width);
+		const int y_begin = std::max(static_cast<int>(std::ceil(min_y)), row_begin);
+		const int y_end = std::min({ static_cast<int>(std::floor(max_y)), row_end, height });
+		if (x_begin >= x_end || y_begin >= y_end) {
+			return;
+		}
+
+		// The nearest depth of the piece at every corner of these pixels, infinity where it does not cover the corner:
+		const int corner_columns = x_end - x_begin + 1;
+		const int corner_rows = y_end - y_begin + 1;
+		corner_depths.assign(static_cast<size_t>(corner_columns) * corner_rows, std::numeric_limits<float>::infinity());
+		for (uint32_t i = 0; i < num_vertices; i += 3) {
+			glm::vec3 v0 = vertices[i], v1 = vertices[i + 1], v2 = vertices[i + 2];
+			float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+			if (area < 0.0f) {
+				// Occluders are rasterized regardless of their facing => make the winding consistent:
+				std::swap(v1, v2);
+				area = -area;
+			}
+			if (area < 1e-12f) {
+				continue;
+			}
+			const int cx_begin = std::max(static_cast<int>(std::ceil(std::min({ v0.x, v1.x, v2.x }))), x_begin);
+			const int cx_end = std::min(static_cast<int>(std::floor(std::max({ v0.x, v1.x, v2.x }))), x_end) + 1;
+			const int cy_begin = std::max(static_cast<int>(std::ceil(std::min({ v0.y, v1.y, v2.y }))), y_begin);
+			const int cy_end = std::min(static_cast<int>(std::floor(std::max({ v0.y, v1.y, v2.y }))), y_end) + 1;
+
+			// Edge functions e_i(x, y) = a_i * x + b_i * y + c_i are positive inside, and e_i / area are the barycentric
+			// coordinates. Depth is affine in screen space, so it is interpolated with them directly:
+			const float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = v1.x * v2.y - v1.y * v2.x;
+			const float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = v2.x * v0.y - v2.y * v0.x;
+			const float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = v0.x * v1.y - v0.y * v1.x;
+			const float inverse_area = 1.0f / area;
+			const float z0 = v0.z * inverse_area, z1 = v1.z * inverse_area, z2 = v2.z * inverse_area;
+			for (int y = cy_begin; y < cy_end; ++y) {
+				const float corner_x = static_cast<float>(cx_begin);
+				const float corner_y = static_cast<float>(y);
+				float e0 = a0 * corner_x + b0 * corner_y + c0;
+				float e1 = a1 * corner_x + b1 * corner_y + c1;
+				float e2 = a2 * corner_x + b2 * corner_y + c2;
+				float* row = corner_depths.data() + static_cast<size_t>(y - y_begin) * corner_columns;
+				for (int x = cx_begin; x < cx_end; ++x) {
+					if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f) {
+						row[x - x_begin] = std::min(row[x - x_begin], e0 * z0 + e1 * z1 + e2 * z2);
+					}
+					e0 += a0;
+					e1 += a1;
+					e2 += a2;
+				}
+			}
+		}
+
+		std::vector<float>& depth = culler.levels[0];
+		for (int y = y_begin; y < y_end; ++y) {
+			const float* top = corner_depths.data() + static_cast<size_t>(y - y_begin) * corner_columns;
+			const float* bottom = top + corner_columns;
+			float* row = depth.data() + static_cast<size_t>(y) * width + x_begin;
+			for (int x = 0; x < x_end - x_begin; ++x) {
+				// Infinity if any corner is not covered:
+				const float farthest = std::max(std::max(top[x], top[x + 1]), std::max(bottom[x], bottom[x + 1]));
+				row[x] = std::min(row[x], farthest);
+			}
+		}
+	}
+
+	// Projects the occluder's convex pieces. Pieces which cross the near plane are skipped, which only removes
+	// occlusion, so the result stays conservative:
+	void projectOccluder(OcclusionCuller& culler, const OcclusionObject& object, const glm::mat4& model_view_projection)
+	{
+		const float width = static_cast<float>(culler.levelWidths[0]);
+		const float height = static_cast<float>(culler.levelHeights[0]);
+		const uint32_t num_piece_indices = std::max(object.numPieceIndices - object.numPieceIndices % 3, 3u);
+		for (uint32_t first = 0; first + num_piece_indices <= object.numIndices; first += num_piece_indices) {
+			const size_t num_projected = culler.occluderTriangles.size();
+			bool projected = true;
+			for (uint32_t i = first; i < first + num_piece_indices && projected; ++i) {
+				glm::vec3 vertex;
+				projected = project(model_view_projection * glm::vec4(object.positions[object.indices[i]], 1.0f), width, height, vertex);
+				culler.occluderTriangles.push_back(vertex);
+			}
+			if (projected) {
+				culler.occluderPieceEnds.push_back(static_cast<uint32_t>(culler.occluderTriangles.size() / 3));
+				culler.statistics.numRasterizedTriangles += num_piece_indices / 3;
+			}
+			else {
+				culler.occluderTriangles.resize(num_projected);
+			}
+		}
+	}
+
+	void rasterizeBand(OcclusionCuller& culler, uint32_t row_begin, uint32_t row_end)
+	{
+		std::vector<float> corner_depths;
+		uint32_t first_triangle = 0;
+		for (uint32_t end_triangle : culler.occluderPieceEnds) {
+			rasterizePiece(culler, first_triangle, end_triangle, static_cast<int>(row_begin), static_cast<int>(row_end), corner_depths);
+			first_triangle = end_triangle;
+		}
+	}
+
+	// The bands of one rasterizeOccluders call. Jobs which start after all bands have been taken only touch this,
+	// hence it is shared with them:
+	struct BandQueue {
+		std::atomic<uint32_t>   nextBand{ 0 };
+		uint32_t                numBands = 0;
+		uint32_t                rowsPerBand = 0;
+		uint32_t                height = 0;
+		std::mutex              mutex;
+		std::condition_variable finished;
+		uint32_t                numFinished = 0;
+	};
+
+	// Rasterizes bands until all of them have been taken:
+	void rasterizeBands(OcclusionCuller& culler, BandQueue& queue)
+	{
+		for (uint32_t band = queue.nextBand.fetch_add(1); band < queue.numBands; band = queue.nextBand.fetch_add(1)) {
+			rasterizeBand(culler, std::min(band * queue.rowsPerBand, queue.height), std::min((band + 1) * queue.rowsPerBand, queue.height));
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (++queue.numFinished == queue.numBands) {
+				queue.finished.notify_one();
+			}
+		}
+	}
+
+	// Every band of rows is written by a single thread. Workers and the main thread take bands in turn, so if all
+	// workers are busy with long jobs, the main thread rasterizes all bands itself. It only waits for bands which
+	// workers are rasterizing already, and never runs other jobs, since main-thread jobs would change residency mid-frame:
+	void rasterizeOccluders(OcclusionCuller& culler)
+	{
+		const uint32_t height = culler.levelHeights[0];
+		const uint32_t num_triangles = static_cast<uint32_t>(culler.occluderTriangles.size() / 3);
+		std::shared_ptr<BandQueue> queue = std::make_shared<BandQueue>();
+		queue->height = height;
+		queue->numBands = num_triangles < kMinBandedTriangles ? 1u
+			: std::min(jobSystemGetNumWorkers() + 1, std::max(height / kMinBandRows, 1u));
+		queue->rowsPerBand = (height + queue->numBands - 1) / queue->numBands;
+		OcclusionCuller* shared_culler = &culler;
+		for (uint32_t helper = 1; helper < queue->numBands; ++helper) {
+			jobSystemSubmit("Rasterize Occluders", [shared_culler, queue] {
+				rasterizeBands(*shared_culler, *queue);
+			});
+		}
+		rasterizeBands(culler, *queue);
+		std::unique_lock<std::mutex> lock(queue->mutex);
+		queue->finished.wait(lock, [&queue] { return queue->numFinished == queue->numBands; });
+	}
+
+	// Each texel of a level holds the farthest depth of the (up to) 2x2 texels which it covers in the level below:
+	void buildDepthPyramid(OcclusionCuller& culler)
+	{
+		for (size_t level = 1; level < culler.levels.size(); ++level) {
+			const std::vector<float>& source = culler.levels[level - 1];
+			const uint32_t source_width = culler.levelWidths[level - 1];
+			const uint32_t source_height = culler.levelHeights[level - 1];
+			std::vector<float>& destination = culler.levels[level];
+			const uint32_t width = culler.levelWidths[level];
+			const uint32_t height = culler.levelHeights[level];
+			for (uint32_t y = 0; y < height; ++y) {
+				const uint32_t y0 = 2 * y;
+				const uint32_t y1 = std::min(2 * y + 1, source_height - 1);
+				for (uint32_t x = 0; x < width; ++x) {
+					const uint32_t x0 = 2 * x;
+					const uint32_t x1 = std::min(2 * x + 1, source_width - 1);
+					destination[y * width + x] = std::max(std::max(source[y0 * source_width + x0], source[y0 * source_width + x1]),
+						std::max(source[y1 * source_width + x0], source[y1 * source_width + x1]));
+				}
+			}
+		}
+	}
+
+	// Returns true if all corners of the box are outside of one of the clip space planes. The near plane is
+	// approximated with w <= 0, which holds for both depth ranges:
+	bool isOutsideFrustum(const glm::vec4* corners)
+	{
+		bool outside_left = true, outside_right = true, outside_bottom = true, outside_top = true, outside_far = true, behind = true;
+		for (uint32_t i = 0; i < 8; ++i) {
+			const glm::vec4& c = corners[i];
+			outside_left = outside_left && c.x < -c.w;
+			outside_right = outside_right && c.x > c.w;
+			outside_bottom = outside_bottom && c.y < -c.w;
+			outside_top = outside_top && c.y > c.w;
+			outside_far = outside_far && c.z > c.w;
+			behind = behind && c.w <= 0.0f;
+		}
+		return outside_left || outside_right || outside_bottom || outside_top || outside_far || behind;
+	}
+
+	void computeCorners(const OcclusionObject& object, const glm::mat4& model_view_projection, glm::vec4* corners)
+	{
+		for (uint32_t i = 0; i < 8; ++i) {
+			const glm::vec3 corner((i & 1) ? object.boundsMax.x : object.boundsMin.x, (i & 2) ? object.boundsMax.y : object.boundsMin.y,
+				(i & 4) ? object.boundsMax.z : object.boundsMin.z);
+			corners[i] = model_view_projection * glm::vec4(corner, 1.0f);
+		}
+	}
+
+	// A box is only outside of several views if it is outside of every view's frustum:
+	bool isOutsideFrusta(const OcclusionObject& object, const glm::mat4* view_projections, uint32_t num_views)
+	{
+		glm::vec4 corners[8];
+		for (uint32_t v = 0; v < num_views; ++v) {
+			computeCorners(object, view_projections[v] * object.worldMatrix, corners);
+			if (!isOutsideFrustum(corners)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Tests a box which is (at least partially) inside of the view frustum against the depth pyramid:
+	bool isOccluded(const OcclusionCuller& culler, const glm::vec4* corners)
+	{
+		const float width = static_cast<float>(culler.levelWidths[0]);
+		const float height = static_cast<float>(culler.levelHeights[0]);
+		float min_x = width, max_x = 0.0f, min_y = height, max_y = 0.0f, min_depth = 1.0f;
+		for (uint32_t i = 0; i < 8; ++i) {
+			glm::vec3 vertex;
+			if (!project(corners[i], width, height, vertex)) {
+				// The box crosses the near plane => its nearest depth is unknown:
+				return false;
+			}
+			min_x = std::min(min_x, vertex.x);
+			max_x = std::max(max_x, vertex.x);
+			min_y = std::min(min_y, vertex.y);
+			max_y = std::max(max_y, vertex.y);
+			min_depth = std::min(min_depth, vertex.z);
+		}
+
+		// All texels whose area overlaps the box' screen rectangle:
+		const uint32_t x0 = static_cast<uint32_t>(std::min(std::max(std::floor(min_x), 0.0f), width - 1.0f));
+		const uint32_t x1 = static_cast<uint32_t>(std::min(std::max(std::floor(max_x), 0.0f), width - 1.0f));
+		const uint32_t y0 = static_cast<uint32_t>(std::min(std::max(std::floor(min_y), 0.0f), height - 1.0f));
+		const uint32_t y1 = static_cast<uint32_t>(std::min(std::max(std::floor(max_y), 0.0f), height - 1.0f));
+
+		// The finest level at which these texels are covered by at most 2x2 texels:
+		uint32_t level = 0;
+		while (level + 1 < culler.levels.size() && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+			++level;
+		}
+		const std::vector<float>& depth = culler.levels[level];
+		const uint32_t level_width = culler.levelWidths[level];
+		float max_depth = 0.0f;
+		for (uint32_t y = y0 >> level; y <= (y1 >> level); ++y) {
+			for (uint32_t x = x0 >> level; x <= (x1 >> level); ++x) {
+				max_depth = std::max(max_depth, depth[y * level_width + x]);
+			}
+		}
+		return min_depth > max_depth;
+	}
+}
+
+void occlusionCullerBuildOccluder(const glm::vec3* positions, const uint32_t* indices, uint32_t num_indices,
+	const glm::vec3& bounds_min, const glm::vec3& bounds_max, OcclusionOccluder& occluder)
+{
+	occluder.positions.clear();
+	occluder.indices.clear();
+	occluder.numPieceIndices = 3;
+	const uint32_t num_triangles = num_indices / 3;
+	if (0 == num_triangles) {
+		return;
+	}
+
+	// Flat meshes have no inside:
+	const glm::vec3 extent = bounds_max - bounds_min;
+	const float max_extent = std::max({ extent.x, extent.y, extent.z });
+	if (std::min({ extent.x, extent.y, extent.z }) > 1e-3f * max_extent) {
+		VoxelGrid grid;
+		grid.cellSize = extent / static_cast<float>(kOccluderGridResolution);
+		grid.origin = bounds_min - 2.0f * grid.cellSize;
+		grid.size = kOccluderGridResolution + 4;
+		grid.cells.assign(static_cast<size_t>(grid.size) * grid.size * grid.size, VoxelGrid::UNKNOWN);
+		for (uint32_t i = 0; i + 2 < num_indices; i += 3) {
+			markTriangle(grid, positions[indices[i]], positions[indices[i + 1]], positions[indices[i + 2]], 0);
+		}
+		// Cells which are neither surface nor reachable from outside are inside. If the mesh has holes, the flood
+		// leaks in, and there are none:
+		floodOutside(grid);
+		findInsideBoxes(grid, occluder);
+		if (!occluder.indices.empty()) {
+			occluder.numPieceIndices = kOccluderBoxIndices;
+			return;
+		}
+	}
+
+	// The largest triangles occlude the most:
+	std::vector<uint32_t> triangles(num_triangles);
+	std::iota(triangles.begin(), triangles.end(), 0u);
+	const auto area = [positions, indices](uint32_t triangle) {
+		const glm::vec3& p0 = positions[indices[3 * triangle]];
+		return glm::length(glm::cross(positions[indices[3 * triangle + 1]] - p0, positions[indices[3 * triangle + 2]] - p0));
+	};
+	const uint32_t num_kept = std::min(num_triangles, kOccluderMaxTriangles);
+	std::partial_sort(triangles.begin(), triangles.begin() + num_kept, triangles.end(),
+		[&area](uint32_t a, uint32_t b) { return area(a) > area(b); });
+	for (uint32_t i = 0; i < num_kept; ++i) {
+		for (uint32_t corner = 0; corner < 3; ++corner) {
+			occluder.indices.push_back(static_cast<uint32_t>(occluder.positions.size()));
+			occluder.positions.push_back(positions[indices[3 * triangles[i] + corner]]);
+		}
+	}
+}
+
+void occlusionCullerCreate(OcclusionCuller& culler, uint32_t width, uint32_t height)
+{
+	culler.levels.clear();
+	culler.levelWidths.clear();
+	culler.levelHeights.clear();
+	width = std::max(width, 1u);
+	height = std::max(height, 1u);
+	while (true) {
+		culler.levels.emplace_back(static_cast<size_t>(width) * height, 1.0f);
+		culler.levelWidths.push_back(width);
+		culler.levelHeights.push_back(height);
+		if (1 == width && 1 == height) {
+			break;
+		}
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+	}
+	culler.visible.clear();
+	culler.statistics = {};
+}
+
+void occlusionCullerCull(OcclusionCuller& culler, const OcclusionObject* objects, uint32_t num_objects, const glm::mat4* view_projections,
+	uint32_t num_views, uint8_t* visible)
+{
+	culler.statistics = {};
+	culler.statistics.numObjects = num_objects;
+	if (num_views > 1) {
+		// The depth buffer could only hold one view's occluders, which hide different objects in the other views:
+		const uint32_t num_inside = occlusionCullerCullFrustum(objects, num_objects, view_projections, num_views, visible);
+		culler.statistics.numPhaseOneObjects = num_inside;
+		culler.statistics.numFrustumCulledObjects = num_objects - num_inside;
+		return;
+	}
+	const glm::mat4& view_projection = view_projections[0];
+	culler.visible.resize(num_objects, 1);
+	culler.modelViewProjections.resize(num_objects);
+	culler.insideFrustum.resize(num_objects);
+	std::fill(culler.levels[0].begin(), culler.levels[0].end(), 1.0f);
+	culler.occluderTriangles.clear();
+	culler.occluderPieceEnds.clear();
+
+	// Phase one: last frame's visible set is drawn, and its occluders are rasterized:
+	glm::vec4 corners[8];
+	for (uint32_t i = 0; i < num_objects; ++i) {
+		culler.modelViewProjections[i] = view_projection * objects[i].worldMatrix;
+		computeCorners(objects[i], culler.modelViewProjections[i], corners);
+		culler.insideFrustum[i] = isOutsideFrustum(corners) ? 0 : 1;
+		visible[i] = culler.insideFrustum[i] & culler.visible[i];
+		if (0 != visible[i]) {
+			++culler.statistics.numPhaseOneObjects;
+			if (nullptr != objects[i].positions) {
+				projectOccluder(culler, objects[i], culler.modelViewProjections[i]);
+			}
+		}
+	}
+	rasterizeOccluders(culler);
+	buildDepthPyramid(culler);
+
+	// Phase two: all objects are tested against the pyramid. Those which have become visible are drawn, too,
+	// and the results are the next frame's visible set:
+	for (uint32_t i = 0; i < num_objects; ++i) {
+		if (0 == culler.insideFrustum[i]) {
+			culler.visible[i] = 0;
+			++culler.statistics.numFrustumCulledObjects;
+			continue;
+		}
+		computeCorners(objects[i], culler.modelViewProjections[i], corners);
+		const bool occluded = isOccluded(culler, corners);
+		culler.visible[i] = occluded ? 0 : 1;
+		if (0 == visible[i]) {
+			if (occluded) {
+				++culler.statistics.numOccludedObjects;
+			}
+			else {
+				visible[i] = 1;
+				++culler.statistics.numNewlyVisibleObjects;
+			}
+		}
+	}
+}
+
+uint32_t occlusionCullerCullFrustum(const OcclusionObject* objects, uint32_t num_objects, const glm::mat4* view_projections, uint32_t num_views,
+	uint8_t* inside)
+{
+	uint32_t num_inside = 0;
+	for (uint32_t i = 0; i < num_objects; ++i) {
+		inside[i] = isOutsideFrusta(objects[i], view_projections, num_views) ? 0 : 1;
+		num_inside += inside[i];
+	}
+	return num_inside;
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+/* --------------------------------------------- */
+// Occlusion Culler
+//
+// Two-phase hierarchical-Z (Hi-Z) occlusion culling on the CPU:
+//  1. The occluders of the objects which were visible in the previous frame
+//     are rasterized into a low-resolution depth buffer, in horizontal bands
+//     on the job system. A depth pyramid is built from it, where every texel
+//     holds the farthest depth of the four texels below it.
+//  2. All objects' bounding boxes are tested against the pyramid, at the
+//     level where the box covers at most 2x2 texels. An object is occluded
+//     if its nearest depth lies behind the farthest depth of these texels.
+//     Newly visible objects are drawn as well, and the test results become
+//     the next frame's visible set.
+// Objects which were visible in the previous frame are always drawn, so the
+// result is conservative as long as the occluders are. Objects which cross
+// the near plane are never culled, and occluder pieces which cross it are
+// skipped.
+//
+// With several views, e.g., for multiview rendering, occluders hide
+// different objects in every view. Hence, objects are only culled if they
+// are outside of every view's frustum, and the depth buffer is not used.
+//
+// Occluders consist of convex pieces, e.g., boxes. A texel of the depth
+// buffer is only covered by a piece if the piece covers the whole texel, and
+// then receives the farthest depth of the piece's front surface within it.
+// Hence, occluders never hide objects which peek past their silhouettes.
+//
+// Occluders are simplified versions of the meshes, which are built once with
+// occlusionCullerBuildOccluder, e.g., when a mesh is loaded: a few boxes
+// which lie inside of the mesh, found on a coarse voxel grid. Meshes which
+// are not closed have no inside, and occlude with their largest triangles
+// instead. Both never extend beyond the mesh's surface.
+//
+// Depth values are z / w of clip space coordinates. Hence, the culler works
+// with both, [0, 1] and [-1, 1] depth ranges.
+//
+// The culler runs on the CPU because the visible set is used there: it is
+// sorted into the draw list, which is recorded with direct draws and can be
+// reused in later frames. A GPU pyramid would have to be built between the
+// two phases' draws. The render graph's passes are submitted before all of
+// the frame's draws, so the scene pass would have to be split in two around
+// the downsample, and the second phase's draws would be selected on the GPU
+// with indirect draws. The results would then reach the CPU a frame late.
+/* --------------------------------------------- */
+
+/*!
+ *	An object which can be culled, and which can occlude other objects.
+ */
+struct OcclusionObject {
+	//! Transforms the object into world space
+	glm::mat4 worldMatrix;
+
+	//! The object's bounding box in object space
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+
+	//! Triangle list which occludes other objects, in object space, e.g., from occlusionCullerBuildOccluder.
+	//! It must not extend beyond the object's surface. nullptr if the object does not occlude anything.
+	const glm::vec3* positions;
+	const uint32_t*  indices;
+	uint32_t         numIndices;
+
+	//! Number of indices of every convex piece of the triangle list, e.g., 36 for boxes or 3 for single triangles
+	uint32_t         numPieceIndices;
+};
+
+/*!
+ *	Statistics of the most recent occlusionCullerCull call.
+ */
+struct OcclusionCullerStatistics {
+	//! Number of objects which have been tested
+	uint32_t numObjects;
+
+	//! Objects which have been drawn in phase one, because they were visible in the previous frame
+	uint32_t numPhaseOneObjects;
+
+	//! Objects which have been drawn in phase two, because they have become visible
+	uint32_t numNewlyVisibleObjects;
+
+	//! Objects outside of the view frustum
+	uint32_t numFrustumCulledObjects;
+
+	//! Objects inside of the view frustum which are hidden behind occluders
+	uint32_t numOccludedObjects;
+
+	//! Occluder triangles which have been rasterized into the depth buffer
+	uint32_t numRasterizedTriangles;
+};
+
+/*!
+ *	The depth pyramid and the visibility of every object in the previous frame.
+ */
+struct OcclusionCuller {
+	//! Max-depth pyramid. Level 0 is the depth buffer which the occluders are rasterized into.
+	std::vector<std::vector<float>> levels;
+	std::vector<uint32_t> levelWidths;
+	std::vector<uint32_t> levelHeights;
+
+	//! Per object: 1 if it was visible in the previous frame. New objects are assumed to be visible.
+	std::vector<uint8_t> visible;
+
+	//! Scratch space, per object: its model-view-projection matrix, and 1 if it is inside of the view frustum
+	std::vector<glm::mat4> modelViewProjections;
+	std::vector<uint8_t>   insideFrustum;
+
+	//! Scratch space: the projected corners (x, y, depth) of all occluder triangles, three per triangle,
+	//! and per convex piece, the end of its triangles
+	std::vector<glm::vec3> occluderTriangles;
+	std::vector<uint32_t>  occluderPieceEnds;
+
+	OcclusionCullerStatistics statistics;
+};
+
+/*!
+ *	A simplified triangle list which occludes (part of) what a mesh occludes, see occlusionCullerBuildOccluder.
+ */
+struct OcclusionOccluder {
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t>  indices;
+
+	//! Number of indices of every convex piece: 36 for boxes, 3 for triangles
+	uint32_t               numPieceIndices = 0;
+};
+
+/*!
+ *	Builds the occluder of a mesh: up to a few boxes which lie inside of the mesh, or, if the mesh is not closed,
+ *	a subset of its largest triangles. Either never extends beyond the mesh's surface. Takes a few milliseconds for
+ *	large meshes, hence it should run on a worker thread, e.g., when the mesh is loaded.
+ *	@param	positions		The mesh's vertex positions
+ *	@param	indices			The mesh's triangle list indices
+ *	@param	num_indices		Number of indices
+ *	@param	bounds_min		Minimum of the mesh's bounding box
+ *	@param	bounds_max		Maximum of the mesh's bounding box
+ *	@param	occluder		Receives the occluder. Empty if the mesh cannot occlude anything.
+ */
+void occlusionCullerBuildOccluder(const glm::vec3* positions, const uint32_t* indices, uint32_t num_indices,
+	const glm::vec3& bounds_min, const glm::vec3& bounds_max, OcclusionOccluder& occluder);
+
+/*!
+ *	Allocates the depth pyramid.
+ *	@param	culler	The culler to initialize
+ *	@param	width	Width of the depth buffer. A fraction of the viewport's width is usually sufficient.
+ *	@param	height	Height of the depth buffer
+ */
+void occlusionCullerCreate(OcclusionCuller& culler, uint32_t width, uint32_t height);
+
+/*!
+ *	Determines which objects are visible. The objects must be passed in the same order every frame, since
+ *	the visibility of object i in the previous frame selects the occluders of the current frame.
+ *	The job system must have been created. Must be called from the main thread, which rasterizes bands of the
+ *	depth buffer together with idle workers, and never runs other jobs in the meantime.
+ *	@param	culler				The culler
+ *	@param	objects				The objects to test
+ *	@param	num_objects			Number of objects
+ *	@param	view_projections	Per view, transforms world space into clip space
+ *	@param	num_views			Number of views. With more than one, only the views' frusta are tested.
+ *	@param	visible				Receives, per object, 1 if it must be drawn, and 0 if it has been culled
+ */
+void occlusionCullerCull(OcclusionCuller& culler, const OcclusionObject* objects, uint32_t num_objects, const glm::mat4* view_projections,
+	uint32_t num_views, uint8_t* visible);
+
+/*!
+ *	Tests the objects against the view frusta only, as in the first phase of occlusionCullerCull.
+ *	@param	objects				The objects to test
+ *	@param	num_objects			Number of objects
+ *	@param	view_projections	Per view, transforms world space into clip space
+ *	@param	num_views			Number of views
+ *	@param	inside				Receives, per object, 1 if its bounding box is (partially) inside of any view's frustum, and 0 otherwise
+ *	@return	Number of objects inside of any view's frustum
+ */
+uint32_t occlusionCullerCullFrustum(const OcclusionObject* objects, uint32_t num_objects, const glm::mat4* view_projections, uint32_t num_views,
+	uint8_t* inside);
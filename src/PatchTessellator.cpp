@@ -0,0 +1,290 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "PatchTessellator.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define PATCH_TESSELLATOR_USE_SSE 1
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define PATCH_TESSELLATOR_USE_NEON 1
+#endif
+
+namespace
+{
+	constexpr uint32_t kControlPointsPerPatch = 16;
+	constexpr uint32_t kMaxSamples = kPatchTessellatorMaxLevel + 1;
+	// Basis arrays are padded to a multiple of four samples, so that SIMD loads never read out of bounds:
+	constexpr uint32_t kMaxPaddedSamples = (kMaxSamples + 3) & ~3u;
+
+	// Four floats, i.e., four consecutive samples along a row of the grid:
+#if defined(PATCH_TESSELLATOR_USE_SSE)
+	typedef __m128 Float4;
+	inline Float4 float4Set(float value) { return _mm_set1_ps(value); }
+	inline Float4 float4Load(const float* source) { return _mm_loadu_ps(source); }
+	inline void float4Store(float* destination, Float4 value) { _mm_storeu_ps(destination, value); }
+	inline Float4 float4Mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+	inline Float4 float4Sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+	inline Float4 float4MulAdd(Float4 a, Float4 b, Float4 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+#elif defined(PATCH_TESSELLATOR_USE_NEON)
+	typedef float32x4_t Float4;
+	inline Float4 float4Set(float value) { return vdupq_n_f32(value); }
+	inline Float4 float4Load(const float* source) { return vld1q_f32(source); }
+	inline void float4Store(float* destination, Float4 value) { vst1q_f32(destination, value); }
+	inline Float4 float4Mul(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+	inline Float4 float4Sub(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+	inline Float4 float4MulAdd(Float4 a, Float4 b, Float4 c) { return vfmaq_f32(c, a, b); }
+#else
+	struct Float4 {
+		float lanes[4];
+	};
+	inline Float4 float4Set(float value) { return Float4{ { value, value, value, value } }; }
+	inline Float4 float4Load(const float* source) { return Float4{ { source[0], source[1], source[2], source[3] } }; }
+	inline void float4Store(float* destination, Float4 value) { std::copy(value.lanes, value.lanes + 4, destination); }
+	inline Float4 float4Mul(Float4 a, Float4 b) { return Float4{ { a.lanes[0] * b.lanes[0], a.lanes[1] * b.lanes[1], a.lanes[2] * b.lanes[2], a.lanes[3] * b.lanes[3] } }; }
+	inline Float4 float4Sub(Float4 a, Float4 b) { return Float4{ { a.lanes[0] - b.lanes[0], a.lanes[1] - b.lanes[1], a.lanes[2] - b.lanes[2], a.lanes[3] - b.lanes[3] } }; }
+	inline Float4 float4MulAdd(Float4 a, Float4 b, Float4 c) { return Float4{ { a.lanes[0] * b.lanes[0] + c.lanes[0], a.lanes[1] * b.lanes[1] + c.lanes[1], a.lanes[2] * b.lanes[2] + c.lanes[2], a.lanes[3] * b.lanes[3] + c.lanes[3] } }; }
+#endif
+
+	// The cubic Bernstein polynomials and their derivatives at t:
+	inline void bernstein(float t, float* basis, float* derivative)
+	{
+		const float s = 1.0f - t;
+		basis[0] = s * s * s;
+		basis[1] = 3.0f * t * s * s;
+		basis[2] = 3.0f * t * t * s;
+		basis[3] = t * t * t;
+		derivative[0] = -3.0f * s * s;
+		derivative[1] = 3.0f * s * s - 6.0f * t * s;
+		derivative[2] = 6.0f * t * s - 3.0f * t * t;
+		derivative[3] = 3.0f * t * t;
+	}
+
+	// Where both partial derivatives are (almost) parallel, e.g., at the poles of the teapot's lid and bottom,
+	// where a whole row of control points collapses into one point, the cross product is not a usable normal:
+	inline bool isDegenerate(const glm::vec3& normal, const glm::vec3& du, const glm::vec3& dv)
+	{
+		const float scale = glm::dot(du, du) + glm::dot(dv, dv);
+		return glm::dot(normal, normal) <= 1e-10f * scale * scale;
+	}
+
+	void evaluateUnnormalized(const glm::vec3* p, float u, float v, glm::vec3& position, glm::vec3& normal, glm::vec3& du, glm::vec3& dv)
+	{
+		float bu[4], dbu[4], bv[4], dbv[4];
+		bernstein(u, bu, dbu);
+		bernstein(v, bv, dbv);
+		position = du = dv = glm::vec3(0.0f);
+		for (int row = 0; row < 4; ++row) {
+			for (int column = 0; column < 4; ++column) {
+				const glm::vec3& control_point = p[4 * row + column];
+				position += (bu[column] * bv[row]) * control_point;
+				du += (dbu[column] * bv[row]) * control_point;
+				dv += (bu[column] * dbv[row]) * control_point;
+			}
+		}
+		normal = glm::cross(du, dv);
+	}
+
+	// Bezier patches lie within the convex hull of their control points, so the length of the control polygon
+	// bounds the length of every iso-curve on screen:
+	float projectedControlPolygonLength(const glm::vec2* screen)
+	{
+		float longest = 0.0f;
+		for (int i = 0; i < 4; ++i) {
+			float row_length = 0.0f;
+			float column_length = 0.0f;
+			for (int j = 0; j < 3; ++j) {
+				row_length += glm::length(screen[4 * i + j + 1] - screen[4 * i + j]);
+				column_length += glm::length(screen[4 * (j + 1) + i] - screen[4 * j + i]);
+			}
+			longest = std::max(longest, std::max(row_length, column_length));
+		}
+		return longest;
+	}
+}
+
+PatchTessellationBuffer patchTessellatorCreateBuffer(VkPhysicalDevice physical_device, VkDevice device, uint32_t num_patches)
+{
+	const VkDeviceSize max_vertices = static_cast<VkDeviceSize>(num_patches) * kMaxSamples * kMaxSamples;
+	const VkDeviceSize max_indices = static_cast<VkDeviceSize>(num_patches) * kPatchTessellatorMaxLevel * kPatchTessellatorMaxLevel * 6;
+	PatchTessellationBuffer buffer = {};
+	buffer.vertexBuffer = hlpCreateMappedBuffer(physical_device, device, sizeof(PatchTessellatorVertex) * max_vertices,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, MEMORY_CATEGORY_GEOMETRY, "Tessellated Vertices");
+	buffer.indexBuffer = hlpCreateMappedBuffer(physical_device, device, sizeof(uint32_t) * max_indices,
+		VK_BUFFER_USAGE_INDEX_BUFFER_BIT, MEMORY_CATEGORY_GEOMETRY, "Tessellated Indices");
+	return buffer;
+}
+
+void patchTessellatorDestroyBuffer(VkDevice device, PatchTessellationBuffer& buffer)
+{
+	hlpDestroyMappedBuffer(device, buffer.vertexBuffer);
+	hlpDestroyMappedBuffer(device, buffer.indexBuffer);
+	buffer.level = 0;
+	buffer.indexCount = 0;
+}
+
+uint32_t patchTessellatorSelectLevel(const glm::vec3* control_points, uint32_t num_patches, const glm::mat4& model_view_projection,
+	const glm::vec2& viewport_size, float pixels_per_segment)
+{
+	float longest = 0.0f;
+	for (uint32_t patch = 0; patch < num_patches; ++patch) {
+		const glm::vec3* p = control_points + kControlPointsPerPatch * patch;
+		glm::vec4 clip[kControlPointsPerPatch];
+		bool crosses_eye_plane = false;
+		uint32_t outside_left = 0, outside_right = 0, outside_bottom = 0, outside_top = 0, outside_far = 0;
+		for (uint32_t i = 0; i < kControlPointsPerPatch; ++i) {
+			clip[i] = model_view_projection * glm::vec4(p[i], 1.0f);
+			crosses_eye_plane = crosses_eye_plane || clip[i].w <= 1e-4f;
+			outside_left += clip[i].x < -clip[i].w ? 1 : 0;
+			outside_right += clip[i].x > clip[i].w ? 1 : 0;
+			outside_bottom += clip[i].y < -clip[i].w ? 1 : 0;
+			outside_top += clip[i].y > clip[i].w ? 1 : 0;
+			outside_far += clip[i].z > clip[i].w ? 1 : 0;
+		}
+		// The patch lies within its control points' convex hull => if all of them are outside of one plane, so is the patch:
+		if (kControlPointsPerPatch == outside_left || kControlPointsPerPatch == outside_right || kControlPointsPerPatch == outside_bottom
+			|| kControlPointsPerPatch == outside_top || kControlPointsPerPatch == outside_far) {
+			continue;
+		}
+		// Projected lengths are unbounded for patches which reach behind the camera => use the finest level:
+		if (crosses_eye_plane) {
+			return kPatchTessellatorMaxLevel;
+		}
+		glm::vec2 screen[kControlPointsPerPatch];
+		for (uint32_t i = 0; i < kControlPointsPerPatch; ++i) {
+			screen[i] = glm::vec2(clip[i].x, clip[i].y) / clip[i].w * 0.5f * viewport_size;
+		}
+		longest = std::max(longest, projectedControlPolygonLength(screen));
+	}
+	if (0.0f == longest) {
+		return 0;
+	}
+	const float level = std::ceil(longest / pixels_per_segment);
+	return static_cast<uint32_t>(std::min(std::max(level, 1.0f), static_cast<float>(kPatchTessellatorMaxLevel)));
+}
+
+bool patchTessellatorUpdate(PatchTessellationBuffer& buffer, const glm::vec3* control_points, uint32_t num_patches, uint32_t level)
+{
+	level = std::min(std::max(level, 1u), kPatchTessellatorMaxLevel);
+	if (level == buffer.level) {
+		return false;
+	}
+	const uint32_t num_samples = level + 1;
+	const float step = 1.0f / static_cast<float>(level);
+
+	// Basis functions are the same for every patch. They are stored per control point column, one sample after
+	// another, so that four consecutive samples can be loaded into one SIMD register:
+	alignas(16) float basis_u[4][kMaxPaddedSamples] = {};
+	alignas(16) float derivative_u[4][kMaxPaddedSamples] = {};
+	float basis_v[kMaxSamples][4];
+	float derivative_v[kMaxSamples][4];
+	for (uint32_t s = 0; s < num_samples; ++s) {
+		float basis[4], derivative[4];
+		bernstein(static_cast<float>(s) * step, basis, derivative);
+		for (int k = 0; k < 4; ++k) {
+			basis_u[k][s] = basis_v[s][k] = basis[k];
+			derivative_u[k][s] = derivative_v[s][k] = derivative[k];
+		}
+	}
+
+	PatchTessellatorVertex* vertices = static_cast<PatchTessellatorVertex*>(buffer.vertexBuffer.mappedData);
+	for (uint32_t patch = 0; patch < num_patches; ++patch) {
+		const glm::vec3* p = control_points + kControlPointsPerPatch * patch;
+		for (uint32_t row = 0; row < num_samples; ++row) {
+			// Collapse the patch into the cubic curve at v (and the curve of its v-derivatives):
+			glm::vec3 curve[4], curve_dv[4];
+			for (int column = 0; column < 4; ++column) {
+				curve[column] = curve_dv[column] = glm::vec3(0.0f);
+				for (int k = 0; k < 4; ++k) {
+					curve[column] += basis_v[row][k] * p[4 * k + column];
+					curve_dv[column] += derivative_v[row][k] * p[4 * k + column];
+				}
+			}
+
+			for (uint32_t first = 0; first < num_samples; first += 4) {
+				Float4 px = float4Set(0.0f), py = float4Set(0.0f), pz = float4Set(0.0f);
+				Float4 ux = float4Set(0.0f), uy = float4Set(0.0f), uz = float4Set(0.0f);
+				Float4 vx = float4Set(0.0f), vy = float4Set(0.0f), vz = float4Set(0.0f);
+				for (int k = 0; k < 4; ++k) {
+					const Float4 b = float4Load(&basis_u[k][first]);
+					const Float4 db = float4Load(&derivative_u[k][first]);
+					px = float4MulAdd(b, float4Set(curve[k].x), px);
+					py = float4MulAdd(b, float4Set(curve[k].y), py);
+					pz = float4MulAdd(b, float4Set(curve[k].z), pz);
+					ux = float4MulAdd(db, float4Set(curve[k].x), ux);
+					uy = float4MulAdd(db, float4Set(curve[k].y), uy);
+					uz = float4MulAdd(db, float4Set(curve[k].z), uz);
+					vx = float4MulAdd(b, float4Set(curve_dv[k].x), vx);
+					vy = float4MulAdd(b, float4Set(curve_dv[k].y), vy);
+					vz = float4MulAdd(b, float4Set(curve_dv[k].z), vz);
+				}
+				alignas(16) float lanes[12][4];
+				float4Store(lanes[0], px);
+				float4Store(lanes[1], py);
+				float4Store(lanes[2], pz);
+				float4Store(lanes[3], float4Sub(float4Mul(uy, vz), float4Mul(uz, vy)));
+				float4Store(lanes[4], float4Sub(float4Mul(uz, vx), float4Mul(ux, vz)));
+				float4Store(lanes[5], float4Sub(float4Mul(ux, vy), float4Mul(uy, vx)));
+				float4Store(lanes[6], ux);
+				float4Store(lanes[7], uy);
+				float4Store(lanes[8], uz);
+				float4Store(lanes[9], vx);
+				float4Store(lanes[10], vy);
+				float4Store(lanes[11], vz);
+
+				const uint32_t count = std::min(4u, num_samples - first);
+				for (uint32_t lane = 0; lane < count; ++lane) {
+					PatchTessellatorVertex vertex;
+					vertex.position = glm::vec3(lanes[0][lane], lanes[1][lane], lanes[2][lane]);
+					const glm::vec3 normal(lanes[3][lane], lanes[4][lane], lanes[5][lane]);
+					const glm::vec3 du(lanes[6][lane], lanes[7][lane], lanes[8][lane]);
+					const glm::vec3 dv(lanes[9][lane], lanes[10][lane], lanes[11][lane]);
+					if (!isDegenerate(normal, du, dv)) {
+						vertex.normal = glm::normalize(normal);
+					}
+					else {
+						glm::vec3 unused_position;
+						patchTessellatorEvaluate(p, static_cast<float>(first + lane) * step, static_cast<float>(row) * step, unused_position, vertex.normal);
+					}
+					*vertices++ = vertex;
+				}
+			}
+		}
+	}
+
+	// Two counter-clockwise triangles per grid cell, matching the winding of the control point mesh:
+	uint32_t* indices = static_cast<uint32_t*>(buffer.indexBuffer.mappedData);
+	for (uint32_t patch = 0; patch < num_patches; ++patch) {
+		const uint32_t patch_base = patch * num_samples * num_samples;
+		for (uint32_t row = 0; row < level; ++row) {
+			for (uint32_t column = 0; column < level; ++column) {
+				const uint32_t i00 = patch_base + row * num_samples + column;
+				const uint32_t i01 = i00 + 1;
+				const uint32_t i10 = i00 + num_samples;
+				const uint32_t i11 = i10 + 1;
+				*indices++ = i00; *indices++ = i11; *indices++ = i10;
+				*indices++ = i00; *indices++ = i01; *indices++ = i11;
+			}
+		}
+	}
+
+	buffer.level = level;
+	buffer.indexCount = num_patches * level * level * 6;
+	return true;
+}
+
+void patchTessellatorEvaluate(const glm::vec3* patch_control_points, float u, float v, glm::vec3& position, glm::vec3& normal)
+{
+	glm::vec3 du, dv;
+	evaluateUnnormalized(patch_control_points, u, v, position, normal, du, dv);
+	if (isDegenerate(normal, du, dv)) {
+		// The normal at a pole is the limit of the normals around it => take the one slightly towards the patch's center:
+		glm::vec3 unused_position;
+		evaluateUnnormalized(patch_control_points, u + (0.5f - u) * 1e-3f, v + (0.5f - v) * 1e-3f, unused_position, normal, du, dv);
+	}
+	const float length = glm::length(normal);
+	normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include "VulkanHelpers.h"
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+
+/* --------------------------------------------- */
+// Patch Tessellator
+//
+// Evaluates bicubic Bezier patches on the CPU at a view-dependent level.
+// Every patch is sampled on a regular (level + 1) x (level + 1) grid, four
+// samples at a time with SIMD (SSE on x86, NEON on ARM). Normals are computed
+// analytically as the cross product of the partial derivatives.
+//
+// All patches of a mesh share one level, which is derived from the largest
+// projected control polygon in pixels. Hence, adjacent patches always agree
+// on their shared edges and the surface has no cracks, while the number of
+// triangles follows the mesh's screen coverage.
+//
+// Results are written into reusable, persistently mapped buffers, which are
+// only rewritten when the level changes.
+/* --------------------------------------------- */
+
+//! The finest tessellation level, i.e., the maximum number of segments per patch edge
+constexpr uint32_t kPatchTessellatorMaxLevel = 32;
+
+/*!
+ *	A vertex of a tessellated patch. Vertex input binding 0 of the tessellated pipelines.
+ */
+struct PatchTessellatorVertex {
+	glm::vec3 position;
+	glm::vec3 normal;
+};
+
+/*!
+ *	Vertex and index buffers which hold a tessellation of a set of patches. Sized for kPatchTessellatorMaxLevel.
+ */
+struct PatchTessellationBuffer {
+	//! Vertices of all patches, patch after patch
+	HlpMappedBuffer vertexBuffer;
+
+	//! Triangle list indices into vertexBuffer
+	HlpMappedBuffer indexBuffer;
+
+	//! The level which the buffers currently hold, 0 if they have not been written yet
+	uint32_t level;
+
+	//! Number of indices for the current level
+	uint32_t indexCount;
+};
+
+/*!
+ *	Creates buffers which can hold the tessellation of num_patches patches at every level.
+ */
+PatchTessellationBuffer patchTessellatorCreateBuffer(VkPhysicalDevice physical_device, VkDevice device, uint32_t num_patches);
+
+/*!
+ *	Destroys the given buffers. The GPU must not use them anymore.
+ */
+void patchTessellatorDestroyBuffer(VkDevice device, PatchTessellationBuffer& buffer);
+
+/*!
+ *	Selects a tessellation level such that no segment of a patch is longer than the given number of pixels on screen.
+ *	@param	control_points			16 control points per patch, in row-major order
+ *	@param	num_patches				Number of patches
+ *	@param	model_view_projection	Transforms control points into clip space
+ *	@param	viewport_size			Size of the viewport in pixels
+ *	@param	pixels_per_segment		The targeted on-screen length of a segment
+ *	@return	A level between 1 and kPatchTessellatorMaxLevel, or 0 if all patches are outside of the view frustum.
+ */
+uint32_t patchTessellatorSelectLevel(const glm::vec3* control_points, uint32_t num_patches, const glm::mat4& model_view_projection,
+	const glm::vec2& viewport_size, float pixels_per_segment);
+
+/*!
+ *	Tessellates all patches at the given level into the given buffers, unless they already hold that level.
+ *	The GPU must not be reading from the buffers at the moment, i.e., use one buffer per frame in flight.
+ *	@param	buffer			Buffers created for (at least) num_patches patches
+ *	@param	control_points	16 control points per patch, in row-major order
+ *	@param	num_patches		Number of patches
+ *	@param	level			Number of segments per patch edge, between 1 and kPatchTessellatorMaxLevel
+ *	@return	True if the buffers have been rewritten
+ */
+bool patchTessellatorUpdate(PatchTessellationBuffer& buffer, const glm::vec3* control_points, uint32_t num_patches, uint32_t level);
+
+/*!
+ *	Evaluates a bicubic Bezier patch's position and analytic normal at (u, v), with u along the rows of control points.
+ *	The normal is normalized and points in the direction of dP/du x dP/dv.
+ */
+void patchTessellatorEvaluate(const glm::vec3* patch_control_points, float u, float v, glm::vec3& position, glm::vec3& normal);
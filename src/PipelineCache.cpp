@@ -0,0 +1,167 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "PipelineCache.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+	struct PipelineEntry {
+		//! VK_NULL_HANDLE until the pipeline has been compiled and published
+		VkPipeline pipeline = VK_NULL_HANDLE;
+
+		//! The main-thread job which publishes the pipeline, while it is being compiled in the background
+		JobHandle publishJob;
+	};
+
+	VkDevice mDevice = VK_NULL_HANDLE;
+	VkRenderPass mRenderPass = VK_NULL_HANDLE;
+	VkExtent2D mExtent = {};
+	VkPipelineCache mVkPipelineCache = VK_NULL_HANDLE;
+	// Node-based => pointers to entries stay valid while other entries are inserted:
+	std::unordered_map<std::string, PipelineEntry> mEntries;
+
+	template <typename T>
+	void appendToKey(std::string& key, const T& value)
+	{
+		key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	void appendStringToKey(std::string& key, const std::string& value)
+	{
+		appendToKey(key, static_cast<uint32_t>(value.size()));
+		key.append(value);
+	}
+
+	// Serializes every field which determines the pipeline, one by one (structs might contain padding), so that
+	// equal keys mean equal pipelines:
+	std::string makeKey(const VklGraphicsPipelineConfig& config, const HlpPipelineState& state)
+	{
+		std::string key;
+		appendStringToKey(key, std::string(config.vertexShaderPath));
+		appendStringToKey(key, state.useFragmentShader ? std::string(config.fragmentShaderPath) : std::string());
+		appendToKey(key, static_cast<uint32_t>(config.vertexInputBuffers.size()));
+		for (const VkVertexInputBindingDescription& binding : config.vertexInputBuffers) {
+			appendToKey(key, binding.binding);
+			appendToKey(key, binding.stride);
+			appendToKey(key, binding.inputRate);
+		}
+		appendToKey(key, static_cast<uint32_t>(config.inputAttributeDescriptions.size()));
+		for (const VkVertexInputAttributeDescription& attribute : config.inputAttributeDescriptions) {
+			appendToKey(key, attribute.location);
+			appendToKey(key, attribute.binding);
+			appendToKey(key, attribute.format);
+			appendToKey(key, attribute.offset);
+		}
+		appendToKey(key, config.polygonDrawMode);
+		appendToKey(key, static_cast<uint32_t>(config.descriptorLayout.size()));
+		for (const VkDescriptorSetLayoutBinding& binding : config.descriptorLayout) {
+			appendToKey(key, binding.binding);
+			appendToKey(key, binding.descriptorType);
+			appendToKey(key, binding.descriptorCount);
+			appendToKey(key, binding.stageFlags);
+			appendToKey(key, binding.pImmutableSamplers);
+		}
+		// hlpCreateGraphicsPipeline takes the culling mode from the state, not from config.triangleCullingMode:
+		appendToKey(key, state.cullMode);
+		appendToKey(key, state.frontFace);
+		appendToKey(key, state.depthTestEnable);
+		appendToKey(key, state.depthWriteEnable);
+		appendToKey(key, state.depthCompareOp);
+		appendToKey(key, state.colorWriteMask);
+		appendToKey(key, state.useFragmentShader);
+		appendToKey(key, state.dynamicViewport);
+		appendToKey(key, state.numSpecializationConstants);
+		for (uint32_t i = 0; i < state.numSpecializationConstants; ++i) {
+			appendToKey(key, state.specializationConstants[i]);
+		}
+		return key;
+	}
+
+	JobHandle startCompiling(PipelineEntry& entry, const VklGraphicsPipelineConfig& config, const HlpPipelineState& state)
+	{
+		std::shared_ptr<VkPipeline> compiled = std::make_shared<VkPipeline>(VK_NULL_HANDLE);
+		const auto start_time = std::chrono::steady_clock::now();
+		const JobHandle compile_job = jobSystemSubmit("Compile Pipeline", [compiled, config, state] {
+			*compiled = hlpCreateGraphicsPipeline(mDevice, config, state, mRenderPass, mExtent, mVkPipelineCache);
+		});
+		PipelineEntry* published_entry = &entry;
+		entry.publishJob = jobSystemSubmit("Publish Pipeline", [compiled, published_entry, start_time] {
+			published_entry->pipeline = *compiled;
+			published_entry->publishJob = nullptr;
+			const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+			VKL_LOG("Pipeline variant compiled in the background in " << milliseconds << " ms (" << mEntries.size() << " variants in total).");
+		}, &compile_job, 1, JOB_AFFINITY_MAIN_THREAD);
+		return compile_job;
+	}
+}
+
+void pipelineCacheCreate(VkDevice device, VkRenderPass render_pass, VkExtent2D extent)
+{
+	mDevice = device;
+	mRenderPass = render_pass;
+	mExtent = extent;
+	VkPipelineCacheCreateInfo pipeline_cache_create_info = {};
+	pipeline_cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	VkResult result = vkCreatePipelineCache(device, &pipeline_cache_create_info, nullptr, &mVkPipelineCache);
+	VKL_CHECK_VULKAN_RESULT(result);
+}
+
+void pipelineCacheDestroy()
+{
+	for (auto& entry : mEntries) {
+		if (VK_NULL_HANDLE != entry.second.pipeline) {
+			hlpDestroyGraphicsPipeline(mDevice, entry.second.pipeline);
+		}
+	}
+	mEntries.clear();
+	vkDestroyPipelineCache(mDevice, mVkPipelineCache, nullptr);
+	mVkPipelineCache = VK_NULL_HANDLE;
+	mDevice = VK_NULL_HANDLE;
+}
+
+VkPipeline pipelineCacheGet(const VklGraphicsPipelineConfig& config, const HlpPipelineState& state)
+{
+	PipelineEntry& entry = mEntries[makeKey(config, state)];
+	if (nullptr != entry.publishJob) {
+		// The publish job resets entry.publishJob => wait on a copy of the handle:
+		const JobHandle publish_job = entry.publishJob;
+		jobSystemWait(publish_job);
+	}
+	else if (VK_NULL_HANDLE == entry.pipeline) {
+		PROFILER_ZONE("Compile Pipeline");
+		entry.pipeline = hlpCreateGraphicsPipeline(mDevice, config, state, mRenderPass, mExtent, mVkPipelineCache);
+	}
+	return entry.pipeline;
+}
+
+JobHandle pipelineCachePrepare(const VklGraphicsPipelineConfig& config, const HlpPipelineState& state)
+{
+	PipelineEntry& entry = mEntries[makeKey(config, state)];
+	if (VK_NULL_HANDLE != entry.pipeline || nullptr != entry.publishJob) {
+		return nullptr;
+	}
+	return startCompiling(entry, config, state);
+}
+
+VkPipeline pipelineCacheRequest(const VklGraphicsPipelineConfig& config, const HlpPipelineState& state, VkPipeline fallback)
+{
+	PipelineEntry& entry = mEntries[makeKey(config, state)];
+	if (VK_NULL_HANDLE != entry.pipeline) {
+		return entry.pipeline;
+	}
+	if (nullptr == entry.publishJob) {
+		startCompiling(entry, config, state);
+	}
+	return fallback;
+}
+
+uint32_t pipelineCacheGetNumPipelines()
+{
+	return static_cast<uint32_t>(mEntries.size());
+}
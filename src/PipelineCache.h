@@ -0,0 +1,70 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include "VulkanHelpers.h"
+#include "JobSystem.h"
+#include <VulkanLaunchpad.h>
+#include <vulkan/vulkan.h>
+#include <cstdint>
+
+/* --------------------------------------------- */
+// Pipeline Cache
+//
+// A registry of graphics pipeline variants. Pipelines are keyed on everything
+// which hlpCreateGraphicsPipeline consumes: the VklGraphicsPipelineConfig
+// (shaders, vertex input, polygon mode, culling, descriptor layout) and the
+// HlpPipelineState (including specialization constants). Identical requests
+// return the same VkPipeline.
+//
+// Variants can be requested without blocking: a missing variant is compiled
+// on the job system, and the caller's fallback pipeline is returned until it
+// is ready. Finished variants are published on the main thread, so a
+// variant never changes in the middle of a frame. All compiles share one
+// VkPipelineCache, so the driver can reuse work between similar variants.
+//
+// All functions must be called from the main thread.
+/* --------------------------------------------- */
+
+/*!
+ *	Creates the pipeline cache. All pipelines are created for the given render pass and extent.
+ *	The job system must have been created.
+ *	@param	device			Device handle
+ *	@param	render_pass		A render pass which is compatible with the one that the pipelines are used in
+ *	@param	extent			The viewport and scissor extent
+ */
+void pipelineCacheCreate(VkDevice device, VkRenderPass render_pass, VkExtent2D extent);
+
+/*!
+ *	Destroys all pipelines. No compile may be in flight anymore, i.e., call this after jobSystemDestroy,
+ *	and the device must be idle.
+ */
+void pipelineCacheDestroy();
+
+/*!
+ *	Returns the pipeline for the given config and state. If it does not exist yet, it is compiled right away;
+ *	if it is being compiled in the background, this function waits for it. Use this during startup.
+ */
+VkPipeline pipelineCacheGet(const VklGraphicsPipelineConfig& config, const HlpPipelineState& state);
+
+/*!
+ *	Starts compiling the pipeline for the given config and state in the background, unless it exists or is being
+ *	compiled already. Fetch it with pipelineCacheGet later, e.g., to overlap compiles with the rest of startup.
+ *	@return	The job which compiles the pipeline, or nullptr if no compile has been started.
+ */
+JobHandle pipelineCachePrepare(const VklGraphicsPipelineConfig& config, const HlpPipelineState& state);
+
+/*!
+ *	Returns the pipeline for the given config and state if it is ready. Otherwise, starts compiling it in the
+ *	background (unless that has already happened) and returns the fallback. Never blocks.
+ *	@param	config		Shaders, vertex input, polygon mode, and descriptor layout
+ *	@param	state		Culling, winding order, depth, color write state, and specialization constants
+ *	@param	fallback	The pipeline to use until the requested one is ready
+ *	@return	The requested pipeline, or the fallback.
+ */
+VkPipeline pipelineCacheRequest(const VklGraphicsPipelineConfig& config, const HlpPipelineState& state, VkPipeline fallback);
+
+/*!
+ *	Returns the number of pipelines which have been requested, including those which are still compiling.
+ */
+uint32_t pipelineCacheGetNumPipelines();
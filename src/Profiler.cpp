@@ -0,0 +1,218 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "Profiler.h"
+
+#if PROFILER_ENABLED
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PROFILER_USE_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define PROFILER_USE_RDTSC 1
+#else
+#define PROFILER_USE_RDTSC 0
+#endif
+
+namespace
+{
+	struct ProfilerEvent {
+		const char* name;
+		uint64_t    begin;
+		uint64_t    end;
+	};
+
+	// One ring buffer per thread. Only the owning thread writes into it, hence no locking is required.
+	struct ProfilerThreadBuffer {
+		std::vector<ProfilerEvent> events;
+		std::atomic<uint64_t>      writeCount{ 0 };
+		uint32_t                   threadId = 0;
+		const char*                threadName = nullptr;
+	};
+
+	std::mutex mBuffersMutex;
+	std::vector<std::unique_ptr<ProfilerThreadBuffer>> mThreadBuffers;
+	size_t mEventsPerThread = 65536;
+
+	// Reference points for converting ticks into microseconds:
+	uint64_t mEpochTicks = 0;
+	std::chrono::steady_clock::time_point mEpochTime;
+
+	thread_local ProfilerThreadBuffer* tThreadBuffer = nullptr;
+
+	ProfilerThreadBuffer* createBuffer()
+	{
+		auto buffer = std::make_unique<ProfilerThreadBuffer>();
+		buffer->events.resize(mEventsPerThread);
+		std::lock_guard<std::mutex> lock(mBuffersMutex);
+		buffer->threadId = static_cast<uint32_t>(mThreadBuffers.size());
+		mThreadBuffers.push_back(std::move(buffer));
+		return mThreadBuffers.back().get();
+	}
+
+	ProfilerThreadBuffer* getThreadBuffer()
+	{
+		if (nullptr == tThreadBuffer) {
+			tThreadBuffer = createBuffer();
+		}
+		return tThreadBuffer;
+	}
+
+	void pushEvent(ProfilerThreadBuffer* buffer, const ProfilerEvent& e)
+	{
+		const uint64_t index = buffer->writeCount.load(std::memory_order_relaxed);
+		buffer->events[index % buffer->events.size()] = e;
+		buffer->writeCount.store(index + 1, std::memory_order_release);
+	}
+
+	double ticksPerMicrosecond()
+	{
+#if PROFILER_USE_RDTSC
+		// Calibrate the TSC frequency against steady_clock over the whole time since profilerInit:
+		static thread_local uint64_t sLastCalibrationTicks = 0;
+		static thread_local double sTicksPerMicrosecond = 0.0;
+		const uint64_t ticks = profilerNow();
+		if (ticks - sLastCalibrationTicks > 100000000ull || sTicksPerMicrosecond <= 0.0) {
+			const double elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - mEpochTime).count();
+			if (elapsed_us > 0.0) {
+				sTicksPerMicrosecond = static_cast<double>(ticks - mEpochTicks) / elapsed_us;
+				sLastCalibrationTicks = ticks;
+			}
+		}
+		return sTicksPerMicrosecond > 0.0 ? sTicksPerMicrosecond : 1000.0;
+#else
+		return 1000.0; // steady_clock ticks are nanoseconds
+#endif
+	}
+
+	void writeJsonString(FILE* file, const char* str)
+	{
+		fputc('"', file);
+		for (const char* c = str; *c != '\0'; ++c) {
+			if (*c == '"' || *c == '\\') {
+				fputc('\\', file);
+			}
+			fputc(*c, file);
+		}
+		fputc('"', file);
+	}
+}
+
+void profilerInit(size_t events_per_thread)
+{
+	mEventsPerThread = events_per_thread > 0 ? events_per_thread : 1;
+	mEpochTime = std::chrono::steady_clock::now();
+	mEpochTicks = profilerNow();
+	profilerSetThreadName("Main Thread");
+}
+
+void profilerSetThreadName(const char* thread_name)
+{
+	getThreadBuffer()->threadName = thread_name;
+}
+
+uint64_t profilerNow()
+{
+#if PROFILER_USE_RDTSC
+	return __rdtsc();
+#else
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+double profilerTicksToMicroseconds(uint64_t ticks)
+{
+	return static_cast<double>(ticks) / ticksPerMicrosecond();
+}
+
+double profilerTimestampToMicroseconds(uint64_t timestamp)
+{
+	return profilerTicksToMicroseconds(timestamp - mEpochTicks);
+}
+
+void profilerRecordZone(const char* name, uint64_t begin_ticks, uint64_t end_ticks)
+{
+	pushEvent(getThreadBuffer(), ProfilerEvent{ name, begin_ticks, end_ticks });
+}
+
+uint32_t profilerCreateTrack(const char* track_name)
+{
+	ProfilerThreadBuffer* buffer = createBuffer();
+	buffer->threadName = track_name;
+	return buffer->threadId;
+}
+
+void profilerRecordTrackZone(uint32_t track, const char* name, double begin_us, double duration_us)
+{
+	ProfilerThreadBuffer* buffer;
+	{
+		std::lock_guard<std::mutex> lock(mBuffersMutex);
+		if (track >= mThreadBuffers.size()) {
+			return;
+		}
+		buffer = mThreadBuffers[track].get();
+	}
+	const double ticks_per_us = ticksPerMicrosecond();
+	const uint64_t begin = mEpochTicks + static_cast<uint64_t>((begin_us > 0.0 ? begin_us : 0.0) * ticks_per_us);
+	const uint64_t end = begin + static_cast<uint64_t>(duration_us * ticks_per_us);
+	pushEvent(buffer, ProfilerEvent{ name, begin, end });
+}
+
+bool profilerWriteChromeTrace(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if (nullptr == file) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(mBuffersMutex);
+	const double ticks_per_us = ticksPerMicrosecond();
+
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+	bool first = true;
+	for (const auto& buffer : mThreadBuffers) {
+		if (nullptr != buffer->threadName) {
+			fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+				first ? "" : ",\n", buffer->threadId);
+			writeJsonString(file, buffer->threadName);
+			fputs("}}", file);
+			first = false;
+		}
+
+		const uint64_t count = buffer->writeCount.load(std::memory_order_acquire);
+		const uint64_t capacity = buffer->events.size();
+		const uint64_t oldest = count > capacity ? count - capacity : 0;
+		for (uint64_t i = oldest; i < count; ++i) {
+			const ProfilerEvent& e = buffer->events[i % capacity];
+			const double ts = static_cast<double>(e.begin - mEpochTicks) / ticks_per_us;
+			const double dur = static_cast<double>(e.end - e.begin) / ticks_per_us;
+			fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+			writeJsonString(file, e.name);
+			fprintf(file, ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				buffer->threadId, ts, dur);
+			first = false;
+		}
+	}
+	fputs("\n]}\n", file);
+
+	return 0 == fclose(file);
+}
+
+void profilerShutdown()
+{
+	std::lock_guard<std::mutex> lock(mBuffersMutex);
+	mThreadBuffers.clear();
+	tThreadBuffer = nullptr;
+}
+
+#endif
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+/* --------------------------------------------- */
+// CPU Profiler
+//
+// Scoped zones are written into per-thread ring buffers without any locking
+// and can be exported in the Chrome trace event format, which can be opened
+// with chrome://tracing or https://ui.perfetto.dev.
+//
+// The profiler is compiled in if PROFILER_ENABLED is set to 1 (see the
+// ENABLE_PROFILER CMake option). Otherwise, all the PROFILER_* macros expand
+// to nothing and all functions are empty inline stubs.
+/* --------------------------------------------- */
+
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 0
+#endif
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+
+#if PROFILER_ENABLED
+
+/*!
+ *	Initializes the profiler. Must be called before any zones are recorded,
+ *	ideally as the very first thing in main.
+ *	@param	events_per_thread	Capacity of each thread's ring buffer. When a ring buffer is full,
+ *								the oldest events of that thread are overwritten.
+ */
+void profilerInit(size_t events_per_thread = 65536);
+
+/*!
+ *	Assigns a name to the calling thread, which is shown in the trace viewer.
+ *	@param	thread_name		Name of the thread. Must stay valid until the trace has been written.
+ */
+void profilerSetThreadName(const char* thread_name);
+
+/*!
+ *	Returns the current timestamp in profiler ticks (rdtsc on x86, std::chrono::steady_clock otherwise).
+ */
+uint64_t profilerNow();
+
+/*!
+ *	Converts a duration in profiler ticks into microseconds.
+ */
+double profilerTicksToMicroseconds(uint64_t ticks);
+
+/*!
+ *	Converts a timestamp in profiler ticks into microseconds since profilerInit.
+ */
+double profilerTimestampToMicroseconds(uint64_t timestamp);
+
+/*!
+ *	Records a completed zone into the calling thread's ring buffer.
+ *	@param	name			Name of the zone. Must stay valid until the trace has been written
+ *							(string literals are the intended use case).
+ *	@param	begin_ticks		Start timestamp, as returned by profilerNow()
+ *	@param	end_ticks		End timestamp, as returned by profilerNow()
+ */
+void profilerRecordZone(const char* name, uint64_t begin_ticks, uint64_t end_ticks);
+
+/*!
+ *	Creates an additional track which is not tied to a CPU thread, e.g. for GPU timings.
+ *	Zones are added to it with profilerRecordTrackZone.
+ *	@param	track_name		Name of the track. Must stay valid until the trace has been written.
+ *	@return	Identifier of the new track
+ */
+uint32_t profilerCreateTrack(const char* track_name);
+
+/*!
+ *	Records a completed zone on a track created with profilerCreateTrack.
+ *	Must always be called from the same thread for a given track.
+ *	@param	track			Identifier as returned by profilerCreateTrack
+ *	@param	name			Name of the zone. Must stay valid until the trace has been written.
+ *	@param	begin_us		Start time in microseconds since profilerInit
+ *	@param	duration_us		Duration in microseconds
+ */
+void profilerRecordTrackZone(uint32_t track, const char* name, double begin_us, double duration_us);
+
+/*!
+ *	Writes all recorded events of all threads into a JSON file in the Chrome trace event format.
+ *	Should be called while no other thread is recording zones.
+ *	@param	path	Path of the file to write
+ *	@return	True on success, false if the file could not be written.
+ */
+bool profilerWriteChromeTrace(const char* path);
+
+/*!
+ *	Frees all ring buffers. Recorded events are lost afterwards.
+ */
+void profilerShutdown();
+
+/*!
+ *	RAII helper which records a zone from its construction until its destruction
+ *	(or until end() is called, whichever happens first).
+ */
+class ProfilerZone
+{
+public:
+	explicit ProfilerZone(const char* name) : mName(name), mBegin(profilerNow()) {}
+	~ProfilerZone() { end(); }
+
+	void end()
+	{
+		if (nullptr != mName) {
+			profilerRecordZone(mName, mBegin, profilerNow());
+			mName = nullptr;
+		}
+	}
+
+	ProfilerZone(const ProfilerZone&) = delete;
+	ProfilerZone& operator=(const ProfilerZone&) = delete;
+
+private:
+	const char* mName;
+	uint64_t    mBegin;
+};
+
+//! Records a zone spanning the rest of the enclosing scope.
+#define PROFILER_ZONE(name)       ProfilerZone PROFILER_CONCAT(profiler_zone_, __LINE__)(name)
+//! Starts a zone which is ended explicitly with PROFILER_END(var), e.g., for sequential startup phases.
+#define PROFILER_BEGIN(var, name) ProfilerZone var(name)
+#define PROFILER_END(var)         var.end()
+
+#else
+
+inline void profilerInit(size_t = 0) {}
+inline void profilerSetThreadName(const char*) {}
+inline uint64_t profilerNow() { return 0; }
+inline double profilerTicksToMicroseconds(uint64_t) { return 0.0; }
+inline double profilerTimestampToMicroseconds(uint64_t) { return 0.0; }
+inline void profilerRecordZone(const char*, uint64_t, uint64_t) {}
+inline uint32_t profilerCreateTrack(const char*) { return 0; }
+inline void profilerRecordTrackZone(uint32_t, const char*, double, double) {}
+inline bool profilerWriteChromeTrace(const char*) { return false; }
+inline void profilerShutdown() {}
+
+#define PROFILER_ZONE(name)
+#define PROFILER_BEGIN(var, name)
+#define PROFILER_END(var)
+
+#endif
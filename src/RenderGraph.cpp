@@ -0,0 +1,862 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "RenderGraph.h"
+#include "VulkanHelpers.h"
+#include "GpuProfiler.h"
+#include <VulkanLaunchpad.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace
+{
+	constexpr uint32_t kNoPass = std::numeric_limits<uint32_t>::max();
+
+	constexpr VkAccessFlags kWriteAccessMask =
+		VK_ACCESS_SHADER_WRITE_BIT |
+		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+		VK_ACCESS_TRANSFER_WRITE_BIT |
+		VK_ACCESS_HOST_WRITE_BIT |
+		VK_ACCESS_MEMORY_WRITE_BIT;
+
+	// What a RenderGraphUsage means in terms of synchronization:
+	struct UsageInfo {
+		VkPipelineStageFlags stages;
+		VkAccessFlags        access;
+		VkImageLayout        layout;
+		VkImageUsageFlags    imageUsage;
+		bool                 write;
+	};
+
+	UsageInfo getUsageInfo(RenderGraphUsage usage)
+	{
+		switch (usage) {
+		case RENDER_GRAPH_USAGE_COLOR_ATTACHMENT:
+			return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true };
+		case RENDER_GRAPH_USAGE_DEPTH_ATTACHMENT:
+			return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+				VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true };
+		case RENDER_GRAPH_USAGE_DEPTH_ATTACHMENT_READ_ONLY:
+			return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, false };
+		case RENDER_GRAPH_USAGE_SAMPLED_FRAGMENT:
+			return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, false };
+		case RENDER_GRAPH_USAGE_SAMPLED_COMPUTE:
+			return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, false };
+		case RENDER_GRAPH_USAGE_STORAGE_READ_GRAPHICS:
+			return { VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+				VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, false };
+		case RENDER_GRAPH_USAGE_STORAGE_READ_COMPUTE:
+			return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+				VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, false };
+		case RENDER_GRAPH_USAGE_STORAGE_WRITE_COMPUTE:
+			return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+				VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, true };
+		case RENDER_GRAPH_USAGE_INDIRECT_READ:
+			return { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+				VK_IMAGE_LAYOUT_UNDEFINED, 0, false };
+		case RENDER_GRAPH_USAGE_TRANSFER_SRC:
+			return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, false };
+		case RENDER_GRAPH_USAGE_TRANSFER_DST:
+			return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, true };
+		case RENDER_GRAPH_USAGE_PRESENT:
+			return { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, false };
+		case RENDER_GRAPH_USAGE_NONE:
+		default:
+			return { 0, 0, VK_IMAGE_LAYOUT_UNDEFINED, 0, false };
+		}
+	}
+
+	struct Resource {
+		const char*          name;
+		bool                 isImage;
+		bool                 isTransient;
+		VkImage              image = VK_NULL_HANDLE;
+		VkImageView          imageView = VK_NULL_HANDLE;
+		VkBuffer             buffer = VK_NULL_HANDLE;
+		VkImageAspectFlags   aspectMask = 0;
+		RenderGraphImageDesc desc = {};
+		RenderGraphUsage     initialUsage = RENDER_GRAPH_USAGE_NONE;
+		bool                 isOutput = false;
+		RenderGraphUsage     finalUsage = RENDER_GRAPH_USAGE_NONE;
+
+		// Set by renderGraphCompile:
+		uint32_t             firstPass = kNoPass;
+		uint32_t             lastPass = kNoPass;
+		VkPipelineStageFlags allStages = 0;
+		VkAccessFlags        allWriteAccess = 0;
+		VkImageUsageFlags    imageUsage = 0;
+		VkMemoryRequirements memoryRequirements = {};
+		uint32_t             memoryBlock = kNoPass;
+	};
+
+	struct Access {
+		RenderGraphResource resource;
+		RenderGraphUsage    usage;
+	};
+
+	// All usages of one resource within one pass, combined:
+	struct CombinedAccess {
+		RenderGraphResource  resource;
+		VkPipelineStageFlags stages;
+		VkAccessFlags        access;
+		VkImageLayout        layout;
+		bool                 write;
+	};
+
+	struct Barrier {
+		RenderGraphResource  resource;
+		VkPipelineStageFlags srcStages;
+		VkPipelineStageFlags dstStages;
+		VkAccessFlags        srcAccess;
+		VkAccessFlags        dstAccess;
+		VkImageLayout        oldLayout;
+		VkImageLayout        newLayout;
+	};
+
+	struct Pass {
+		const char*                           name;
+		std::function<void(VkCommandBuffer)>  record;
+		std::vector<Access>                   accesses;
+		std::vector<CombinedAccess>           combinedAccesses;
+		std::vector<Barrier>                  barriers;
+		bool                                  sideEffects = false;
+		bool                                  culled = false;
+	};
+
+	// Synchronization state of a resource while barriers are being computed:
+	struct ResourceState {
+		VkImageLayout        layout = VK_IMAGE_LAYOUT_UNDEFINED;
+		VkPipelineStageFlags writeStages = 0;   // Stages of the most recent write (or layout transition)
+		VkAccessFlags        writeAccess = 0;   // Accesses of the most recent write, which must be made available
+		VkPipelineStageFlags readStages = 0;    // Stages which have read the resource since the most recent write
+		VkPipelineStageFlags visibleStages = 0; // Stages which the most recent write has been made visible to
+		VkAccessFlags        visibleAccess = 0; // Accesses which the most recent write has been made visible to
+	};
+
+	// A block of device memory which is shared by transient images with disjoint lifetimes:
+	struct MemoryBlock {
+		VkDeviceMemory                   memory = VK_NULL_HANDLE;
+		VkDeviceSize                     size = 0;
+		uint32_t                         memoryTypeBits = ~0u;
+		std::vector<RenderGraphResource> images; // Sorted by firstPass after compilation
+	};
+
+	struct Frame {
+		VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+		VkFence         fence = VK_NULL_HANDLE;
+	};
+
+	VkPhysicalDevice mPhysicalDevice = VK_NULL_HANDLE;
+	VkDevice mDevice = VK_NULL_HANDLE;
+	VkQueue mQueue = VK_NULL_HANDLE;
+	VkCommandPool mCommandPool = VK_NULL_HANDLE;
+	std::vector<Frame> mFrames;
+	uint64_t mFrameNumber = 0;
+
+#if defined(VK_KHR_synchronization2)
+	PFN_vkCmdPipelineBarrier2KHR mVkCmdPipelineBarrier2KHR = nullptr;
+	std::vector<VkImageMemoryBarrier2KHR> mImageBarriers2;
+#endif
+	std::vector<VkImageMemoryBarrier> mImageBarriers;
+
+	std::vector<Resource> mResources;
+	std::vector<Pass> mPasses;
+	std::vector<Barrier> mFinalBarriers;
+	std::vector<MemoryBlock> mMemoryBlocks;
+	RenderGraphStatistics mStatistics = {};
+	bool mCompiled = false;
+
+	void combineAccesses(Pass& pass)
+	{
+		pass.combinedAccesses.clear();
+		for (const Access& access : pass.accesses) {
+			const UsageInfo info = getUsageInfo(access.usage);
+			auto it = std::find_if(pass.combinedAccesses.begin(), pass.combinedAccesses.end(),
+				[&](const CombinedAccess& c) { return c.resource == access.resource; });
+			if (it == pass.combinedAccesses.end()) {
+				pass.combinedAccesses.push_back(CombinedAccess{ access.resource, info.stages, info.access, info.layout, info.write });
+			}
+			else {
+				it->stages |= info.stages;
+				it->access |= info.access;
+				it->layout = info.layout;
+				it->write = it->write || info.write;
+			}
+			mResources[access.resource].imageUsage |= info.imageUsage;
+		}
+	}
+
+	// Walks the passes backwards, starting at outputs and passes with side effects. A pass is
+	// kept if it writes a resource which a kept pass (or an output) depends on:
+	void cullPasses()
+	{
+		std::vector<bool> needed(mResources.size(), false);
+		for (size_t i = 0; i < mResources.size(); ++i) {
+			needed[i] = mResources[i].isOutput;
+		}
+		for (size_t p = mPasses.size(); p-- > 0; ) {
+			Pass& pass = mPasses[p];
+			bool keep = pass.sideEffects;
+			for (const CombinedAccess& access : pass.combinedAccesses) {
+				keep = keep || (access.write && needed[access.resource]);
+			}
+			pass.culled = !keep;
+			if (keep) {
+				// Read-modify-write is not distinguishable from a full overwrite => be conservative:
+				for (const CombinedAccess& access : pass.combinedAccesses) {
+					needed[access.resource] = true;
+				}
+			}
+		}
+	}
+
+	void computeLifetimes()
+	{
+		for (uint32_t p = 0; p < static_cast<uint32_t>(mPasses.size()); ++p) {
+			if (mPasses[p].culled) {
+				continue;
+			}
+			for (const CombinedAccess& access : mPasses[p].combinedAccesses) {
+				Resource& resource = mResources[access.resource];
+				resource.firstPass = std::min(resource.firstPass, p);
+				resource.lastPass = kNoPass == resource.lastPass ? p : std::max(resource.lastPass, p);
+				resource.allStages |= access.stages;
+				resource.allWriteAccess |= access.access & kWriteAccessMask;
+			}
+		}
+		// Outputs are consumed after the last pass:
+		for (Resource& resource : mResources) {
+			if (resource.isOutput) {
+				resource.lastPass = static_cast<uint32_t>(mPasses.size());
+				resource.firstPass = std::min(resource.firstPass, resource.lastPass);
+				resource.imageUsage |= getUsageInfo(resource.finalUsage).imageUsage;
+			}
+		}
+	}
+
+	uint32_t findDeviceLocalMemoryType(uint32_t memory_type_bits)
+	{
+		VkPhysicalDeviceMemoryProperties memory_properties;
+		vkGetPhysicalDeviceMemoryProperties(mPhysicalDevice, &memory_properties);
+		for (uint32_t i = 0; i < memory_properties.memoryTypeCount; ++i) {
+			if ((memory_type_bits & (1u << i)) != 0
+				&& (memory_properties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0) {
+				return i;
+			}
+		}
+		return kNoPass;
+	}
+
+	void createTransientImages()
+	{
+		std::vector<RenderGraphResource> transient_images;
+		for (RenderGraphResource r = 0; r < static_cast<RenderGraphResource>(mResources.size()); ++r) {
+			Resource& resource = mResources[r];
+			if (!resource.isTransient || kNoPass == resource.firstPass) {
+				continue; // Not used by any pass which survived culling
+			}
+
+			VkImageCreateInfo image_create_info = {};
+			image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			image_create_info.imageType = VK_IMAGE_TYPE_2D;
+			image_create_info.format = resource.desc.format;
+			image_create_info.extent = VkExtent3D{ resource.desc.extent.width, resource.desc.extent.height, 1 };
+			image_create_info.mipLevels = resource.desc.mipLevels;
+			image_create_info.arrayLayers = resource.desc.arrayLayers;
+			image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+			image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+			image_create_info.usage = resource.imageUsage;
+			image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			VkResult result = vkCreateImage(mDevice, &image_create_info, nullptr, &resource.image);
+			VKL_CHECK_VULKAN_RESULT(result);
+			hlpSetDebugUtilsObjectName(mDevice, VK_OBJECT_TYPE_IMAGE, (uint64_t)resource.image, resource.name);
+
+			vkGetImageMemoryRequirements(mDevice, resource.image, &resource.memoryRequirements);
+			transient_images.push_back(r);
+		}
+
+		// Greedily assign the largest images first to memory blocks whose images' lifetimes do not overlap:
+		std::sort(transient_images.begin(), transient_images.end(), [](RenderGraphResource a, RenderGraphResource b) {
+			return mResources[a].memoryRequirements.size > mResources[b].memoryRequirements.size;
+		});
+		for (RenderGraphResource r : transient_images) {
+			Resource& resource = mResources[r];
+			for (uint32_t b = 0; b < static_cast<uint32_t>(mMemoryBlocks.size()) && kNoPass == resource.memoryBlock; ++b) {
+				MemoryBlock& block = mMemoryBlocks[b];
+				const uint32_t common_bits = block.memoryTypeBits & resource.memoryRequirements.memoryTypeBits;
+				if (kNoPass == findDeviceLocalMemoryType(common_bits)) {
+					continue;
+				}
+				const bool overlaps = std::any_of(block.images.begin(), block.images.end(), [&](RenderGraphResource other) {
+					return mResources[other].firstPass <= resource.lastPass && resource.firstPass <= mResources[other].lastPass;
+				});
+				if (!overlaps) {
+					block.memoryTypeBits = common_bits;
+					block.images.push_back(r);
+					resource.memoryBlock = b;
+				}
+			}
+			if (kNoPass == resource.memoryBlock) {
+				resource.memoryBlock = static_cast<uint32_t>(mMemoryBlocks.size());
+				mMemoryBlocks.emplace_back();
+				mMemoryBlocks.back().memoryTypeBits = resource.memoryRequirements.memoryTypeBits;
+				mMemoryBlocks.back().images.push_back(r);
+			}
+			MemoryBlock& block = mMemoryBlocks[resource.memoryBlock];
+			block.size = std::max(block.size, resource.memoryRequirements.size);
+			mStatistics.transientMemoryBytesWithoutAliasing += resource.memoryRequirements.size;
+		}
+
+		// Every image is bound at offset 0 of its block, which satisfies any alignment requirement:
+		for (MemoryBlock& block : mMemoryBlocks) {
+			VkMemoryAllocateInfo memory_allocate_info = {};
+			memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			memory_allocate_info.allocationSize = block.size;
+			memory_allocate_info.memoryTypeIndex = findDeviceLocalMemoryType(block.memoryTypeBits);
+			VkResult result = MEMORY_TRACKER_ALLOCATE(mDevice, &memory_allocate_info, &block.memory, MEMORY_CATEGORY_RENDER_TARGETS, "Render Graph Transients");
+			VKL_CHECK_VULKAN_RESULT(result);
+			mStatistics.transientMemoryBytes += block.size;
+
+			std::sort(block.images.begin(), block.images.end(), [](RenderGraphResource a, RenderGraphResource b) {
+				return mResources[a].firstPass < mResources[b].firstPass;
+			});
+			for (RenderGraphResource r : block.images) {
+				Resource& resource = mResources[r];
+				result = vkBindImageMemory(mDevice, resource.image, block.memory, 0);
+				VKL_CHECK_VULKAN_RESULT(result);
+
+				VkImageViewCreateInfo image_view_create_info = {};
+				image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				image_view_create_info.image = resource.image;
+				image_view_create_info.viewType = resource.desc.arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+				image_view_create_info.format = resource.desc.format;
+				image_view_create_info.subresourceRange = { resource.aspectMask, 0, resource.desc.mipLevels, 0, resource.desc.arrayLayers };
+				result = vkCreateImageView(mDevice, &image_view_create_info, nullptr, &resource.imageView);
+				VKL_CHECK_VULKAN_RESULT(result);
+			}
+		}
+		mStatistics.numTransientImages = static_cast<uint32_t>(transient_images.size());
+	}
+
+	ResourceState getInitialState(const Resource& resource)
+	{
+		ResourceState state;
+		if (resource.isTransient) {
+			// The image's memory has been used by the previous image in its memory block before (or, for the first
+			// image of a block, by the last image of the previous frame). Those accesses must be complete:
+			const MemoryBlock& block = mMemoryBlocks[resource.memoryBlock];
+			const auto it = std::find(block.images.begin(), block.images.end(),
+				static_cast<RenderGraphResource>(&resource - mResources.data()));
+			const Resource& previous = mResources[it == block.images.begin() ? block.images.back() : *(it - 1)];
+			state.writeStages = previous.allStages;
+			state.writeAccess = previous.allWriteAccess;
+			return state;
+		}
+		const UsageInfo info = getUsageInfo(resource.initialUsage);
+		state.layout = info.layout;
+		state.writeStages = info.write ? info.stages : 0;
+		state.writeAccess = info.access & kWriteAccessMask;
+		state.readStages = info.write ? 0 : info.stages;
+		return state;
+	}
+
+	// Computes the barrier (if any) which is required before the given access and updates the resource's state.
+	// lookahead_stages/lookahead_access are the stages and accesses of subsequent reads in the same layout,
+	// which are made visible by the same barrier so that they need no barriers of their own.
+	bool computeBarrier(RenderGraphResource r, const CombinedAccess& access, VkPipelineStageFlags lookahead_stages,
+		VkAccessFlags lookahead_access, ResourceState& state, Barrier& barrier)
+	{
+		const Resource& resource = mResources[r];
+		const VkImageLayout new_layout = resource.isImage ? access.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+		const bool layout_transition = resource.isImage && new_layout != state.layout;
+
+		barrier = Barrier{ r, 0, access.stages, 0, access.access, state.layout, new_layout };
+		bool required = false;
+		if (access.write || layout_transition) {
+			// Write-after-read, write-after-write, and layout transitions must wait for all previous accesses:
+			barrier.srcStages = state.writeStages | state.readStages;
+			barrier.srcAccess = state.writeAccess;
+			required = layout_transition || 0 != barrier.srcStages;
+		}
+		else if ((access.stages & ~state.visibleStages) != 0 || (access.access & ~state.visibleAccess) != 0) {
+			// Read-after-write: the most recent write must be made visible to this read:
+			barrier.srcStages = state.writeStages;
+			barrier.srcAccess = state.writeAccess;
+			required = 0 != barrier.srcStages;
+		}
+
+		if (access.write) {
+			state.writeStages = access.stages;
+			state.writeAccess = access.access & kWriteAccessMask;
+			state.readStages = 0;
+			state.visibleStages = 0;
+			state.visibleAccess = 0;
+		}
+		else if (required) {
+			barrier.dstStages |= lookahead_stages;
+			barrier.dstAccess |= lookahead_access;
+			if (layout_transition) {
+				// The transition itself is a write, which happens before the barrier's destination stages:
+				state.writeStages = barrier.dstStages;
+				state.writeAccess = 0;
+				state.readStages = 0;
+				state.visibleStages = barrier.dstStages;
+				state.visibleAccess = barrier.dstAccess;
+			}
+			else {
+				state.visibleStages |= barrier.dstStages;
+				state.visibleAccess |= barrier.dstAccess;
+			}
+		}
+		state.readStages |= access.write ? 0 : access.stages;
+		state.layout = new_layout;
+		return required;
+	}
+
+	void computeBarriers()
+	{
+		std::vector<ResourceState> states(mResources.size());
+		for (size_t r = 0; r < mResources.size(); ++r) {
+			if (kNoPass != mResources[r].firstPass) {
+				states[r] = getInitialState(mResources[r]);
+			}
+		}
+
+		for (size_t p = 0; p < mPasses.size(); ++p) {
+			Pass& pass = mPasses[p];
+			pass.barriers.clear();
+			if (pass.culled) {
+				continue;
+			}
+			for (const CombinedAccess& access : pass.combinedAccesses) {
+				// Collect subsequent reads in the same layout up to the next write:
+				VkPipelineStageFlags lookahead_stages = 0;
+				VkAccessFlags lookahead_access = 0;
+				if (!access.write) {
+					bool done = false;
+					for (size_t q = p + 1; q < mPasses.size() && !done; ++q) {
+						if (mPasses[q].culled) {
+							continue;
+						}
+						for (const CombinedAccess& later : mPasses[q].combinedAccesses) {
+							if (later.resource != access.resource) {
+								continue;
+							}
+							done = later.write || (mResources[later.resource].isImage && later.layout != access.layout);
+							if (!done) {
+								lookahead_stages |= later.stages;
+								lookahead_access |= later.access;
+							}
+						}
+					}
+				}
+
+				Barrier barrier;
+				if (computeBarrier(access.resource, access, lookahead_stages, lookahead_access, states[access.resource], barrier)) {
+					pass.barriers.push_back(barrier);
+				}
+			}
+		}
+
+		// Bring all outputs into the usage in which they are consumed after the graph:
+		mFinalBarriers.clear();
+		for (RenderGraphResource r = 0; r < static_cast<RenderGraphResource>(mResources.size()); ++r) {
+			const Resource& resource = mResources[r];
+			if (!resource.isOutput) {
+				continue;
+			}
+			const UsageInfo info = getUsageInfo(resource.finalUsage);
+			const CombinedAccess access = { r, info.stages, info.access, info.layout, info.write };
+			Barrier barrier;
+			if (computeBarrier(r, access, 0, 0, states[r], barrier)) {
+				mFinalBarriers.push_back(barrier);
+			}
+		}
+	}
+
+	void recordBarriers(VkCommandBuffer command_buffer, const std::vector<Barrier>& barriers)
+	{
+		if (barriers.empty()) {
+			return;
+		}
+
+#if defined(VK_KHR_synchronization2)
+		if (nullptr != mVkCmdPipelineBarrier2KHR) {
+			// synchronization2 allows individual stage masks per barrier:
+			VkMemoryBarrier2KHR memory_barrier = {};
+			memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+			mImageBarriers2.clear();
+			for (const Barrier& b : barriers) {
+				const Resource& resource = mResources[b.resource];
+				if (!resource.isImage) {
+					// Buffer hazards are merged into one global memory barrier:
+					memory_barrier.srcStageMask |= b.srcStages;
+					memory_barrier.dstStageMask |= b.dstStages;
+					memory_barrier.srcAccessMask |= b.srcAccess;
+					memory_barrier.dstAccessMask |= b.dstAccess;
+					continue;
+				}
+				VkImageMemoryBarrier2KHR image_barrier = {};
+				image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+				image_barrier.srcStageMask = b.srcStages;
+				image_barrier.srcAccessMask = b.srcAccess;
+				image_barrier.dstStageMask = b.dstStages;
+				image_barrier.dstAccessMask = b.dstAccess;
+				image_barrier.oldLayout = b.oldLayout;
+				image_barrier.newLayout = b.newLayout;
+				image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				image_barrier.image = resource.image;
+				image_barrier.subresourceRange = { resource.aspectMask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+				mImageBarriers2.push_back(image_barrier);
+			}
+
+			VkDependencyInfoKHR dependency_info = {};
+			dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+			dependency_info.memoryBarrierCount = (0 != memory_barrier.dstStageMask) ? 1 : 0;
+			dependency_info.pMemoryBarriers = &memory_barrier;
+			dependency_info.imageMemoryBarrierCount = static_cast<uint32_t>(mImageBarriers2.size());
+			dependency_info.pImageMemoryBarriers = mImageBarriers2.data();
+			mVkCmdPipelineBarrier2KHR(command_buffer, &dependency_info);
+			return;
+		}
+#endif
+
+		// Without synchronization2, all barriers of a batch share the union of their stage masks:
+		VkPipelineStageFlags src_stages = 0;
+		VkPipelineStageFlags dst_stages = 0;
+		VkMemoryBarrier memory_barrier = {};
+		memory_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		bool has_memory_barrier = false;
+		mImageBarriers.clear();
+		for (const Barrier& b : barriers) {
+			const Resource& resource = mResources[b.resource];
+			src_stages |= b.srcStages;
+			dst_stages |= b.dstStages;
+			if (!resource.isImage) {
+				memory_barrier.srcAccessMask |= b.srcAccess;
+				memory_barrier.dstAccessMask |= b.dstAccess;
+				has_memory_barrier = true;
+				continue;
+			}
+			VkImageMemoryBarrier image_barrier = {};
+			image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			image_barrier.srcAccessMask = b.srcAccess;
+			image_barrier.dstAccessMask = b.dstAccess;
+			image_barrier.oldLayout = b.oldLayout;
+			image_barrier.newLayout = b.newLayout;
+			image_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			image_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			image_barrier.image = resource.image;
+			image_barrier.subresourceRange = { resource.aspectMask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+			mImageBarriers.push_back(image_barrier);
+		}
+		vkCmdPipelineBarrier(command_buffer,
+			0 != src_stages ? src_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			0 != dst_stages ? dst_stages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0,
+			has_memory_barrier ? 1 : 0, &memory_barrier,
+			0, nullptr,
+			static_cast<uint32_t>(mImageBarriers.size()), mImageBarriers.data());
+	}
+
+	void countBarriers(const std::vector<Barrier>& barriers)
+	{
+		if (barriers.empty()) {
+			return;
+		}
+		++mStatistics.numBarrierBatches;
+		for (const Barrier& b : barriers) {
+			if (mResources[b.resource].isImage) {
+				++mStatistics.numImageBarriers;
+			}
+			else {
+				++mStatistics.numBufferBarriers;
+			}
+		}
+	}
+
+	void destroyTransientImages()
+	{
+		for (Resource& resource : mResources) {
+			if (!resource.isTransient) {
+				continue;
+			}
+			if (VK_NULL_HANDLE != resource.imageView) {
+				vkDestroyImageView(mDevice, resource.imageView, nullptr);
+			}
+			if (VK_NULL_HANDLE != resource.image) {
+				vkDestroyImage(mDevice, resource.image, nullptr);
+			}
+			resource.imageView = VK_NULL_HANDLE;
+			resource.image = VK_NULL_HANDLE;
+		}
+		for (MemoryBlock& block : mMemoryBlocks) {
+			memoryTrackerFree(mDevice, block.memory);
+		}
+		mMemoryBlocks.clear();
+	}
+}
+
+void renderGraphCreate(VkPhysicalDevice physical_device, VkDevice device, VkQueue queue, uint32_t queue_family_index,
+	uint32_t num_frames, bool synchronization2_enabled)
+{
+	mPhysicalDevice = physical_device;
+	mDevice = device;
+	mQueue = queue;
+
+#if defined(VK_KHR_synchronization2)
+	if (synchronization2_enabled) {
+		mVkCmdPipelineBarrier2KHR = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2KHR"));
+	}
+	VKL_LOG("Render graph records barriers with " << (nullptr != mVkCmdPipelineBarrier2KHR ? "vkCmdPipelineBarrier2KHR." : "vkCmdPipelineBarrier."));
+#endif
+
+	VkCommandPoolCreateInfo command_pool_create_info = {};
+	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	command_pool_create_info.queueFamilyIndex = queue_family_index;
+	VkResult result = vkCreateCommandPool(device, &command_pool_create_info, nullptr, &mCommandPool);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	mFrames.resize(std::max(num_frames, 1u));
+	for (Frame& frame : mFrames) {
+		VkCommandBufferAllocateInfo command_buffer_alloc_info = {};
+		command_buffer_alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		command_buffer_alloc_info.commandPool = mCommandPool;
+		command_buffer_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		command_buffer_alloc_info.commandBufferCount = 1;
+		result = vkAllocateCommandBuffers(device, &command_buffer_alloc_info, &frame.commandBuffer);
+		VKL_CHECK_VULKAN_RESULT(result);
+
+		VkFenceCreateInfo fence_create_info = {};
+		fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+		result = vkCreateFence(device, &fence_create_info, nullptr, &frame.fence);
+		VKL_CHECK_VULKAN_RESULT(result);
+	}
+}
+
+void renderGraphDestroy()
+{
+	renderGraphReset();
+	for (Frame& frame : mFrames) {
+		vkDestroyFence(mDevice, frame.fence, nullptr);
+	}
+	mFrames.clear();
+	if (VK_NULL_HANDLE != mCommandPool) {
+		vkDestroyCommandPool(mDevice, mCommandPool, nullptr);
+		mCommandPool = VK_NULL_HANDLE;
+	}
+#if defined(VK_KHR_synchronization2)
+	mVkCmdPipelineBarrier2KHR = nullptr;
+#endif
+}
+
+void renderGraphReset()
+{
+	destroyTransientImages();
+	mResources.clear();
+	mPasses.clear();
+	mFinalBarriers.clear();
+	mStatistics = {};
+	mCompiled = false;
+}
+
+RenderGraphResource renderGraphImportImage(const char* name, VkImage image, VkImageView image_view, VkImageAspectFlags aspect_mask,
+	RenderGraphUsage initial_usage)
+{
+	Resource resource = {};
+	resource.name = name;
+	resource.isImage = true;
+	resource.isTransient = false;
+	resource.image = image;
+	resource.imageView = image_view;
+	resource.aspectMask = aspect_mask;
+	resource.initialUsage = initial_usage;
+	mResources.push_back(resource);
+	mCompiled = false;
+	return static_cast<RenderGraphResource>(mResources.size() - 1);
+}
+
+RenderGraphResource renderGraphImportBuffer(const char* name, VkBuffer buffer, RenderGraphUsage initial_usage)
+{
+	Resource resource = {};
+	resource.name = name;
+	resource.isImage = false;
+	resource.isTransient = false;
+	resource.buffer = buffer;
+	resource.initialUsage = initial_usage;
+	mResources.push_back(resource);
+	mCompiled = false;
+	return static_cast<RenderGraphResource>(mResources.size() - 1);
+}
+
+void renderGraphSetImportedImage(RenderGraphResource resource, VkImage image, VkImageView image_view)
+{
+	mResources[resource].image = image;
+	mResources[resource].imageView = image_view;
+}
+
+void renderGraphSetImportedBuffer(RenderGraphResource resource, VkBuffer buffer)
+{
+	mResources[resource].buffer = buffer;
+}
+
+RenderGraphResource renderGraphCreateTransientImage(const char* name, const RenderGraphImageDesc& desc)
+{
+	Resource resource = {};
+	resource.name = name;
+	resource.isImage = true;
+	resource.isTransient = true;
+	resource.aspectMask = desc.aspectMask;
+	resource.desc = desc;
+	mResources.push_back(resource);
+	mCompiled = false;
+	return static_cast<RenderGraphResource>(mResources.size() - 1);
+}
+
+RenderGraphPass renderGraphAddPass(const char* name, std::function<void(VkCommandBuffer)> record_callback)
+{
+	Pass pass;
+	pass.name = name;
+	pass.record = std::move(record_callback);
+	mPasses.push_back(std::move(pass));
+	mCompiled = false;
+	return static_cast<RenderGraphPass>(mPasses.size() - 1);
+}
+
+void renderGraphUseResource(RenderGraphPass pass, RenderGraphResource resource, RenderGraphUsage usage)
+{
+	mPasses[pass].accesses.push_back(Access{ resource, usage });
+	mCompiled = false;
+}
+
+void renderGraphSetPassSideEffects(RenderGraphPass pass)
+{
+	mPasses[pass].sideEffects = true;
+	mCompiled = false;
+}
+
+void renderGraphMarkOutput(RenderGraphResource resource, RenderGraphUsage final_usage)
+{
+	mResources[resource].isOutput = true;
+	mResources[resource].finalUsage = final_usage;
+	mCompiled = false;
+}
+
+void renderGraphCompile()
+{
+	destroyTransientImages();
+	mStatistics = {};
+	for (Resource& resource : mResources) {
+		resource.firstPass = kNoPass;
+		resource.lastPass = kNoPass;
+		resource.allStages = 0;
+		resource.allWriteAccess = 0;
+		resource.imageUsage = 0;
+		resource.memoryBlock = kNoPass;
+	}
+
+	for (Pass& pass : mPasses) {
+		combineAccesses(pass);
+	}
+	cullPasses();
+	computeLifetimes();
+	createTransientImages();
+	computeBarriers();
+
+	mStatistics.numPasses = static_cast<uint32_t>(mPasses.size());
+	for (const Pass& pass : mPasses) {
+		if (pass.culled) {
+			++mStatistics.numCulledPasses;
+			VKL_LOG("Render graph: culled pass \"" << pass.name << "\", its results are never used.");
+		}
+		countBarriers(pass.barriers);
+	}
+	countBarriers(mFinalBarriers);
+	mCompiled = true;
+
+	VKL_LOG("Render graph compiled: " << mStatistics.numPasses << " passes (" << mStatistics.numCulledPasses << " culled), "
+		<< mStatistics.numBarrierBatches << " barrier batches with " << mStatistics.numImageBarriers << " image and "
+		<< mStatistics.numBufferBarriers << " buffer barriers, " << mStatistics.numTransientImages << " transient images in "
+		<< (mStatistics.transientMemoryBytes / 1024) << " KiB (" << (mStatistics.transientMemoryBytesWithoutAliasing / 1024)
+		<< " KiB without aliasing).");
+}
+
+void renderGraphExecute()
+{
+	if (!mCompiled || mFrames.empty()) {
+		return;
+	}
+	const bool has_passes = std::any_of(mPasses.begin(), mPasses.end(), [](const Pass& pass) { return !pass.culled; });
+	if (!has_passes && mFinalBarriers.empty()) {
+		return;
+	}
+
+	Frame& frame = mFrames[mFrameNumber++ % mFrames.size()];
+	// Usually signaled long ago, since the framework waits for older frames before acquiring the next image:
+	vkWaitForFences(mDevice, 1, &frame.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+	vkResetFences(mDevice, 1, &frame.fence);
+
+	VkResult result = vkResetCommandBuffer(frame.commandBuffer, 0);
+	VKL_CHECK_VULKAN_RESULT(result);
+	VkCommandBufferBeginInfo begin_info = {};
+	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	result = vkBeginCommandBuffer(frame.commandBuffer, &begin_info);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	for (Pass& pass : mPasses) {
+		if (pass.culled) {
+			continue;
+		}
+		recordBarriers(frame.commandBuffer, pass.barriers);
+		hlpBeginDebugUtilsLabel(frame.commandBuffer, pass.name);
+		gpuProfilerBeginScope(frame.commandBuffer, pass.name);
+		pass.record(frame.commandBuffer);
+		gpuProfilerEndScope(frame.commandBuffer);
+		hlpEndDebugUtilsLabel(frame.commandBuffer);
+	}
+	recordBarriers(frame.commandBuffer, mFinalBarriers);
+
+	result = vkEndCommandBuffer(frame.commandBuffer);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	VkSubmitInfo submit_info = {};
+	submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers = &frame.commandBuffer;
+	result = vkQueueSubmit(mQueue, 1, &submit_info, frame.fence);
+	VKL_CHECK_VULKAN_RESULT(result);
+}
+
+VkImage renderGraphGetImage(RenderGraphResource resource)
+{
+	return mResources[resource].image;
+}
+
+VkImageView renderGraphGetImageView(RenderGraphResource resource)
+{
+	return mResources[resource].imageView;
+}
+
+VkBuffer renderGraphGetBuffer(RenderGraphResource resource)
+{
+	return mResources[resource].buffer;
+}
+
+RenderGraphStatistics renderGraphGetStatistics()
+{
+	return mStatistics;
+}
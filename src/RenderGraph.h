@@ -0,0 +1,246 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <functional>
+
+/* --------------------------------------------- */
+// Render Graph
+//
+// Passes declare which resources (images and buffers) they access and how.
+// From these declarations, the render graph
+//  - culls passes whose results are never used,
+//  - computes the barriers which are required between passes, and records
+//    all barriers in front of a pass with one single barrier call
+//    (vkCmdPipelineBarrier2KHR if VK_KHR_synchronization2 is enabled,
+//    vkCmdPipelineBarrier otherwise), and
+//  - creates transient images and lets images whose lifetimes do not
+//    overlap share the same memory.
+//
+// The graph is declared and compiled once and then executed every frame.
+// All passes are recorded into the render graph's own command buffer, which
+// is submitted before the framework's command buffer of the same frame. The
+// framework's render pass (into the swapchain image) is the graph's sink:
+// everything it consumes must be marked with renderGraphMarkOutput.
+/* --------------------------------------------- */
+
+//! Handle to a resource of the render graph. Only valid until renderGraphReset is called.
+typedef uint32_t RenderGraphResource;
+
+//! Handle to a pass of the render graph. Only valid until renderGraphReset is called.
+typedef uint32_t RenderGraphPass;
+
+/*!
+ *	Describes how a pass accesses a resource. Each usage implies pipeline stages, memory accesses,
+ *	and (for images) the image layout which the resource must be in during the pass.
+ */
+enum RenderGraphUsage {
+	//! No access; undefined contents. Used as initial usage of imported resources.
+	RENDER_GRAPH_USAGE_NONE,
+	//! Written as color attachment
+	RENDER_GRAPH_USAGE_COLOR_ATTACHMENT,
+	//! Depth-tested and written as depth/stencil attachment
+	RENDER_GRAPH_USAGE_DEPTH_ATTACHMENT,
+	//! Depth-tested against, but not written (read-only depth/stencil attachment)
+	RENDER_GRAPH_USAGE_DEPTH_ATTACHMENT_READ_ONLY,
+	//! Sampled in a fragment shader
+	RENDER_GRAPH_USAGE_SAMPLED_FRAGMENT,
+	//! Sampled in a compute shader
+	RENDER_GRAPH_USAGE_SAMPLED_COMPUTE,
+	//! Read as storage image or storage buffer in a vertex or fragment shader
+	RENDER_GRAPH_USAGE_STORAGE_READ_GRAPHICS,
+	//! Read as storage image or storage buffer in a compute shader
+	RENDER_GRAPH_USAGE_STORAGE_READ_COMPUTE,
+	//! Read and written as storage image or storage buffer in a compute shader
+	RENDER_GRAPH_USAGE_STORAGE_WRITE_COMPUTE,
+	//! Read as indirect draw/dispatch arguments
+	RENDER_GRAPH_USAGE_INDIRECT_READ,
+	//! Source of a copy or blit
+	RENDER_GRAPH_USAGE_TRANSFER_SRC,
+	//! Destination of a copy, blit, or clear
+	RENDER_GRAPH_USAGE_TRANSFER_DST,
+	//! Presented to the screen
+	RENDER_GRAPH_USAGE_PRESENT,
+};
+
+/*!
+ *	Describes a transient image, i.e., an image which is created and owned by the render graph
+ *	and whose contents only live during one frame.
+ */
+struct RenderGraphImageDesc {
+	//! The image's format
+	VkFormat format;
+
+	//! The image's width and height
+	VkExtent2D extent;
+
+	//! The aspect(s) of the image, e.g. VK_IMAGE_ASPECT_COLOR_BIT or VK_IMAGE_ASPECT_DEPTH_BIT
+	VkImageAspectFlags aspectMask;
+
+	//! Number of mip levels. Barriers always apply to all of them.
+	uint32_t mipLevels = 1;
+
+	//! Number of array layers. Barriers always apply to all of them.
+	uint32_t arrayLayers = 1;
+};
+
+/*!
+ *	Statistics of the most recent renderGraphCompile call.
+ */
+struct RenderGraphStatistics {
+	//! Number of passes which have been added
+	uint32_t numPasses;
+
+	//! Number of passes which have been culled, because nothing uses their results
+	uint32_t numCulledPasses;
+
+	//! Number of barrier calls recorded per frame (one per pass at most, plus one for the outputs)
+	uint32_t numBarrierBatches;
+
+	//! Number of image memory barriers recorded per frame
+	uint32_t numImageBarriers;
+
+	//! Number of buffer hazards per frame. They are merged into one global memory barrier per batch.
+	uint32_t numBufferBarriers;
+
+	//! Number of transient images
+	uint32_t numTransientImages;
+
+	//! Device memory allocated for transient images
+	VkDeviceSize transientMemoryBytes;
+
+	//! Device memory which transient images would require without aliasing
+	VkDeviceSize transientMemoryBytesWithoutAliasing;
+};
+
+/*!
+ *	Creates the render graph's command buffers. Must be called after the framework has been initialized.
+ *	@param	physical_device				Physical device, used to select memory types for transient images
+ *	@param	device						Device handle
+ *	@param	queue						The queue which the graph's command buffers are submitted to.
+ *										Must be the same queue which the framework submits to.
+ *	@param	queue_family_index			The queue's family index
+ *	@param	num_frames					Number of frames which can be in flight at the same time
+ *	@param	synchronization2_enabled	True if VK_KHR_synchronization2 and its synchronization2 feature have
+ *										been enabled on the device. Barriers are recorded with
+ *										vkCmdPipelineBarrier2KHR then, which has per-barrier stage masks.
+ */
+void renderGraphCreate(VkPhysicalDevice physical_device, VkDevice device, VkQueue queue, uint32_t queue_family_index,
+	uint32_t num_frames, bool synchronization2_enabled);
+
+/*!
+ *	Destroys all passes, resources, and command buffers of the render graph. The device must be idle.
+ */
+void renderGraphDestroy();
+
+/*!
+ *	Removes all passes and resources, and destroys all transient images. The device must be idle.
+ *	Afterwards, a new graph can be declared and compiled.
+ */
+void renderGraphReset();
+
+/*!
+ *	Adds a resource which is not owned by the render graph, e.g. a swapchain image or a buffer
+ *	which is uploaded from the host.
+ *	@param	name			Name of the resource, used in debug output. Must stay valid until renderGraphReset.
+ *	@param	image			The image. Can be changed per frame with renderGraphSetImportedImage.
+ *	@param	image_view		A view of the image, or VK_NULL_HANDLE
+ *	@param	aspect_mask		The aspect(s) of the image which barriers apply to
+ *	@param	initial_usage	The usage which the image is in at the beginning of each frame
+ *	@return	Handle to the new resource
+ */
+RenderGraphResource renderGraphImportImage(const char* name, VkImage image, VkImageView image_view, VkImageAspectFlags aspect_mask,
+	RenderGraphUsage initial_usage = RENDER_GRAPH_USAGE_NONE);
+
+/*!
+ *	Adds a buffer which is not owned by the render graph.
+ *	@param	name			Name of the resource, used in debug output. Must stay valid until renderGraphReset.
+ *	@param	buffer			The buffer. Can be changed per frame with renderGraphSetImportedBuffer.
+ *	@param	initial_usage	The usage which the buffer is in at the beginning of each frame
+ *	@return	Handle to the new resource
+ */
+RenderGraphResource renderGraphImportBuffer(const char* name, VkBuffer buffer, RenderGraphUsage initial_usage = RENDER_GRAPH_USAGE_NONE);
+
+/*!
+ *	Exchanges the image of an imported image resource, e.g. for the current frame's swapchain image.
+ */
+void renderGraphSetImportedImage(RenderGraphResource resource, VkImage image, VkImageView image_view);
+
+/*!
+ *	Exchanges the buffer of an imported buffer resource.
+ */
+void renderGraphSetImportedBuffer(RenderGraphResource resource, VkBuffer buffer);
+
+/*!
+ *	Declares a transient image. The image is created by renderGraphCompile with the usage flags
+ *	that all passes' declared usages require. Its contents are undefined at the beginning of each frame.
+ *	@param	name			Name of the resource, used in debug output. Must stay valid until renderGraphReset.
+ *	@param	desc			Format, extent, aspects, mip levels, and array layers of the image
+ *	@return	Handle to the new resource
+ */
+RenderGraphResource renderGraphCreateTransientImage(const char* name, const RenderGraphImageDesc& desc);
+
+/*!
+ *	Adds a pass. Passes are executed in the order in which they have been added.
+ *	@param	name				Name of the pass, used for debug labels and GPU profiler scopes.
+ *								Must stay valid until renderGraphReset.
+ *	@param	record_callback		Records the pass' commands into the given command buffer. The callback
+ *								is responsible for beginning and ending render passes, if it needs any.
+ *	@return	Handle to the new pass
+ */
+RenderGraphPass renderGraphAddPass(const char* name, std::function<void(VkCommandBuffer)> record_callback);
+
+/*!
+ *	Declares that the given pass accesses the given resource with the given usage.
+ *	A pass can use the same resource multiple times (e.g., read and write); it is then
+ *	transitioned into the layout of the most recently declared usage.
+ */
+void renderGraphUseResource(RenderGraphPass pass, RenderGraphResource resource, RenderGraphUsage usage);
+
+/*!
+ *	Declares that the given pass must never be culled, e.g., because it writes into host-visible memory.
+ */
+void renderGraphSetPassSideEffects(RenderGraphPass pass);
+
+/*!
+ *	Declares that the given resource is consumed after the graph has been executed, e.g., by the
+ *	framework's render pass. Passes which contribute to outputs are never culled. After the last pass,
+ *	outputs are transitioned into the given usage.
+ */
+void renderGraphMarkOutput(RenderGraphResource resource, RenderGraphUsage final_usage);
+
+/*!
+ *	Culls unused passes, computes barriers, and creates transient images and their (aliased) memory.
+ *	Must be called after all passes and resources have been declared and before renderGraphExecute.
+ */
+void renderGraphCompile();
+
+/*!
+ *	Records all passes which have not been culled, together with their barriers, into the next of the
+ *	render graph's command buffers and submits it. Must be called every frame before the framework's
+ *	command buffer of that frame is submitted (i.e., before vklEndRecordingCommands).
+ *	Does nothing if there is nothing to record.
+ */
+void renderGraphExecute();
+
+/*!
+ *	Returns the image of the given resource (transient images are only available after renderGraphCompile).
+ */
+VkImage renderGraphGetImage(RenderGraphResource resource);
+
+/*!
+ *	Returns a view of all mip levels and layers of the given image resource.
+ */
+VkImageView renderGraphGetImageView(RenderGraphResource resource);
+
+/*!
+ *	Returns the buffer of the given resource.
+ */
+VkBuffer renderGraphGetBuffer(RenderGraphResource resource);
+
+/*!
+ *	Returns the statistics of the most recent renderGraphCompile call.
+ */
+RenderGraphStatistics renderGraphGetStatistics();
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "RenderOnDemand.h"
+#include "Profiler.h"
+#include <VulkanLaunchpad.h>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+	// While background work is pending, the loop wakes up this often to run its main-thread jobs:
+	constexpr double kWorkPendingTimeoutSeconds = 0.005;
+
+	using Clock = std::chrono::steady_clock;
+	using Seconds = std::chrono::duration<double>;
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+
+	GLFWwindow* mWindow = nullptr;
+	double mMaxIdleSeconds = 0.0;
+
+	bool mInvalidated = true;
+	bool mRenderedPreviousIteration = true;
+	uint64_t mRenderedHash = 0;
+	Clock::time_point mLastPresentTime;
+
+	// Set if an event has ended a wait, until the resulting frame has been presented or skipped:
+	bool mWokenByEvent = false;
+	Clock::time_point mWakeTime;
+
+	RenderOnDemandStatistics mStatistics = {};
+	double mTotalWakeLatencyMilliseconds = 0.0;
+	uint64_t mNumWakeLatencies = 0;
+
+	void handleWindowRefresh(GLFWwindow* window)
+	{
+		renderOnDemandInvalidate();
+	}
+}
+
+void renderOnDemandCreate(GLFWwindow* window, double max_idle_seconds)
+{
+	mWindow = window;
+	mMaxIdleSeconds = std::max(max_idle_seconds, 0.0);
+	mInvalidated = true;
+	mRenderedPreviousIteration = true;
+	mLastPresentTime = Clock::now();
+	mWokenByEvent = false;
+	mStatistics = {};
+	mTotalWakeLatencyMilliseconds = 0.0;
+	mNumWakeLatencies = 0;
+	glfwSetWindowRefreshCallback(window, handleWindowRefresh);
+}
+
+void renderOnDemandDestroy()
+{
+	glfwSetWindowRefreshCallback(mWindow, nullptr);
+	mWindow = nullptr;
+}
+
+void renderOnDemandHandleEvents(bool work_pending)
+{
+	if (mRenderedPreviousIteration) {
+		glfwPollEvents();
+		return;
+	}
+
+	// Wait until the next event, but no longer than until the idle interval ends. Only wait without a timeout if there is
+	// neither an idle interval nor pending work. An idle interval which has already ended only polls:
+	const bool wait_indefinitely = !work_pending && mMaxIdleSeconds <= 0.0;
+	double timeout = work_pending ? kWorkPendingTimeoutSeconds : 0.0;
+	if (mMaxIdleSeconds > 0.0) {
+		const double remaining = std::max(0.0, mMaxIdleSeconds - Seconds(Clock::now() - mLastPresentTime).count());
+		timeout = work_pending ? std::min(timeout, remaining) : remaining;
+	}
+
+	PROFILER_ZONE("Wait For Events");
+	const Clock::time_point wait_start = Clock::now();
+	if (wait_indefinitely) {
+		glfwWaitEvents();
+	}
+	else if (timeout > 0.0) {
+		glfwWaitEventsTimeout(timeout);
+	}
+	else {
+		glfwPollEvents();
+	}
+	const Clock::time_point wait_end = Clock::now();
+	const double waited = Seconds(wait_end - wait_start).count();
+	mStatistics.idleSeconds += waited;
+
+	// GLFW does not tell why a wait has ended. If it ended early, an event has arrived:
+	if (wait_indefinitely || (timeout > 0.0 && waited < timeout)) {
+		mWokenByEvent = true;
+		mWakeTime = wait_end;
+	}
+}
+
+uint64_t renderOnDemandHash(uint64_t hash, const void* data, size_t size)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; ++i) {
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+void renderOnDemandInvalidate()
+{
+	mInvalidated = true;
+}
+
+bool renderOnDemandShouldRender(uint64_t state_hash)
+{
+	const bool idle_interval_elapsed = mMaxIdleSeconds > 0.0 && Seconds(Clock::now() - mLastPresentTime).count() >= mMaxIdleSeconds;
+	const bool render = mInvalidated || state_hash != mRenderedHash || idle_interval_elapsed;
+	if (render) {
+		mRenderedHash = state_hash;
+		mInvalidated = false;
+		++mStatistics.numRendered;
+	}
+	else {
+		// Events which have not changed anything, e.g., mouse movement without a pressed button, have no latency:
+		mWokenByEvent = false;
+		++mStatistics.numSkipped;
+	}
+	mRenderedPreviousIteration = render;
+	return render;
+}
+
+void renderOnDemandFramePresented()
+{
+	mLastPresentTime = Clock::now();
+	if (mWokenByEvent) {
+		const double latency = Milliseconds(mLastPresentTime - mWakeTime).count();
+		mTotalWakeLatencyMilliseconds += latency;
+		++mNumWakeLatencies;
+		mStatistics.maxWakeLatencyMilliseconds = std::max(mStatistics.maxWakeLatencyMilliseconds, latency);
+		mWokenByEvent = false;
+	}
+}
+
+RenderOnDemandStatistics renderOnDemandGetStatistics()
+{
+	RenderOnDemandStatistics statistics = mStatistics;
+	statistics.meanWakeLatencyMilliseconds = mNumWakeLatencies > 0 ? mTotalWakeLatencyMilliseconds / mNumWakeLatencies : 0.0;
+	return statistics;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+struct GLFWwindow;
+
+/* --------------------------------------------- */
+// Render On Demand
+//
+// Renders only frames which differ from the last presented one. Every
+// iteration of the render loop hashes everything which determines the image
+// (camera, scene graph version, pipelines, animation time, ...) and renders
+// only if the hash has changed, if the frame has been invalidated, e.g., by
+// the window system, or if the maximum idle interval has elapsed.
+//
+// After an iteration which has rendered, events are polled, since input
+// which is held down (e.g., a camera movement key) keeps changing the image
+// without generating new events. After an iteration which has not rendered,
+// the loop blocks in glfwWaitEventsTimeout until the next event, the end of
+// the idle interval, or, while background jobs are pending, a short timeout.
+/* --------------------------------------------- */
+
+/*!
+ *	Counters since renderOnDemandCreate.
+ */
+struct RenderOnDemandStatistics {
+	//! Iterations which have rendered and presented a frame
+	uint64_t numRendered;
+
+	//! Iterations which have been skipped because nothing visibly changed
+	uint64_t numSkipped;
+
+	//! Time spent blocked in glfwWaitEventsTimeout, in seconds
+	double idleSeconds;
+
+	//! Time from an event waking the loop to the presentation of the resulting frame, averaged, in milliseconds
+	double meanWakeLatencyMilliseconds;
+
+	//! Maximum of the wake latencies, in milliseconds
+	double maxWakeLatencyMilliseconds;
+};
+
+/*!
+ *	Starts on-demand rendering for the given window. The first frame always renders.
+ *	@param	window				The window whose events are waited for; its refresh callback is set to invalidate the frame
+ *	@param	max_idle_seconds	A frame is rendered at least this often, even if nothing has changed. 0 means never.
+ */
+void renderOnDemandCreate(GLFWwindow* window, double max_idle_seconds);
+
+/*!
+ *	Removes the window's refresh callback.
+ */
+void renderOnDemandDestroy();
+
+/*!
+ *	Handles window events instead of glfwPollEvents: polls if the previous iteration has rendered,
+ *	waits for events otherwise.
+ *	@param	work_pending	Whether background work (e.g., asset loads) will change the image once it finishes.
+ *							Waits are limited to a few milliseconds then, so that results are picked up in time.
+ */
+void renderOnDemandHandleEvents(bool work_pending);
+
+/*!
+ *	Adds data which the image depends on to a state hash (FNV-1a).
+ *	@param	hash	The hash so far, or kRenderOnDemandInitialHash
+ *	@param	data	The data to add
+ *	@param	size	Size of data in bytes
+ *	@return	The updated hash
+ */
+uint64_t renderOnDemandHash(uint64_t hash, const void* data, size_t size);
+
+//! Start value for renderOnDemandHash
+constexpr uint64_t kRenderOnDemandInitialHash = 14695981039346656037ull;
+
+/*!
+ *	Makes the next renderOnDemandShouldRender return true, e.g., after the window contents have been damaged.
+ */
+void renderOnDemandInvalidate();
+
+/*!
+ *	Decides whether the current iteration renders. If it returns true, the frame must be presented
+ *	and renderOnDemandFramePresented be called.
+ *	@param	state_hash		Hash of everything which the image depends on, see renderOnDemandHash
+ *	@return	True if the image has changed, if the frame has been invalidated, or if the maximum idle interval has elapsed
+ */
+bool renderOnDemandShouldRender(uint64_t state_hash);
+
+/*!
+ *	Records that the frame has been presented, for the wake latency.
+ */
+void renderOnDemandFramePresented();
+
+/*!
+ *	Returns the counters since renderOnDemandCreate.
+ */
+RenderOnDemandStatistics renderOnDemandGetStatistics();
@@ -0,0 +1,174 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "SceneGraph.h"
+#include <cassert>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SCENE_GRAPH_USE_SSE 1
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SCENE_GRAPH_USE_NEON 1
+#endif
+
+namespace
+{
+	// Computes result = a * b for column-major 4x4 matrices. Every column of the result is a linear
+	// combination of a's columns, weighted with the entries of b's corresponding column.
+	// result must not alias a or b.
+	inline void multiplyMatrices(const float* a, const float* b, float* result)
+	{
+#if defined(SCENE_GRAPH_USE_SSE)
+		const __m128 a0 = _mm_loadu_ps(a + 0);
+		const __m128 a1 = _mm_loadu_ps(a + 4);
+		const __m128 a2 = _mm_loadu_ps(a + 8);
+		const __m128 a3 = _mm_loadu_ps(a + 12);
+		for (int column = 0; column < 4; ++column) {
+			const float* b_column = b + 4 * column;
+			__m128 r = _mm_mul_ps(a0, _mm_set1_ps(b_column[0]));
+			r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(b_column[1])));
+			r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(b_column[2])));
+			r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(b_column[3])));
+			_mm_storeu_ps(result + 4 * column, r);
+		}
+#elif defined(SCENE_GRAPH_USE_NEON)
+		const float32x4_t a0 = vld1q_f32(a + 0);
+		const float32x4_t a1 = vld1q_f32(a + 4);
+		const float32x4_t a2 = vld1q_f32(a + 8);
+		const float32x4_t a3 = vld1q_f32(a + 12);
+		for (int column = 0; column < 4; ++column) {
+			const float32x4_t b_column = vld1q_f32(b + 4 * column);
+			float32x4_t r = vmulq_laneq_f32(a0, b_column, 0);
+			r = vfmaq_laneq_f32(r, a1, b_column, 1);
+			r = vfmaq_laneq_f32(r, a2, b_column, 2);
+			r = vfmaq_laneq_f32(r, a3, b_column, 3);
+			vst1q_f32(result + 4 * column, r);
+		}
+#else
+		for (int column = 0; column < 4; ++column) {
+			for (int row = 0; row < 4; ++row) {
+				result[4 * column + row] = a[row] * b[4 * column] + a[4 + row] * b[4 * column + 1]
+					+ a[8 + row] * b[4 * column + 2] + a[12 + row] * b[4 * column + 3];
+			}
+		}
+#endif
+	}
+
+	// Composes translation * rotation * scale into a column-major 4x4 matrix.
+	inline void composeLocalMatrix(const glm::vec3& t, const glm::quat& q, const glm::vec3& s, float* result)
+	{
+		const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+		const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+		const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+		result[0]  = (1.0f - 2.0f * (yy + zz)) * s.x;
+		result[1]  = (2.0f * (xy + wz)) * s.x;
+		result[2]  = (2.0f * (xz - wy)) * s.x;
+		result[3]  = 0.0f;
+		result[4]  = (2.0f * (xy - wz)) * s.y;
+		result[5]  = (1.0f - 2.0f * (xx + zz)) * s.y;
+		result[6]  = (2.0f * (yz + wx)) * s.y;
+		result[7]  = 0.0f;
+		result[8]  = (2.0f * (xz + wy)) * s.z;
+		result[9]  = (2.0f * (yz - wx)) * s.z;
+		result[10] = (1.0f - 2.0f * (xx + yy)) * s.z;
+		result[11] = 0.0f;
+		result[12] = t.x;
+		result[13] = t.y;
+		result[14] = t.z;
+		result[15] = 1.0f;
+	}
+
+	inline void markDirty(SceneGraph& scene, uint32_t node)
+	{
+		scene.dirty[node] = 1;
+		if (node < scene.firstDirty) {
+			scene.firstDirty = node;
+		}
+	}
+}
+
+uint32_t sceneGraphAddNode(SceneGraph& scene, uint32_t parent, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale)
+{
+	const uint32_t node = sceneGraphGetNumNodes(scene);
+	assert(kSceneGraphNoParent == parent || parent < node);
+	scene.parents.push_back(parent);
+	scene.localTranslations.push_back(translation);
+	scene.localRotations.push_back(rotation);
+	scene.localScales.push_back(scale);
+	scene.worldMatrices.push_back(glm::mat4(1.0f));
+	scene.worldVersions.push_back(0);
+	scene.dirty.push_back(0);
+	markDirty(scene, node);
+	return node;
+}
+
+void sceneGraphSetLocalTransform(SceneGraph& scene, uint32_t node, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale)
+{
+	scene.localTranslations[node] = translation;
+	scene.localRotations[node] = rotation;
+	scene.localScales[node] = scale;
+	markDirty(scene, node);
+}
+
+void sceneGraphSetLocalRotation(SceneGraph& scene, uint32_t node, const glm::quat& rotation)
+{
+	scene.localRotations[node] = rotation;
+	markDirty(scene, node);
+}
+
+uint32_t sceneGraphUpdate(SceneGraph& scene)
+{
+	const uint32_t num_nodes = sceneGraphGetNumNodes(scene);
+	if (scene.firstDirty >= num_nodes) {
+		return 0;
+	}
+
+	// Every world matrix which is recomputed in this pass gets tagged with the new version. Since parents
+	// are processed before their children, a child can tell from its parent's version whether it lies in
+	// a dirty subtree, without propagating any flags:
+	const uint64_t new_version = scene.version + 1;
+	uint32_t num_updated = 0;
+	alignas(16) float local[16];
+	for (uint32_t i = scene.firstDirty; i < num_nodes; ++i) {
+		const uint32_t parent = scene.parents[i];
+		const bool parent_changed = kSceneGraphNoParent != parent && new_version == scene.worldVersions[parent];
+		if (0 == scene.dirty[i] && !parent_changed) {
+			continue;
+		}
+		scene.dirty[i] = 0;
+
+		float* world = &scene.worldMatrices[i][0][0];
+		if (kSceneGraphNoParent == parent) {
+			composeLocalMatrix(scene.localTranslations[i], scene.localRotations[i], scene.localScales[i], world);
+		}
+		else {
+			composeLocalMatrix(scene.localTranslations[i], scene.localRotations[i], scene.localScales[i], local);
+			multiplyMatrices(&scene.worldMatrices[parent][0][0], local, world);
+		}
+		scene.worldVersions[i] = new_version;
+		++num_updated;
+	}
+
+	scene.firstDirty = num_nodes;
+	scene.version = new_version;
+	return num_updated;
+}
+
+uint32_t sceneGraphWriteInstances(const SceneGraph& scene, glm::mat4* destination, uint64_t& destination_version)
+{
+	const uint32_t num_nodes = sceneGraphGetNumNodes(scene);
+	uint32_t num_written = 0;
+	if (destination_version < scene.version) {
+		for (uint32_t i = 0; i < num_nodes; ++i) {
+			if (scene.worldVersions[i] > destination_version) {
+				memcpy(destination + i, &scene.worldMatrices[i], sizeof(glm::mat4));
+				++num_written;
+			}
+		}
+	}
+	destination_version = scene.version;
+	return num_written;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <vector>
+
+/* --------------------------------------------- */
+// Scene Graph
+//
+// A flat hierarchy of nodes, stored as structure of arrays. Nodes are sorted
+// parent-before-child, i.e., a node's parent always has a smaller index.
+// Hence, all world matrices can be updated in one single pass over the arrays
+// in index order, and a dirty flag propagates down to all descendants within
+// that same pass. Only nodes in dirty subtrees are recomputed, with SIMD 4x4
+// matrix multiplications (SSE on x86, NEON on ARM).
+//
+// World matrices are laid out exactly as a per-instance vertex buffer expects
+// them (one column-major mat4 per node), so changed matrices can be written
+// straight into mapped instance buffer memory with sceneGraphWriteInstances.
+/* --------------------------------------------- */
+
+//! Parent index of root nodes
+constexpr uint32_t kSceneGraphNoParent = 0xFFFFFFFFu;
+
+/*!
+ *	A scene graph with local and world transforms stored as structure of arrays.
+ *	All arrays have one entry per node. Use the sceneGraph* functions to modify it.
+ */
+struct SceneGraph {
+	//! Index of each node's parent, or kSceneGraphNoParent. parents[i] < i holds for every non-root node.
+	std::vector<uint32_t> parents;
+
+	//! Translation of each node relative to its parent
+	std::vector<glm::vec3> localTranslations;
+
+	//! Rotation of each node relative to its parent
+	std::vector<glm::quat> localRotations;
+
+	//! Scale of each node relative to its parent
+	std::vector<glm::vec3> localScales;
+
+	//! World matrix of each node as of the most recent sceneGraphUpdate
+	std::vector<glm::mat4> worldMatrices;
+
+	//! Value of version at the time each node's world matrix has last been changed
+	std::vector<uint64_t> worldVersions;
+
+	//! Non-zero for nodes whose local transform has changed since the most recent sceneGraphUpdate
+	std::vector<uint8_t> dirty;
+
+	//! Lowest index of a dirty node, or the number of nodes if no node is dirty
+	uint32_t firstDirty = 0;
+
+	//! Incremented by every sceneGraphUpdate which changes at least one world matrix
+	uint64_t version = 0;
+};
+
+/*!
+ *	Appends a node to the scene graph.
+ *	@param	scene		The scene graph
+ *	@param	parent		Index of the parent node, which must already exist, or kSceneGraphNoParent
+ *	@param	translation	Translation relative to the parent
+ *	@param	rotation	Rotation relative to the parent
+ *	@param	scale		Scale relative to the parent
+ *	@return	Index of the new node
+ */
+uint32_t sceneGraphAddNode(SceneGraph& scene, uint32_t parent,
+	const glm::vec3& translation = glm::vec3(0.0f), const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f), const glm::vec3& scale = glm::vec3(1.0f));
+
+/*!
+ *	Changes a node's local transform and marks its subtree dirty.
+ */
+void sceneGraphSetLocalTransform(SceneGraph& scene, uint32_t node, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale);
+
+/*!
+ *	Changes a node's local rotation and marks its subtree dirty.
+ */
+void sceneGraphSetLocalRotation(SceneGraph& scene, uint32_t node, const glm::quat& rotation);
+
+/*!
+ *	Recomputes the world matrices of all dirty nodes and their descendants.
+ *	@return	The number of world matrices which have been recomputed
+ */
+uint32_t sceneGraphUpdate(SceneGraph& scene);
+
+/*!
+ *	Writes all world matrices which have changed since a given version into instance buffer memory.
+ *	Keep one version per instance buffer (e.g., one per frame in flight), so that every buffer
+ *	receives all changes which it has missed, no matter in which order the buffers are used.
+ *	@param	scene				The scene graph
+ *	@param	destination			Mapped instance buffer memory with space for one mat4 per node. It is
+ *								only written to, never read from, which is what write-combined memory requires.
+ *	@param	destination_version	The scene graph version which the destination's contents correspond to.
+ *								Initialize it with 0 for a buffer with undefined contents. Updated to the
+ *								scene graph's current version.
+ *	@return	The number of world matrices which have been written
+ */
+uint32_t sceneGraphWriteInstances(const SceneGraph& scene, glm::mat4* destination, uint64_t& destination_version);
+
+/*!
+ *	Returns the number of nodes of the given scene graph.
+ */
+inline uint32_t sceneGraphGetNumNodes(const SceneGraph& scene) { return static_cast<uint32_t>(scene.parents.size()); }
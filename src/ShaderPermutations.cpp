@@ -0,0 +1,47 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "ShaderPermutations.h"
+
+void shaderPermutationApply(ShaderFeatures features, VklGraphicsPipelineConfig& config, HlpPipelineState& state)
+{
+	if (nullptr == shaderPermutationFind(features & ~SHADER_FEATURE_MULTIVIEW)) {
+		VKL_EXIT_WITH_ERROR("Invalid shader permutation " << features << " => add it to kShaderPermutations if it should be supported.");
+	}
+
+	// Baked features select the SPIR-V binaries, which CMake compiles once per combination of defines.
+	// Index: bit 0 = VERTEX_NORMALS, bit 1 = CLUSTERED_LIGHTING, bit 2 = MULTIVIEW. Fragment shaders only depend on
+	// MULTIVIEW with CLUSTERED_LIGHTING, where it selects the view's cluster lists:
+	static const char* const vertex_shader_paths[] = {
+		SHADER_BINARY_DIR "/vertex.spv",
+		SHADER_BINARY_DIR "/vertex_normals.spv",
+		SHADER_BINARY_DIR "/vertex_clustered.spv",
+		SHADER_BINARY_DIR "/vertex_normals_clustered.spv",
+		SHADER_BINARY_DIR "/vertex_multiview.spv",
+		SHADER_BINARY_DIR "/vertex_normals_multiview.spv",
+		SHADER_BINARY_DIR "/vertex_clustered_multiview.spv",
+		SHADER_BINARY_DIR "/vertex_normals_clustered_multiview.spv",
+	};
+	static const char* const fragment_shader_paths[] = {
+		SHADER_BINARY_DIR "/fragment.spv",
+		SHADER_BINARY_DIR "/fragment_normals.spv",
+		SHADER_BINARY_DIR "/fragment_clustered.spv",
+		SHADER_BINARY_DIR "/fragment_normals_clustered.spv",
+		SHADER_BINARY_DIR "/fragment.spv",
+		SHADER_BINARY_DIR "/fragment_normals.spv",
+		SHADER_BINARY_DIR "/fragment_clustered_multiview.spv",
+		SHADER_BINARY_DIR "/fragment_normals_clustered_multiview.spv",
+	};
+	const uint32_t binary_index = (0 != (features & SHADER_FEATURE_VERTEX_NORMALS) ? 1u : 0u)
+		| (0 != (features & SHADER_FEATURE_CLUSTERED_LIGHTING) ? 2u : 0u)
+		| (0 != (features & SHADER_FEATURE_MULTIVIEW) ? 4u : 0u);
+	config.vertexShaderPath = vertex_shader_paths[binary_index];
+	config.fragmentShaderPath = fragment_shader_paths[binary_index];
+
+	// All other features are boolean specialization constants, with constant_id = index in kShaderSpecializationFeatures:
+	const uint32_t num_constants = static_cast<uint32_t>(sizeof(kShaderSpecializationFeatures) / sizeof(kShaderSpecializationFeatures[0]));
+	for (uint32_t i = 0; i < num_constants; ++i) {
+		state.specializationConstants[i] = 0 != (features & kShaderSpecializationFeatures[i]) ? VK_TRUE : VK_FALSE;
+	}
+	state.numSpecializationConstants = num_constants;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include "VulkanHelpers.h"
+#include <VulkanLaunchpad.h>
+#include <cstddef>
+#include <cstdint>
+
+/* --------------------------------------------- */
+// Shader Permutations
+//
+// Optional shader features are selected per pipeline instead of by branching
+// on uniforms in the shaders. Features which change the shader interface
+// (i.e., vertex inputs and varyings) are baked into separate SPIR-V binaries
+// at build time via preprocessor defines. All other features are
+// specialization constants, which the driver folds into straight-line code
+// when it compiles the pipeline.
+//
+// Only the combinations listed in kShaderPermutations are valid; the table is
+// checked at compile time. Pick the smallest permutation which a draw needs.
+// Multiview is not part of the table, since it can be added to every entry.
+/* --------------------------------------------- */
+
+//! A combination of ShaderFeature bits
+typedef uint32_t ShaderFeatures;
+
+enum ShaderFeature : ShaderFeatures {
+	//! Baked (VERTEX_NORMALS define): the vertex shader reads a normal from location 5 and passes it on
+	SHADER_FEATURE_VERTEX_NORMALS = 1u << 0,
+
+	//! Specialization constant 0: diffuse lighting from a directional light. Requires vertex normals.
+	SHADER_FEATURE_LIGHTING = 1u << 1,
+
+	//! Specialization constant 1: exponential distance fog towards the clear color
+	SHADER_FEATURE_FOG = 1u << 2,
+
+	//! Baked (CLUSTERED_LIGHTING define): diffuse lighting from the point lights of the fragment's cluster, see
+	//! ClusteredLighting.h. The vertex shader passes on the world space position. Requires descriptor bindings 1 and 2.
+	SHADER_FEATURE_CLUSTERED_LIGHTING = 1u << 3,
+
+	//! Baked (MULTIVIEW define): positions are transformed with the view-projection matrix of gl_ViewIndex, see
+	//! Multiview.h. With clustered lighting, fragments read the cluster lists of gl_ViewIndex.
+	//! Valid together with every entry of kShaderPermutations.
+	SHADER_FEATURE_MULTIVIEW = 1u << 4,
+};
+
+//! The features which are selected via specialization constants, in the order of their constant_id
+constexpr ShaderFeature kShaderSpecializationFeatures[] = { SHADER_FEATURE_LIGHTING, SHADER_FEATURE_FOG };
+
+/*!
+ *	An entry of the permutation table.
+ */
+struct ShaderPermutation {
+	ShaderFeatures features;
+
+	//! A human-readable name, for logs and debug names
+	const char*    name;
+};
+
+//! All valid permutations
+constexpr ShaderPermutation kShaderPermutations[] = {
+	{ 0,                                                                                      "unlit" },
+	{ SHADER_FEATURE_FOG,                                                                     "unlit + fog" },
+	{ SHADER_FEATURE_VERTEX_NORMALS,                                                          "vertex normals" },
+	{ SHADER_FEATURE_VERTEX_NORMALS | SHADER_FEATURE_FOG,                                     "vertex normals + fog" },
+	{ SHADER_FEATURE_VERTEX_NORMALS | SHADER_FEATURE_LIGHTING,                                "vertex normals + lighting" },
+	{ SHADER_FEATURE_VERTEX_NORMALS | SHADER_FEATURE_LIGHTING | SHADER_FEATURE_FOG,           "vertex normals + lighting + fog" },
+	{ SHADER_FEATURE_CLUSTERED_LIGHTING,                                                      "clustered lighting" },
+	{ SHADER_FEATURE_CLUSTERED_LIGHTING | SHADER_FEATURE_FOG,                                 "clustered lighting + fog" },
+	{ SHADER_FEATURE_VERTEX_NORMALS | SHADER_FEATURE_CLUSTERED_LIGHTING,                      "vertex normals + clustered lighting" },
+	{ SHADER_FEATURE_VERTEX_NORMALS | SHADER_FEATURE_CLUSTERED_LIGHTING | SHADER_FEATURE_FOG, "vertex normals + clustered lighting + fog" },
+};
+
+/*!
+ *	Returns the entry of kShaderPermutations for the given features, or nullptr if they are not a valid permutation.
+ */
+constexpr const ShaderPermutation* shaderPermutationFind(ShaderFeatures features)
+{
+	for (const ShaderPermutation& permutation : kShaderPermutations) {
+		if (permutation.features == features) {
+			return &permutation;
+		}
+	}
+	return nullptr;
+}
+
+/*!
+ *	Compile-time check of kShaderPermutations: no unknown features, no duplicates, no lighting without vertex normals,
+ *	since lighting reads the interpolated normal, which only exists in the VERTEX_NORMALS binaries, and no lighting
+ *	together with clustered lighting, since the point lights replace the directional light.
+ */
+constexpr bool shaderPermutationTableIsConsistent()
+{
+	constexpr ShaderFeatures all_features = SHADER_FEATURE_VERTEX_NORMALS | SHADER_FEATURE_LIGHTING | SHADER_FEATURE_FOG | SHADER_FEATURE_CLUSTERED_LIGHTING;
+	constexpr size_t num_permutations = sizeof(kShaderPermutations) / sizeof(kShaderPermutations[0]);
+	for (size_t i = 0; i < num_permutations; ++i) {
+		const ShaderFeatures features = kShaderPermutations[i].features;
+		if (0 != (features & ~all_features)) {
+			return false;
+		}
+		if (0 != (features & SHADER_FEATURE_LIGHTING) && 0 == (features & SHADER_FEATURE_VERTEX_NORMALS)) {
+			return false;
+		}
+		if (0 != (features & SHADER_FEATURE_LIGHTING) && 0 != (features & SHADER_FEATURE_CLUSTERED_LIGHTING)) {
+			return false;
+		}
+		for (size_t j = i + 1; j < num_permutations; ++j) {
+			if (kShaderPermutations[j].features == features) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static_assert(shaderPermutationTableIsConsistent(), "kShaderPermutations contains unknown features, a duplicate, or an invalid lighting combination");
+static_assert(sizeof(kShaderSpecializationFeatures) / sizeof(kShaderSpecializationFeatures[0]) <= kHlpMaxSpecializationConstants,
+	"HlpPipelineState cannot hold all feature specialization constants");
+
+/*!
+ *	Configures the given pipeline config and state for a permutation: selects the shader binaries for the baked
+ *	features and writes one specialization constant (0 or 1) per kShaderSpecializationFeatures entry.
+ *	Exits with an error if the permutation, without SHADER_FEATURE_MULTIVIEW, is not in kShaderPermutations.
+ *	@param	features	The permutation
+ *	@param	config		Its shader paths are overwritten, everything else is left untouched.
+ *	@param	state		Its specialization constants are overwritten, everything else is left untouched.
+ */
+void shaderPermutationApply(ShaderFeatures features, VklGraphicsPipelineConfig& config, HlpPipelineState& state);
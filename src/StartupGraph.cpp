@@ -0,0 +1,206 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "StartupGraph.h"
+#include "Profiler.h"
+#include <VulkanLaunchpad.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+
+	constexpr StartupTask kNoTask = 0xFFFFFFFFu;
+
+	struct Task {
+		const char* name;
+		bool        isPhase;
+
+		//! Written by the job for background tasks
+		Clock::time_point begin;
+		Clock::time_point end;
+
+		//! Tasks which must have finished before a background task starts, or before a phase ends
+		std::vector<StartupTask> dependencies;
+
+		//! The phase which has submitted a background task, and when
+		StartupTask       submitter = kNoTask;
+		Clock::time_point submitTime;
+
+		//! The job which sets end, for background tasks
+		JobHandle job;
+
+		uint64_t profilerBegin = 0;
+	};
+
+	// A deque, so that the jobs' pointers to tasks stay valid while new tasks are added:
+	std::deque<Task> mTasks;
+	Clock::time_point mStartTime;
+	StartupTask mCurrentPhase = kNoTask;
+	StartupTask mPreviousPhase = kNoTask;
+
+	// Tasks which have been waited for between phases, which the next phase depends on:
+	std::vector<StartupTask> mWaitedFor;
+
+	double toMilliseconds(Clock::time_point time)
+	{
+		return Milliseconds(time - mStartTime).count();
+	}
+
+	StartupTask addBackgroundTask(const char* name)
+	{
+		const StartupTask handle = static_cast<StartupTask>(mTasks.size());
+		mTasks.emplace_back();
+		Task& task = mTasks.back();
+		task.name = name;
+		task.isPhase = false;
+		task.submitter = kNoTask != mCurrentPhase ? mCurrentPhase : mPreviousPhase;
+		task.submitTime = Clock::now();
+		task.begin = task.submitTime;
+		task.end = task.submitTime;
+		return handle;
+	}
+
+	// The predecessor which has finished last is the one which has held up the task:
+	StartupTask findCriticalPredecessor(const Task& task)
+	{
+		StartupTask latest = kNoTask;
+		for (StartupTask dependency : task.dependencies) {
+			if (kNoTask == latest || mTasks[dependency].end > mTasks[latest].end) {
+				latest = dependency;
+			}
+		}
+		// A background task cannot start before it has been submitted. If no dependency has held it up beyond
+		// that, the phase which has submitted it is on the critical path:
+		if (!task.isPhase && (kNoTask == latest || mTasks[latest].end < task.submitTime)) {
+			return task.submitter;
+		}
+		return latest;
+	}
+}
+
+void startupGraphCreate()
+{
+	mStartTime = Clock::now();
+	mTasks.clear();
+	mCurrentPhase = kNoTask;
+	mPreviousPhase = kNoTask;
+	mWaitedFor.clear();
+}
+
+StartupTask startupGraphBegin(const char* name)
+{
+	const StartupTask handle = static_cast<StartupTask>(mTasks.size());
+	mTasks.emplace_back();
+	Task& phase = mTasks.back();
+	phase.name = name;
+	phase.isPhase = true;
+	phase.begin = Clock::now();
+	phase.profilerBegin = profilerNow();
+	if (kNoTask != mPreviousPhase) {
+		phase.dependencies.push_back(mPreviousPhase);
+	}
+	phase.dependencies.insert(phase.dependencies.end(), mWaitedFor.begin(), mWaitedFor.end());
+	mWaitedFor.clear();
+	mCurrentPhase = handle;
+	return handle;
+}
+
+void startupGraphEnd(StartupTask phase)
+{
+	Task& task = mTasks[phase];
+	task.end = Clock::now();
+	profilerRecordZone(task.name, task.profilerBegin, profilerNow());
+	mPreviousPhase = phase;
+	if (mCurrentPhase == phase) {
+		mCurrentPhase = kNoTask;
+	}
+}
+
+StartupTask startupGraphSubmit(const char* name, std::function<void()> work, const StartupTask* dependencies, uint32_t num_dependencies)
+{
+	const StartupTask handle = addBackgroundTask(name);
+	Task* task = &mTasks.back();
+	std::vector<JobHandle> dependency_jobs;
+	for (uint32_t i = 0; i < num_dependencies; ++i) {
+		task->dependencies.push_back(dependencies[i]);
+		dependency_jobs.push_back(mTasks[dependencies[i]].job);
+	}
+	task->job = jobSystemSubmit(name, [task, work = std::move(work)] {
+		task->begin = Clock::now();
+		work();
+		task->end = Clock::now();
+	}, dependency_jobs.data(), static_cast<uint32_t>(dependency_jobs.size()));
+	return handle;
+}
+
+StartupTask startupGraphTrack(const char* name, const JobHandle& job)
+{
+	const StartupTask handle = addBackgroundTask(name);
+	Task* task = &mTasks.back();
+	if (nullptr != job) {
+		// The end is taken by a continuation, hence it may be late by the time it takes to schedule that:
+		task->job = jobSystemSubmit(name, [task] {
+			task->end = Clock::now();
+		}, &job, 1);
+	}
+	return handle;
+}
+
+void startupGraphWait(StartupTask task)
+{
+	// Running other jobs in the meantime could delay the phase beyond the task's end, which would distort the critical path:
+	const JobHandle& job = mTasks[task].job;
+	if (nullptr != job) {
+		jobSystemSleepUntilDone(job);
+	}
+	if (kNoTask != mCurrentPhase) {
+		mTasks[mCurrentPhase].dependencies.push_back(task);
+	}
+	else {
+		mWaitedFor.push_back(task);
+	}
+}
+
+void startupGraphLogReport(StartupTask last_phase, double target_milliseconds)
+{
+	for (const Task& task : mTasks) {
+		if (nullptr != task.job) {
+			jobSystemWait(task.job);
+		}
+	}
+
+	std::vector<bool> critical(mTasks.size(), false);
+	for (StartupTask task = last_phase; kNoTask != task; task = findCriticalPredecessor(mTasks[task])) {
+		critical[task] = true;
+	}
+
+	const double total = toMilliseconds(mTasks[last_phase].end);
+	VKL_LOG("Startup took " << total << " ms until \"" << mTasks[last_phase].name << "\" ended (target: " << target_milliseconds << " ms"
+		<< (total <= target_milliseconds ? ", met" : ", missed") << "). Tasks in order of their start, * marks the critical path:");
+
+	std::vector<StartupTask> order(mTasks.size());
+	for (StartupTask i = 0; i < static_cast<StartupTask>(order.size()); ++i) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [](StartupTask a, StartupTask b) { return mTasks[a].begin < mTasks[b].begin; });
+	double background_milliseconds = 0.0;
+	for (StartupTask i : order) {
+		const Task& task = mTasks[i];
+		if (!task.isPhase) {
+			background_milliseconds += Milliseconds(task.end - task.begin).count();
+		}
+		std::ostringstream line;
+		line << std::fixed << std::setprecision(1) << (critical[i] ? "  * " : "    ")
+			<< std::setw(7) << toMilliseconds(task.begin) << " - " << std::setw(7) << toMilliseconds(task.end) << " ms  "
+			<< (task.isPhase ? "main    " : "worker  ") << task.name;
+		VKL_LOG(line.str());
+	}
+	VKL_LOG(background_milliseconds << " ms of background work overlapped with the main thread.");
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include "JobSystem.h"
+#include <cstdint>
+#include <functional>
+
+/* --------------------------------------------- */
+// Startup Graph
+//
+// Measures startup as a graph of tasks and reports its critical path, i.e.,
+// the chain of tasks which has determined the time to the first frame.
+//
+// Phases run on the main thread, one after another: every phase depends on
+// the previous one and on all tasks which it has waited for. Background tasks
+// run on the job system and depend on the phase which has submitted them and
+// on their explicit dependencies. Work which other modules start on the job
+// system, e.g., pipeline compiles, can be tracked as well.
+//
+// Phases also record profiler zones, so they show up in the trace as before.
+/* --------------------------------------------- */
+
+//! Handle to a phase or a background task
+typedef uint32_t StartupTask;
+
+/*!
+ *	Starts measuring. Call this as early as possible in main, since all times are relative to this call.
+ */
+void startupGraphCreate();
+
+/*!
+ *	Starts a phase on the main thread. It depends on the previous phase.
+ *	@param	name	Name of the phase. Must stay valid until the report has been written.
+ *	@return	Handle to the phase, which is passed to startupGraphEnd
+ */
+StartupTask startupGraphBegin(const char* name);
+
+/*!
+ *	Ends a phase which has been started with startupGraphBegin.
+ */
+void startupGraphEnd(StartupTask phase);
+
+/*!
+ *	Runs work on the job system. It starts once the given tasks have finished, but not before this call.
+ *	The job system must have been created. Must be called from the main thread.
+ *	@param	name				Name of the task, also used as job name. Must stay valid until the report has been written.
+ *	@param	work				The work to do
+ *	@param	dependencies		Tasks which must have finished before the work starts. Can be nullptr.
+ *	@param	num_dependencies	Number of elements in dependencies
+ *	@return	Handle to the task
+ */
+StartupTask startupGraphSubmit(const char* name, std::function<void()> work, const StartupTask* dependencies = nullptr, uint32_t num_dependencies = 0);
+
+/*!
+ *	Tracks a job which has been submitted elsewhere, from now until it has finished. Must be called from the main thread.
+ *	@param	name	Name of the task. Must stay valid until the report has been written.
+ *	@param	job		The job to track. nullptr counts as a task which has already finished.
+ *	@return	Handle to the task
+ */
+StartupTask startupGraphTrack(const char* name, const JobHandle& job);
+
+/*!
+ *	Waits for a background task on the main thread. Unlike jobSystemWait, it does not run other jobs in the meantime,
+ *	since a long one, e.g., parsing a mesh, would hold up the main thread. The main thread sleeps until the task has
+ *	finished. The current phase (or, between phases, the next one) depends on the task.
+ */
+void startupGraphWait(StartupTask task);
+
+/*!
+ *	Waits for all background tasks and logs every task's start and end, the critical path which ends with the
+ *	given phase, and the total time until that phase has ended. Call this once, e.g., after the first frame.
+ *	@param	last_phase				The phase which ends startup, e.g., the first frame
+ *	@param	target_milliseconds		The time which startup should take at most, for comparison
+ */
+void startupGraphLogReport(StartupTask last_phase, double target_milliseconds);
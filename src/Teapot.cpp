@@ -2,18 +2,10 @@
  * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
  */
 #include "Teapot.h"
-#include <VulkanLaunchpad.h>
-#include <vulkan/vulkan.hpp>
 
-uint32_t mNumTeapotIndices;
-VkBuffer mTeapotPositions;
-VkDeviceMemory mTeapotPositionsMemory;
-VkBuffer mTeapotIndices;
-VkDeviceMemory mTeapotIndicesMemory;
-
-void teapotCreateGeometryAndBuffers() 
+void teapotGetGeometry(std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices)
 {
-	std::vector<glm::vec3> positions = {
+	positions = {
 		glm::vec3(-0.0112664,0.188986,-0.392027), glm::vec3(0.187941,0.188986,-0.339176), glm::vec3(0.327909,0.188986,-0.199208), glm::vec3(0.38076,0.188986,-9.72432e-10),
 		glm::vec3(-0.0112664,0.213487,-0.387619), glm::vec3(0.185702,0.213487,-0.335362), glm::vec3(0.324096,0.213487,-0.196968), glm::vec3(0.376353,0.213487,-9.72432e-10),
 		glm::vec3(-0.0112664,0.213487,-0.401102), glm::vec3(0.192553,0.213487,-0.347027), glm::vec3(0.335761,0.213487,-0.203819), glm::vec3(0.389835,0.213487,-9.72432e-10),
@@ -144,16 +136,7 @@ void teapotCreateGeometryAndBuffers()
 		glm::vec3(0.772787,0.188986,-9.72432e-10), glm::vec3(0.801826,0.188986,0.0280019), glm::vec3(0.855756,0.188986,0.0280019), glm::vec3(0.884795,0.188986,-9.72432e-10)
 	};
 
-	auto m = glm::mat3(-1,  0,  0,
-		                0,  1,  0,
-		                0,  0, -1);
-
-	for (size_t i = 0; i < positions.size(); i++)
-	{
-		positions[i] = m * positions[i];
-	}
-
-	std::vector<unsigned int> indices = {
+	indices = {
 		0,5,4, 0,1,5, 1,6,5, 1,2,6, 2,7,6, 2,3,7, 4,9,8, 4,5,9, 5,10,9, 5,6,10,
 		6,11,10, 6,7,11, 8,13,12, 8,9,13, 9,14,13, 9,10,14, 10,15,14, 10,11,15, 16,21,20, 16,17,21,
 		17,22,21, 17,18,22, 18,23,22, 18,19,23, 20,25,24, 20,21,25, 21,26,25, 21,22,26, 22,27,26, 22,23,27,
@@ -213,126 +196,4 @@ void teapotCreateGeometryAndBuffers()
 		497,502,501, 497,498,502, 498,503,502, 498,499,503, 500,505,504, 500,501,505, 501,506,505, 501,502,506, 502,507,506, 502,503,507,
 		504,509,508, 504,505,509, 505,510,509, 505,506,510, 506,511,510, 506,507,511
 	};
-
-	mNumTeapotIndices = static_cast<uint32_t>(indices.size());
-	const auto device = vklGetDevice();
-	auto dispatchLoader = vk::DispatchLoaderStatic();
-
-	// 1. POSITIONS BUFFER (Buffer, Memory, Bind 'em together, copy data into it)
-	{
-		VkBufferCreateInfo posBufferCreateInfo {};
-		posBufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-		posBufferCreateInfo.size = (sizeof(positions[0]) * positions.size());
-		posBufferCreateInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT; // <--- Mind the usage flags!
-		auto result = vkCreateBuffer(device, &posBufferCreateInfo, NULL, &mTeapotPositions);
-		if(result != VK_SUCCESS) {
-			VKL_EXIT_WITH_ERROR(std::string("Failed to create buffer for teapot positions with error: ") + to_string(result));
-		}
-		VkMemoryRequirements memoryRequirements {};
-		vkGetBufferMemoryRequirements(device, mTeapotPositions, &memoryRequirements);
-		mTeapotPositionsMemory = vklAllocateMemoryForGivenRequirements(posBufferCreateInfo.size, memoryRequirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		result = vkBindBufferMemory(device, mTeapotPositions, mTeapotPositionsMemory, 0);
-		if(result != VK_SUCCESS) {
-			VKL_EXIT_WITH_ERROR(std::string("Failed to bind the buffer memory for the teapot positions with error: ") + to_string(result));
-		}
-
-		// Copy the positions into the buffer:
-		void* mappedMemory;
-		vkMapMemory(device, mTeapotPositionsMemory, 0, posBufferCreateInfo.size, 0, &mappedMemory);
-		memcpy(mappedMemory, positions.data(), posBufferCreateInfo.size);
-		vkUnmapMemory(device, mTeapotPositionsMemory);
-	}
-
-	// 2. INDICES BUFFER (Buffer, Memory, Bind 'em together, copy data into it)
-	{
-		VkBufferCreateInfo indexBufferCreateInfo {};
-		indexBufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-		indexBufferCreateInfo.size = sizeof(indices[0]) * indices.size();
-		indexBufferCreateInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT; // <--- Mind the usage flags!
-		auto result = vkCreateBuffer(device, &indexBufferCreateInfo, NULL, &mTeapotIndices);
-		if(result != VK_SUCCESS)
-		{
-			VKL_EXIT_WITH_ERROR(std::string("Failed to create buffer for teapot indices with error: ") + to_string(result));
-		}
-		VkMemoryRequirements memoryRequirements{};
-		vkGetBufferMemoryRequirements(device, mTeapotIndices, &memoryRequirements);
-		mTeapotIndicesMemory = vklAllocateMemoryForGivenRequirements(indexBufferCreateInfo.size, memoryRequirements, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		result = vkBindBufferMemory(device, mTeapotIndices, mTeapotIndicesMemory, 0);
-		if(result != VK_SUCCESS)
-		{
-			VKL_EXIT_WITH_ERROR(std::string("Failed to bind the buffer memory for the teapot indices with error: ") + to_string(result));
-		}
-
-		// Copy the indices into the buffer:
-		void* mappedMemory;
-		vkMapMemory(device, mTeapotIndicesMemory, 0, indexBufferCreateInfo.size, 0, &mappedMemory);
-		memcpy(mappedMemory, indices.data(), indexBufferCreateInfo.size);
-		vkUnmapMemory(device, mTeapotIndicesMemory);
-	}
-}
-
-void teapotDestroyBuffers()
-{
-	auto device = vklGetDevice();
-	vkFreeMemory(device, mTeapotIndicesMemory, NULL);
-	vkDestroyBuffer(device, mTeapotIndices, NULL);
-	vkFreeMemory(device, mTeapotPositionsMemory, NULL);
-	vkDestroyBuffer(device, mTeapotPositions, NULL);
-}
-
-void teapotDraw()
-{
-	if (!vklFrameworkInitialized()) {
-		VKL_EXIT_WITH_ERROR("Framework not initialized. Ensure to invoke vklFrameworkInitialized beforehand!");
-	}
-
-	const vk::CommandBuffer& cb = vklGetCurrentCommandBuffer();
-	auto currentSwapChainImageIndex = vklGetCurrentSwapChainImageIndex();
-	assert(currentSwapChainImageIndex < vklGetNumFramebuffers());
-	assert(currentSwapChainImageIndex < vklGetNumClearValues());
-
-	cb.bindPipeline(vk::PipelineBindPoint::eGraphics, vklGetBasicPipeline());
-
-	cb.bindVertexBuffers(0u, { mTeapotPositions }, { vk::DeviceSize{ 0 } });
-	cb.bindIndexBuffer(mTeapotIndices, vk::DeviceSize{ 0 }, vk::IndexType::eUint32);
-	cb.drawIndexed(mNumTeapotIndices, 1u, 0u, 0, 0u);
-}
-
-void teapotDraw(VkPipeline pipeline)
-{
-	if (!vklFrameworkInitialized()) {
-		VKL_EXIT_WITH_ERROR("Framework not initialized. Ensure to invoke vklFrameworkInitialized beforehand!");
-	}
-	const vk::CommandBuffer& cb = vklGetCurrentCommandBuffer();
-	auto currentSwapChainImageIndex = vklGetCurrentSwapChainImageIndex();
-	assert(currentSwapChainImageIndex < vklGetNumFramebuffers());
-	assert(currentSwapChainImageIndex < vklGetNumClearValues());
-
-	auto pipe = vk::Pipeline{ pipeline };
-	cb.bindPipeline(vk::PipelineBindPoint::eGraphics, pipe);
-
-	cb.bindVertexBuffers(0u, { vk::Buffer{ teapotGetPositionsBuffer() } }, { vk::DeviceSize{ 0 } });
-	cb.bindIndexBuffer(vk::Buffer{ teapotGetIndicesBuffer() }, vk::DeviceSize{ 0 }, vk::IndexType::eUint32);
-	cb.drawIndexed(teapotGetNumIndices(), 1u, 0u, 0, 0u);
-}
-
-void teapotDraw(VkPipeline pipeline, VkDescriptorSet descriptor_set)
-{
-	vklBindDescriptorSetToPipeline(descriptor_set, pipeline);
-	teapotDraw(pipeline);
-}
-
-VkBuffer teapotGetPositionsBuffer()
-{
-	return static_cast<VkBuffer>(mTeapotPositions);
-}
-
-VkBuffer teapotGetIndicesBuffer()
-{
-	return static_cast<VkBuffer>(mTeapotIndices);
-}
-
-uint32_t teapotGetNumIndices()
-{
-	return mNumTeapotIndices;
 }
@@ -1,15 +1,11 @@
 /*
  * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
  */
-#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
 
-void teapotCreateGeometryAndBuffers();
-void teapotDestroyBuffers();
-void teapotDraw();
-
-void teapotDraw(VkPipeline pipeline);
-void teapotDraw(VkPipeline pipeline, VkDescriptorSet descriptor_set);
-
-VkBuffer teapotGetPositionsBuffer();
-VkBuffer teapotGetIndicesBuffer();
-uint32_t teapotGetNumIndices();
+// Returns the teapot's vertex positions and triangle list indices, e.g., to copy them into a geometry pool.
+// The positions are the control points of the teapot's 32 bicubic Bezier patches (16 per patch, row-major),
+// which the indices connect into a coarse quad grid.
+void teapotGetGeometry(std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices);
@@ -0,0 +1,340 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include "TileStreamer.h"
+#include "FrameScheduler.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <VulkanLaunchpad.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <utility>
+
+namespace
+{
+	// Loads which may be in flight at the same time, so that reads do not pile up when the camera moves fast:
+	constexpr uint32_t kMaxConcurrentLoads = 4;
+
+	// Resident tiles are ranked as if they were this much closer than they are, so that tiles at the edge of
+	// the budget do not alternate between being loaded and being evicted:
+	constexpr float kResidentDistanceBias = 0.9f;
+
+	enum TileState {
+		TILE_STATE_UNLOADED,
+		TILE_STATE_LOADING,
+		TILE_STATE_RESIDENT,
+		// Reading or staging has failed. Retried once another tile has been evicted, which frees pool space:
+		TILE_STATE_FAILED,
+	};
+
+	struct Tile {
+		TileFileEntry    entry;
+		TileState        state = TILE_STATE_UNLOADED;
+		GeometryPoolMesh mesh = kGeometryPoolInvalidMesh;
+
+		//! Whether the tile is among the nearest tiles which fit into the budget
+		bool wanted = false;
+
+		//! Set if the tile has dropped out of the budget while it was loading
+		bool evictWhenLoaded = false;
+
+		//! Only used while loading: the CPU copy, and the mesh which the stage job has created
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t>  indices;
+		GeometryPoolMesh       stagedMesh = kGeometryPoolInvalidMesh;
+	};
+
+	const char* mPath = nullptr;
+	uint64_t mBudgetBytes = 0;
+	float mLoadDistance = 0.0f;
+	TileFileHeader mHeader = {};
+
+	// The largest share of a tile's bytes which its positions and its indices take, respectively:
+	double mMaxVertexShare = 0.0;
+	double mMaxIndexShare = 0.0;
+
+	// Not resized after tileStreamerCreate, so that the jobs' pointers to tiles stay valid:
+	std::vector<Tile> mTiles;
+
+	std::vector<StreamedTile> mResidentTiles;
+	bool mResidentTilesChanged = false;
+	uint64_t mResidencyVersion = 0;
+
+	// Bytes of the tiles which are loading or resident, or evicted but possibly still in use by the GPU:
+	uint64_t mCommittedBytes = 0;
+	uint64_t mResidentBytes = 0;
+	uint32_t mNumLoading = 0;
+	TileStreamerStatistics mStatistics = {};
+
+	// Scratch space of tileStreamerUpdate: distance and index of every tile which may be loaded
+	std::vector<std::pair<float, uint32_t>> mRanking;
+
+	uint64_t bytesOf(const TileFileEntry& entry)
+	{
+		return static_cast<uint64_t>(entry.numVertices) * sizeof(glm::vec3) + static_cast<uint64_t>(entry.numIndices) * sizeof(uint32_t);
+	}
+
+	// Distance from a point to the tile's bounding box, 0 inside of it:
+	float distanceTo(const TileFileEntry& entry, const glm::vec3& point)
+	{
+		const glm::vec3 bounds_min(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]);
+		const glm::vec3 bounds_max(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2]);
+		return glm::length(point - glm::clamp(point, bounds_min, bounds_max));
+	}
+
+	bool readChunk(const TileFileEntry& entry, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices)
+	{
+		std::ifstream file(mPath, std::ios::binary);
+		if (!file.seekg(static_cast<std::streamoff>(entry.offset))) {
+			return false;
+		}
+		positions.resize(entry.numVertices);
+		indices.resize(entry.numIndices);
+		file.read(reinterpret_cast<char*>(positions.data()), sizeof(glm::vec3) * positions.size());
+		file.read(reinterpret_cast<char*>(indices.data()), sizeof(uint32_t) * indices.size());
+		if (!file) {
+			return false;
+		}
+		// Indices index into the tile's own vertices; anything else would read outside of its pool range:
+		for (uint32_t index : indices) {
+			if (index >= entry.numVertices) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void startLoading(Tile* tile)
+	{
+		tile->state = TILE_STATE_LOADING;
+		tile->evictWhenLoaded = false;
+		mCommittedBytes += bytesOf(tile->entry);
+		++mNumLoading;
+
+		const JobHandle read_job = jobSystemSubmit("Read Tile", [tile] {
+			if (!readChunk(tile->entry, tile->positions, tile->indices)) {
+				tile->positions.clear();
+				tile->indices.clear();
+			}
+		});
+		// Only the geometry pool keeps the geometry, the CPU copy is released right after staging:
+		const JobHandle stage_job = jobSystemSubmit("Stage Tile", [tile] {
+			tile->stagedMesh = kGeometryPoolInvalidMesh;
+			if (!tile->indices.empty()) {
+				tile->stagedMesh = geometryPoolAddMesh("Tile", tile->positions.data(), static_cast<uint32_t>(tile->positions.size()),
+					tile->indices.data(), static_cast<uint32_t>(tile->indices.size()));
+			}
+			std::vector<glm::vec3>().swap(tile->positions);
+			std::vector<uint32_t>().swap(tile->indices);
+		}, &read_job, 1);
+		jobSystemSubmit("Publish Tile", [tile] {
+			--mNumLoading;
+			if (kGeometryPoolInvalidMesh == tile->stagedMesh || tile->evictWhenLoaded) {
+				// The GPU has never seen the mesh, so it can be removed right away:
+				if (kGeometryPoolInvalidMesh != tile->stagedMesh) {
+					geometryPoolRemoveMesh(tile->stagedMesh);
+				}
+				else if (!tile->evictWhenLoaded) {
+					VKL_LOG("Tile streamer: unable to load the tile at offset " << tile->entry.offset << " of \"" << mPath << "\".");
+				}
+				tile->state = kGeometryPoolInvalidMesh == tile->stagedMesh && !tile->evictWhenLoaded ? TILE_STATE_FAILED : TILE_STATE_UNLOADED;
+				tile->stagedMesh = kGeometryPoolInvalidMesh;
+				mCommittedBytes -= bytesOf(tile->entry);
+				return;
+			}
+			tile->state = TILE_STATE_RESIDENT;
+			tile->mesh = tile->stagedMesh;
+			tile->stagedMesh = kGeometryPoolInvalidMesh;
+			mResidentBytes += bytesOf(tile->entry);
+			mStatistics.peakResidentBytes = std::max(mStatistics.peakResidentBytes, mResidentBytes);
+			++mStatistics.numLoads;
+			mResidentTilesChanged = true;
+		}, &stage_job, 1, JOB_AFFINITY_MAIN_THREAD);
+	}
+
+	void evict(Tile& tile)
+	{
+		const uint64_t bytes = bytesOf(tile.entry);
+		const GeometryPoolMesh mesh = tile.mesh;
+		// The budget is only released once the GPU has finished with the tile, so the pool never holds more than the budget:
+		frameSchedulerDeferDeletion([mesh, bytes] {
+			geometryPoolRemoveMesh(mesh);
+			mCommittedBytes -= bytes;
+		});
+		tile.state = TILE_STATE_UNLOADED;
+		tile.mesh = kGeometryPoolInvalidMesh;
+		mResidentBytes -= bytes;
+		++mStatistics.numEvictions;
+		mResidentTilesChanged = true;
+	}
+}
+
+bool tileStreamerCreate(const char* path, uint64_t budget_bytes, float load_distance)
+{
+	std::ifstream file(path, std::ios::binary);
+	TileFileHeader header = {};
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || kTileFileMagic != header.magic) {
+		return false;
+	}
+	std::vector<TileFileEntry> entries(header.numTiles);
+	if (!file.read(reinterpret_cast<char*>(entries.data()), sizeof(TileFileEntry) * entries.size())) {
+		return false;
+	}
+
+	mPath = path;
+	mBudgetBytes = budget_bytes;
+	mLoadDistance = load_distance;
+	mHeader = header;
+	mTiles.clear();
+	mTiles.resize(entries.size());
+	uint64_t total_bytes = 0;
+	mMaxVertexShare = mMaxIndexShare = 0.0;
+	for (size_t i = 0; i < entries.size(); ++i) {
+		mTiles[i].entry = entries[i];
+		const uint64_t bytes = bytesOf(entries[i]);
+		total_bytes += bytes;
+		if (bytes > 0) {
+			const double vertex_bytes = static_cast<double>(entries[i].numVertices) * sizeof(glm::vec3);
+			mMaxVertexShare = std::max(mMaxVertexShare, vertex_bytes / static_cast<double>(bytes));
+			mMaxIndexShare = std::max(mMaxIndexShare, 1.0 - vertex_bytes / static_cast<double>(bytes));
+		}
+	}
+	mResidentTiles.clear();
+	mResidentTilesChanged = false;
+	mCommittedBytes = 0;
+	mResidentBytes = 0;
+	mNumLoading = 0;
+	mStatistics = {};
+	mStatistics.numTiles = header.numTiles;
+	VKL_LOG("Tile streamer: \"" << path << "\" has " << header.numTiles << " tiles with " << static_cast<double>(total_bytes) / (1024.0 * 1024.0)
+		<< " MiB of geometry, the budget is " << static_cast<double>(budget_bytes) / (1024.0 * 1024.0) << " MiB.");
+	return true;
+}
+
+void tileStreamerDestroy()
+{
+	for (Tile& tile : mTiles) {
+		if (TILE_STATE_RESIDENT == tile.state) {
+			geometryPoolRemoveMesh(tile.mesh);
+		}
+	}
+	mTiles.clear();
+	mResidentTiles.clear();
+	mRanking.clear();
+	mCommittedBytes = 0;
+	mResidentBytes = 0;
+	mNumLoading = 0;
+}
+
+void tileStreamerUpdate(const glm::vec3& camera_position)
+{
+	PROFILER_ZONE("Update Tile Streamer");
+
+	// Rank all tiles within the load distance by their distance to the camera:
+	mRanking.clear();
+	for (uint32_t i = 0; i < static_cast<uint32_t>(mTiles.size()); ++i) {
+		const Tile& tile = mTiles[i];
+		if (TILE_STATE_FAILED == tile.state) {
+			continue;
+		}
+		float distance = distanceTo(tile.entry, camera_position);
+		if (mLoadDistance > 0.0f && distance > mLoadDistance) {
+			continue;
+		}
+		if (TILE_STATE_RESIDENT == tile.state || (TILE_STATE_LOADING == tile.state && !tile.evictWhenLoaded)) {
+			distance *= kResidentDistanceBias;
+		}
+		mRanking.emplace_back(distance, i);
+	}
+	std::sort(mRanking.begin(), mRanking.end());
+
+	// The nearest tiles which fit into the budget are wanted. Tiles which are too large are skipped, so that smaller ones can fill the budget:
+	for (Tile& tile : mTiles) {
+		tile.wanted = false;
+	}
+	uint64_t wanted_bytes = 0;
+	for (const auto& ranked : mRanking) {
+		const uint64_t bytes = bytesOf(mTiles[ranked.second].entry);
+		if (wanted_bytes + bytes <= mBudgetBytes) {
+			mTiles[ranked.second].wanted = true;
+			wanted_bytes += bytes;
+		}
+	}
+
+	bool evicted = false;
+	for (Tile& tile : mTiles) {
+		if (TILE_STATE_RESIDENT == tile.state && !tile.wanted) {
+			evict(tile);
+			evicted = true;
+		}
+		else if (TILE_STATE_LOADING == tile.state) {
+			tile.evictWhenLoaded = !tile.wanted;
+		}
+	}
+	if (evicted) {
+		for (Tile& tile : mTiles) {
+			if (TILE_STATE_FAILED == tile.state) {
+				tile.state = TILE_STATE_UNLOADED;
+			}
+		}
+	}
+
+	// Load the nearest wanted tiles first. Evicted tiles still count against the budget until the GPU has finished with them:
+	for (const auto& ranked : mRanking) {
+		if (mNumLoading >= kMaxConcurrentLoads) {
+			break;
+		}
+		Tile& tile = mTiles[ranked.second];
+		if (tile.wanted && TILE_STATE_UNLOADED == tile.state && mCommittedBytes + bytesOf(tile.entry) <= mBudgetBytes) {
+			startLoading(&tile);
+		}
+	}
+
+	if (mResidentTilesChanged) {
+		mResidentTiles.clear();
+		for (const Tile& tile : mTiles) {
+			if (TILE_STATE_RESIDENT == tile.state) {
+				mResidentTiles.push_back(StreamedTile{ tile.mesh,
+					glm::vec3(tile.entry.boundsMin[0], tile.entry.boundsMin[1], tile.entry.boundsMin[2]),
+					glm::vec3(tile.entry.boundsMax[0], tile.entry.boundsMax[1], tile.entry.boundsMax[2]) });
+			}
+		}
+		mResidentTilesChanged = false;
+		++mResidencyVersion;
+	}
+}
+
+const std::vector<StreamedTile>& tileStreamerGetResidentTiles()
+{
+	return mResidentTiles;
+}
+
+uint64_t tileStreamerGetResidencyVersion()
+{
+	return mResidencyVersion;
+}
+
+void tileStreamerGetBounds(glm::vec3& bounds_min, glm::vec3& bounds_max)
+{
+	bounds_min = glm::vec3(mHeader.boundsMin[0], mHeader.boundsMin[1], mHeader.boundsMin[2]);
+	bounds_max = glm::vec3(mHeader.boundsMax[0], mHeader.boundsMax[1], mHeader.boundsMax[2]);
+}
+
+void tileStreamerGetGeometryCapacity(uint32_t& max_vertices, uint32_t& max_indices)
+{
+	// However the committed tiles are mixed, their positions take at most mMaxVertexShare of the budget, and their
+	// indices at most mMaxIndexShare:
+	const double budget_bytes = static_cast<double>(mBudgetBytes);
+	max_vertices = static_cast<uint32_t>(std::min(std::ceil(budget_bytes * mMaxVertexShare / sizeof(glm::vec3)), static_cast<double>(1u << 28)));
+	max_indices = static_cast<uint32_t>(std::min(std::ceil(budget_bytes * mMaxIndexShare / sizeof(uint32_t)), static_cast<double>(1u << 28)));
+}
+
+TileStreamerStatistics tileStreamerGetStatistics()
+{
+	TileStreamerStatistics statistics = mStatistics;
+	statistics.numResident = static_cast<uint32_t>(mResidentTiles.size());
+	statistics.numLoading = mNumLoading;
+	statistics.residentBytes = mResidentBytes;
+	return statistics;
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#pragma once
+#include "GeometryPool.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+/* --------------------------------------------- */
+// Tile Streamer
+//
+// Streams scenes which are too large to keep in memory as a whole. An
+// offline tool (tools/ObjTiler.cpp) partitions a model into the cells of a
+// uniform grid and writes a tile file:
+//
+//   TileFileHeader | TileFileEntry[numTiles] | chunk 0 | chunk 1 | ...
+//
+// where every chunk holds a tile's welded positions followed by its 32-bit
+// indices. At runtime, only the table is kept in memory. Every frame, the
+// tiles within the load distance are ranked by their distance to the
+// camera, and the nearest ones which fit into the memory budget are made
+// resident. Loads run on the job system (read, then stage into the geometry
+// pool) and become visible on the main thread. Tiles which drop out of the
+// budget are evicted, and CPU copies are released right after staging.
+// Tiles which are being read, and evicted tiles until the GPU has finished
+// with them, count against the budget, so RAM usage for tiles stays below it.
+// The geometry pool's vertex and index buffers share the budget: each one
+// reserves the largest share of it which positions or indices take in any
+// tile (see tileStreamerGetGeometryCapacity). For tiles with similar ratios
+// of vertices to indices, both reservations together are close to the budget;
+// they never exceed twice the budget.
+/* --------------------------------------------- */
+
+//! Identifies tile files, "TIL1"
+constexpr uint32_t kTileFileMagic = 0x314C4954u;
+
+/*!
+ *	The beginning of a tile file.
+ */
+struct TileFileHeader {
+	//! kTileFileMagic
+	uint32_t magic;
+
+	//! Number of TileFileEntry records which follow the header
+	uint32_t numTiles;
+
+	//! Bounding box of the whole model
+	float boundsMin[3];
+	float boundsMax[3];
+};
+
+/*!
+ *	One tile in a tile file's table.
+ */
+struct TileFileEntry {
+	//! Bounding box of the tile's positions
+	float boundsMin[3];
+	float boundsMax[3];
+
+	//! Offset of the tile's chunk from the beginning of the file
+	uint64_t offset;
+
+	//! The chunk holds numVertices positions (3 floats each), followed by numIndices 32-bit indices
+	uint32_t numVertices;
+	uint32_t numIndices;
+};
+
+/*!
+ *	A tile whose geometry is resident in the geometry pool.
+ */
+struct StreamedTile {
+	//! The tile's mesh in the geometry pool
+	GeometryPoolMesh mesh;
+
+	//! Bounding box of the tile, in model space
+	glm::vec3 boundsMin;
+	glm::vec3 boundsMax;
+};
+
+/*!
+ *	Counters and current state, e.g., for logging.
+ */
+struct TileStreamerStatistics {
+	//! Number of tiles in the tile file
+	uint32_t numTiles;
+
+	//! Number of tiles which are resident, and which are being loaded
+	uint32_t numResident;
+	uint32_t numLoading;
+
+	//! Bytes of geometry of the resident tiles, and the maximum of it so far
+	uint64_t residentBytes;
+	uint64_t peakResidentBytes;
+
+	//! Total number of tiles which have been loaded and evicted since tileStreamerCreate
+	uint64_t numLoads;
+	uint64_t numEvictions;
+};
+
+/*!
+ *	Opens a tile file and reads its table. The job system and the frame scheduler must have been created, and the geometry
+ *	pool must be created before tileStreamerUpdate is called.
+ *	@param	path			Path of the tile file. Must stay valid until the streamer is destroyed.
+ *	@param	budget_bytes	Maximum number of bytes of geometry (positions and indices) which is resident or being loaded
+ *	@param	load_distance	Tiles further away from the camera than this are never loaded. 0 means no limit.
+ *	@return	True if the table has been read, false if the file cannot be read or is not a tile file.
+ */
+bool tileStreamerCreate(const char* path, uint64_t budget_bytes, float load_distance);
+
+/*!
+ *	Removes all resident tiles from the geometry pool. Call this after jobSystemDestroy, while the device is idle.
+ */
+void tileStreamerDestroy();
+
+/*!
+ *	Makes finished loads visible, evicts tiles which are no longer among the nearest ones within the budget, and
+ *	starts loading the nearest tiles which are not resident. Call this on the main thread, once per frame, after
+ *	jobSystemRunMainThreadJobs.
+ *	@param	camera_position		Position of the camera in model space
+ */
+void tileStreamerUpdate(const glm::vec3& camera_position);
+
+/*!
+ *	Returns all resident tiles. Only changes in tileStreamerUpdate.
+ */
+const std::vector<StreamedTile>& tileStreamerGetResidentTiles();
+
+/*!
+ *	Returns a number which changes whenever the set of resident tiles changes.
+ */
+uint64_t tileStreamerGetResidencyVersion();
+
+/*!
+ *	Returns the bounding box of the whole model.
+ */
+void tileStreamerGetBounds(glm::vec3& bounds_min, glm::vec3& bounds_max);
+
+/*!
+ *	Returns how many vertices and indices the geometry pool must have room for, so that every combination of tiles
+ *	which fits into the budget can be resident. Available after tileStreamerCreate, e.g., to size the geometry pool.
+ */
+void tileStreamerGetGeometryCapacity(uint32_t& max_vertices, uint32_t& max_indices);
+
+/*!
+ *	Returns counters and the current state.
+ */
+TileStreamerStatistics tileStreamerGetStatistics();
@@ -3,11 +3,29 @@
  */
 #include "VulkanHelpers.h"
 #include "VulkanLaunchpad.h"
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
 /* --------------------------------------------- */
 // Vulkan-Specific Helper Function Definitions
 /* --------------------------------------------- */
 
+// VK_EXT_debug_utils entry points; they stay nullptr if the extension is not enabled:
+static PFN_vkSetDebugUtilsObjectNameEXT  s_vkSetDebugUtilsObjectNameEXT  = nullptr;
+static PFN_vkCmdBeginDebugUtilsLabelEXT  s_vkCmdBeginDebugUtilsLabelEXT  = nullptr;
+static PFN_vkCmdEndDebugUtilsLabelEXT    s_vkCmdEndDebugUtilsLabelEXT    = nullptr;
+
+// Layouts of the pipelines created with hlpCreateGraphicsPipeline and hlpCreateComputePipeline:
+struct HlpPipelineLayouts {
+	VkPipelineLayout      pipelineLayout;
+	VkDescriptorSetLayout descriptorSetLayout;
+};
+static std::unordered_map<VkPipeline, HlpPipelineLayouts> s_pipelineLayouts;
+// Pipelines may be created on worker threads while others are in use:
+static std::mutex s_pipelineLayoutsMutex;
+
 bool hlpIsInstanceExtensionSupported(const char* extension_name) {
 	static std::vector<VkExtensionProperties> supportedExtensions = []() {
 		// Get the extensions which are supported:
@@ -52,6 +70,22 @@ bool hlpIsInstanceLayerSupported(const char* layer_name) {
 	return false;
 }
 
+bool hlpIsDeviceExtensionSupported(VkPhysicalDevice physical_device, const char* extension_name) {
+	uint32_t num_supported_extensions;
+	VkResult result = vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &num_supported_extensions, nullptr);
+	VKL_CHECK_VULKAN_ERROR(result);
+	std::vector<VkExtensionProperties> supported_extensions(num_supported_extensions);
+	result = vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &num_supported_extensions, supported_extensions.data());
+	VKL_CHECK_VULKAN_ERROR(result);
+
+	for (const auto& exProp : supported_extensions) {
+		if (strncmp(extension_name, exProp.extensionName, VK_MAX_EXTENSION_NAME_SIZE) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
 uint32_t hlpSelectPhysicalDeviceIndex(const VkPhysicalDevice* physical_devices, uint32_t physical_device_count, VkSurfaceKHR surface) {
 	// Iterate over all the physical devices and select one that satisfies all our requirements.
 	// Our requirements are:
@@ -120,10 +154,93 @@ VkSurfaceFormatKHR hlpGetSurfaceImageFormat(VkPhysicalDevice physical_device, Vk
 	return surface_formats[0];
 }
 
+uint32_t hlpFindMemoryTypeIndex(VkPhysicalDevice physical_device, uint32_t memory_type_bits, VkMemoryPropertyFlags memory_properties) {
+	VkPhysicalDeviceMemoryProperties physical_device_memory_properties;
+	vkGetPhysicalDeviceMemoryProperties(physical_device, &physical_device_memory_properties);
+	for (uint32_t i = 0; i < physical_device_memory_properties.memoryTypeCount; ++i) {
+		if ((memory_type_bits & (1u << i)) != 0
+			&& (physical_device_memory_properties.memoryTypes[i].propertyFlags & memory_properties) == memory_properties) {
+			return i;
+		}
+	}
+	VKL_EXIT_WITH_ERROR("Unable to find a suitable memory type.");
+}
+
+VkFormat hlpSelectDepthFormat(VkPhysicalDevice physical_device) {
+	const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM };
+	for (VkFormat format : candidates) {
+		VkFormatProperties format_properties;
+		vkGetPhysicalDeviceFormatProperties(physical_device, format, &format_properties);
+		if ((format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) != 0) {
+			return format;
+		}
+	}
+	// D16_UNORM must be supported by every Vulkan implementation:
+	return VK_FORMAT_D16_UNORM;
+}
+
+bool hlpIsPresentModeSupported(VkPhysicalDevice physical_device, VkSurfaceKHR surface, VkPresentModeKHR present_mode) {
+	uint32_t present_mode_count;
+	VkResult result = vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_mode_count, nullptr);
+	VKL_CHECK_VULKAN_ERROR(result);
+
+	std::vector<VkPresentModeKHR> present_modes(present_mode_count);
+	result = vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &present_mode_count, present_modes.data());
+	VKL_CHECK_VULKAN_ERROR(result);
+
+	for (VkPresentModeKHR mode : present_modes) {
+		if (mode == present_mode) {
+			return true;
+		}
+	}
+	return false;
+}
+
 VkSurfaceTransformFlagBitsKHR hlpGetSurfaceTransform(VkPhysicalDevice physical_device, VkSurfaceKHR surface) {
     return hlpGetPhysicalDeviceSurfaceCapabilities(physical_device, surface).currentTransform;
 }
 
+bool hlpLoadDebugUtilsFunctions(VkInstance instance) {
+	s_vkSetDebugUtilsObjectNameEXT = reinterpret_cast<PFN_vkSetDebugUtilsObjectNameEXT>(vkGetInstanceProcAddr(instance, "vkSetDebugUtilsObjectNameEXT"));
+	s_vkCmdBeginDebugUtilsLabelEXT = reinterpret_cast<PFN_vkCmdBeginDebugUtilsLabelEXT>(vkGetInstanceProcAddr(instance, "vkCmdBeginDebugUtilsLabelEXT"));
+	s_vkCmdEndDebugUtilsLabelEXT   = reinterpret_cast<PFN_vkCmdEndDebugUtilsLabelEXT>(vkGetInstanceProcAddr(instance, "vkCmdEndDebugUtilsLabelEXT"));
+	return nullptr != s_vkSetDebugUtilsObjectNameEXT && nullptr != s_vkCmdBeginDebugUtilsLabelEXT && nullptr != s_vkCmdEndDebugUtilsLabelEXT;
+}
+
+void hlpSetDebugUtilsObjectName(VkDevice device, VkObjectType object_type, uint64_t object_handle, const char* name) {
+	if (nullptr == s_vkSetDebugUtilsObjectNameEXT || 0 == object_handle) {
+		return;
+	}
+	VkDebugUtilsObjectNameInfoEXT name_info = {};
+	name_info.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+	name_info.objectType = object_type;
+	name_info.objectHandle = object_handle;
+	name_info.pObjectName = name;
+	s_vkSetDebugUtilsObjectNameEXT(device, &name_info);
+}
+
+void hlpBeginDebugUtilsLabel(VkCommandBuffer command_buffer, const char* label_name, const float* color) {
+	if (nullptr == s_vkCmdBeginDebugUtilsLabelEXT) {
+		return;
+	}
+	VkDebugUtilsLabelEXT label = {};
+	label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+	label.pLabelName = label_name;
+	if (nullptr != color) {
+		for (int i = 0; i < 4; ++i) {
+			label.color[i] = color[i];
+		}
+	}
+	s_vkCmdBeginDebugUtilsLabelEXT(command_buffer, &label);
+}
+
+void hlpEndDebugUtilsLabel(VkCommandBuffer command_buffer) {
+	if (nullptr == s_vkCmdEndDebugUtilsLabelEXT) {
+		return;
+	}
+	s_vkCmdEndDebugUtilsLabelEXT(command_buffer);
+}
+
 void hlpRecordPipelineBarrierWithImageLayoutTransition(
 	VkCommandBuffer            command_buffer,
 	VkPipelineStageFlags       src_stage_mask,
@@ -132,7 +249,12 @@ void hlpRecordPipelineBarrierWithImageLayoutTransition(
 	VkAccessFlags              dst_access_mask,
 	VkImage                    image,
 	VkImageLayout              old_layout,
-	VkImageLayout              new_layout)
+	VkImageLayout              new_layout,
+	VkImageAspectFlags         aspect_mask,
+	uint32_t                   base_mip_level,
+	uint32_t                   level_count,
+	uint32_t                   base_array_layer,
+	uint32_t                   layer_count)
 {
 	VkImageMemoryBarrier image_memory_barrier = {};
 	image_memory_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -143,11 +265,11 @@ void hlpRecordPipelineBarrierWithImageLayoutTransition(
 	image_memory_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 	image_memory_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 	image_memory_barrier.image = image;
-	image_memory_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	image_memory_barrier.subresourceRange.baseMipLevel = 0;
-	image_memory_barrier.subresourceRange.levelCount = 1;
-	image_memory_barrier.subresourceRange.baseArrayLayer = 0;
-	image_memory_barrier.subresourceRange.layerCount = 1;
+	image_memory_barrier.subresourceRange.aspectMask = aspect_mask;
+	image_memory_barrier.subresourceRange.baseMipLevel = base_mip_level;
+	image_memory_barrier.subresourceRange.levelCount = level_count;
+	image_memory_barrier.subresourceRange.baseArrayLayer = base_array_layer;
+	image_memory_barrier.subresourceRange.layerCount = layer_count;
 	vkCmdPipelineBarrier(command_buffer,
 		src_stage_mask, dst_stage_mask,
 		0,
@@ -230,3 +352,502 @@ void hlpDestroySampler(VkDevice device, VkSampler sampler)
 {
 	vkDestroySampler(device, sampler, nullptr);
 }
+
+HlpMappedBuffer hlpCreateMappedBuffer(VkPhysicalDevice physical_device, VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage,
+	MemoryCategory category, const char* name)
+{
+	HlpMappedBuffer mapped_buffer = {};
+	mapped_buffer.size = size;
+
+	VkBufferCreateInfo buffer_create_info = {};
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.size = size;
+	buffer_create_info.usage = usage;
+	buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	VkResult result = vkCreateBuffer(device, &buffer_create_info, nullptr, &mapped_buffer.buffer);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	VkMemoryRequirements memory_requirements;
+	vkGetBufferMemoryRequirements(device, mapped_buffer.buffer, &memory_requirements);
+	VkMemoryAllocateInfo memory_allocate_info = {};
+	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memory_allocate_info.allocationSize = memory_requirements.size;
+	memory_allocate_info.memoryTypeIndex = hlpFindMemoryTypeIndex(physical_device, memory_requirements.memoryTypeBits,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	result = MEMORY_TRACKER_ALLOCATE(device, &memory_allocate_info, &mapped_buffer.memory, category, name);
+	VKL_CHECK_VULKAN_RESULT(result);
+	result = vkBindBufferMemory(device, mapped_buffer.buffer, mapped_buffer.memory, 0);
+	VKL_CHECK_VULKAN_RESULT(result);
+	result = vkMapMemory(device, mapped_buffer.memory, 0, VK_WHOLE_SIZE, 0, &mapped_buffer.mappedData);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	hlpSetDebugUtilsObjectName(device, VK_OBJECT_TYPE_BUFFER, (uint64_t)mapped_buffer.buffer, name);
+	return mapped_buffer;
+}
+
+void hlpDestroyMappedBuffer(VkDevice device, HlpMappedBuffer& mapped_buffer)
+{
+	if (VK_NULL_HANDLE != mapped_buffer.memory) {
+		vkUnmapMemory(device, mapped_buffer.memory);
+	}
+	vkDestroyBuffer(device, mapped_buffer.buffer, nullptr);
+	memoryTrackerFree(device, mapped_buffer.memory);
+	mapped_buffer = {};
+}
+
+HlpImage hlpCreateImage(VkPhysicalDevice physical_device, VkDevice device, VkFormat format, VkExtent2D extent, uint32_t num_layers,
+	VkImageUsageFlags usage, VkImageAspectFlags aspect, MemoryCategory category, const char* name)
+{
+	HlpImage image = {};
+
+	VkImageCreateInfo image_create_info = {};
+	image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	image_create_info.imageType = VK_IMAGE_TYPE_2D;
+	image_create_info.format = format;
+	image_create_info.extent = VkExtent3D{ extent.width, extent.height, 1 };
+	image_create_info.mipLevels = 1;
+	image_create_info.arrayLayers = num_layers;
+	image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+	image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	image_create_info.usage = usage;
+	image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	VkResult result = vkCreateImage(device, &image_create_info, nullptr, &image.image);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	VkMemoryRequirements memory_requirements;
+	vkGetImageMemoryRequirements(device, image.image, &memory_requirements);
+	VkMemoryAllocateInfo memory_allocate_info = {};
+	memory_allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memory_allocate_info.allocationSize = memory_requirements.size;
+	memory_allocate_info.memoryTypeIndex = hlpFindMemoryTypeIndex(physical_device, memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	result = MEMORY_TRACKER_ALLOCATE(device, &memory_allocate_info, &image.memory, category, name);
+	VKL_CHECK_VULKAN_RESULT(result);
+	result = vkBindImageMemory(device, image.image, image.memory, 0);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	VkImageViewCreateInfo image_view_create_info = {};
+	image_view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	image_view_create_info.image = image.image;
+	image_view_create_info.viewType = num_layers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+	image_view_create_info.format = format;
+	image_view_create_info.subresourceRange = { aspect, 0, 1, 0, num_layers };
+	result = vkCreateImageView(device, &image_view_create_info, nullptr, &image.view);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	hlpSetDebugUtilsObjectName(device, VK_OBJECT_TYPE_IMAGE, (uint64_t)image.image, name);
+	return image;
+}
+
+void hlpDestroyImage(VkDevice device, HlpImage& image)
+{
+	vkDestroyImageView(device, image.view, nullptr);
+	vkDestroyImage(device, image.image, nullptr);
+	memoryTrackerFree(device, image.memory);
+	image = {};
+}
+
+VkRenderPass hlpCreateCompatibleRenderPass(VkDevice device, VkFormat color_format, VkFormat depth_format, uint32_t view_mask)
+{
+	// Render pass compatibility only depends on the attachments' formats and sample counts and on the
+	// attachment references, not on load/store operations or layouts:
+	VkAttachmentDescription attachments[2] = {};
+	attachments[0].format = color_format;
+	attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+	attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[0].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	attachments[1].format = depth_format;
+	attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+	attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference color_reference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+	VkAttachmentReference depth_reference = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+	const bool has_depth = VK_FORMAT_UNDEFINED != depth_format;
+
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &color_reference;
+	subpass.pDepthStencilAttachment = has_depth ? &depth_reference : nullptr;
+
+	VkRenderPassCreateInfo render_pass_create_info = {};
+	render_pass_create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	render_pass_create_info.attachmentCount = has_depth ? 2 : 1;
+	render_pass_create_info.pAttachments = attachments;
+	render_pass_create_info.subpassCount = 1;
+	render_pass_create_info.pSubpasses = &subpass;
+
+	// The view mask is part of the compatibility, too. All views are rendered concurrently:
+	VkRenderPassMultiviewCreateInfo multiview_create_info = {};
+	multiview_create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO;
+	multiview_create_info.subpassCount = 1;
+	multiview_create_info.pViewMasks = &view_mask;
+	multiview_create_info.correlationMaskCount = 1;
+	multiview_create_info.pCorrelationMasks = &view_mask;
+	if (0 != view_mask) {
+		render_pass_create_info.pNext = &multiview_create_info;
+	}
+
+	VkRenderPass render_pass;
+	VkResult result = vkCreateRenderPass(device, &render_pass_create_info, nullptr, &render_pass);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	return render_pass;
+}
+
+VkRenderPass hlpCreateOffscreenRenderPass(VkDevice device, VkFormat color_format, VkFormat depth_format, VkImageLayout color_final_layout,
+	uint32_t view_mask)
+{
+	// The color attachment is read by copies or by fragment shaders after the render pass:
+	const bool copied = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL == color_final_layout;
+	const VkPipelineStageFlags read_stage = copied ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	const VkAccessFlags read_access = copied ? VK_ACCESS_TRANSFER_READ_BIT : VK_ACCESS_SHADER_READ_BIT;
+
+	VkAttachmentDescription attachments[2] = {};
+	attachments[0].format = color_format;
+	attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+	attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[0].finalLayout = color_final_layout;
+	attachments[1].format = depth_format;
+	attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+	attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference color_reference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+	VkAttachmentReference depth_reference = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &color_reference;
+	subpass.pDepthStencilAttachment = &depth_reference;
+
+	// The previous frame's reads of the color attachment (which fragment shaders may sample even after a copy) and its
+	// depth test must have finished before the attachments are cleared, and the color attachment must have been written
+	// before it is read:
+	VkSubpassDependency dependencies[2] = {};
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = read_stage | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[1].dstStageMask = read_stage;
+	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstAccessMask = read_access;
+
+	VkRenderPassCreateInfo render_pass_create_info = {};
+	render_pass_create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	render_pass_create_info.attachmentCount = 2;
+	render_pass_create_info.pAttachments = attachments;
+	render_pass_create_info.subpassCount = 1;
+	render_pass_create_info.pSubpasses = &subpass;
+	render_pass_create_info.dependencyCount = 2;
+	render_pass_create_info.pDependencies = dependencies;
+
+	// The views are close to each other, i.e., they see mostly the same geometry, which implementations may exploit:
+	VkRenderPassMultiviewCreateInfo multiview_create_info = {};
+	multiview_create_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO;
+	multiview_create_info.subpassCount = 1;
+	multiview_create_info.pViewMasks = &view_mask;
+	multiview_create_info.correlationMaskCount = 1;
+	multiview_create_info.pCorrelationMasks = &view_mask;
+	if (0 != view_mask) {
+		render_pass_create_info.pNext = &multiview_create_info;
+	}
+
+	VkRenderPass render_pass;
+	VkResult result = vkCreateRenderPass(device, &render_pass_create_info, nullptr, &render_pass);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	return render_pass;
+}
+
+VkFramebuffer hlpCreateFramebuffer(VkDevice device, VkRenderPass render_pass, VkImageView color_view, VkImageView depth_view, VkExtent2D extent)
+{
+	const VkImageView attachments[2] = { color_view, depth_view };
+	VkFramebufferCreateInfo framebuffer_create_info = {};
+	framebuffer_create_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebuffer_create_info.renderPass = render_pass;
+	framebuffer_create_info.attachmentCount = 2;
+	framebuffer_create_info.pAttachments = attachments;
+	framebuffer_create_info.width = extent.width;
+	framebuffer_create_info.height = extent.height;
+	framebuffer_create_info.layers = 1;
+
+	VkFramebuffer framebuffer;
+	VkResult result = vkCreateFramebuffer(device, &framebuffer_create_info, nullptr, &framebuffer);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	return framebuffer;
+}
+
+static VkShaderModule hlpLoadShaderModule(VkDevice device, const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) {
+		VKL_EXIT_WITH_ERROR("Unable to open SPIR-V file \"" << path << "\"");
+	}
+	const size_t size = static_cast<size_t>(file.tellg());
+	std::vector<uint32_t> code((size + 3) / 4);
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(code.data()), size);
+
+	VkShaderModuleCreateInfo shader_module_create_info = {};
+	shader_module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	shader_module_create_info.codeSize = size;
+	shader_module_create_info.pCode = code.data();
+
+	VkShaderModule shader_module;
+	VkResult result = vkCreateShaderModule(device, &shader_module_create_info, nullptr, &shader_module);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	return shader_module;
+}
+
+VkPipeline hlpCreateGraphicsPipeline(VkDevice device, const VklGraphicsPipelineConfig& config, const HlpPipelineState& state,
+	VkRenderPass render_pass, VkExtent2D extent, VkPipelineCache pipeline_cache)
+{
+	VkResult result;
+
+	// Layouts:
+	HlpPipelineLayouts layouts = {};
+	VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info = {};
+	descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptor_set_layout_create_info.bindingCount = static_cast<uint32_t>(config.descriptorLayout.size());
+	descriptor_set_layout_create_info.pBindings = config.descriptorLayout.data();
+	result = vkCreateDescriptorSetLayout(device, &descriptor_set_layout_create_info, nullptr, &layouts.descriptorSetLayout);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
+	pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipeline_layout_create_info.setLayoutCount = 1;
+	pipeline_layout_create_info.pSetLayouts = &layouts.descriptorSetLayout;
+	result = vkCreatePipelineLayout(device, &pipeline_layout_create_info, nullptr, &layouts.pipelineLayout);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	// Specialization constants, shared by all stages (constants which a stage does not declare are ignored):
+	VkSpecializationMapEntry specialization_entries[kHlpMaxSpecializationConstants];
+	for (uint32_t i = 0; i < state.numSpecializationConstants; ++i) {
+		specialization_entries[i].constantID = i;
+		specialization_entries[i].offset = i * sizeof(uint32_t);
+		specialization_entries[i].size = sizeof(uint32_t);
+	}
+	VkSpecializationInfo specialization_info = {};
+	specialization_info.mapEntryCount = state.numSpecializationConstants;
+	specialization_info.pMapEntries = specialization_entries;
+	specialization_info.dataSize = state.numSpecializationConstants * sizeof(uint32_t);
+	specialization_info.pData = state.specializationConstants;
+	const VkSpecializationInfo* stage_specialization_info = state.numSpecializationConstants > 0 ? &specialization_info : nullptr;
+
+	// Shader stages:
+	VkPipelineShaderStageCreateInfo shader_stages[2] = {};
+	shader_stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	shader_stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+	shader_stages[0].module = hlpLoadShaderModule(device, std::string(config.vertexShaderPath));
+	shader_stages[0].pName = "main";
+	shader_stages[0].pSpecializationInfo = stage_specialization_info;
+	uint32_t num_shader_stages = 1;
+	if (state.useFragmentShader) {
+		shader_stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shader_stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		shader_stages[1].module = hlpLoadShaderModule(device, std::string(config.fragmentShaderPath));
+		shader_stages[1].pName = "main";
+		shader_stages[1].pSpecializationInfo = stage_specialization_info;
+		num_shader_stages = 2;
+	}
+
+	// Fixed-function state:
+	VkPipelineVertexInputStateCreateInfo vertex_input_state = {};
+	vertex_input_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	vertex_input_state.vertexBindingDescriptionCount = static_cast<uint32_t>(config.vertexInputBuffers.size());
+	vertex_input_state.pVertexBindingDescriptions = config.vertexInputBuffers.data();
+	vertex_input_state.vertexAttributeDescriptionCount = static_cast<uint32_t>(config.inputAttributeDescriptions.size());
+	vertex_input_state.pVertexAttributeDescriptions = config.inputAttributeDescriptions.data();
+
+	VkPipelineInputAssemblyStateCreateInfo input_assembly_state = {};
+	input_assembly_state.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	input_assembly_state.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+	VkViewport viewport = { 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+	VkRect2D scissor = { VkOffset2D{ 0, 0 }, extent };
+	VkPipelineViewportStateCreateInfo viewport_state = {};
+	viewport_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+	viewport_state.viewportCount = 1;
+	viewport_state.pViewports = &viewport;
+	viewport_state.scissorCount = 1;
+	viewport_state.pScissors = &scissor;
+
+	VkPipelineRasterizationStateCreateInfo rasterization_state = {};
+	rasterization_state.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+	rasterization_state.polygonMode = config.polygonDrawMode;
+	rasterization_state.cullMode = state.cullMode;
+	rasterization_state.frontFace = state.frontFace;
+	rasterization_state.lineWidth = 1.0f;
+
+	VkPipelineMultisampleStateCreateInfo multisample_state = {};
+	multisample_state.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+	multisample_state.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+	VkPipelineDepthStencilStateCreateInfo depth_stencil_state = {};
+	depth_stencil_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+	depth_stencil_state.depthTestEnable = state.depthTestEnable;
+	depth_stencil_state.depthWriteEnable = state.depthWriteEnable;
+	depth_stencil_state.depthCompareOp = state.depthCompareOp;
+
+	VkPipelineColorBlendAttachmentState color_blend_attachment = {};
+	color_blend_attachment.colorWriteMask = state.colorWriteMask;
+	VkPipelineColorBlendStateCreateInfo color_blend_state = {};
+	color_blend_state.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+	color_blend_state.attachmentCount = 1;
+	color_blend_state.pAttachments = &color_blend_attachment;
+
+	const VkDynamicState dynamic_states[2] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+	VkPipelineDynamicStateCreateInfo dynamic_state = {};
+	dynamic_state.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamic_state.dynamicStateCount = 2;
+	dynamic_state.pDynamicStates = dynamic_states;
+
+	VkGraphicsPipelineCreateInfo pipeline_create_info = {};
+	pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipeline_create_info.stageCount = num_shader_stages;
+	pipeline_create_info.pStages = shader_stages;
+	pipeline_create_info.pVertexInputState = &vertex_input_state;
+	pipeline_create_info.pInputAssemblyState = &input_assembly_state;
+	pipeline_create_info.pViewportState = &viewport_state;
+	pipeline_create_info.pRasterizationState = &rasterization_state;
+	pipeline_create_info.pMultisampleState = &multisample_state;
+	pipeline_create_info.pDepthStencilState = &depth_stencil_state;
+	pipeline_create_info.pColorBlendState = &color_blend_state;
+	pipeline_create_info.pDynamicState = state.dynamicViewport ? &dynamic_state : nullptr;
+	pipeline_create_info.layout = layouts.pipelineLayout;
+	pipeline_create_info.renderPass = render_pass;
+	pipeline_create_info.subpass = 0;
+
+	VkPipeline pipeline;
+	result = vkCreateGraphicsPipelines(device, pipeline_cache, 1, &pipeline_create_info, nullptr, &pipeline);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	for (uint32_t i = 0; i < num_shader_stages; ++i) {
+		vkDestroyShaderModule(device, shader_stages[i].module, nullptr);
+	}
+	std::lock_guard<std::mutex> lock(s_pipelineLayoutsMutex);
+	s_pipelineLayouts[pipeline] = layouts;
+	return pipeline;
+}
+
+VkPipeline hlpCreateFullscreenPipeline(VkDevice device, const char* fragment_shader_path, const std::vector<VkDescriptorSetLayoutBinding>& descriptor_layout,
+	VkRenderPass render_pass, VkExtent2D extent, const HlpPipelineState& state)
+{
+	VklGraphicsPipelineConfig config;
+	config.vertexShaderPath = SHADER_BINARY_DIR "/fullscreen.spv";
+	config.fragmentShaderPath = fragment_shader_path;
+	config.polygonDrawMode = VK_POLYGON_MODE_FILL;
+	config.triangleCullingMode = VK_CULL_MODE_NONE;
+	config.descriptorLayout = descriptor_layout;
+
+	HlpPipelineState fullscreen_state = state;
+	fullscreen_state.cullMode = VK_CULL_MODE_NONE;
+	fullscreen_state.depthTestEnable = VK_FALSE;
+	fullscreen_state.depthWriteEnable = VK_FALSE;
+	return hlpCreateGraphicsPipeline(device, config, fullscreen_state, render_pass, extent);
+}
+
+VkPipeline hlpCreateComputePipeline(VkDevice device, const char* shader_path, const std::vector<VkDescriptorSetLayoutBinding>& descriptor_layout,
+	uint32_t push_constants_size)
+{
+	HlpPipelineLayouts layouts = {};
+	VkDescriptorSetLayoutCreateInfo descriptor_set_layout_create_info = {};
+	descriptor_set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptor_set_layout_create_info.bindingCount = static_cast<uint32_t>(descriptor_layout.size());
+	descriptor_set_layout_create_info.pBindings = descriptor_layout.data();
+	VkResult result = vkCreateDescriptorSetLayout(device, &descriptor_set_layout_create_info, nullptr, &layouts.descriptorSetLayout);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	VkPushConstantRange push_constant_range = {};
+	push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	push_constant_range.offset = 0;
+	push_constant_range.size = push_constants_size;
+	VkPipelineLayoutCreateInfo pipeline_layout_create_info = {};
+	pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipeline_layout_create_info.setLayoutCount = 1;
+	pipeline_layout_create_info.pSetLayouts = &layouts.descriptorSetLayout;
+	pipeline_layout_create_info.pushConstantRangeCount = push_constants_size > 0 ? 1 : 0;
+	pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+	result = vkCreatePipelineLayout(device, &pipeline_layout_create_info, nullptr, &layouts.pipelineLayout);
+	VKL_CHECK_VULKAN_RESULT(result);
+
+	VkComputePipelineCreateInfo pipeline_create_info = {};
+	pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipeline_create_info.stage.module = hlpLoadShaderModule(device, std::string(shader_path));
+	pipeline_create_info.stage.pName = "main";
+	pipeline_create_info.layout = layouts.pipelineLayout;
+
+	VkPipeline pipeline;
+	result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &pipeline);
+	VKL_CHECK_VULKAN_RESULT(result);
+	vkDestroyShaderModule(device, pipeline_create_info.stage.module, nullptr);
+
+	std::lock_guard<std::mutex> lock(s_pipelineLayoutsMutex);
+	s_pipelineLayouts[pipeline] = layouts;
+	return pipeline;
+}
+
+VkPipelineLayout hlpGetPipelineLayout(VkPipeline pipeline)
+{
+	std::lock_guard<std::mutex> lock(s_pipelineLayoutsMutex);
+	auto it = s_pipelineLayouts.find(pipeline);
+	if (it == s_pipelineLayouts.end()) {
+		VKL_EXIT_WITH_ERROR("The given pipeline has not been created with hlpCreateGraphicsPipeline or hlpCreateComputePipeline.");
+	}
+	return it->second.pipelineLayout;
+}
+
+VkDescriptorSetLayout hlpGetDescriptorSetLayout(VkPipeline pipeline)
+{
+	std::lock_guard<std::mutex> lock(s_pipelineLayoutsMutex);
+	auto it = s_pipelineLayouts.find(pipeline);
+	if (it == s_pipelineLayouts.end()) {
+		VKL_EXIT_WITH_ERROR("The given pipeline has not been created with hlpCreateGraphicsPipeline or hlpCreateComputePipeline.");
+	}
+	return it->second.descriptorSetLayout;
+}
+
+void hlpBindDescriptorSetToPipeline(VkCommandBuffer command_buffer, VkDescriptorSet descriptor_set, VkPipeline pipeline)
+{
+	vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, hlpGetPipelineLayout(pipeline), 0, 1, &descriptor_set, 0, nullptr);
+}
+
+void hlpDestroyGraphicsPipeline(VkDevice device, VkPipeline pipeline)
+{
+	std::lock_guard<std::mutex> lock(s_pipelineLayoutsMutex);
+	auto it = s_pipelineLayouts.find(pipeline);
+	if (it != s_pipelineLayouts.end()) {
+		vkDestroyPipelineLayout(device, it->second.pipelineLayout, nullptr);
+		vkDestroyDescriptorSetLayout(device, it->second.descriptorSetLayout, nullptr);
+		s_pipelineLayouts.erase(it);
+	}
+	vkDestroyPipeline(device, pipeline, nullptr);
+}
@@ -3,6 +3,9 @@
  */
 #include <vulkan/vulkan.h>
 #include <vector>
+#include "MemoryTracker.h"
+
+struct VklGraphicsPipelineConfig;
 
 /* --------------------------------------------- */
 // Vulkan-Specific Helper Struct Definitions
@@ -48,6 +51,80 @@ struct HlpGeometryHandles {
 	VkBuffer textureCoordinatesBuffer;
  };
 
+//! Maximum number of specialization constants of a pipeline created with hlpCreateGraphicsPipeline
+constexpr uint32_t kHlpMaxSpecializationConstants = 8;
+
+/*!
+ * Fixed-function state of a graphics pipeline which VklGraphicsPipelineConfig does not cover.
+ * Used by hlpCreateGraphicsPipeline.
+ */
+struct HlpPipelineState {
+	//! Which faces to cull. Overrides VklGraphicsPipelineConfig::triangleCullingMode.
+	VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+
+	//! Which winding order is front-facing, in framebuffer coordinates. With a projection matrix that
+	//! flips the y axis for Vulkan's framebuffer coordinates, counter-clockwise meshes stay counter-clockwise.
+	VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+	//! Whether or not fragments are tested against the depth attachment
+	VkBool32 depthTestEnable = VK_TRUE;
+
+	//! Whether or not fragments which pass the depth test write their depth
+	VkBool32 depthWriteEnable = VK_TRUE;
+
+	//! The depth test's comparison operator. VK_COMPARE_OP_EQUAL after a depth pre-pass.
+	VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+
+	//! Which color components are written. 0 for depth-only passes.
+	VkColorComponentFlags colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+	//! If false, the pipeline has no fragment shader (e.g., for depth-only passes).
+	bool useFragmentShader = true;
+
+	//! If true, viewport and scissor are dynamic state, which must be set with vkCmdSetViewport and vkCmdSetScissor
+	//! before drawing, e.g., to render into a part of the attachments. Otherwise, both cover the whole extent.
+	bool dynamicViewport = false;
+
+	//! Values of the specialization constants with constant_id 0 to numSpecializationConstants - 1, which are
+	//! passed to all shader stages. Every value is 32 bits wide, i.e., a uint, int, bool, or float bit pattern.
+	uint32_t specializationConstants[kHlpMaxSpecializationConstants] = {};
+
+	//! Number of valid entries in specializationConstants
+	uint32_t numSpecializationConstants = 0;
+};
+
+/*!
+ * A buffer in host-visible, host-coherent memory which stays mapped for its whole lifetime.
+ * Created with hlpCreateMappedBuffer.
+ */
+struct HlpMappedBuffer {
+	//! The buffer handle
+	VkBuffer buffer;
+
+	//! The buffer's backing memory
+	VkDeviceMemory memory;
+
+	//! Pointer to the mapped memory. Might be write-combined => write sequentially and never read from it.
+	void* mappedData;
+
+	//! The size of the buffer in bytes
+	VkDeviceSize size;
+};
+
+/*!
+ * An image in device-local memory, with a view of all of its layers. Created with hlpCreateImage.
+ */
+struct HlpImage {
+	//! The image handle
+	VkImage image;
+
+	//! The image's backing memory
+	VkDeviceMemory memory;
+
+	//! A view of the image's first mipmap level and all of its layers
+	VkImageView view;
+};
+
 /* --------------------------------------------- */
 // Vulkan-Specific Helper Function Definitions
 // As a convention, their names start with `hlp`.
@@ -69,6 +146,15 @@ bool hlpIsInstanceExtensionSupported(const char* extension_name);
  */
 bool hlpIsInstanceLayerSupported(const char* layer_name);
 
+/*!
+ *	Queries the given physical device's supported device extensions and determines whether or not
+ *	the given extension name is among them.
+ *	@param		physical_device		The physical device to be checked.
+ *	@param		extension_name		The extension name to be checked.
+ *	@return		True if the extension name is supported by the physical device, false otherwise.
+ */
+bool hlpIsDeviceExtensionSupported(VkPhysicalDevice physical_device, const char* extension_name);
+
 /*!
  *	From the given list of physical devices, select the first one that satisfies all requirements.
  *	@param		physical_devices		A pointer which points to contiguous memory of #physical_device_count sequentially
@@ -105,6 +191,26 @@ VkSurfaceCapabilitiesKHR hlpGetPhysicalDeviceSurfaceCapabilities(VkPhysicalDevic
  */
 VkSurfaceFormatKHR hlpGetSurfaceImageFormat(VkPhysicalDevice physical_device, VkSurfaceKHR surface);
 
+/*!
+ *	Finds the index of a memory type which is allowed by the given memory type bits (as returned in
+ *	VkMemoryRequirements::memoryTypeBits) and which has all of the given memory properties.
+ *	@return		The index of a suitable memory type. Exits with an error if there is none.
+ */
+uint32_t hlpFindMemoryTypeIndex(VkPhysicalDevice physical_device, uint32_t memory_type_bits, VkMemoryPropertyFlags memory_properties);
+
+/*!
+ *	Selects the most precise depth format which the given physical device supports as depth attachment
+ *	with optimal tiling. D32_SFLOAT is preferred, followed by D32_SFLOAT_S8_UINT, D24_UNORM_S8_UINT, and D16_UNORM.
+ *	@return		A supported depth format is returned.
+ */
+VkFormat hlpSelectDepthFormat(VkPhysicalDevice physical_device);
+
+/*!
+ *	Determines whether or not the given present mode is supported for the given physical device and surface.
+ *	@return		True if the present mode is supported, false otherwise.
+ */
+bool hlpIsPresentModeSupported(VkPhysicalDevice physical_device, VkSurfaceKHR surface, VkPresentModeKHR present_mode);
+
 /*!
  *	Based on the given physical device and the surface, return its surface transform flag.
  *	This can be used to set the swap chain to the same configuration as the surface's current transform.
@@ -112,16 +218,58 @@ VkSurfaceFormatKHR hlpGetSurfaceImageFormat(VkPhysicalDevice physical_device, Vk
  */
 VkSurfaceTransformFlagBitsKHR hlpGetSurfaceTransform(VkPhysicalDevice physical_device, VkSurfaceKHR surface);
 
+/*!
+ *	Loads the VK_EXT_debug_utils entry points (object names and command buffer labels) for the given instance.
+ *	Must be called after instance creation. If the extension has not been enabled on the instance, all the
+ *	hlp*DebugUtils* functions below silently do nothing, so that they can be called unconditionally.
+ *	@param		instance			The instance which VK_EXT_debug_utils may have been enabled for.
+ *	@return		True if the entry points could be loaded, false otherwise.
+ */
+bool hlpLoadDebugUtilsFunctions(VkInstance instance);
+
+/*!
+ *	Assigns a human-readable name to a Vulkan object, so that validation messages, graphics debuggers,
+ *	and external profilers (RenderDoc, Nsight, RGP, ...) can show it instead of a bare handle value.
+ *	@param		device				Device handle
+ *	@param		object_type			The type of the object, e.g. VK_OBJECT_TYPE_BUFFER
+ *	@param		object_handle		The object's handle, cast to uint64_t
+ *	@param		name				The name to be assigned
+ */
+void hlpSetDebugUtilsObjectName(VkDevice device, VkObjectType object_type, uint64_t object_handle, const char* name);
+
+/*!
+ *	Opens a named label region in the given command buffer. Every call must be matched by a call to
+ *	hlpEndDebugUtilsLabel on the same command buffer. Label regions can be nested.
+ *	@param		command_buffer		Command buffer to record the label into
+ *	@param		label_name			Name of the region, e.g. the name of a render pass
+ *	@param		color				Optional RGBA color which tools may use to display the region (nullptr for none)
+ */
+void hlpBeginDebugUtilsLabel(VkCommandBuffer command_buffer, const char* label_name, const float* color = nullptr);
+
+/*!
+ *	Closes the label region that has most recently been opened with hlpBeginDebugUtilsLabel.
+ *	@param		command_buffer		Command buffer to record the end of the label region into
+ */
+void hlpEndDebugUtilsLabel(VkCommandBuffer command_buffer);
+
 /*!
  *  Records an image memory barrier with layout transition into the given command buffer.
- *  @param	command_buffer	Command buffer to record the image memory barrier into
- *  @param	src_stage_mask	The stage(s) of previous commands to sync with.
- *	@param	dst_stage_mask	The stage(s) of subsequent commands to sync with. 
- *	@param	src_access_mask	The memory access(es) of previous commands to be made available.
- *	@param	dst_access_mask	The memory access(es) of subsequent commands to make the data visible to.
- *	@param	image			The image that must be synchronized
- *	@param	old_layout		The previous image layout, i.e. the layout transitioned from.
- *	@param	new_layout		The new layout the image shall be transitioned into.
+ *  By default, the barrier applies to the color aspect of the image's first mip level and first layer.
+ *  Other subresources (e.g., depth aspects, whole mip chains, or array layers) can be specified
+ *  with the trailing parameters.
+ *  @param	command_buffer		Command buffer to record the image memory barrier into
+ *  @param	src_stage_mask		The stage(s) of previous commands to sync with.
+ *	@param	dst_stage_mask		The stage(s) of subsequent commands to sync with. 
+ *	@param	src_access_mask		The memory access(es) of previous commands to be made available.
+ *	@param	dst_access_mask		The memory access(es) of subsequent commands to make the data visible to.
+ *	@param	image				The image that must be synchronized
+ *	@param	old_layout			The previous image layout, i.e. the layout transitioned from.
+ *	@param	new_layout			The new layout the image shall be transitioned into.
+ *	@param	aspect_mask			The aspect(s) of the image to be synchronized, e.g. VK_IMAGE_ASPECT_DEPTH_BIT
+ *	@param	base_mip_level		The first mip level to be synchronized
+ *	@param	level_count			The number of mip levels to be synchronized (or VK_REMAINING_MIP_LEVELS)
+ *	@param	base_array_layer	The first array layer to be synchronized
+ *	@param	layer_count			The number of array layers to be synchronized (or VK_REMAINING_ARRAY_LAYERS)
  */
 void hlpRecordPipelineBarrierWithImageLayoutTransition(
 	VkCommandBuffer            command_buffer,
@@ -131,7 +279,12 @@ void hlpRecordPipelineBarrierWithImageLayoutTransition(
 	VkAccessFlags              dst_access_mask,
 	VkImage                    image,
 	VkImageLayout              old_layout,
-	VkImageLayout              new_layout);
+	VkImageLayout              new_layout,
+	VkImageAspectFlags         aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT,
+	uint32_t                   base_mip_level = 0,
+	uint32_t                   level_count = 1,
+	uint32_t                   base_array_layer = 0,
+	uint32_t                   layer_count = 1);
 
 /*!
  *  Records a copy buffer to image command into the given command buffer
@@ -184,3 +337,158 @@ VkSampler hlpCreateSampler(VkDevice device, VkFilter mag_filter, VkFilter min_fi
  *  @param	sampler			The sampler which shall be destroyed.
  */
 void hlpDestroySampler(VkDevice device, VkSampler sampler);
+
+/*!
+ *  Creates a buffer in host-visible, host-coherent memory and maps it persistently.
+ *  @param	physical_device	Physical device, used to select a memory type
+ *  @param	device			Device handle
+ *  @param	size			The size of the buffer in bytes
+ *  @param	usage			The buffer's usage flags, e.g. VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+ *  @param	category		What the memory is used for, see MemoryTracker.h
+ *  @param	name			A debug name for the buffer and its memory
+ *  @return	The buffer, its memory, and the mapped pointer.
+ */
+HlpMappedBuffer hlpCreateMappedBuffer(VkPhysicalDevice physical_device, VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage,
+	MemoryCategory category, const char* name);
+
+/*!
+ *  Unmaps and destroys a buffer which was previously created with hlpCreateMappedBuffer.
+ *  @param	device			Device handle
+ *  @param	mapped_buffer	The buffer which shall be destroyed. Reset to all zeros afterwards.
+ */
+void hlpDestroyMappedBuffer(VkDevice device, HlpMappedBuffer& mapped_buffer);
+
+/*!
+ *  Creates a 2D image with a single mipmap level in device-local memory, and a view of it, e.g., for an offscreen
+ *  attachment. With more than one layer, the view is a 2D array view.
+ *  @param	physical_device	Physical device, used to select a memory type
+ *  @param	device			Device handle
+ *  @param	format			The image's format
+ *  @param	extent			The image's width and height
+ *  @param	num_layers		Number of array layers, e.g., one per view for multiview rendering
+ *  @param	usage			The image's usage flags, e.g. VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT
+ *  @param	aspect			The aspect which the view covers, e.g. VK_IMAGE_ASPECT_DEPTH_BIT for depth attachments
+ *  @param	category		What the memory is used for, see MemoryTracker.h
+ *  @param	name			A debug name for the image and its memory
+ *  @return	The image, its memory, and its view.
+ */
+HlpImage hlpCreateImage(VkPhysicalDevice physical_device, VkDevice device, VkFormat format, VkExtent2D extent, uint32_t num_layers,
+	VkImageUsageFlags usage, VkImageAspectFlags aspect, MemoryCategory category, const char* name);
+
+/*!
+ *  Destroys an image which was previously created with hlpCreateImage, along with its view and memory.
+ *  @param	device			Device handle
+ *  @param	image			The image which shall be destroyed. Reset to all zeros afterwards.
+ */
+void hlpDestroyImage(VkDevice device, HlpImage& image);
+
+/*!
+ *  Creates a render pass which is compatible with Vulkan Launchpad's render pass, i.e., one subpass with
+ *  a color attachment at index 0 and, optionally, a depth attachment at index 1. It is not meant to be
+ *  begun, but to create pipelines which are used within Vulkan Launchpad's render pass.
+ *  @param	device			Device handle
+ *  @param	color_format	The format of the color attachment (i.e., of the swapchain images)
+ *  @param	depth_format	The format of the depth attachment, or VK_FORMAT_UNDEFINED if there is none
+ *  @param	view_mask		If not 0, the subpass renders to the layers in this mask at once (multiview), which
+ *							makes the render pass compatible with a multiview render pass of the same mask instead.
+ *  @return	A handle to a new render pass.
+ */
+VkRenderPass hlpCreateCompatibleRenderPass(VkDevice device, VkFormat color_format, VkFormat depth_format, uint32_t view_mask = 0);
+
+/*!
+ *  Creates a render pass which renders into offscreen color and depth attachments, and which is compatible with
+ *  hlpCreateCompatibleRenderPass of the same formats and view mask. Both attachments are cleared, and the color
+ *  attachment is stored and made available to whatever reads it after the render pass.
+ *  @param	device				Device handle
+ *  @param	color_format		The format of the color attachment
+ *  @param	depth_format		The format of the depth attachment
+ *  @param	color_final_layout	VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL if the color attachment is sampled afterwards, or
+ *								VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL if it is copied
+ *  @param	view_mask			If not 0, the subpass renders to the layers in this mask at once (multiview)
+ *  @return	A handle to a new render pass.
+ */
+VkRenderPass hlpCreateOffscreenRenderPass(VkDevice device, VkFormat color_format, VkFormat depth_format, VkImageLayout color_final_layout,
+	uint32_t view_mask = 0);
+
+/*!
+ *  Creates a framebuffer with a color and a depth attachment and a single layer. With multiview, the render pass's
+ *  view mask selects the attachments' layers.
+ *  @param	device			Device handle
+ *  @param	render_pass		The render pass which the framebuffer is used with
+ *  @param	color_view		View of the color attachment
+ *  @param	depth_view		View of the depth attachment
+ *  @param	extent			The framebuffer's width and height
+ *  @return	A handle to a new framebuffer.
+ */
+VkFramebuffer hlpCreateFramebuffer(VkDevice device, VkRenderPass render_pass, VkImageView color_view, VkImageView depth_view, VkExtent2D extent);
+
+/*!
+ *  Creates a graphics pipeline with control over culling, winding order, depth test, and color writes.
+ *  Vertex input, polygon mode, and descriptor layout are taken from the given config. Unlike
+ *  vklCreateGraphicsPipeline, the config's shader paths must point to SPIR-V files (see SHADER_BINARY_DIR).
+ *  A pipeline layout is created along with the pipeline; get it with hlpGetPipelineLayout.
+ *  @param	device			Device handle
+ *  @param	config			Shaders, vertex input, polygon mode, and descriptor layout
+ *  @param	state			Culling, winding order, depth, and color write state
+ *  @param	render_pass		A render pass which is compatible with the one that the pipeline is used in
+ *  @param	extent			The viewport and scissor extent
+ *  @param	pipeline_cache	A pipeline cache to speed up creation, or VK_NULL_HANDLE
+ *  @return	A handle to a new graphics pipeline.
+ *  This function is thread-safe, i.e., pipelines can be created in the background.
+ */
+VkPipeline hlpCreateGraphicsPipeline(VkDevice device, const VklGraphicsPipelineConfig& config, const HlpPipelineState& state,
+	VkRenderPass render_pass, VkExtent2D extent, VkPipelineCache pipeline_cache = VK_NULL_HANDLE);
+
+/*!
+ *  Creates a graphics pipeline which draws a fullscreen triangle without vertex input (3 vertices, see
+ *  shaders/fullscreen.shader), e.g., to copy or filter an offscreen image into the framework's render pass.
+ *  Every pixel is overwritten, i.e., culling and the depth test are disabled.
+ *  @param	device					Device handle
+ *  @param	fragment_shader_path	Path to the fragment shader's SPIR-V file
+ *  @param	descriptor_layout		Bindings of the fragment shader's descriptor set
+ *  @param	render_pass				A render pass which is compatible with the one that the pipeline is used in
+ *  @param	extent					The viewport and scissor extent
+ *  @param	state					Further state, e.g., specialization constants. Its culling and depth state is ignored.
+ *  @return	A handle to a new graphics pipeline.
+ */
+VkPipeline hlpCreateFullscreenPipeline(VkDevice device, const char* fragment_shader_path, const std::vector<VkDescriptorSetLayoutBinding>& descriptor_layout,
+	VkRenderPass render_pass, VkExtent2D extent, const HlpPipelineState& state = HlpPipelineState());
+
+/*!
+ *  Creates a compute pipeline. Like with hlpCreateGraphicsPipeline, a pipeline layout is created along with it,
+ *  with one descriptor set at index 0 and, optionally, push constants which are visible to the compute stage.
+ *  @param	device					Device handle
+ *  @param	shader_path				Path to the compute shader's SPIR-V file
+ *  @param	descriptor_layout		The bindings of descriptor set 0
+ *  @param	push_constants_size		Size of the push constants in bytes, or 0 if there are none
+ *  @return	A handle to a new compute pipeline. Destroy it with hlpDestroyGraphicsPipeline.
+ */
+VkPipeline hlpCreateComputePipeline(VkDevice device, const char* shader_path, const std::vector<VkDescriptorSetLayoutBinding>& descriptor_layout,
+	uint32_t push_constants_size);
+
+/*!
+ *  Returns the pipeline layout of a pipeline which was created with hlpCreateGraphicsPipeline or hlpCreateComputePipeline.
+ */
+VkPipelineLayout hlpGetPipelineLayout(VkPipeline pipeline);
+
+/*!
+ *  Returns the layout of descriptor set 0 of a pipeline which was created with hlpCreateGraphicsPipeline or
+ *  hlpCreateComputePipeline, e.g., to allocate descriptor sets for it.
+ */
+VkDescriptorSetLayout hlpGetDescriptorSetLayout(VkPipeline pipeline);
+
+/*!
+ *  Binds a descriptor set to set index 0 of a pipeline which was created with hlpCreateGraphicsPipeline.
+ *  @param	command_buffer	Command buffer to record the bind command into
+ *  @param	descriptor_set	The descriptor set to bind
+ *  @param	pipeline		The pipeline whose layout is used
+ */
+void hlpBindDescriptorSetToPipeline(VkCommandBuffer command_buffer, VkDescriptorSet descriptor_set, VkPipeline pipeline);
+
+/*!
+ *  Destroys a pipeline which was previously created with hlpCreateGraphicsPipeline or hlpCreateComputePipeline,
+ *  along with its layouts.
+ *  @param	device			Device handle
+ *  @param	pipeline		The pipeline which shall be destroyed.
+ */
+void hlpDestroyGraphicsPipeline(VkDevice device, VkPipeline pipeline);
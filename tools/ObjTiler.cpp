@@ -0,0 +1,354 @@
+/*
+ * Copyright 2023 TU Wien, Institute of Visual Computing & Human-Centered Technology.
+ */
+#include <VulkanLaunchpad.h>
+#include "AssetLoader.h"
+#include "TileStreamer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+/* --------------------------------------------- */
+// OBJ Tiler
+//
+// Partitions an OBJ model into the cells of a uniform grid and writes a
+// tile file for the tile streamer (see src/TileStreamer.h). Every triangle
+// goes into the cell which contains its centroid, so tiles' bounding boxes
+// may overlap slightly. Each tile's vertices are welded, as the asset
+// loader would do it at runtime.
+//
+// The file is read twice, line by line: first for the vertex positions and
+// the bounding box, then for the faces. Only positions are used; normals and
+// texture coordinates are ignored, like everywhere else in this application.
+// Polygons are triangulated as fans.
+//
+// Models need not fit into memory: positions go into a temporary file, which
+// the faces read through a fixed-size cache. Triangles are collected per
+// cell and appended to one temporary file per cell whenever the collected
+// ones exceed a limit. Cells are then welded and written one at a time, so
+// memory usage is bounded by the limits and the largest tile.
+//
+// Usage: VulkanLaunchpadStarterTiler <input.obj> <output.tiles> [--grid <n>]
+//        n is the number of cells along the longest axis of the bounding box
+//        (default: 8); cells are cubes.
+/* --------------------------------------------- */
+
+namespace
+{
+	// Parses the next index of a face ("i", "i/t", "i//n", or "i/t/n"), relative to the vertices which
+	// have been defined so far. Returns false at the end of the line or for an invalid index:
+	bool parseFaceIndex(const char*& cursor, uint32_t num_defined_vertices, uint32_t& index)
+	{
+		char* end = nullptr;
+		const long value = strtol(cursor, &end, 10);
+		if (end == cursor) {
+			return false;
+		}
+		cursor = end;
+		while ('\0' != *cursor && ' ' != *cursor && '\t' != *cursor) {
+			++cursor;
+		}
+		const long resolved = value < 0 ? static_cast<long>(num_defined_vertices) + value : value - 1;
+		if (resolved < 0 || resolved >= static_cast<long>(num_defined_vertices)) {
+			return false;
+		}
+		index = static_cast<uint32_t>(resolved);
+		return true;
+	}
+
+	// Triangles which are collected in memory before they are appended to the cells' temporary files:
+	constexpr size_t kMaxCollectedPositions = (64u << 20) / sizeof(glm::vec3);
+
+	// The position cache holds kNumCachedBlocks blocks of kCachedBlockSize consecutive positions (48 MiB):
+	constexpr uint32_t kCachedBlockSize = 1u << 14;
+	constexpr uint32_t kNumCachedBlocks = 256;
+
+	struct Cell {
+		//! Three positions per triangle which have not been appended to the temporary file yet
+		std::vector<glm::vec3> positions;
+
+		//! Number of positions in the temporary file
+		uint64_t numFlushedPositions = 0;
+	};
+
+	// Reads positions from the temporary position file. Direct-mapped: every block has a single slot. Faces mostly
+	// refer to vertices which have been defined shortly before them, so most lookups hit the cache:
+	struct PositionCache {
+		std::ifstream file;
+		std::vector<glm::vec3> positions;
+		std::vector<uint32_t> blocks;
+
+		const glm::vec3& get(uint32_t index)
+		{
+			const uint32_t block = index / kCachedBlockSize;
+			const uint32_t slot = block % kNumCachedBlocks;
+			if (blocks[slot] != block) {
+				file.clear();
+				file.seekg(static_cast<std::streamoff>(block) * kCachedBlockSize * sizeof(glm::vec3));
+				file.read(reinterpret_cast<char*>(&positions[static_cast<size_t>(slot) * kCachedBlockSize]), sizeof(glm::vec3) * kCachedBlockSize);
+				blocks[slot] = block;
+			}
+			return positions[static_cast<size_t>(slot) * kCachedBlockSize + index % kCachedBlockSize];
+		}
+	};
+
+	std::string cellPath(const char* output_path, size_t cell_index)
+	{
+		return std::string(output_path) + ".cell" + std::to_string(cell_index) + ".tmp";
+	}
+
+	// Appends the collected positions of all cells to their temporary files:
+	bool flushCells(const char* output_path, std::vector<Cell>& cells)
+	{
+		for (size_t i = 0; i < cells.size(); ++i) {
+			Cell& cell = cells[i];
+			if (cell.positions.empty()) {
+				continue;
+			}
+			std::ofstream file(cellPath(output_path, i), std::ios::binary | std::ios::app);
+			file.write(reinterpret_cast<const char*>(cell.positions.data()), sizeof(glm::vec3) * cell.positions.size());
+			if (!file) {
+				return false;
+			}
+			cell.numFlushedPositions += cell.positions.size();
+			cell.positions.clear();
+		}
+		return true;
+	}
+
+	// Deletes all temporary files:
+	void removeTemporaryFiles(const char* output_path, const std::vector<Cell>& cells)
+	{
+		std::remove((std::string(output_path) + ".positions.tmp").c_str());
+		for (size_t i = 0; i < cells.size(); ++i) {
+			if (cells[i].numFlushedPositions > 0) {
+				std::remove(cellPath(output_path, i).c_str());
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const char* input_path = nullptr;
+	const char* output_path = nullptr;
+	uint32_t grid = 8;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--grid") == 0 && i + 1 < argc) {
+			grid = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)));
+		}
+		else if (nullptr == input_path) {
+			input_path = argv[i];
+		}
+		else if (nullptr == output_path) {
+			output_path = argv[i];
+		}
+		else {
+			VKL_LOG("Ignoring unknown command line argument \"" << argv[i] << "\"");
+		}
+	}
+	if (nullptr == output_path) {
+		VKL_LOG("Usage: VulkanLaunchpadStarterTiler <input.obj> <output.tiles> [--grid <n>]");
+		return EXIT_FAILURE;
+	}
+
+	// First pass: positions, which are written to a temporary file, and their bounding box
+	std::ifstream input(input_path);
+	if (!input) {
+		VKL_LOG("Unable to read \"" << input_path << "\"");
+		return EXIT_FAILURE;
+	}
+	const std::string positions_path = std::string(output_path) + ".positions.tmp";
+	std::ofstream positions_output(positions_path, std::ios::binary);
+	uint32_t num_positions = 0;
+	glm::vec3 bounds_min(std::numeric_limits<float>::max());
+	glm::vec3 bounds_max(-std::numeric_limits<float>::max());
+	std::string line;
+	while (std::getline(input, line)) {
+		if (line.size() > 2 && 'v' == line[0] && (' ' == line[1] || '\t' == line[1])) {
+			const char* cursor = line.c_str() + 2;
+			char* end = nullptr;
+			glm::vec3 position;
+			for (int c = 0; c < 3; ++c) {
+				position[c] = strtof(cursor, &end);
+				cursor = end;
+			}
+			positions_output.write(reinterpret_cast<const char*>(&position), sizeof(position));
+			++num_positions;
+			bounds_min = glm::min(bounds_min, position);
+			bounds_max = glm::max(bounds_max, position);
+		}
+	}
+	positions_output.close();
+	if (!positions_output) {
+		std::remove(positions_path.c_str());
+		VKL_LOG("Unable to write \"" << positions_path << "\"");
+		return EXIT_FAILURE;
+	}
+	if (0 == num_positions) {
+		std::remove(positions_path.c_str());
+		VKL_LOG("\"" << input_path << "\" has no vertices");
+		return EXIT_FAILURE;
+	}
+
+	// Cubic cells, grid of them along the longest axis:
+	const glm::vec3 extent = bounds_max - bounds_min;
+	const float cell_size = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f)) / static_cast<float>(grid);
+	uint32_t dimensions[3];
+	for (int a = 0; a < 3; ++a) {
+		dimensions[a] = std::max(1u, static_cast<uint32_t>(std::ceil(extent[a] / cell_size)));
+	}
+	std::vector<Cell> cells(static_cast<size_t>(dimensions[0]) * dimensions[1] * dimensions[2]);
+
+	// Second pass: distribute the triangles among the cells. Relative indices refer to the vertices defined so far:
+	PositionCache positions;
+	positions.file.open(positions_path, std::ios::binary);
+	positions.positions.resize(static_cast<size_t>(kNumCachedBlocks) * kCachedBlockSize);
+	positions.blocks.assign(kNumCachedBlocks, std::numeric_limits<uint32_t>::max());
+	size_t num_collected_positions = 0;
+	input.clear();
+	input.seekg(0);
+	uint32_t num_defined_vertices = 0;
+	uint64_t num_triangles = 0;
+	uint64_t num_invalid_faces = 0;
+	std::vector<uint32_t> face;
+	while (std::getline(input, line)) {
+		if (line.size() > 2 && 'v' == line[0] && (' ' == line[1] || '\t' == line[1])) {
+			++num_defined_vertices;
+			continue;
+		}
+		if (line.size() < 2 || 'f' != line[0] || (' ' != line[1] && '\t' != line[1])) {
+			continue;
+		}
+		face.clear();
+		const char* cursor = line.c_str() + 2;
+		uint32_t index;
+		while (parseFaceIndex(cursor, num_defined_vertices, index)) {
+			face.push_back(index);
+		}
+		if (face.size() < 3) {
+			++num_invalid_faces;
+			continue;
+		}
+		for (size_t k = 2; k < face.size(); ++k) {
+			// Copies, since a lookup may replace the block of a previous one:
+			const glm::vec3 a = positions.get(face[0]);
+			const glm::vec3 b = positions.get(face[k - 1]);
+			const glm::vec3 c = positions.get(face[k]);
+			const glm::vec3 cell_coordinates = ((a + b + c) / 3.0f - bounds_min) / cell_size;
+			uint32_t cell_index = 0;
+			for (int axis = 2; axis >= 0; --axis) {
+				const uint32_t coordinate = std::min(static_cast<uint32_t>(std::max(cell_coordinates[axis], 0.0f)), dimensions[axis] - 1);
+				cell_index = cell_index * dimensions[axis] + coordinate;
+			}
+			cells[cell_index].positions.push_back(a);
+			cells[cell_index].positions.push_back(b);
+			cells[cell_index].positions.push_back(c);
+			++num_triangles;
+			num_collected_positions += 3;
+		}
+		if (num_collected_positions >= kMaxCollectedPositions) {
+			if (!flushCells(output_path, cells)) {
+				removeTemporaryFiles(output_path, cells);
+				VKL_LOG("Unable to write temporary files next to \"" << output_path << "\"");
+				return EXIT_FAILURE;
+			}
+			num_collected_positions = 0;
+		}
+	}
+	if (num_invalid_faces > 0) {
+		VKL_LOG("Skipped " << num_invalid_faces << " faces with fewer than 3 valid vertices");
+	}
+	positions.file.close();
+	std::vector<glm::vec3>().swap(positions.positions);
+	std::remove(positions_path.c_str());
+
+	// Write the header and a placeholder table, then the chunks, then the final table:
+	std::ofstream output(output_path, std::ios::binary);
+	if (!output) {
+		removeTemporaryFiles(output_path, cells);
+		VKL_LOG("Unable to write \"" << output_path << "\"");
+		return EXIT_FAILURE;
+	}
+	std::vector<TileFileEntry> entries;
+	for (const Cell& cell : cells) {
+		if (!cell.positions.empty() || cell.numFlushedPositions > 0) {
+			entries.emplace_back();
+		}
+	}
+	TileFileHeader header = {};
+	header.magic = kTileFileMagic;
+	header.numTiles = static_cast<uint32_t>(entries.size());
+	memcpy(header.boundsMin, &bounds_min, sizeof(header.boundsMin));
+	memcpy(header.boundsMax, &bounds_max, sizeof(header.boundsMax));
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output.write(reinterpret_cast<const char*>(entries.data()), sizeof(TileFileEntry) * entries.size());
+
+	uint64_t offset = sizeof(header) + sizeof(TileFileEntry) * entries.size();
+	uint32_t max_vertices = 0;
+	uint32_t max_indices = 0;
+	size_t t = 0;
+	bool read_failed = false;
+	for (size_t c = 0; c < cells.size(); ++c) {
+		Cell& cell = cells[c];
+		if (cell.positions.empty() && 0 == cell.numFlushedPositions) {
+			continue;
+		}
+
+		// The cell's triangles in the order in which they have been read: first the temporary file, then the rest:
+		if (cell.numFlushedPositions > 0) {
+			std::vector<glm::vec3> collected_positions;
+			collected_positions.swap(cell.positions);
+			cell.positions.resize(static_cast<size_t>(cell.numFlushedPositions));
+			std::ifstream cell_file(cellPath(output_path, c), std::ios::binary);
+			if (!cell_file.read(reinterpret_cast<char*>(cell.positions.data()), sizeof(glm::vec3) * cell.positions.size())) {
+				read_failed = true;
+				break;
+			}
+			cell.positions.insert(cell.positions.end(), collected_positions.begin(), collected_positions.end());
+		}
+		std::vector<uint32_t> indices(cell.positions.size());
+		for (uint32_t i = 0; i < static_cast<uint32_t>(indices.size()); ++i) {
+			indices[i] = i;
+		}
+		assetLoaderWeldVertices(cell.positions, indices);
+
+		TileFileEntry& entry = entries[t++];
+		glm::vec3 tile_min = cell.positions[0];
+		glm::vec3 tile_max = cell.positions[0];
+		for (const glm::vec3& position : cell.positions) {
+			tile_min = glm::min(tile_min, position);
+			tile_max = glm::max(tile_max, position);
+		}
+		memcpy(entry.boundsMin, &tile_min, sizeof(entry.boundsMin));
+		memcpy(entry.boundsMax, &tile_max, sizeof(entry.boundsMax));
+		entry.offset = offset;
+		entry.numVertices = static_cast<uint32_t>(cell.positions.size());
+		entry.numIndices = static_cast<uint32_t>(indices.size());
+		output.write(reinterpret_cast<const char*>(cell.positions.data()), sizeof(glm::vec3) * cell.positions.size());
+		output.write(reinterpret_cast<const char*>(indices.data()), sizeof(uint32_t) * indices.size());
+		offset += sizeof(glm::vec3) * cell.positions.size() + sizeof(uint32_t) * indices.size();
+		max_vertices = std::max(max_vertices, entry.numVertices);
+		max_indices = std::max(max_indices, entry.numIndices);
+		std::vector<glm::vec3>().swap(cell.positions);
+	}
+	removeTemporaryFiles(output_path, cells);
+	output.seekp(sizeof(header));
+	output.write(reinterpret_cast<const char*>(entries.data()), sizeof(TileFileEntry) * entries.size());
+	output.close();
+	if (read_failed || !output) {
+		VKL_LOG("Unable to write \"" << output_path << "\"");
+		return EXIT_FAILURE;
+	}
+
+	VKL_LOG("Wrote " << entries.size() << " tiles (" << dimensions[0] << "x" << dimensions[1] << "x" << dimensions[2] << " grid, " << num_triangles
+		<< " triangles, " << offset / (1024 * 1024) << " MiB) to \"" << output_path << "\". The largest tile has " << max_vertices << " vertices and "
+		<< max_indices << " indices.");
+	return EXIT_SUCCESS;
+}